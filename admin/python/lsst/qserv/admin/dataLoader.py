@@ -495,7 +495,11 @@ class DataLoader(object):
         for name, wmgr in self._connections(useCzar=True, useWorkers=True):
             self._log.info('Creating table %r in %r', table, name)
             chunkColumns = bool(self.partitioned)
-            wmgr.createTable(database, table, schema=self.schema, chunkColumns=chunkColumns)
+            # index subChunkId of sub-chunked tables so that workers can use
+            # subchunks of chunk tables in place
+            subChunkIndex = chunkColumns and not self.oneTable and self.partOptions.isSubChunked
+            wmgr.createTable(database, table, schema=self.schema, chunkColumns=chunkColumns,
+                             subChunkIndex=subChunkIndex)
 
 
     def _loadData(self, database, table, files):
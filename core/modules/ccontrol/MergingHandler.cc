@@ -35,13 +35,14 @@
 #include "global/Bug.h"
 #include "global/debugUtil.h"
 #include "global/MsgReceiver.h"
+#include "proto/MsgPool.h"
 #include "proto/ProtoHeaderWrap.h"
 #include "proto/ProtoImporter.h"
+#include "proto/ResultCompression.h"
 #include "proto/WorkerResponse.h"
 #include "qdisp/JobQuery.h"
 #include "rproc/InfileMerger.h"
 #include "util/common.h"
-#include "util/StringHash.h"
 
 using lsst::qserv::proto::ProtoImporter;
 using lsst::qserv::proto::ProtoHeader;
@@ -63,8 +64,7 @@ MergingHandler::MergingHandler(
     std::shared_ptr<MsgReceiver> msgReceiver,
     std::shared_ptr<rproc::InfileMerger> merger,
     std::string const& tableName)
-    : _msgReceiver{msgReceiver}, _infileMerger{merger}, _tableName{tableName},
-      _response{new WorkerResponse()} {
+    : _msgReceiver{msgReceiver}, _infileMerger{merger}, _tableName{tableName} {
     _initState();
 }
 
@@ -97,6 +97,9 @@ bool MergingHandler::flush(int bLen, bool& last) {
     }
     switch(_state) {
     case MsgState::HEADER_SIZE_WAIT:
+        if (!_response) {
+            _response = proto::MsgPool<WorkerResponse>::getPool().acquire();
+        }
         _response->headerSize = static_cast<unsigned char>(_buffer[0]);
         if (!proto::ProtoHeaderWrap::unwrap(_response, _buffer)) {
             std::string s = "From:" + _wName + "Error decoding proto header for " + getStateStr(_state);
@@ -115,6 +118,7 @@ bool MergingHandler::flush(int bLen, bool& last) {
 
     case MsgState::RESULT_WAIT:
         if (!_verifyResult()) { return false; }
+        if (!_uncompressResult()) { return false; }
         if (!_setResult()) { return false; }
         LOGS(_log, LOG_LVL_DEBUG, "From:" << _wName << " _buffer "
              << util::prettyCharList(_buffer, 5));
@@ -135,7 +139,10 @@ bool MergingHandler::flush(int bLen, bool& last) {
 
             auto success = _merge();
             if (msgContinues) {
-                _response.reset(new WorkerResponse());
+                // Release the message just merged first, so the pool usually
+                // hands it back, with its allocations.
+                _response.reset();
+                _response = proto::MsgPool<WorkerResponse>::getPool().acquire();
             }
             return success;
         }
@@ -249,9 +256,24 @@ bool MergingHandler::_setResult() {
     LOGS(_log, LOG_LVL_DEBUG, "protoDur=" << protoDur.count());
     return true;
 }
+/// Replace a compressed result message in _buffer by its uncompressed bytes.
+bool MergingHandler::_uncompressResult() {
+    ProtoHeader const& header = _response->protoHeader;
+    if (!header.has_compression() || header.compression() == ProtoHeader::NONE) {
+        return true;
+    }
+    if (!proto::ResultCompression::uncompress(header, _buffer.data(), _buffer.size(), _rawBuffer)) {
+        _setError(ccontrol::MSG_RESULT_DECODE, "Error uncompressing result msg");
+        _state = MsgState::RESULT_ERR;
+        return false;
+    }
+    _buffer.swap(_rawBuffer); // Both keep their capacity for the next message.
+    return true;
+}
+
 bool MergingHandler::_verifyResult() {
-    if (_response->protoHeader.md5() != util::StringHash::getMd5(_buffer.data(), _buffer.size())) {
-        _setError(ccontrol::MSG_RESULT_MD5, "Result message MD5 mismatch");
+    if (!proto::ProtoHeaderWrap::checkChecksum(_response->protoHeader, _buffer.data(), _buffer.size())) {
+        _setError(ccontrol::MSG_RESULT_MD5, "Result message checksum mismatch");
         _state = MsgState::RESULT_ERR;
         return false;
     }
@@ -103,16 +103,18 @@ private:
     bool _merge();
     void _setError(int code, std::string const& msg);
     bool _setResult();
+    bool _uncompressResult();
     bool _verifyResult();
 
     std::shared_ptr<MsgReceiver> _msgReceiver; ///< Message code receiver
     std::shared_ptr<rproc::InfileMerger> _infileMerger; ///< Merging delegate
     std::string _tableName; ///< Target table name
     std::vector<char> _buffer; ///< Raw response buffer, resized for each msg
+    std::vector<char> _rawBuffer; ///< Uncompressed result msg
     Error _error; ///< Error description
     mutable std::mutex _errorMutex; ///< Protect readers from partial updates
     MsgState _state; ///< Received message state
-    std::shared_ptr<proto::WorkerResponse> _response; ///< protobufs msg buf
+    std::shared_ptr<proto::WorkerResponse> _response; ///< protobufs msg buf, from proto::MsgPool
     bool _flushed {false}; ///< flushed to InfileMerger?
     std::string _wName {"~"}; /// worker name
 };
@@ -46,9 +46,7 @@ public:
         _prefix = ss.str();
     }
     std::string make(int chunkId, int seq=0) {
-        std::stringstream ss;
-        ss << _prefix << chunkId << "_" << seq;
-        return ss.str();
+        return _prefix + std::to_string(chunkId) + "_" + std::to_string(seq);
     }
 private:
     std::string _prefix;
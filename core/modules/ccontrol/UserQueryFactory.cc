@@ -25,7 +25,10 @@
 #include "ccontrol/UserQueryFactory.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <chrono>
 #include <cstdlib>
 #include <string>
 
@@ -49,6 +52,8 @@
 #include "qdisp/Executive.h"
 #include "qdisp/MessageStore.h"
 #include "qmeta/QMetaMysql.h"
+#include "qproc/ChunkCoverage.h"
+#include "qproc/PlanCache.h"
 #include "qproc/QuerySession.h"
 #include "qproc/SecondaryIndex.h"
 #include "rproc/InfileMerger.h"
@@ -56,6 +61,18 @@
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.UserQueryFactory");
+
+/// Parse a result compression codec name, case-insensitively.
+/// @return false if name is not a known codec
+bool parseCompression(std::string name, int& compression) {
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    lsst::qserv::proto::ProtoHeader::CompressionType type;
+    if (!lsst::qserv::proto::ProtoHeader::CompressionType_Parse(name, &type)) {
+        return false;
+    }
+    compression = type;
+    return true;
+}
 }
 
 namespace lsst {
@@ -73,7 +90,14 @@ public:
     qdisp::Executive::Config::Ptr executiveConfig;
     std::shared_ptr<css::CssAccess> css;
     mysql::MySqlConfig const mysqlResultConfig;
+    int const mergeConnections;
+    bool const aggregateInMemory;
+    proto::ProtoHeader::ChecksumType resultChecksum{proto::ProtoHeader::MD5};
+    int const maxResultProtocol;
+    int resultCompression{0}; ///< 0 leaves the codec to each worker
     std::shared_ptr<qproc::SecondaryIndex> secondaryIndex;
+    std::shared_ptr<qproc::PlanCache> planCache; ///< nullptr if disabled
+    std::shared_ptr<qproc::ChunkCoverageMap> chunkCoverage; ///< nullptr if disabled
     std::shared_ptr<qmeta::QMeta> queryMetadata;
     std::unique_ptr<sql::SqlConnection> resultDbConn;
     qmeta::CzarId qMetaCzarId = {0};   ///< Czar ID in QMeta database
@@ -93,16 +117,23 @@ UserQueryFactory::UserQueryFactory(czar::CzarConfig const& czarConfig,
 
 UserQuery::Ptr
 UserQueryFactory::newUserQuery(std::string const& query,
-                               std::string const& defaultDb) {
+                               std::string const& defaultDb,
+                               std::string const& resultCompression) {
     std::string dbName, tableName;
 
     if (UserQueryType::isSelect(query)) {
+        int compression = _impl->resultCompression;
+        if (!resultCompression.empty() && !parseCompression(resultCompression, compression)) {
+            return std::make_shared<UserQueryInvalid>("Unknown result compression: "
+                                                      + resultCompression);
+        }
         // Processing regular select query
         bool sessionValid = true;
         std::string errorExtra;
         qproc::QuerySession::Ptr qs = std::make_shared<qproc::QuerySession>(_impl->css);
         try {
             qs->setDefaultDb(defaultDb);
+            qs->setPlanCache(_impl->planCache);
             qs->analyzeQuery(query);
         } catch (...) {
             errorExtra = "Unknown failure occurred setting up QuerySession (query is invalid).";
@@ -120,11 +151,17 @@ UserQueryFactory::newUserQuery(std::string const& query,
         if (sessionValid) {
             executive = qdisp::Executive::newExecutive(_impl->executiveConfig, messageStore);
             infileMergerConfig = std::make_shared<rproc::InfileMergerConfig>(_impl->mysqlResultConfig);
+            infileMergerConfig->mergeConnections = _impl->mergeConnections;
+            infileMergerConfig->aggregateInMemory = _impl->aggregateInMemory;
+            infileMergerConfig->resultChecksum = _impl->resultChecksum;
+            infileMergerConfig->maxResultProtocol = _impl->maxResultProtocol;
+            infileMergerConfig->resultCompression = compression;
         }
         auto uq = std::make_shared<UserQuerySelect>(qs, messageStore, executive, infileMergerConfig,
                                                     _impl->secondaryIndex, _impl->queryMetadata,
                                                     _impl->qMetaCzarId, errorExtra);
         if (sessionValid) {
+            uq->setChunkCoverage(_impl->chunkCoverage);
             uq->setupChunking();
         }
         return uq;
@@ -133,6 +170,7 @@ UserQueryFactory::newUserQuery(std::string const& query,
         if (dbName.empty()) {
             dbName = defaultDb;
         }
+        _invalidatePlans(dbName);
         auto uq = std::make_shared<UserQueryDrop>(_impl->css, dbName, tableName,
                                                   _impl->resultDbConn.get(),
                                                   _impl->queryMetadata, _impl->qMetaCzarId);
@@ -140,12 +178,14 @@ UserQueryFactory::newUserQuery(std::string const& query,
         return uq;
     } else if (UserQueryType::isDropDb(query, dbName)) {
         // processing DROP DATABASE
+        _invalidatePlans(dbName);
         auto uq = std::make_shared<UserQueryDrop>(_impl->css, dbName, std::string(),
                                                   _impl->resultDbConn.get(),
                                                   _impl->queryMetadata, _impl->qMetaCzarId);
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryDrop: db=" << dbName);
         return uq;
     } else if (UserQueryType::isFlushChunksCache(query, dbName)) {
+        _invalidatePlans(dbName);
         auto uq = std::make_shared<UserQueryFlushChunksCache>(_impl->css, dbName,
                                                               _impl->resultDbConn.get());
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryFlushChunksCache: " << dbName);
@@ -157,11 +197,48 @@ UserQueryFactory::newUserQuery(std::string const& query,
     }
 }
 
+void UserQueryFactory::_invalidatePlans(std::string const& dbName) {
+    if (_impl->planCache) {
+        _impl->planCache->invalidate(dbName);
+    }
+}
+
 UserQueryFactory::Impl::Impl(czar::CzarConfig const& czarConfig)
-    : mysqlResultConfig(czarConfig.getMySqlResultConfig()) {
+    : mysqlResultConfig(czarConfig.getMySqlResultConfig()),
+      mergeConnections(czarConfig.getMergeConnections()),
+      aggregateInMemory(czarConfig.getAggregateInMemory()),
+      maxResultProtocol(czarConfig.getResultProtocol()) {
+
+    std::string checksumName = czarConfig.getResultChecksum();
+    std::transform(checksumName.begin(), checksumName.end(), checksumName.begin(), ::toupper);
+    if (!proto::ProtoHeader::ChecksumType_Parse(checksumName, &resultChecksum)) {
+        throw ConfigError("Unknown tuning.resultChecksum " + czarConfig.getResultChecksum());
+    }
+    std::string const& compressionName = czarConfig.getResultCompression();
+    if (!compressionName.empty() && !parseCompression(compressionName, resultCompression)) {
+        throw ConfigError("Unknown tuning.resultCompression " + compressionName);
+    }
 
     executiveConfig = std::make_shared<qdisp::Executive::Config>(czarConfig.getXrootdFrontendUrl());
-    secondaryIndex = std::make_shared<qproc::SecondaryIndex>(mysqlResultConfig);
+    executiveConfig->maxJobsInFlight = czarConfig.getMaxJobsInFlight();
+    executiveConfig->maxAttempts = czarConfig.getRetryAttempts();
+    qdisp::RetryScheduler::Config retryConfig;
+    retryConfig.baseDelay = std::chrono::milliseconds(czarConfig.getRetryBaseDelayMs());
+    retryConfig.maxDelay = std::chrono::milliseconds(czarConfig.getRetryMaxDelayMs());
+    retryConfig.maxPerService = czarConfig.getRetryMaxRunning();
+    executiveConfig->retryScheduler = std::make_shared<qdisp::RetryScheduler>(retryConfig);
+    secondaryIndex = std::make_shared<qproc::SecondaryIndex>(mysqlResultConfig,
+                                                             czarConfig.getSecondaryIndexTables(),
+                                                             czarConfig.getSecondaryIndexDir(),
+                                                             std::chrono::seconds(
+                                                                 czarConfig.getSecondaryIndexCheckSeconds()));
+    if (czarConfig.getPlanCacheSize() > 0) {
+        planCache = std::make_shared<qproc::PlanCache>(
+            czarConfig.getPlanCacheSize(), std::chrono::seconds(czarConfig.getPlanCacheCheckSeconds()));
+    }
+    if (czarConfig.getCoverageCacheSize() > 0) {
+        chunkCoverage = std::make_shared<qproc::ChunkCoverageMap>(czarConfig.getCoverageCacheSize());
+    }
 
     // make one dedicated connection for results database
     resultDbConn.reset(new sql::SqlConnection(mysqlResultConfig));
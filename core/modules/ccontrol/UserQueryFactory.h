@@ -59,11 +59,18 @@ public:
 
     /// @param query:       Query text
     /// @param defaultDb:   Default database name, may be empty
+    /// @param resultCompression: Codec workers compress results of this
+    ///                     query with (NONE, LZ4 or ZLIB), empty for the
+    ///                     czar configuration
     /// @return new UserQuery object
     UserQuery::Ptr newUserQuery(std::string const& query,
-                                std::string const& defaultDb);
+                                std::string const& defaultDb,
+                                std::string const& resultCompression=std::string());
 
 private:
+    /// Drop the cached query plans on tables of dbName.
+    void _invalidatePlans(std::string const& dbName);
+
     class Impl;
     std::shared_ptr<Impl> _impl;
 };
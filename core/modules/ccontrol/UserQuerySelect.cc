@@ -65,13 +65,16 @@
 
 // System headers
 #include <cassert>
+#include <chrono>
 #include <memory>
+#include <utility>
 
 // LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
 #include "ccontrol/MergingHandler.h"
+#include "ccontrol/msgCode.h"
 #include "ccontrol/TmpTableName.h"
 #include "ccontrol/UserQueryError.h"
 #include "global/constants.h"
@@ -192,6 +195,7 @@ UserQuerySelect::getProxyOrderBy() {
 
 /// Begin running on all chunks added so far.
 void UserQuerySelect::submit() {
+    _submitTime = std::chrono::steady_clock::now();
     _qSession->finalize();
 
     // has to be done after result table name
@@ -202,11 +206,11 @@ void UserQuerySelect::submit() {
     LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() << " UserQuerySelect beginning submission");
     assert(_infileMerger);
 
-    qproc::TaskMsgFactory taskMsgFactory(_qMetaQueryId);
+    qproc::TaskMsgFactory taskMsgFactory(_qMetaQueryId, _infileMergerConfig->resultChecksum,
+                                         _infileMergerConfig->maxResultProtocol,
+                                         _infileMergerConfig->resultCompression);
     TmpTableName ttn(_qMetaQueryId, _qSession->getOriginal());
-    proto::ProtoImporter<proto::TaskMsg> pi;
     std::vector<int> chunks;
-    int msgCount = 0;
     int sequence = 0;
     // Writing query for each chunk, stop if query is cancelled.
     for(auto i = _qSession->cQueryBegin(), e = _qSession->cQueryEnd();
@@ -214,25 +218,19 @@ void UserQuerySelect::submit() {
         qproc::ChunkQuerySpec& cs = *i;
         chunks.push_back(cs.chunkId);
         std::string chunkResultName = ttn.make(cs.chunkId);
-        ++msgCount;
-        std::ostringstream ss;
-        taskMsgFactory.serializeMsg(cs, chunkResultName, _executive->getId(), sequence, ss);
-        std::string msg = ss.str();
-
-        pi(msg.data(), msg.size());
-        if (pi.getNumAccepted() != msgCount) {
-            throw UserQueryBug(getQueryIdString() + " Error serializing TaskMsg.");
-        }
+        std::string msg;
+        taskMsgFactory.serializeMsg(cs, chunkResultName, _executive->getId(), sequence, msg);
 
         std::shared_ptr<ChunkMsgReceiver> cmr = ChunkMsgReceiver::newInstance(cs.chunkId, _messageStore);
         ResourceUnit ru;
         ru.setAsDbChunk(cs.db, cs.chunkId);
-        qdisp::JobDescription jobDesc(sequence, ru, ss.str(),
+        qdisp::JobDescription jobDesc(sequence, ru, std::move(msg),
                 std::make_shared<MergingHandler>(cmr, _infileMerger, chunkResultName));
         _executive->add(jobDesc);
         ++sequence;
     }
 
+    _jobCount = sequence;
     LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() <<" total jobs in query=" << sequence);
 
     // we only care about per-chunk info for ASYNC queries, and
@@ -247,6 +245,7 @@ void UserQuerySelect::submit() {
 /// @return the QueryState indicating success or failure
 QueryState UserQuerySelect::join() {
     bool successful = _executive->join(); // Wait for all data
+    _reportDispatch();
     _infileMerger->finalize(); // Since all data are in, run final SQL commands like GROUP BY.
     _discardMerger();
     if (successful) {
@@ -260,6 +259,21 @@ QueryState UserQuerySelect::join() {
     }
 }
 
+/// Log how long after submit() the first job was handed to XrdSsi, and
+/// add it to the query messages.
+void UserQuerySelect::_reportDispatch() {
+    auto const firstDispatch = _executive->getFirstDispatchTime();
+    if (firstDispatch == std::chrono::steady_clock::time_point()) {
+        return;
+    }
+    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        firstDispatch - _submitTime).count();
+    std::string msg = "Dispatched " + std::to_string(_jobCount) + " jobs, the first "
+        + std::to_string(ms) + " ms after submission";
+    LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " " << msg);
+    _messageStore->addMessage(NOTSET, ccontrol::MSG_FIRST_DISPATCH, msg);
+}
+
 /// Release resources held by the merger
 void UserQuerySelect::_discardMerger() {
     _infileMergerConfig.reset();
@@ -311,13 +325,10 @@ void UserQuerySelect::setupChunking() {
         throw UserQueryError(getQueryIdString() + " Couldn't determine dominantDb for dispatch");
     }
 
-    std::shared_ptr<IntSet const> eSet = _qSession->getEmptyChunks();
-    {
-        eSet = _qSession->getEmptyChunks();
-        if (!eSet) {
-            eSet = std::make_shared<IntSet>();
-            LOGS(_log, LOG_LVL_WARN, getQueryIdString() << " Missing empty chunks info for " << dominantDb);
-        }
+    css::ChunkBitmap::Ptr eSet = _qSession->getEmptyChunks();
+    if (!eSet) {
+        eSet = css::ChunkBitmap::build({});
+        LOGS(_log, LOG_LVL_WARN, getQueryIdString() << " Missing empty chunks info for " << dominantDb);
     }
     // FIXME add operator<< for QuerySession
     LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " _qSession: " << _qSession);
@@ -325,7 +336,12 @@ void UserQuerySelect::setupChunking() {
         std::shared_ptr<query::ConstraintVector> constraints = _qSession->getConstraints();
         css::StripingParams partStriping = _qSession->getDbStriping();
 
-        im = std::make_shared<qproc::IndexMap>(partStriping, _secondaryIndex);
+        // IndexMap leaves out empty chunks
+        qproc::ChunkCoverage::Ptr coverage;
+        if (_chunkCoverage) {
+            coverage = _chunkCoverage->get(partStriping);
+        }
+        im = std::make_shared<qproc::IndexMap>(partStriping, _secondaryIndex, eSet, coverage);
         qproc::ChunkSpecVector csv;
         if (constraints) {
             csv = im->getChunks(*constraints);
@@ -334,13 +350,8 @@ void UserQuerySelect::setupChunking() {
         }
 
         LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " Chunk specs: " << util::printable(csv));
-        // Filter out empty chunks
-        for(qproc::ChunkSpecVector::const_iterator i=csv.begin(), e=csv.end();
-            i != e;
-            ++i) {
-            if (eSet->count(i->chunkId) == 0) { // chunk not in empty?
-                _qSession->addChunk(*i);
-            }
+        for (auto const& chunkSpec : csv) {
+            _qSession->addChunk(chunkSpec);
         }
     } else {
         LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " No chunks added, QuerySession will add dummy chunk");
@@ -354,17 +365,14 @@ void UserQuerySelect::_qMetaRegister()
     std::string user = "anonymous";    // we do not have access to that info yet
 
     std::string qTemplate;
-    auto const& stmtVector = _qSession->getStmtParallel();
-    for (auto itr = stmtVector.begin(); itr != stmtVector.end(); ++ itr) {
-        auto stmt = *itr;
-        if (stmt) {
-            if (not qTemplate.empty()) {
-                // if there is more than one statement separate them by
-                // special token
-                qTemplate += " /*QSEPARATOR*/; ";
-            }
-            qTemplate += stmt->getQueryTemplate().sqlFragment();
+    auto const& templates = _qSession->getParallelTemplates();
+    for (auto itr = templates.begin(); itr != templates.end(); ++ itr) {
+        if (not qTemplate.empty()) {
+            // if there is more than one statement separate them by
+            // special token
+            qTemplate += " /*QSEPARATOR*/; ";
         }
+        qTemplate += itr->sqlFragment();
     }
 
     std::string qMerge;
@@ -32,6 +32,7 @@
   */
 
 // System headers
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -57,6 +58,7 @@ namespace qmeta {
 class QMeta;
 }
 namespace qproc {
+class ChunkCoverageMap;
 class QuerySession;
 class SecondaryIndex;
 }
@@ -119,11 +121,18 @@ public:
     /// Add a chunk for later execution
     void addChunk(qproc::ChunkSpec const& cs);
 
+    /// Compute the chunks of spatial constraints with chunkCoverage, with
+    /// sphgeom if nullptr.
+    void setChunkCoverage(std::shared_ptr<qproc::ChunkCoverageMap> const& chunkCoverage) {
+        _chunkCoverage = chunkCoverage;
+    }
+
     void setupChunking();
 
 private:
     void _setupMerger();
     void _discardMerger();
+    void _reportDispatch();
     void _qMetaRegister();
     void _qMetaUpdateStatus(qmeta::QInfo::QStatus qStatus);
     void _qMetaAddChunks(std::vector<int> const& chunks);
@@ -135,6 +144,7 @@ private:
     std::shared_ptr<rproc::InfileMergerConfig> _infileMergerConfig;
     std::shared_ptr<rproc::InfileMerger> _infileMerger;
     std::shared_ptr<qproc::SecondaryIndex> _secondaryIndex;
+    std::shared_ptr<qproc::ChunkCoverageMap> _chunkCoverage;
     std::shared_ptr<qmeta::QMeta> _queryMetadata;
 
     qmeta::CzarId _qMetaCzarId;     ///< Czar ID in QMeta database
@@ -145,6 +155,8 @@ private:
     std::mutex _killMutex;
     std::string _errorExtra;        ///< Additional error information
     std::string _resultTable;       ///< Result table name
+    std::chrono::steady_clock::time_point _submitTime; ///< When submit() began
+    int _jobCount{0};               ///< Jobs submitted
 };
 
 }}} // namespace lsst::qserv:ccontrol
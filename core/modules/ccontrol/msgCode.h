@@ -33,6 +33,7 @@ namespace ccontrol {
 // Codes for czar C++ layer are >= 1000.
 // (<1000 reserved for Python layer.)
 const int MSG_MGR_ADD       = 1200;
+const int MSG_FIRST_DISPATCH = 1210;
 const int MSG_XRD_OPEN_FAIL = 1290;
 const int MSG_XRD_WRITE     = 1300;
 const int MSG_XRD_READ      = 1400;
@@ -0,0 +1,185 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "css/ChunkBitmap.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <sys/stat.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "util/MappedFile.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.css.ChunkBitmap");
+
+using lsst::qserv::util::MappedFile;
+
+char const MAGIC[MappedFile::MAGIC_SIZE] = {'Q', 'S', 'E', 'M', 'P', 'T', 'Y', '2'};
+
+/// The start of a chunk bitmap file, followed by the words of the bitmap.
+struct FileHeader {
+    char magic[MappedFile::MAGIC_SIZE];
+    std::uint64_t wordCount;
+    std::uint64_t size;
+    std::uint64_t sourceSize;
+    std::int64_t sourceMtimeNs;
+};
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+ChunkBitmap::Ptr ChunkBitmap::build(std::vector<int> const& chunks) {
+    int maxChunk = -1;
+    for (int chunk : chunks) {
+        if (chunk < 0 || chunk > MAX_CHUNK_ID) {
+            throw std::out_of_range("ChunkBitmap: chunk id out of range: " + std::to_string(chunk));
+        }
+        maxChunk = std::max(maxChunk, chunk);
+    }
+    auto words = std::make_shared<std::vector<std::uint64_t>>((maxChunk + 64) / 64, 0);
+    std::shared_ptr<ChunkBitmap> bitmap(new ChunkBitmap());
+    for (int chunk : chunks) {
+        std::uint64_t& word = (*words)[chunk >> 6];
+        std::uint64_t const bit = std::uint64_t(1) << (chunk & 63);
+        bitmap->_size += (word & bit) == 0;
+        word |= bit;
+    }
+    bitmap->_words = words->data();
+    bitmap->_wordCount = words->size();
+    bitmap->_storage = words;
+    return bitmap;
+}
+
+
+ChunkBitmap::Ptr ChunkBitmap::readText(std::string const& path) {
+    // The file is stat'ed first, so that a change while reading it makes
+    // the source recorded out of date rather than unnoticed.
+    Source source;
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!statSource(path, source) || !in.good()) {
+        throw std::runtime_error(util::errnoText("ChunkBitmap: cannot open", path));
+    }
+    std::string const text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<int> chunks;
+    std::uint64_t skipped = 0;
+    char const* pos = text.c_str();
+    while (true) {
+        while (std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+        char* end;
+        long const chunk = std::strtol(pos, &end, 10);
+        if (end == pos) {
+            break;
+        }
+        if (chunk < 0 || chunk > MAX_CHUNK_ID) {
+            if (skipped++ == 0) {
+                LOGS(_log, LOG_LVL_WARN, "ChunkBitmap: skipped chunk id " << std::string(pos, end - pos)
+                     << " out of range in " << path);
+            }
+        } else {
+            chunks.push_back(static_cast<int>(chunk));
+        }
+        pos = end;
+    }
+    if (skipped > 1) {
+        LOGS(_log, LOG_LVL_WARN, "ChunkBitmap: skipped " << skipped << " chunk ids out of range in "
+             << path);
+    }
+    if (*pos != '\0') {
+        LOGS(_log, LOG_LVL_WARN, "ChunkBitmap: ignored text after chunk " << chunks.size() + skipped
+             << " of " << path);
+    }
+    auto bitmap = std::const_pointer_cast<ChunkBitmap>(build(chunks));
+    bitmap->_source = source;
+    return bitmap;
+}
+
+
+bool ChunkBitmap::statSource(std::string const& path, Source& source) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    source.size = st.st_size;
+    source.mtimeNs = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+
+ChunkBitmap::Ptr ChunkBitmap::load(std::string const& path) {
+    auto file = MappedFile::map(path, "ChunkBitmap");
+    FileHeader const* header = reinterpret_cast<FileHeader const*>(file->data());
+    if (!file->hasHeader(MAGIC, sizeof(FileHeader))
+        || header->wordCount > (MAX_CHUNK_ID / 64 + 1)
+        || sizeof(FileHeader) + 8 * header->wordCount != file->size()) {
+        throw std::runtime_error("ChunkBitmap: " + path + " is not a chunk bitmap file");
+    }
+    std::shared_ptr<ChunkBitmap> bitmap(new ChunkBitmap());
+    bitmap->_words = reinterpret_cast<std::uint64_t const*>(file->data() + sizeof(FileHeader));
+    bitmap->_wordCount = header->wordCount;
+    bitmap->_size = header->size;
+    bitmap->_source.size = header->sourceSize;
+    bitmap->_source.mtimeNs = header->sourceMtimeNs;
+    bitmap->_storage = file;
+    LOGS(_log, LOG_LVL_DEBUG, "ChunkBitmap mapped " << path << " chunks=" << bitmap->_size);
+    return bitmap;
+}
+
+
+void ChunkBitmap::save(std::string const& path) const {
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.wordCount = _wordCount;
+    header.size = _size;
+    header.sourceSize = _source.size;
+    header.sourceMtimeNs = _source.mtimeNs;
+    MappedFile::save(path, {{&header, sizeof(header)}, {_words, 8 * _wordCount}}, "ChunkBitmap");
+}
+
+
+std::vector<int> ChunkBitmap::getChunks() const {
+    std::vector<int> chunks;
+    chunks.reserve(_size);
+    for (std::uint64_t w = 0; w < _wordCount; ++w) {
+        for (std::uint64_t word = _words[w]; word != 0; word &= word - 1) {
+            chunks.push_back(static_cast<int>(64 * w + __builtin_ctzll(word)));
+        }
+    }
+    return chunks;
+}
+
+}}} // namespace lsst::qserv::css
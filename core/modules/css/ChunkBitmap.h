@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CSS_CHUNKBITMAP_H
+#define LSST_QSERV_CSS_CHUNKBITMAP_H
+
+// System headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+/// ChunkBitmap is an immutable set of chunk ids, held as one bit per chunk
+/// id from 0 to the largest in the set. Chunk ids of a partitioning are
+/// dense, so this takes a few tens of kilobytes for all chunks of a
+/// partitioning, and a lookup is one bit test.
+///
+/// save() writes the bits to a file that load() maps back without parsing.
+/// A set read by readText() remembers the size and modification time of its
+/// text file, kept through save() and load(), so that a saved copy can be
+/// checked against the text it came from.
+class ChunkBitmap {
+public:
+    using Ptr = std::shared_ptr<ChunkBitmap const>;
+
+    /// Size and modification time of a text file.
+    struct Source {
+        std::uint64_t size = 0;
+        std::int64_t mtimeNs = 0; ///< Nanoseconds since the epoch
+
+        bool operator==(Source const& other) const {
+            return size == other.size && mtimeNs == other.mtimeNs;
+        }
+        bool operator!=(Source const& other) const { return !(*this == other); }
+    };
+
+    /// Largest chunk id accepted, to bound memory use.
+    static int const MAX_CHUNK_ID = (1 << 28) - 1;
+
+    /// @return the set of chunks.
+    /// @throws std::out_of_range if a chunk id is negative or above MAX_CHUNK_ID.
+    static Ptr build(std::vector<int> const& chunks);
+
+    /// @return the set of chunk ids in text file path, separated by white
+    ///         space. Reading stops at the first word that is not a number.
+    ///         Chunk ids that are negative or above MAX_CHUNK_ID are logged
+    ///         and skipped.
+    /// @throws std::runtime_error if path cannot be read.
+    static Ptr readText(std::string const& path);
+
+    /// @return true if text file path exists, with its size and
+    ///         modification time in source.
+    static bool statSource(std::string const& path, Source& source);
+
+    /// @return the set in file path, written by save(). The file is mapped
+    ///         into memory and must not be modified while in use.
+    /// @throws std::runtime_error if path cannot be mapped or is not a
+    ///         chunk bitmap file.
+    static Ptr load(std::string const& path);
+
+    /// Write the set to path, through a temporary file renamed to path, so
+    /// that readers never see a partial file.
+    /// @throws std::runtime_error on failure.
+    void save(std::string const& path) const;
+
+    bool contains(int chunkId) const {
+        return chunkId >= 0 && static_cast<std::uint64_t>(chunkId) < 64 * _wordCount
+            && (_words[chunkId >> 6] >> (chunkId & 63) & 1) != 0;
+    }
+
+    /// @return the number of chunks in the set.
+    std::uint64_t size() const { return _size; }
+
+    /// @return the text file the set was read from, as when readText()
+    ///         started, or zeros for a set from build().
+    Source const& getSource() const { return _source; }
+
+    /// @return the chunks in the set, in increasing order.
+    std::vector<int> getChunks() const;
+
+private:
+    ChunkBitmap() = default;
+
+    std::uint64_t const* _words = nullptr;
+    std::uint64_t _wordCount = 0;
+    std::uint64_t _size = 0;
+    Source _source;
+    std::shared_ptr<void const> _storage; ///< Owns _words, in memory or mapped
+};
+
+}}} // namespace lsst::qserv::css
+
+#endif // LSST_QSERV_CSS_CHUNKBITMAP_H
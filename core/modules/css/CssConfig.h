@@ -100,6 +100,17 @@ public:
         return _technology;
     }
 
+    /* Get interval between checks for changes of "mysql" CSS
+     *
+     * When positive, reads are answered from an in-memory snapshot of CSS,
+     * refreshed when it changes.
+     *
+     * @return interval in seconds, 0 to read from mysql on every call
+     */
+    int getSnapshotSeconds() const {
+        return _snapshotSeconds;
+    }
+
 private:
 
     CssConfig(util::ConfigStore const& configStore);
@@ -112,6 +123,7 @@ private:
 
     // used by "mysql" technology
     mysql::MySqlConfig const _mySqlConfig;
+    int const _snapshotSeconds;
 
 };
 
@@ -25,11 +25,8 @@
 #include "css/EmptyChunks.h"
 
 // System headers
-#include <algorithm>
-#include <iterator>
-#include <fstream>
-#include <functional>
-#include <memory>
+#include <stdexcept>
+#include <unistd.h>
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -39,7 +36,7 @@
 #include "global/stringUtil.h"
 
 using lsst::qserv::ConfigError;
-using lsst::qserv::IntSet;
+using lsst::qserv::css::ChunkBitmap;
 
 namespace {
 
@@ -50,27 +47,70 @@ makeFilename(std::string const& db) {
     return "empty_" + lsst::qserv::sanitizeName(db) + ".txt";
 }
 
-void
+/// @return the path of the binary sidecar of text file textPath.
+std::string
+sidecarPath(std::string const& textPath) {
+    std::string const suffix = ".txt";
+    if (textPath.size() > suffix.size()
+        && textPath.compare(textPath.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return textPath.substr(0, textPath.size() - suffix.size()) + ".bin";
+    }
+    return textPath + ".bin";
+}
+
+/// @return the chunks listed in textPath, or in its sidecar if that was
+///         made from the text as it is, nullptr if neither exists.
+ChunkBitmap::Ptr
+readFile(std::string const& textPath) {
+    std::string const binPath = sidecarPath(textPath);
+    ChunkBitmap::Source textSource;
+    bool const hasText = ChunkBitmap::statSource(textPath, textSource);
+    if (::access(binPath.c_str(), F_OK) == 0) {
+        try {
+            LOGS(_log, LOG_LVL_DEBUG, "Mapping empty chunks from file " << binPath);
+            auto bitmap = ChunkBitmap::load(binPath);
+            if (!hasText || bitmap->getSource() == textSource) {
+                return bitmap;
+            }
+            LOGS(_log, LOG_LVL_DEBUG, "Sidecar " << binPath << " is out of date");
+        } catch (std::exception const& exc) {
+            LOGS(_log, LOG_LVL_WARN, exc.what());
+        }
+    }
+    if (!hasText) {
+        return nullptr;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "Reading empty chunks from file " << textPath);
+    auto bitmap = ChunkBitmap::readText(textPath);
+    try {
+        bitmap->save(binPath);
+    } catch (std::exception const& exc) {
+        // e.g. the directory is read-only, the text is read again next time.
+        LOGS(_log, LOG_LVL_DEBUG, "No sidecar for " << textPath << ": " << exc.what());
+    }
+    return bitmap;
+}
+
+ChunkBitmap::Ptr
 populate(std::string const& path,
          std::string const& fallbackFile,
-         IntSet& s,
          std::string const& db) {
     std::string const best = path + "/" + makeFilename(db);
-    std::string fileName = best;
-    std::ifstream rawStream(best.c_str());
-    if (!rawStream.good()) { // On error, try using default filename
-        rawStream.close();
-        rawStream.open(fallbackFile.c_str());
-        fileName = fallbackFile;
+    LOGS(_log, LOG_LVL_DEBUG, "Reading empty chunks for db " << db);
+    ChunkBitmap::Ptr bitmap;
+    try {
+        bitmap = readFile(best);
+        if (!bitmap) { // On error, try using default filename
+            bitmap = readFile(fallbackFile);
+        }
+    } catch (std::runtime_error const& exc) {
+        throw ConfigError(exc.what());
     }
-    LOGS(_log, LOG_LVL_DEBUG, "Reading empty chunks for db " << db << " from file " << fileName);
-    if (!rawStream.good()) {
+    if (!bitmap) {
         throw ConfigError("No such empty chunks file: " + best
                           + " or " + fallbackFile);
     }
-    std::istream_iterator<int> chunkStream(rawStream);
-    std::istream_iterator<int> eos;
-    std::copy(chunkStream, eos, std::insert_iterator<IntSet>(s, s.begin()));
+    return bitmap;
 }
 } // anonymous namespace
 
@@ -78,28 +118,29 @@ namespace lsst {
 namespace qserv {
 namespace css {
 
-std::shared_ptr<IntSet const>
+ChunkBitmap::Ptr
 EmptyChunks::getEmpty(std::string const& db) const {
     std::lock_guard<std::mutex> lock(_setsMutex);
-    IntSetMap::const_iterator i = _sets.find(db);
+    BitmapMap::const_iterator i = _sets.find(db);
     if (i != _sets.end()) {
-        IntSetConstPtr readOnly = i->second;
-        return readOnly;
+        return i->second;
     }
-    IntSetPtr newSet = std::make_shared<IntSet>();
-    _sets.insert(IntSetMap::value_type(db, newSet));
-    populate(_path, _fallbackFile, *newSet, db); // Populate reference
-    return IntSetConstPtr(newSet);
+    // As an unreadable file used to, it fails the first call only, later
+    // calls find no empty chunks.
+    _sets.insert(BitmapMap::value_type(db, ChunkBitmap::build({})));
+    ChunkBitmap::Ptr bitmap = populate(_path, _fallbackFile, db);
+    _sets[db] = bitmap;
+    return bitmap;
 }
 
 bool
 EmptyChunks::isEmpty(std::string const& db, int chunk) const {
-    IntSetConstPtr s = getEmpty(db);
-    return s->end() != s->find(chunk);
+    return getEmpty(db)->contains(chunk);
 }
 
 void
 EmptyChunks::clearCache(std::string const& db) const {
+    std::lock_guard<std::mutex> lock(_setsMutex);
     if (db.empty()) {
         LOGS(_log, LOG_LVL_DEBUG, "Clearing empty chunks cache for all databases");
         _sets.clear();
@@ -40,7 +40,7 @@
 #include <string>
 
 // Qserv headers
-#include "global/intTypes.h"
+#include "css/ChunkBitmap.h"
 
 namespace lsst {
 namespace qserv {
@@ -51,6 +51,11 @@ namespace css {
 /// per-partitioning-group scheme, at which point, we will re-think
 /// the db-based dispatch as well (user tables in the partitioning
 /// group may be extremely sparse).
+///
+/// The empty chunks of db are read from empty_<db>.txt, a list of chunk ids,
+/// or from its binary sidecar empty_<db>.bin when that records the size and
+/// modification time the text file has. The sidecar is written after the
+/// text is read, if the directory is writable.
 class EmptyChunks {
 public:
     EmptyChunks(std::string const& path=".",
@@ -60,7 +65,7 @@ public:
     // accessors
 
     /// @return set of empty chunks for this db
-    std::shared_ptr<IntSet const> getEmpty(std::string const& db) const;
+    ChunkBitmap::Ptr getEmpty(std::string const& db) const;
 
     /// @return true if db/chunk is empty
     bool isEmpty(std::string const& db, int chunk) const;
@@ -72,14 +77,10 @@ public:
 
 private:
 
-    // Convenience types
-    typedef std::shared_ptr<IntSet> IntSetPtr;
-    typedef std::shared_ptr<IntSet const> IntSetConstPtr;
-
-    typedef std::map<std::string, IntSetPtr> IntSetMap;
+    typedef std::map<std::string, ChunkBitmap::Ptr> BitmapMap;
     std::string _path; ///< Search path for empty chunks files
     std::string _fallbackFile; ///< Fallback path for empty chunks
-    mutable IntSetMap _sets; ///< Container for empty chunks sets (cache)
+    mutable BitmapMap _sets; ///< Container for empty chunks sets (cache)
     mutable std::mutex _setsMutex;
 };
 
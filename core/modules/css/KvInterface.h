@@ -144,6 +144,23 @@ public:
      */
     virtual std::string dumpKV() = 0;
 
+    /**
+     *  Returns all keys with their values, the root key as "/".
+     *
+     *  Unlike dumpKV() this does not restrict values, and is meant for
+     *  in-memory copies of CSS, see KvInterfaceImplSnapshot.
+     *  @throws CssError for problems (e.g., a connection error is detected).
+     */
+    virtual std::map<std::string, std::string> getAll() = 0;
+
+    /**
+     *  Returns a fingerprint of the complete CSS contents, which changes
+     *  whenever a key is created, set or deleted. It is much cheaper to get
+     *  than the contents.
+     *  @throws CssError for problems (e.g., a connection error is detected).
+     */
+    virtual std::string getFingerprint() = 0;
+
 protected:
     KvInterface() {}
     virtual std::string _get(std::string const& key,
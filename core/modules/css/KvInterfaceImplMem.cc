@@ -124,6 +124,7 @@ KvInterfaceImplMem::create(string const& key, string const& value, bool unique)
     }
     // store the key with value
     _kvMap[path] = value;
+    ++_changes;
     return path;
 }
 
@@ -146,6 +147,7 @@ KvInterfaceImplMem::set(string const& key, string const& value) {
     }
 
     _kvMap[key] = value;
+    ++_changes;
 }
 
 bool
@@ -172,13 +174,15 @@ KvInterfaceImplMem::_get(string const& key,
                          string const& defaultValue,
                          bool throwIfKeyNotFound) {
     LOGS(_log, LOG_LVL_DEBUG, "get(" << key << ")");
-    if ( !exists(key) ) {
+    // find() rather than operator[], so that concurrent readers are safe
+    auto iter = _kvMap.find(key);
+    if (iter == _kvMap.end()) {
         if (throwIfKeyNotFound) {
             throw NoSuchKey(key);
         }
         return defaultValue;
     }
-    string s = _kvMap[key];
+    string const& s = iter->second;
     LOGS(_log, LOG_LVL_DEBUG, "got: '" << s << "'");
     return s;
 }
@@ -244,6 +248,7 @@ KvInterfaceImplMem::deleteKey(string const& key) {
     }
     LOGS(_log, LOG_LVL_DEBUG, "deleteKey: erasing key " << key);
     _kvMap.erase(iter);
+    ++_changes;
     // delete all children keys, not very efficient but we don't care
     std::string const keyPfx = key + "/";
     for (auto iter = _kvMap.begin(); iter != _kvMap.end(); ) {
@@ -275,6 +280,16 @@ std::string KvInterfaceImplMem::dumpKV() {
     return result;
 }
 
+std::map<std::string, std::string>
+KvInterfaceImplMem::getAll() {
+    return _kvMap;
+}
+
+std::string
+KvInterfaceImplMem::getFingerprint() {
+    return std::to_string(_changes);
+}
+
 void KvInterfaceImplMem::_init(std::istream& mapStream) {
     if (mapStream.fail()) {
         throw ConnError();
@@ -52,6 +52,8 @@ public:
     explicit KvInterfaceImplMem(bool readOnly=false) : _readOnly(readOnly) {}
     explicit KvInterfaceImplMem(std::istream& mapStream, bool readOnly=false);
     explicit KvInterfaceImplMem(std::string const& filename, bool readOnly=false);
+    explicit KvInterfaceImplMem(std::map<std::string, std::string> const& kvMap, bool readOnly=false)
+        : _kvMap(kvMap), _readOnly(readOnly) {}
 
     virtual ~KvInterfaceImplMem();
 
@@ -64,6 +66,8 @@ public:
     virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) override;
     virtual void deleteKey(std::string const& key) override;
     virtual std::string dumpKV() override;
+    virtual std::map<std::string, std::string> getAll() override;
+    virtual std::string getFingerprint() override;
 
     std::shared_ptr<KvInterfaceImplMem> clone() const;
 
@@ -76,6 +80,7 @@ private:
     void _init(std::istream& mapStream);
     std::map<std::string, std::string> _kvMap;
     bool _readOnly;
+    unsigned long long _changes = 0; ///< Number of changes, the fingerprint
 };
 
 }}} // namespace lsst::qserv::css
@@ -580,6 +580,63 @@ std::string KvInterfaceImplMySql::dumpKV() {
 }
 
 
+std::map<std::string, std::string>
+KvInterfaceImplMySql::getAll() {
+
+    std::string query = "SELECT kvKey, kvVal FROM kvData";
+
+    // run query
+    KvTransaction transaction(_conn);
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    LOGS(_log, LOG_LVL_DEBUG, "getAll - executing query: " << query);
+    if (not _conn.runQuery(query, results, errObj)) {
+        std::stringstream ss;
+        ss << "getAll - " << query << " failed with err: " << errObj.errMsg() << std::ends;
+        LOGS(_log, LOG_LVL_ERROR, ss.str());
+        throw CssError(ss.str());
+    }
+
+    // copy results, root key is stored as empty string
+    std::map<std::string, std::string> res;
+    for (auto& row: results) {
+        std::string key = row[0].first;
+        if (key.empty()) key = "/";
+        res.insert(std::make_pair(key, row[1].first ? row[1].first : ""));
+    }
+
+    transaction.commit();
+    return res;
+}
+
+
+std::string
+KvInterfaceImplMySql::getFingerprint() {
+
+    std::string query = "SELECT COUNT(*), COALESCE(SUM(CRC32(CONCAT(kvKey, '\\t', kvVal))), 0) FROM kvData";
+
+    // run query
+    KvTransaction transaction(_conn);
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    LOGS(_log, LOG_LVL_DEBUG, "getFingerprint - executing query: " << query);
+    if (not _conn.runQuery(query, results, errObj)) {
+        std::stringstream ss;
+        ss << "getFingerprint - " << query << " failed with err: " << errObj.errMsg() << std::ends;
+        LOGS(_log, LOG_LVL_ERROR, ss.str());
+        throw CssError(ss.str());
+    }
+
+    std::string fingerprint;
+    for (auto& row: results) {
+        fingerprint = std::string(row[0].first ? row[0].first : "") + ":" + (row[1].first ? row[1].first : "");
+    }
+
+    transaction.commit();
+    return fingerprint;
+}
+
+
 void
 KvInterfaceImplMySql::_delete(std::string const& key, KvTransaction const& transaction) {
     if (not transaction.isActive()) {
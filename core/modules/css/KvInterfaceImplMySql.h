@@ -75,6 +75,14 @@ public:
 
     virtual std::string dumpKV() override;
 
+    virtual std::map<std::string, std::string> getAll() override;
+
+    /**
+     * The fingerprint is the number of keys and a sum of checksums of the
+     * keys with their values, one query on the small kvData table.
+     */
+    virtual std::string getFingerprint() override;
+
 protected:
     virtual std::string _get(std::string const& key,
                              std::string const& defaultValue,
@@ -0,0 +1,189 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "css/KvInterfaceImplSnapshot.h"
+
+// System headers
+#include <exception>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "css/KvInterfaceImplMem.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.css.KvInterfaceImplSnapshot");
+
+}
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+KvInterfaceImplSnapshot::KvInterfaceImplSnapshot(std::shared_ptr<KvInterface> const& backing,
+                                                 std::chrono::milliseconds refreshInterval)
+    : _backing(backing), _refreshInterval(refreshInterval) {
+    {
+        std::lock_guard<std::mutex> lock(_backingMtx);
+        _refresh();
+    }
+    if (_refreshInterval.count() > 0) {
+        _refresher = std::thread(&KvInterfaceImplSnapshot::_refreshLoop, this);
+    }
+}
+
+KvInterfaceImplSnapshot::~KvInterfaceImplSnapshot() {
+    {
+        std::lock_guard<std::mutex> lock(_stopMtx);
+        _stop = true;
+    }
+    _stopCv.notify_all();
+    if (_refresher.joinable()) {
+        _refresher.join();
+    }
+}
+
+std::string
+KvInterfaceImplSnapshot::create(std::string const& key, std::string const& value, bool unique) {
+    std::lock_guard<std::mutex> lock(_backingMtx);
+    std::string const path = _backing->create(key, value, unique);
+    _refreshAfterWrite();
+    return path;
+}
+
+void
+KvInterfaceImplSnapshot::set(std::string const& key, std::string const& value) {
+    std::lock_guard<std::mutex> lock(_backingMtx);
+    _backing->set(key, value);
+    _refreshAfterWrite();
+}
+
+bool
+KvInterfaceImplSnapshot::exists(std::string const& key) {
+    return _current()->kv->exists(key);
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getMany(std::vector<std::string> const& keys) {
+    return _current()->kv->getMany(keys);
+}
+
+std::vector<std::string>
+KvInterfaceImplSnapshot::getChildren(std::string const& key) {
+    return _current()->kv->getChildren(key);
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getChildrenValues(std::string const& key) {
+    return _current()->kv->getChildrenValues(key);
+}
+
+void
+KvInterfaceImplSnapshot::deleteKey(std::string const& key) {
+    std::lock_guard<std::mutex> lock(_backingMtx);
+    _backing->deleteKey(key);
+    _refreshAfterWrite();
+}
+
+std::string
+KvInterfaceImplSnapshot::dumpKV() {
+    return _current()->kv->dumpKV();
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getAll() {
+    return _current()->kv->getAll();
+}
+
+std::string
+KvInterfaceImplSnapshot::getFingerprint() {
+    return _current()->fingerprint;
+}
+
+bool
+KvInterfaceImplSnapshot::refresh() {
+    std::lock_guard<std::mutex> lock(_backingMtx);
+    return _refresh();
+}
+
+std::string
+KvInterfaceImplSnapshot::_get(std::string const& key,
+                              std::string const& defaultValue,
+                              bool throwIfKeyNotFound) {
+    auto version = _current();
+    return throwIfKeyNotFound ? version->kv->get(key) : version->kv->get(key, defaultValue);
+}
+
+std::shared_ptr<KvInterfaceImplSnapshot::Version const>
+KvInterfaceImplSnapshot::_current() const {
+    return std::atomic_load(&_version);
+}
+
+bool
+KvInterfaceImplSnapshot::_refresh() {
+    // A change between the two calls leaves a copy newer than its
+    // fingerprint, which only costs one more copy on the next check.
+    std::string fingerprint = _backing->getFingerprint();
+    auto current = _current();
+    if (current != nullptr && current->fingerprint == fingerprint) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto version = std::make_shared<Version>();
+    version->kv = std::make_shared<KvInterfaceImplMem>(_backing->getAll(), true);
+    version->fingerprint = fingerprint;
+    std::atomic_store(&_version, std::shared_ptr<Version const>(version));
+    std::chrono::duration<double, std::milli> const took = std::chrono::steady_clock::now() - start;
+    LOGS(_log, LOG_LVL_INFO, "New CSS snapshot, fingerprint=" << fingerprint
+         << " took " << took.count() << "ms");
+    return true;
+}
+
+void
+KvInterfaceImplSnapshot::_refreshAfterWrite() {
+    try {
+        _refresh();
+    } catch (std::exception const& exc) {
+        // The write is done, the refresher thread takes the copy later.
+        LOGS(_log, LOG_LVL_WARN, "Failed to refresh CSS snapshot after write: " << exc.what());
+    }
+}
+
+void
+KvInterfaceImplSnapshot::_refreshLoop() {
+    std::unique_lock<std::mutex> lock(_stopMtx);
+    while (not _stopCv.wait_for(lock, _refreshInterval, [this] { return _stop; })) {
+        lock.unlock();
+        try {
+            refresh();
+        } catch (std::exception const& exc) {
+            LOGS(_log, LOG_LVL_WARN, "Failed to refresh CSS snapshot, keeping the old one: " << exc.what());
+        }
+        lock.lock();
+    }
+}
+
+}}} // namespace lsst::qserv::css
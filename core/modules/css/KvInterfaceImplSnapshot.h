@@ -0,0 +1,139 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief Interface to the Common State System - in memory snapshot of
+  * another implementation, refreshed when it changes.
+  */
+
+#ifndef LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
+#define LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Local headers
+#include "css/KvInterface.h"
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+class KvInterfaceImplMem;
+
+/**
+ *  KvInterfaceImplSnapshot answers reads from an immutable in-memory copy of
+ *  the complete contents of another KvInterface, e.g. of the MySQL one, so
+ *  that reads make no round trips.
+ *
+ *  The copy is taken with one getAll() call. A background thread compares
+ *  the fingerprint of the backing store to that of the copy every
+ *  refreshInterval, and swaps in a new copy when they differ. Readers take
+ *  the current copy without locking and keep it for the duration of a call.
+ *  Writes go to the backing store, and the copy is refreshed right after
+ *  them, so a writer reads its own writes.
+ */
+class KvInterfaceImplSnapshot : public KvInterface {
+public:
+
+    /**
+     *  @param backing: store copied, also used for writes.
+     *  @param refreshInterval: time between checks for changes of backing,
+     *         zero for no background refresh.
+     *  @throws CssError if the first copy cannot be taken.
+     */
+    KvInterfaceImplSnapshot(std::shared_ptr<KvInterface> const& backing,
+                            std::chrono::milliseconds refreshInterval);
+
+    virtual ~KvInterfaceImplSnapshot();
+
+    KvInterfaceImplSnapshot(KvInterfaceImplSnapshot const&) = delete;
+    KvInterfaceImplSnapshot& operator=(KvInterfaceImplSnapshot const&) = delete;
+
+    virtual std::string create(std::string const& key, std::string const& value,
+                               bool unique=false) override;
+    virtual void set(std::string const& key, std::string const& value) override;
+    virtual bool exists(std::string const& key) override;
+    virtual std::map<std::string, std::string> getMany(std::vector<std::string> const& keys) override;
+    virtual std::vector<std::string> getChildren(std::string const& key) override;
+    virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) override;
+    virtual void deleteKey(std::string const& key) override;
+    virtual std::string dumpKV() override;
+    virtual std::map<std::string, std::string> getAll() override;
+    virtual std::string getFingerprint() override;
+
+    /**
+     *  Take a new copy of the backing store if its fingerprint changed.
+     *
+     *  @return true if a new copy was taken.
+     *  @throws CssError if the backing store cannot be read.
+     */
+    bool refresh();
+
+protected:
+    virtual std::string _get(std::string const& key,
+                             std::string const& defaultValue,
+                             bool throwIfKeyNotFound) override;
+
+private:
+    /// A copy of the backing store, never modified once built.
+    struct Version {
+        std::shared_ptr<KvInterfaceImplMem> kv;
+        std::string fingerprint;
+    };
+
+    std::shared_ptr<Version const> _current() const;
+
+    /// Take a new copy if the fingerprint changed. _backingMtx must be held.
+    bool _refresh();
+
+    /// Refresh after a write, logging failures instead of throwing them.
+    void _refreshAfterWrite();
+
+    void _refreshLoop();
+
+    std::shared_ptr<KvInterface> const _backing;
+    std::chrono::milliseconds const _refreshInterval;
+
+    std::mutex _backingMtx; ///< Serializes use of _backing, which is not thread safe
+
+    std::shared_ptr<Version const> _version; ///< Accessed only with std::atomic_load/store
+
+    std::mutex _stopMtx;
+    std::condition_variable _stopCv;
+    bool _stop = false; ///< Protected by _stopMtx
+    std::thread _refresher;
+};
+
+}}} // namespace lsst::qserv::css
+
+#endif // LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
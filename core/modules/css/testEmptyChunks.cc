@@ -23,11 +23,18 @@
 
 // System headers
 #include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <ctime>
+#include <stdexcept>
+#include <sys/time.h>
 #include <unistd.h>
 
 // Third-party headers
 
 // Local headers
+#include "css/ChunkBitmap.h"
 #include "css/EmptyChunks.h"
 
 
@@ -37,6 +44,7 @@
 
 namespace test = boost::test_tools;
 
+using lsst::qserv::css::ChunkBitmap;
 using lsst::qserv::css::EmptyChunks;
 
 struct DummyFile {
@@ -91,6 +99,13 @@ struct DummyFile {
         }
         os.close();
     }
+    void setAge(char const* dbname, int seconds) {
+        std::string filename = _path + "/empty_" + dbname + ".txt";
+        struct timeval times[2];
+        times[0].tv_sec = times[1].tv_sec = std::time(nullptr) - seconds;
+        times[0].tv_usec = times[1].tv_usec = 0;
+        ::utimes(filename.c_str(), times);
+    }
     std::string _path;
     std::string _fallback;
 };
@@ -109,14 +124,15 @@ BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
 BOOST_AUTO_TEST_CASE(Basic) {
     EmptyChunks ec(dummyFile._path, dummyFile._fallback);
     auto s = ec.getEmpty("TestOne");
-    BOOST_CHECK(s->find(3) != s->end());
-    BOOST_CHECK(s->find(103) == s->end());
-    BOOST_CHECK(s->find(1001) == s->end());
+    BOOST_CHECK(s->contains(3));
+    BOOST_CHECK(!s->contains(103));
+    BOOST_CHECK(!s->contains(1001));
+    BOOST_CHECK_EQUAL(s->size(), 19U);
 
     s = ec.getEmpty("TestTwo");
-    BOOST_CHECK(s->find(3) == s->end());
-    BOOST_CHECK(s->find(103) != s->end());
-    BOOST_CHECK(s->find(1001) == s->end());
+    BOOST_CHECK(!s->contains(3));
+    BOOST_CHECK(s->contains(103));
+    BOOST_CHECK(!s->contains(1001));
 
     BOOST_CHECK(ec.isEmpty("TestOne", 3));
     BOOST_CHECK(ec.isEmpty("TestTwo", 103));
@@ -124,5 +140,70 @@ BOOST_AUTO_TEST_CASE(Basic) {
 
 }
 
+BOOST_AUTO_TEST_CASE(Sidecar) {
+    // Reading the text writes a sidecar, used by later readers.
+    std::string const binFile = dummyFile._path + "/empty_TestOne.bin";
+    EmptyChunks(dummyFile._path, dummyFile._fallback).getEmpty("TestOne");
+    BOOST_CHECK(std::ifstream(binFile.c_str()).good());
+    BOOST_CHECK(EmptyChunks(dummyFile._path, dummyFile._fallback).isEmpty("TestOne", 3));
+
+    // A changed text file replaces the sidecar, even if it looks older.
+    dummyFile.writeFile("TestOne", 30, 40);
+    dummyFile.setAge("TestOne", 3600);
+    EmptyChunks ec(dummyFile._path, dummyFile._fallback);
+    BOOST_CHECK(!ec.isEmpty("TestOne", 3));
+    BOOST_CHECK(ec.isEmpty("TestOne", 33));
+
+    // So does one of the same size with another modification time.
+    dummyFile.writeFile("TestOne", 50, 60);
+    dummyFile.setAge("TestOne", 7200);
+    ec.clearCache();
+    BOOST_CHECK(!ec.isEmpty("TestOne", 33));
+    BOOST_CHECK(ec.isEmpty("TestOne", 53));
+
+    // A sidecar alone is enough.
+    std::remove((dummyFile._path + "/empty_TestOne.txt").c_str());
+    ec.clearCache();
+    BOOST_CHECK(ec.isEmpty("TestOne", 53));
+}
+
+BOOST_AUTO_TEST_CASE(Bitmap) {
+    auto bitmap = ChunkBitmap::build({5, 64, 0, 5, 1000});
+    BOOST_CHECK_EQUAL(bitmap->size(), 4U);
+    BOOST_CHECK(bitmap->getChunks() == std::vector<int>({0, 5, 64, 1000}));
+    BOOST_CHECK(bitmap->contains(64));
+    BOOST_CHECK(!bitmap->contains(63));
+    BOOST_CHECK(!bitmap->contains(-1));
+    BOOST_CHECK(!bitmap->contains(100000));
+    BOOST_CHECK_EQUAL(ChunkBitmap::build({})->size(), 0U);
+    BOOST_CHECK(!ChunkBitmap::build({})->contains(0));
+    BOOST_CHECK_THROW(ChunkBitmap::build({-3}), std::out_of_range);
+
+    std::string const path = dummyFile._path + "/bitmap.bin";
+    bitmap->save(path);
+    auto loaded = ChunkBitmap::load(path);
+    BOOST_CHECK_EQUAL(loaded->size(), 4U);
+    BOOST_CHECK(loaded->getChunks() == bitmap->getChunks());
+
+    std::ofstream(path.c_str()) << "0 5\n64\n1000 x";
+    BOOST_CHECK_THROW(ChunkBitmap::load(path), std::runtime_error);
+    BOOST_CHECK(ChunkBitmap::readText(path)->getChunks() == bitmap->getChunks());
+    BOOST_CHECK_THROW(ChunkBitmap::readText(path + ".none"), std::runtime_error);
+
+    // Chunk ids out of range are skipped.
+    std::ofstream(path.c_str()) << "5 -3 70\n300000000 64";
+    BOOST_CHECK(ChunkBitmap::readText(path)->getChunks() == std::vector<int>({5, 64, 70}));
+
+    // The text file is remembered through save() and load().
+    auto text = ChunkBitmap::readText(path);
+    ChunkBitmap::Source source;
+    BOOST_REQUIRE(ChunkBitmap::statSource(path, source));
+    BOOST_CHECK(text->getSource() == source);
+    BOOST_CHECK_EQUAL(text->getSource().size, 20U);
+    text->save(path + ".bin");
+    BOOST_CHECK(ChunkBitmap::load(path + ".bin")->getSource() == source);
+    BOOST_CHECK(bitmap->getSource() == ChunkBitmap::Source());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
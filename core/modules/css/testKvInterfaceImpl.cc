@@ -31,6 +31,7 @@
 
 // System headers
 #include <algorithm> // sort
+#include <chrono>
 #include <cstddef>   // nullptr
 #include <cstdlib>   // rand, srand
 #include <iostream>
@@ -45,6 +46,7 @@
 // Qserv headers
 #include "css/KvInterfaceImplMem.h"
 #include "css/KvInterfaceImplMySql.h"
+#include "css/KvInterfaceImplSnapshot.h"
 
 // Boost unit test header
 #define BOOST_TEST_MODULE MyTest
@@ -110,4 +112,48 @@ BOOST_AUTO_TEST_CASE(testMem) {
     doIt(new lsst::qserv::css::KvInterfaceImplMem());
 }
 
+BOOST_AUTO_TEST_CASE(testSnapshot) {
+    std::cout << "========== Testing SNAPSHOT ==========\n";
+    doIt(new lsst::qserv::css::KvInterfaceImplSnapshot(
+        std::make_shared<lsst::qserv::css::KvInterfaceImplMem>(), std::chrono::milliseconds(0)));
+}
+
+BOOST_AUTO_TEST_CASE(testSnapshotRefresh) {
+    auto mem = std::make_shared<lsst::qserv::css::KvInterfaceImplMem>();
+    mem->create(k1, v1);
+    lsst::qserv::css::KvInterfaceImplSnapshot snapshot(mem, std::chrono::milliseconds(0));
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+    BOOST_CHECK_EQUAL(snapshot.getFingerprint(), mem->getFingerprint());
+
+    // Changes to the backing store are seen once refreshed.
+    mem->set(k1, v2);
+    mem->create(k2, v2);
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+    BOOST_CHECK(!snapshot.exists(k2));
+    BOOST_CHECK(snapshot.refresh());
+    BOOST_CHECK(!snapshot.refresh());
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v2);
+    BOOST_CHECK(snapshot.exists(k2));
+    BOOST_CHECK_EQUAL(snapshot.getChildren(prefix).size(), 2U);
+
+    // Writes through the snapshot are seen at once.
+    snapshot.deleteKey(k2);
+    BOOST_CHECK(!snapshot.exists(k2));
+    BOOST_CHECK(!mem->exists(k2));
+    snapshot.set(k3, v1);
+    BOOST_CHECK_EQUAL(snapshot.get(k3), v1);
+    BOOST_CHECK_EQUAL(mem->get(k3), v1);
+}
+
+BOOST_AUTO_TEST_CASE(testSnapshotRefresher) {
+    // The refresher thread stops with the snapshot.
+    auto start = std::chrono::steady_clock::now();
+    {
+        lsst::qserv::css::KvInterfaceImplSnapshot snapshot(
+            std::make_shared<lsst::qserv::css::KvInterfaceImplMem>(), std::chrono::seconds(3600));
+        BOOST_CHECK(!snapshot.exists(k1));
+    }
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(60));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -36,6 +36,7 @@
 // Qserv headers
 #include "ccontrol/ConfigMap.h"
 #include "czar/MessageTable.h"
+#include "qdisp/Executive.h"
 #include "rproc/InfileMerger.h"
 #include "util/IterableFormatter.h"
 
@@ -70,6 +71,7 @@ Czar::Czar(std::string const& configPath, std::string const& czarName)
 
     int largeResultPoolSize = _czarConfig.getLargeResultPoolSize();
     rproc::InfileMerger::setLargeResultPoolSize(largeResultPoolSize);
+    qdisp::Executive::setSubmitPoolSize(_czarConfig.getSubmitPoolSize());
 
     LOGS(_log, LOG_LVL_INFO, "Creating czar instance with name " << czarName);
     LOGS(_log, LOG_LVL_DEBUG, "Czar config: " << _czarConfig);
@@ -97,6 +99,9 @@ Czar::submitQuery(std::string const& query,
     std::string defaultDb = hintsConfigStore.get("db");
     LOGS(_log, LOG_LVL_DEBUG, "Default database is \"" << defaultDb <<"\"");
 
+    // Result compression codec for this query, overriding the configuration
+    std::string resultCompression = hintsConfigStore.get("result_compression");
+
 
 
     // make message table name
@@ -122,7 +127,7 @@ Czar::submitQuery(std::string const& query,
     ccontrol::UserQuery::Ptr uq;
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        uq = _uqFactory->newUserQuery(query, defaultDb);
+        uq = _uqFactory->newUserQuery(query, defaultDb, resultCompression);
     }
     auto queryIdStr = uq->getQueryIdString();
 
@@ -75,7 +75,8 @@ public:
      *
      * @param query: Query text.
      * @param hints: Optional query hints, default database name should be
-     *               provided as "db" key.
+     *               provided as "db" key, result compression codec
+     *               (NONE, LZ4 or ZLIB) as "result_compression" key.
      * @return Structure with info about submitted query.
      */
     SubmitResult submitQuery(std::string const& query,
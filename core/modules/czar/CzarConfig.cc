@@ -25,8 +25,10 @@
 #include "czar/CzarConfig.h"
 
 // System headers
+#include <algorithm>
 
 // Third party headers
+#include "boost/algorithm/string.hpp"
 #include "XrdSsi/XrdSsiLogger.hh"
 
 // LSST headers
@@ -79,15 +81,52 @@ CzarConfig::CzarConfig(util::ConfigStore const& configStore)
                         configStore.get("qmeta.db", "qservMeta")),
        _xrootdFrontendUrl(configStore.get("frontend.xrootd", "localhost:1094")),
        _emptyChunkPath(configStore.get("partitioner.emptyChunkPath", ".")),
-       _largeResultPoolSize(configStore.getInt("tuning.largeResultPoolSize", 3)) {
+       _largeResultPoolSize(configStore.getInt("tuning.largeResultPoolSize", 3)),
+       _mergeConnections(configStore.getInt("tuning.mergeConnections", 1)),
+       _aggregateInMemory(configStore.getInt("tuning.aggregateInMemory", 1) != 0),
+       _resultChecksum(configStore.get("tuning.resultChecksum", "CRC32C")),
+       _resultProtocol(configStore.getInt("tuning.resultProtocol", 3)),
+       _resultCompression(configStore.get("tuning.resultCompression")),
+       _submitPoolSize(configStore.getInt("tuning.submitPoolSize", 4)),
+       _maxJobsInFlight(configStore.getInt("tuning.maxJobsInFlight", 0)),
+       _retryBaseDelayMs(configStore.getInt("tuning.retryBaseDelayMs", 15000)),
+       _retryMaxDelayMs(configStore.getInt("tuning.retryMaxDelayMs", 60000)),
+       _retryAttempts(configStore.getInt("tuning.retryAttempts", 5)),
+       _retryMaxRunning(configStore.getInt("tuning.retryMaxRunning", 16)),
+       _secondaryIndexDir(configStore.get("tuning.secondaryIndexDir")),
+       _secondaryIndexCheckSeconds(configStore.getInt("tuning.secondaryIndexCheckSeconds", 300)),
+       _planCacheSize(configStore.getInt("tuning.planCacheSize", 0)),
+       _planCacheCheckSeconds(configStore.getInt("tuning.planCacheCheckSeconds", 10)),
+       _coverageCacheSize(configStore.getInt("tuning.coverageCacheSize", 0)) {
+    std::string tables = configStore.get("tuning.secondaryIndexTables");
+    boost::split(_secondaryIndexTables, tables, boost::is_any_of(", "), boost::token_compress_on);
+    _secondaryIndexTables.erase(std::remove(_secondaryIndexTables.begin(), _secondaryIndexTables.end(), ""),
+                                _secondaryIndexTables.end());
 }
 
 std::ostream& operator<<(std::ostream &out, CzarConfig const& czarConfig) {
-    out << "[cssConfigMap=" << util::printable(czarConfig._cssConfigMap) <<
+    out << "[aggregateInMemory=" << czarConfig._aggregateInMemory <<
+           ", coverageCacheSize=" << czarConfig._coverageCacheSize <<
+           ", cssConfigMap=" << util::printable(czarConfig._cssConfigMap) <<
            ", emptyChunkPath=" << czarConfig._emptyChunkPath <<
            ", logConfig=" << czarConfig._logConfig <<
+           ", maxJobsInFlight=" << czarConfig._maxJobsInFlight <<
+           ", mergeConnections=" << czarConfig._mergeConnections <<
            ", mySqlQmetaConfig=" << czarConfig._mySqlQmetaConfig <<
            ", mySqlResultConfig=" << czarConfig._mySqlResultConfig <<
+           ", planCacheCheckSeconds=" << czarConfig._planCacheCheckSeconds <<
+           ", planCacheSize=" << czarConfig._planCacheSize <<
+           ", resultChecksum=" << czarConfig._resultChecksum <<
+           ", resultCompression=" << czarConfig._resultCompression <<
+           ", resultProtocol=" << czarConfig._resultProtocol <<
+           ", retryAttempts=" << czarConfig._retryAttempts <<
+           ", retryBaseDelayMs=" << czarConfig._retryBaseDelayMs <<
+           ", retryMaxDelayMs=" << czarConfig._retryMaxDelayMs <<
+           ", retryMaxRunning=" << czarConfig._retryMaxRunning <<
+           ", secondaryIndexCheckSeconds=" << czarConfig._secondaryIndexCheckSeconds <<
+           ", secondaryIndexDir=" << czarConfig._secondaryIndexDir <<
+           ", secondaryIndexTables=" << util::printable(czarConfig._secondaryIndexTables) <<
+           ", submitPoolSize=" << czarConfig._submitPoolSize <<
            ", xrootdFrontendUrl=" << czarConfig._xrootdFrontendUrl <<
            "]";
 
@@ -25,6 +25,8 @@
 #define LSST_QSERV_CZAR_CZARCONFIG_H
 
 // System headers
+#include <string>
+#include <vector>
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
@@ -120,6 +122,159 @@ public:
          return _largeResultPoolSize;
     }
 
+    /* Get number of MySQL connections each query uses to merge results.
+     *
+     * @return the number of parallel merge connections per query.
+     */
+    int getMergeConnections() const {
+         return _mergeConnections;
+    }
+
+    /* Get whether aggregate query results are folded in memory before
+     * being loaded into the result database.
+     *
+     * @return true if in-memory aggregation is enabled.
+     */
+    bool getAggregateInMemory() const {
+         return _aggregateInMemory;
+    }
+
+    /* Get the checksum workers are asked to use for result messages:
+     * MD5, CRC32C or XXHASH64.
+     *
+     * @return the name of the result checksum.
+     */
+    std::string const& getResultChecksum() const {
+         return _resultChecksum;
+    }
+
+    /* Get the highest result protocol workers may use: 2 for rows, 3 for
+     * columnar results.
+     *
+     * @return the result protocol.
+     */
+    int getResultProtocol() const {
+         return _resultProtocol;
+    }
+
+    /* Get the codec workers are asked to compress result messages with:
+     * NONE, LZ4 or ZLIB, empty leaving the choice to each worker.
+     *
+     * @return the name of the result compression codec.
+     */
+    std::string const& getResultCompression() const {
+         return _resultCompression;
+    }
+
+    /* Get number of threads handing the jobs of all queries to XrdSsi,
+     * while each query goes on producing jobs. 0 hands them over from the
+     * thread producing them.
+     *
+     * @return the size of the thread pool for job submission.
+     */
+    int getSubmitPoolSize() const {
+         return _submitPoolSize;
+    }
+
+    /* Get the highest number of incomplete jobs of one query. Producing
+     * more jobs waits until some complete.
+     *
+     * @return the cap on jobs in flight per query, 0 for no cap.
+     */
+    int getMaxJobsInFlight() const {
+         return _maxJobsInFlight;
+    }
+
+    /* Get the delay before the first retry of a failed job. It doubles with
+     * each later retry, up to getRetryMaxDelayMs(), less a random quarter.
+     *
+     * @return the delay in milliseconds.
+     */
+    int getRetryBaseDelayMs() const {
+         return _retryBaseDelayMs;
+    }
+
+    /* Get the cap on the delay before a retry of a failed job.
+     *
+     * @return the delay in milliseconds.
+     */
+    int getRetryMaxDelayMs() const {
+         return _retryMaxDelayMs;
+    }
+
+    /* Get the number of runs of a job, the first included, before its query
+     * fails.
+     *
+     * @return the number of attempts.
+     */
+    int getRetryAttempts() const {
+         return _retryAttempts;
+    }
+
+    /* Get the number of job retries running at once against the xrootd
+     * service, for all queries.
+     *
+     * @return the cap on concurrent retries.
+     */
+    int getRetryMaxRunning() const {
+         return _retryMaxRunning;
+    }
+
+    /* Get the director tables whose secondary index is held in memory,
+     * loaded at startup, rather than looked up in MySQL for each query.
+     *
+     * @return the tables, as db.table.
+     */
+    std::vector<std::string> const& getSecondaryIndexTables() const {
+         return _secondaryIndexTables;
+    }
+
+    /* Get the directory keeping the in-memory secondary indexes as files,
+     * mapped at startup instead of reading MySQL again.
+     *
+     * @return the directory path, empty to always read MySQL.
+     */
+    std::string const& getSecondaryIndexDir() const {
+         return _secondaryIndexDir;
+    }
+
+    /* Get the time between checks of the in-memory secondary indexes
+     * against MySQL, those that changed being rebuilt.
+     *
+     * @return the interval in seconds, 0 to never check them after startup.
+     */
+    int getSecondaryIndexCheckSeconds() const {
+         return _secondaryIndexCheckSeconds;
+    }
+
+    /* Get the number of query shapes whose analysis is cached, for queries
+     * differing only in the literals of their WHERE clause.
+     *
+     * @return the size of the plan cache, 0 to analyze every query.
+     */
+    int getPlanCacheSize() const {
+         return _planCacheSize;
+    }
+
+    /* Get the time between checks of a cached plan against the CSS metadata
+     * of its tables.
+     *
+     * @return the interval in seconds.
+     */
+    int getPlanCacheCheckSeconds() const {
+         return _planCacheCheckSeconds;
+    }
+
+    /* Get the number of spatial regions whose chunk coverage is kept, per
+     * partitioning. When positive, the coverage of circles and boxes is also
+     * computed from precomputed substripe bounds instead of sphgeom.
+     *
+     * @return the size of the coverage cache, 0 to use sphgeom only.
+     */
+    int getCoverageCacheSize() const {
+         return _coverageCacheSize;
+    }
+
 private:
 
     CzarConfig(util::ConfigStore const& ConfigStore);
@@ -134,6 +289,23 @@ private:
     std::string const _xrootdFrontendUrl;
     std::string const _emptyChunkPath;
     int _largeResultPoolSize;
+    int _mergeConnections;
+    bool _aggregateInMemory;
+    std::string _resultChecksum;
+    int _resultProtocol;
+    std::string _resultCompression;
+    int _submitPoolSize;
+    int _maxJobsInFlight;
+    int _retryBaseDelayMs;
+    int _retryMaxDelayMs;
+    int _retryAttempts;
+    int _retryMaxRunning;
+    std::vector<std::string> _secondaryIndexTables;
+    std::string _secondaryIndexDir;
+    int _secondaryIndexCheckSeconds;
+    int _planCacheSize;
+    int _planCacheCheckSeconds;
+    int _coverageCacheSize;
 };
 
 }}} // namespace lsst::qserv::czar
@@ -25,8 +25,11 @@
 #include "memman/MemFile.h"
 
 // System Headers
+#include <algorithm>
 #include <errno.h>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace lsst {
 namespace qserv {
@@ -39,6 +42,100 @@ namespace memman {
 namespace {
 std::mutex                                cacheMutex;
 std::unordered_map<std::string, MemFile*> fileCache;
+
+// Retained files and their sizes, all protected by cacheMutex
+//
+std::unordered_map<MemFile*, uint64_t>    retained;
+uint64_t                                  useTick = 0;
+uint32_t                                  numHits = 0;
+uint32_t                                  numMisses = 0;
+uint32_t                                  numEvicted = 0;
+}
+
+/******************************************************************************/
+/*                        b y t e s T o R e s e r v e                         */
+/******************************************************************************/
+
+uint64_t MemFile::bytesToReserve() {
+
+    std::lock_guard<std::mutex> guard(_fileMutex);
+
+    return (_isReserved ? 0 : _memInfo.size());
+}
+
+/******************************************************************************/
+/*                                 e v i c t                                  */
+/******************************************************************************/
+
+uint64_t MemFile::evict(Memory& mem, uint64_t bytes,
+                        std::function<int(int)> const& demand) {
+
+    using Key = std::tuple<bool, int, uint64_t>;
+    std::vector<std::pair<Key, MemFile*>> cands;
+    std::vector<MemFile*> victims;
+    uint64_t total = 0, freed = 0;
+
+    {    std::lock_guard<std::mutex> guard(cacheMutex);
+
+         // Find the files that could be evicted. If they do not add up to
+         // what is needed, keep them all as evicting would not help.
+         //
+         for (auto&& ret : retained) {
+             MemFile* mfP = ret.first;
+             if (&(mfP->_memory) != &mem) continue;
+             total += ret.second;
+             Key key(demand(mfP->_chunk) > 0, mfP->_rating, mfP->_useTick);
+             cands.push_back({key, mfP});
+         }
+         if (total < bytes || cands.empty()) return 0;
+
+         // Evict in order of preference until enough memory is freed. The
+         // files are removed from the cache so that obtain() cannot find them.
+         //
+         std::sort(cands.begin(), cands.end(),
+                   [](std::pair<Key, MemFile*> const& a,
+                      std::pair<Key, MemFile*> const& b) {
+                       return a.first < b.first;
+                   });
+         for (auto&& cand : cands) {
+             if (freed >= bytes) break;
+             MemFile* mfP = cand.second;
+             freed += retained[mfP];
+             retained.erase(mfP);
+             fileCache.erase(mfP->_fPath);
+             numEvicted++;
+             victims.push_back(mfP);
+         }
+    }
+
+    // Unmap the files outside of the cache lock
+    //
+    for (auto mfP : victims) mfP->_unmapAndDelete();
+    return freed;
+}
+
+/******************************************************************************/
+/*                              e v i c t A l l                               */
+/******************************************************************************/
+
+void MemFile::evictAll(Memory& mem) {
+
+    std::vector<MemFile*> victims;
+
+    {    std::lock_guard<std::mutex> guard(cacheMutex);
+
+         auto it = retained.begin();
+         while(it != retained.end()) {
+              if (&(it->first->_memory) == &mem) {
+                 fileCache.erase(it->first->_fPath);
+                 numEvicted++;
+                 victims.push_back(it->first);
+                 it = retained.erase(it);
+              } else it++;
+         }
+    }
+
+    for (auto mfP : victims) mfP->_unmapAndDelete();
 }
 
 /******************************************************************************/
@@ -147,12 +244,32 @@ uint32_t MemFile::numFiles() {
     return fileCache.size();
 }
 
+/******************************************************************************/
+/*                           r e t a i n S t a t s                            */
+/******************************************************************************/
+
+MemFile::RetainStats MemFile::retainStats(Memory const& mem) {
+
+    std::lock_guard<std::mutex> guard(cacheMutex);
+    RetainStats stats;
+
+    stats.bytes = 0;
+    for (auto&& ret : retained) {
+        if (&(ret.first->_memory) == &mem) stats.bytes += ret.second;
+    }
+    stats.hits    = numHits;
+    stats.misses  = numMisses;
+    stats.evicted = numEvicted;
+    return stats;
+}
+
 /******************************************************************************/
 /*                                o b t a i n                                 */
 /******************************************************************************/
   
 MemFile::MFResult MemFile::obtain(std::string const& fPath,
-                                  Memory& mem, bool isFlex) {
+                                  Memory& mem, bool isFlex,
+                                  int chunk, int rating) {
 
     std::lock_guard<std::mutex> guard(cacheMutex);
 
@@ -166,7 +283,12 @@ MemFile::MFResult MemFile::obtain(std::string const& fPath,
             MFResult errResult(nullptr, EXDEV);
             return errResult;
         }
+        if (it->second->_refs == 0) {
+            retained.erase(it->second);
+            numHits++;
+        }
         it->second->_refs++;
+        it->second->_rating = std::max(it->second->_rating, rating);
         MFResult aokResult(it->second,0);
         return aokResult;
     }
@@ -182,7 +304,10 @@ MemFile::MFResult MemFile::obtain(std::string const& fPath,
     // Get a new file object and insert it into the map
     //
     MemFile* mfP = new MemFile(fPath, mem, mInfo, isFlex);
+    mfP->_chunk  = chunk;
+    mfP->_rating = rating;
     fileCache.insert({fPath, mfP});
+    numMisses++;
 
     // Return the pointer to the file object
     //
@@ -205,10 +330,31 @@ void MemFile::release() {
          _refs--;
          if (_refs > 0) return;
 
+         // A locked file is retained as it is, so the next user of the file
+         // need not read it again. It stays until evicted for its memory.
+         //
+         uint64_t fSize = 0;
+         {   std::lock_guard<std::mutex> fGuard(_fileMutex);
+             if (_isLocked) fSize = _memInfo.size();
+         }
+         if (fSize > 0) {
+             _useTick = ++useTick;
+             retained[this] = fSize;
+             return;
+         }
+
          // Remove the object from our cache
          //
          fileCache.erase(_fPath);
     }
+    _unmapAndDelete();
+}
+
+/******************************************************************************/
+/*                       _ u n m a p A n d D e l e t e                        */
+/******************************************************************************/
+
+void MemFile::_unmapAndDelete() {
 
     // We lock the file mutex. We also get the size of the file as memRel()
     // destroys the _memInfo object.
@@ -27,6 +27,7 @@
 // System headers
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <unistd.h>
@@ -42,6 +43,9 @@ namespace memman {
 //! @brief Description of a memory based file.
 //! This class serializes all the appropriate methods in the memory object.
 //! It is the only class allowed to call non MT-safe memory methods!
+//!
+//! A locked file that is no longer referenced is retained: it stays mapped
+//! and locked, and is found again by obtain(), until evict() needs its memory.
 //-----------------------------------------------------------------------------
 
 class MemFile {
@@ -76,6 +80,39 @@ public:
 
     int         memMap();
 
+    //-----------------------------------------------------------------------------
+    //! @brief Get the number of bytes that memMap() would need to reserve.
+    //!
+    //! @return The file size, or zero if its memory is already reserved.
+    //-----------------------------------------------------------------------------
+
+    uint64_t    bytesToReserve();
+
+    //-----------------------------------------------------------------------------
+    //! @brief Evict retained files to free memory.
+    //!
+    //! Files of chunks without queued tasks go first, then the files cheapest
+    //! to read again (lowest scan rating), then the least recently used ones.
+    //!
+    //! @param  mem     - The memory object whose files may be evicted.
+    //! @param  bytes   - Number of bytes to free.
+    //! @param  demand  - Returns the number of tasks queued for a chunk.
+    //!
+    //! @return The number of bytes freed. Nothing is evicted, and zero is
+    //!         returned, if the retained files cannot free enough memory.
+    //-----------------------------------------------------------------------------
+
+    static uint64_t evict(Memory& mem, uint64_t bytes,
+                          std::function<int(int)> const& demand);
+
+    //-----------------------------------------------------------------------------
+    //! @brief Evict all retained files.
+    //!
+    //! @param  mem     - The memory object whose files are evicted.
+    //-----------------------------------------------------------------------------
+
+    static void evictAll(Memory& mem);
+
     //-----------------------------------------------------------------------------
     //! @brief Get number of active files (global count).
     //!
@@ -84,6 +121,23 @@ public:
 
     static uint32_t numFiles();
 
+    //-----------------------------------------------------------------------------
+    //! @brief Get retained file statistics; the counts are global.
+    //!
+    //! @param  mem     - The memory object whose retained bytes are counted.
+    //!
+    //! @return RetainStats describing the retained files.
+    //-----------------------------------------------------------------------------
+
+    struct RetainStats {
+        uint64_t bytes;    //!< Bytes of the retained files of mem
+        uint32_t hits;     //!< obtain() calls that found a retained file
+        uint32_t misses;   //!< obtain() calls that made a new file object
+        uint32_t evicted;  //!< Retained files evicted
+    };
+
+    static RetainStats retainStats(Memory const& mem);
+
     //-----------------------------------------------------------------------------
     //! @brief Obtain an object describing a in-memory file.
     //!
@@ -91,6 +145,8 @@ public:
     //! @param  fPath   - The path to the file.
     //! @param  mem     - Reference to the memory object to use for the file.
     //! @param  isFlex  - Tag file as flexible or not (only if new file).
+    //! @param  chunk   - Chunk number of the file.
+    //! @param  rating  - Scan rating of the table, the cost to read it again.
     //!
     //! @return MFResult  When mfP is zero or retc is not zero, the MemFile
     //!                   object could not be obtained and retc holds errno.
@@ -103,11 +159,12 @@ public:
         MFResult(MemFile* mfp, int rc) : mfP(mfp), retc(rc) {}
     };
 
-    static MFResult obtain(std::string const& fPath, Memory& mem, bool isFlex);
+    static MFResult obtain(std::string const& fPath, Memory& mem, bool isFlex,
+                           int chunk=-1, int rating=0);
 
     //-----------------------------------------------------------------------------
     //! @brief Release this table. Upon return it may not be references by
-    //!        the caller as it may have been deleted.
+    //!        the caller as it may have been deleted or retained.
     //-----------------------------------------------------------------------------
 
     void release();
@@ -130,6 +187,8 @@ private:
 
    ~MemFile() {}
 
+    void        _unmapAndDelete();
+
     std::mutex  _fileMutex;
     std::string _fPath;
     Memory&     _memory;
@@ -139,6 +198,9 @@ private:
     bool        _isReserved = false;   // Ditto
     bool        _isLocked   = false;   // Ditto
     bool        _isFlex;               // Set once at object creation
+    int         _chunk  = -1;          // Protected by cacheMutex
+    int         _rating = 0;           // Ditto
+    uint64_t    _useTick = 0;          // Ditto, when last released
 };
 
 }}} // namespace lsst:qserv:memman
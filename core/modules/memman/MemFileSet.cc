@@ -58,13 +58,14 @@ MemFileSet::~MemFileSet() {
 /******************************************************************************/
 
 int MemFileSet::add(std::string const& tabname, int chunk,
-                    bool iFile, bool mustLK) {
+                    bool iFile, bool mustLK, int rating) {
 
     std::string fPath(_memory.filePath(tabname, chunk, iFile));
 
     // Obtain a memory file object for this table and chunk
     //
-    MemFile::MFResult mfResult = MemFile::obtain(fPath, _memory, !mustLK);
+    MemFile::MFResult mfResult = MemFile::obtain(fPath, _memory, !mustLK,
+                                                 chunk, rating);
     if (mfResult.mfP == 0) return mfResult.retc;
 
     // Add to the appropriate file set
@@ -78,6 +79,20 @@ int MemFileSet::add(std::string const& tabname, int chunk,
     return 0;
 }
   
+/******************************************************************************/
+/*                        b y t e s T o R e s e r v e                         */
+/******************************************************************************/
+
+uint64_t MemFileSet::bytesToReserve() {
+
+    uint64_t totBytes = 0;
+
+    // Only required files count, flexible files simply go without memory.
+    //
+    for (auto mfP : _lockFiles) totBytes += mfP->bytesToReserve();
+    return totBytes;
+}
+
 /******************************************************************************/
 /*                               l o c k A l l                                */
 /******************************************************************************/
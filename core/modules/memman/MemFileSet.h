@@ -56,12 +56,22 @@ public:
     //! @param  iFile,  - When true  this is an index file, else a data file.
     //! @param  mustLK  - When true  file is added to the mandatory list.
     //!                   When false file is added to the flexible  list.
+    //! @param  rating  - Scan rating of the table.
     //!
     //! @return =0        Corresponding file added to fileset.
     //! @return !0        Corresponding file not added, errno value returned.
     //-----------------------------------------------------------------------------
 
-    int    add(std::string const& tabname, int chunk, bool iFile, bool mustLK);
+    int    add(std::string const& tabname, int chunk, bool iFile, bool mustLK,
+               int rating=0);
+
+    //-----------------------------------------------------------------------------
+    //! @brief Get the memory that mapAll() needs to reserve for required files.
+    //!
+    //! @return The number of bytes.
+    //-----------------------------------------------------------------------------
+
+    uint64_t bytesToReserve();
 
     //-----------------------------------------------------------------------------
     //! @brief Determine ownership.
@@ -79,11 +79,12 @@ namespace memman {
 /*                                C r e a t e                                 */
 /******************************************************************************/
   
-MemMan *MemMan::create(uint64_t maxBytes, std::string const &dbPath) {
+MemMan *MemMan::create(uint64_t maxBytes, std::string const &dbPath,
+                       MapOptions const& mapOpts) {
 
     // Return a memory manager implementation
     //
-    return new MemManReal(dbPath, maxBytes);
+    return new MemManReal(dbPath, maxBytes, mapOpts);
 }
 }}} // namespace lsst:qserv:memman
 
@@ -57,6 +57,7 @@ public:
 
     LockType theData;         //< Lock options for the table's data
     LockType theIndex;        //< Lock options for the table's index, if any
+    int      scanRating;      //< Scan rating, the cost of reading the table again
 
     //-----------------------------------------------------------------------------
     //! Constructor
@@ -64,12 +65,15 @@ public:
     //! @param  tabName   is the name of the table.
     //! @param  optData   lock options for the table's data
     //! @param  optIndex  lock options for the table's index
+    //! @param  rating    scan rating of the table
     //-----------------------------------------------------------------------------
 
     TableInfo(std::string const& tabName,
               LockType optData=LockType::REQUIRED,
-              LockType optIndex=LockType::NOLOCK)
-             : tableName(tabName), theData(optData), theIndex(optIndex)
+              LockType optIndex=LockType::NOLOCK,
+              int rating=0)
+             : tableName(tabName), theData(optData), theIndex(optIndex),
+               scanRating(rating)
              {}
 };
 
@@ -84,17 +88,29 @@ class MemMan {
 public:
     using Ptr = std::shared_ptr<MemMan>;
 
+    //-----------------------------------------------------------------------------
+    //! @brief Options for mapping and locking database files.
+    //-----------------------------------------------------------------------------
+
+    struct MapOptions {
+        bool hugePages;   //!< Advise huge pages (MADV_HUGEPAGE) for mapped files
+        bool interleave;  //!< Interleave locked pages across all NUMA nodes
+        MapOptions() : hugePages(false), interleave(false) {}
+    };
+
     //-----------------------------------------------------------------------------
     //! @brief Create a memory manager and initialize for processing.
     //!
     //! @param  maxBytes   - Maximum amount of memory that can be used
     //! @param  dbPath     - Path to directory where the database resides
+    //! @param  mapOpts    - Options for mapping and locking files
     //!
     //! @return !0: The pointer to the memory manager.
     //! @return  0: A manager could not be created.
     //-----------------------------------------------------------------------------
 
-    static MemMan* create(uint64_t maxBytes, std::string const& dbPath);
+    static MemMan* create(uint64_t maxBytes, std::string const& dbPath,
+                          MapOptions const& mapOpts=MapOptions());
 
     //-----------------------------------------------------------------------------
     //! @brief Lock a set of tables in memory passed to the prepare() method.
@@ -144,6 +160,26 @@ public:
 
     virtual Handle prepare(std::vector<TableInfo> const& tables, int chunk) = 0;
 
+    //-----------------------------------------------------------------------------
+    //! @brief Start reading a set of tables that will soon be prepared.
+    //!
+    //! The files are only read into the file system cache, asynchronously,
+    //! so that a later prepare() and lock() need not wait on the disk. Tables
+    //! marked NOLOCK are skipped. Files still prefetched and not yet prepared
+    //! count against the free memory, which bounds how far ahead one can go.
+    //!
+    //! @param  tables - Reference to the tables to read.
+    //! @param  chunk  - The chunk number associated with the tables.
+    //!
+    //! @return =0     - Reading of all the files was started.
+    //! @return !0     - Not all files were prefetched. The return value is the
+    //!                  errno reason, as follows:
+    //!                  xxxxxx - filesystem error
+    //!                  ENOMEM - insufficient free memory to prefetch more.
+    //-----------------------------------------------------------------------------
+
+    virtual int    prefetch(std::vector<TableInfo> const& tables, int chunk) = 0;
+
     //-----------------------------------------------------------------------------
     //! @brief Unlock a set of tables previously locked by the lock() or were
     //!        prepared for locking by prepare().
@@ -154,10 +190,24 @@ public:
     //! @return true:  The the memory associated with the resource has been
     //!                release. If this is the last usage of the resource,
     //!                the memory associated with the resource is unlocked.
+    //!                A memory manager may instead retain locked files until
+    //!                their memory is needed by prepare().
     //-----------------------------------------------------------------------------
 
     virtual bool  unlock(Handle handle) = 0;
 
+    //-----------------------------------------------------------------------------
+    //! @brief Account for tasks queued to use the tables of a chunk.
+    //!
+    //! Retained files of chunks that tasks are waiting for are the last ones
+    //! evicted when memory is needed.
+    //!
+    //! @param  chunk   - The chunk number.
+    //! @param  tasks   - Tasks added to the queue, negative when removed.
+    //-----------------------------------------------------------------------------
+
+    virtual void  addDemand(int chunk, int tasks) = 0;
+
     //-----------------------------------------------------------------------------
     //! @brief Release all resources and unlock all locked memory.
     //!
@@ -176,6 +226,7 @@ public:
         uint64_t bytesLockMax; //!< Maximum number of bytes to lock
         uint64_t bytesLocked;  //!< Current number of bytes locked
         uint64_t bytesReserved;//!< Current number of bytes reserved
+        uint64_t bytesRetained;//!< Current number of bytes retained (locked)
         uint32_t numMapErrors; //!< Number of mmap()  calls that failed
         uint32_t numLokErrors; //!< Number of mlock() calls that failed
         uint32_t numFSets;     //!< Global  number of active file sets
@@ -185,6 +236,17 @@ public:
         uint32_t numFlexLock;  //!< Number  flexible files that were locked
         uint32_t numLocks;     //!< Number of calls to lock()
         uint32_t numErrors;    //!< Number of calls that failed
+        uint32_t numPrefetch;  //!< Number of files prefetched
+        uint32_t numPrefHits;  //!< Number  prefetched files prepared later
+        uint32_t numPrefSkips; //!< Number  files not prefetched, lacking memory
+        uint32_t numRetHits;   //!< Number  files found retained
+        uint32_t numRetMiss;   //!< Number  files not found retained
+        uint32_t numEvicted;   //!< Number  retained files evicted
+        uint32_t numHugeAdvised;//!< Number  files advised to use huge pages
+                               //!< (not whether the kernel used them)
+        uint32_t numHugeErrors;//!< Number  files where huge pages were refused
+        uint32_t numInterleave;//!< Number  files locked interleaved over nodes
+        uint32_t numPlaceErrors;//!< Number files locked without NUMA placement
     };
 
     virtual Statistics getStatistics() = 0;
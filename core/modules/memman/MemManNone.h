@@ -56,8 +56,14 @@ public:
                return HandleType::ISEMPTY;
            }
 
+    int    prefetch(std::vector<TableInfo> const& tables, int chunk) override {
+               (void)tables; (void)chunk; return 0;
+           }
+
     bool  unlock(Handle handle) override {(void)handle; return true;}
 
+    void  addDemand(int chunk, int tasks) override {(void)chunk; (void)tasks;}
+
     void  unlockAll() override {}
 
     Statistics getStatistics() override {return _myStats;}
@@ -46,12 +46,44 @@ std::unordered_map<lsst::qserv::memman::MemMan::Handle,
 
 lsst::qserv::memman::MemMan::Handle handleNum
                              = lsst::qserv::memman::MemMan::HandleType::ISEMPTY;
+
+// Prefetched files not prepared within this time are assumed to have been
+// dropped from the page cache and no longer count against free memory.
+//
+std::chrono::seconds const prefLife(300);
 }
 
 namespace lsst {
 namespace qserv {
 namespace memman {
   
+/******************************************************************************/
+/*                             a d d D e m a n d                              */
+/******************************************************************************/
+
+void MemManReal::addDemand(int chunk, int tasks) {
+
+    std::lock_guard<std::mutex> guard(_demMutex);
+
+    // Keep only chunks that have tasks queued
+    //
+    int& num = _demand[chunk];
+    num += tasks;
+    if (num <= 0) _demand.erase(chunk);
+}
+
+/******************************************************************************/
+/*                            _ d e m a n d F o r                             */
+/******************************************************************************/
+
+int MemManReal::_demandFor(int chunk) {
+
+    std::lock_guard<std::mutex> guard(_demMutex);
+
+    auto it = _demand.find(chunk);
+    return (it == _demand.end() ? 0 : it->second);
+}
+
 /******************************************************************************/
 /*                         g e t S t a t i s t i c s                          */
 /******************************************************************************/
@@ -71,9 +103,22 @@ MemMan::Statistics MemManReal::getStatistics() {
     stats.numMapErrors = mStats.numMapErrors;
     stats.numLokErrors = mStats.numLokErrors;
     stats.numFlexLock  = mStats.numFlexFiles;
+    stats.numHugeAdvised=mStats.numHugeAdvised;
+    stats.numHugeErrors= mStats.numHugeErrs;
+    stats.numInterleave= mStats.numInterleave;
+    stats.numPlaceErrors=mStats.numPlaceErrs;
     stats.numLocks     = _numLocks;
     stats.numErrors    = _numErrors;
     stats.numFiles     = MemFile::numFiles();
+    stats.numPrefetch  = _numPrefetch;
+    stats.numPrefHits  = _numPrefHits;
+    stats.numPrefSkips = _numPrefSkips;
+
+    MemFile::RetainStats rStats = MemFile::retainStats(_memory);
+    stats.bytesRetained= rStats.bytes;
+    stats.numRetHits   = rStats.hits;
+    stats.numRetMiss   = rStats.misses;
+    stats.numEvicted   = rStats.evicted;
 
     // The following requires a lock
     //
@@ -185,6 +230,10 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     //
     if (lockNum == 0 && flexNum == 0) return HandleType::ISEMPTY;
 
+    // Account for any of these files that were prefetched
+    //
+    _prefetchUsed(tables, chunk);
+
     // Allocate an empty file set sized to handle this request
     //
     MemFileSet* fileSet = new MemFileSet(_memory, lockNum, flexNum, chunk);
@@ -194,12 +243,14 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     for (auto&& tab : tables) {
         mustLock =      tab.theData  == TableInfo::LockType::REQUIRED;
         if (mustLock || tab.theData  == TableInfo::LockType::FLEXIBLE) {
-           retc = fileSet->add(tab.tableName, chunk, false, mustLock);
-            if (retc) break;
+           retc = fileSet->add(tab.tableName, chunk, false, mustLock,
+                               tab.scanRating);
+           if (retc) break;
         }
         mustLock =      tab.theIndex == TableInfo::LockType::REQUIRED;
         if (mustLock || tab.theIndex == TableInfo::LockType::FLEXIBLE) {
-           retc = fileSet->add(tab.tableName, chunk, true,  mustLock);
+           retc = fileSet->add(tab.tableName, chunk, true,  mustLock,
+                               tab.scanRating);
            if (retc) break;
         }
      }
@@ -210,6 +261,16 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     if (retc == 0) {
        std::lock_guard<std::mutex> guard(hanMutex);
 
+       // Make room by evicting retained files if the required files do not
+       // fit in the free memory.
+       //
+       uint64_t bNeed = fileSet->bytesToReserve();
+       uint64_t bFree = _memory.bytesFree();
+       if (bNeed > bFree) {
+          MemFile::evict(_memory, bNeed - bFree,
+                         [this](int chk) {return _demandFor(chk);});
+       }
+
        // Lock all required tables and any flexible tables we can. Upon success
        // (with global mutex held) update statistics, generate a file handle,
        // add it to the handle cache, and return the handle.
@@ -232,6 +293,93 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     return HandleType::INVALID;
 }
 
+/******************************************************************************/
+/*                              p r e f e t c h                               */
+/******************************************************************************/
+
+int MemManReal::prefetch(std::vector<TableInfo> const& tables, int chunk) {
+
+    std::vector<std::string> paths;
+
+    // Get the paths of the files that would be prepared
+    //
+    for (auto&& tab : tables) {
+        if (tab.theData  != TableInfo::LockType::NOLOCK)
+           paths.push_back(_memory.filePath(tab.tableName, chunk, false));
+        if (tab.theIndex != TableInfo::LockType::NOLOCK)
+           paths.push_back(_memory.filePath(tab.tableName, chunk, true));
+    }
+    if (paths.empty()) return 0;
+
+    std::lock_guard<std::mutex> guard(_prefMutex);
+
+    // Forget files prefetched too long ago
+    //
+    auto now = std::chrono::steady_clock::now();
+    auto it  = _prefFiles.begin();
+    while(it != _prefFiles.end()) {
+         if (now - it->second.when > prefLife) {
+            _prefBytes -= it->second.bytes;
+            it = _prefFiles.erase(it);
+         } else it++;
+    }
+
+    // Files prefetched but not yet prepared will need memory that is still
+    // free, or held by retained files that can be evicted, so only the rest
+    // of it may be used to read further ahead.
+    //
+    uint64_t bFree = _memory.bytesFree() + MemFile::retainStats(_memory).bytes;
+    uint64_t bLeft = (bFree <= _prefBytes ? 0 : bFree - _prefBytes);
+
+    // Start reading each file not already on its way in
+    //
+    for (auto&& fPath : paths) {
+        if (_prefFiles.find(fPath) != _prefFiles.end()) continue;
+        MemInfo fInfo = _memory.fileInfo(fPath);
+        if (!fInfo.isValid()) {
+           if (fInfo.errCode() == ESPIPE) continue;
+           return fInfo.errCode();
+        }
+        if (fInfo.size() > bLeft) {
+           _numPrefSkips++;
+           return ENOMEM;
+        }
+        int rc = _memory.fileAdvise(fPath);
+        if (rc) return rc;
+        _prefFiles[fPath] = PrefFile{fInfo.size(), now};
+        _prefBytes += fInfo.size();
+        bLeft      -= fInfo.size();
+        _numPrefetch++;
+    }
+    return 0;
+}
+
+/******************************************************************************/
+/*                         _ p r e f e t c h U s e d                          */
+/******************************************************************************/
+
+void MemManReal::_prefetchUsed(std::vector<TableInfo> const& tables, int chunk) {
+
+    std::lock_guard<std::mutex> guard(_prefMutex);
+    if (_prefFiles.empty()) return;
+
+    // A prepared file that was prefetched is a hit; it no longer needs any of
+    // the free memory set aside for prefetching.
+    //
+    auto used = [this, chunk](std::string const& tabName, bool isIndex) {
+        auto it = _prefFiles.find(_memory.filePath(tabName, chunk, isIndex));
+        if (it != _prefFiles.end()) {
+           _prefBytes -= it->second.bytes;
+           _prefFiles.erase(it);
+           _numPrefHits++;
+        }
+    };
+    for (auto&& tab : tables) {
+        if (tab.theData  != TableInfo::LockType::NOLOCK) used(tab.tableName, false);
+        if (tab.theIndex != TableInfo::LockType::NOLOCK) used(tab.tableName, true);
+    }
+}
+
 /******************************************************************************/
 /*                                u n l o c k                                 */
 /******************************************************************************/
@@ -286,6 +434,10 @@ void MemManReal::unlockAll() {
             it = hanCache.erase(it);
          } else it++;
     }
+
+    // Unlock the files retained after their file sets were deleted
+    //
+    MemFile::evictAll(_memory);
 }
 }}} // namespace lsst:qserv:memman
 
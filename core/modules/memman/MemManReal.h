@@ -26,7 +26,9 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 // Qserv Headers
@@ -48,8 +50,12 @@ public:
 
     Handle prepare(std::vector<TableInfo> const& tables, int chunk) override;
 
+    int    prefetch(std::vector<TableInfo> const& tables, int chunk) override;
+
     bool   unlock(Handle handle) override;
 
+    void   addDemand(int chunk, int tasks) override;
+
     void   unlockAll() override;
 
     Statistics getStatistics() override;
@@ -59,20 +65,43 @@ public:
     MemManReal & operator=(const MemManReal&) = delete;
     MemManReal(const MemManReal&) = delete;
 
-    MemManReal(std::string const& dbPath, uint64_t maxBytes)
-              : _memory(dbPath, maxBytes), _numErrors(0), _numLkerrs(0),
-                _numLocks(0), _numReqdFiles(0), _numFlexFiles(0) {}
+    MemManReal(std::string const& dbPath, uint64_t maxBytes,
+               MapOptions const& mapOpts=MapOptions())
+              : _memory(dbPath, maxBytes, mapOpts.hugePages,
+                        mapOpts.interleave),
+                _numErrors(0), _numLkerrs(0),
+                _numLocks(0), _numReqdFiles(0), _numFlexFiles(0),
+                _prefBytes(0), _numPrefetch(0), _numPrefHits(0),
+                _numPrefSkips(0) {}
 
     ~MemManReal() override {unlockAll();}
 
 private:
 
+    int    _demandFor(int chunk);
+    void   _prefetchUsed(std::vector<TableInfo> const& tables, int chunk);
+
+    struct PrefFile {
+        uint64_t                              bytes;
+        std::chrono::steady_clock::time_point when;
+    };
+
     Memory           _memory;
     std::atomic_uint _numErrors;
     std::atomic_uint _numLkerrs;
     uint32_t         _numLocks;      // Under control of hanMutex
     uint32_t         _numReqdFiles;  // Ditto
     uint32_t         _numFlexFiles;  // Ditto
+
+    std::mutex       _prefMutex;
+    uint64_t         _prefBytes;     // Protected by _prefMutex
+    std::unordered_map<std::string, PrefFile> _prefFiles; // Ditto
+    std::atomic_uint _numPrefetch;
+    std::atomic_uint _numPrefHits;
+    std::atomic_uint _numPrefSkips;
+
+    std::mutex       _demMutex;
+    std::unordered_map<int, int> _demand; // Queued tasks by chunk, _demMutex
 };
 
 }}} // namespace lsst:qserv:memman
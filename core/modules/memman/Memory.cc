@@ -27,14 +27,77 @@
 // System Headers
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 
+/******************************************************************************/
+/*                  L o c a l   S t a t i c   O b j e c t s                   */
+/******************************************************************************/
+
+namespace {
+
+// Node masks are a single word, so at most 64 nodes are used. The kernel
+// takes one more than the number of bits in the mask.
+//
+unsigned long const maxNode = sizeof(unsigned long) * 8 + 1;
+
+// The memory policy calls, without a dependency on libnuma.
+//
+long getMemPolicy(int* mode, unsigned long* mask, unsigned long flags) {
+    return syscall(SYS_get_mempolicy, mode, mask, maxNode, 0, flags);
+}
+
+long setMemPolicy(int mode, unsigned long const* mask) {
+    return syscall(SYS_set_mempolicy, mode, mask, (mask ? maxNode : 0));
+}
+}
+
 namespace lsst {
 namespace qserv {
 namespace memman {
 
+/******************************************************************************/
+/*                          _ a l l o w e d N o d e s                         */
+/******************************************************************************/
+
+bool Memory::_allowedNodes() {
+
+    int mode;
+
+    // Get the NUMA nodes this process may use. Interleaving is pointless
+    // unless there are at least two of them.
+    //
+    if (getMemPolicy(&mode, &_nodeMask, MPOL_F_MEMS_ALLOWED)) {
+        _nodeMask = 0;
+        return false;
+    }
+    return __builtin_popcountl(_nodeMask) > 1;
+}
+
+/******************************************************************************/
+/*                            f i l e A d v i s e                             */
+/******************************************************************************/
+
+int Memory::fileAdvise(std::string const& fPath) {
+
+    int fdNum, rc;
+
+    // Open the file and tell the kernel we will need all of it. The pages are
+    // read in the background and stay in the page cache until mapped.
+    //
+    fdNum = open(fPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdNum < 0) return errno;
+    rc = posix_fadvise(fdNum, 0, 0, POSIX_FADV_WILLNEED);
+
+    // Close the file and return result (posix_fadvise returns the errno)
+    //
+    close(fdNum);
+    return rc;
+}
+
 /******************************************************************************/
 /*                              f i l e I n f o                               */
 /******************************************************************************/
@@ -93,18 +156,40 @@ int Memory::memLock(MemInfo mInfo, bool isFlex) {
     //
     if (!mInfo.isValid()) return EFAULT;
 
-    // Lock this map into memory. Return success if this worked.
+    // When interleaving, switch this thread to the interleave policy so that
+    // the pages mlock() faults in are spread over the nodes. The thread's own
+    // policy is put back afterwards.
+    //
+    int oldMode = MPOL_DEFAULT;
+    unsigned long oldMask = 0;
+    bool placed = false;
+    if (_interleave) {
+        if (!getMemPolicy(&oldMode, &oldMask, 0)
+        &&  !setMemPolicy(MPOL_INTERLEAVE, &_nodeMask)) placed = true;
+           else _numPlaceErrs++;
+    }
+
+    // Lock this map into memory.
     //
-    if (!mlock(mInfo._memAddr, mInfo._memSize)) {
+    int rc = mlock(mInfo._memAddr, mInfo._memSize);
+    int lockErr = errno;
+    if (placed) {
+        setMemPolicy(oldMode, (oldMode == MPOL_DEFAULT ? nullptr : &oldMask));
+    }
+
+    // Return success if this worked.
+    //
+    if (!rc) {
         _lokBytes += mInfo._memSize;
         if (isFlex) _flexNum++;
+        if (placed) _numInterleave++;
         return 0;
     }
 
     // Return failure
     //
     _numLokErrs++;
-    return (errno == EAGAIN ? ENOMEM : errno);
+    return (lockErr == EAGAIN ? ENOMEM : lockErr);
 }
 
 /******************************************************************************/
@@ -146,6 +231,19 @@ MemInfo Memory::mapFile(std::string const& fPath) {
     if (mInfo._memAddr == MAP_FAILED) {
         mInfo.setErrCode(errno);
         _numMapErrs++;
+    } else if (_hugePages) {
+
+        // Ask for huge pages to cut down TLB misses on large locked sets. The
+        // kernel may refuse, e.g. for file systems without huge page support,
+        // in which case the file simply uses normal pages.
+        //
+#ifdef MADV_HUGEPAGE
+        if (!madvise(mInfo._memAddr, mInfo._memSize, MADV_HUGEPAGE)) {
+            _numHugeAdvised++;
+        } else _numHugeErrs++;
+#else
+        _numHugeErrs++;
+#endif
     }
 
     // Close the file and return result
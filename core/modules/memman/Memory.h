@@ -109,6 +109,20 @@ public:
         return (_maxBytes <= _rsvBytes ? 0 : _maxBytes - _rsvBytes);
     }
 
+    //-----------------------------------------------------------------------------
+    //! @brief Advise the kernel that a file will soon be read.
+    //!
+    //! The file is read ahead into the file system cache asynchronously; the
+    //! call does not map, lock or reserve any memory.
+    //!
+    //! @param  fPath - File path of the file to read ahead.
+    //!
+    //! @return =0     - Read ahead was started.
+    //! @return !0     - Read ahead failed, retuned value is the errno.
+    //-----------------------------------------------------------------------------
+
+    int     fileAdvise(std::string const& fPath);
+
     //-----------------------------------------------------------------------------
     //! @brief Get file information.
     //!
@@ -139,6 +153,10 @@ public:
     //-----------------------------------------------------------------------------
     //! @brief Lock a database file in memory.
     //!
+    //! When interleaving, the pages faulted in by the lock are spread over
+    //! all allowed NUMA nodes. Pages already in the page cache stay where
+    //! they are.
+    //!
     //! @param  mInfo  - The memory mapping returned by mapFile().
     //! @param  isFlex - When true account for flexible files in the statistics.
     //!
@@ -149,7 +167,7 @@ public:
     int     memLock(MemInfo mInfo, bool isFlex);
 
     //-----------------------------------------------------------------------------
-    //! @brief Map a database file in memory.
+    //! @brief Map a database file in memory, advising huge pages if so wanted.
     //!
     //! @param  fPath  - Path of the database file to be mapped in memory.
     //! @param  isFlex - When true this is a flexible file request.
@@ -207,6 +225,11 @@ public:
         uint32_t numMapErrors;   //!< Number of mmap()  calls that failed
         uint32_t numLokErrors;   //!< Number of mlock() calls that failed
         uint32_t numFlexFiles;   //!< Number of Flexible files encountered
+        uint32_t numHugeAdvised; //!< Number of files advised to use huge pages,
+                                 //!< which the kernel may still map with normal ones
+        uint32_t numHugeErrs;    //!< Number of madvise(MADV_HUGEPAGE) failures
+        uint32_t numInterleave;  //!< Number of files locked interleaved
+        uint32_t numPlaceErrs;   //!< Number of NUMA memory policy failures
     };
 
     MemStats statistics() {
@@ -219,6 +242,10 @@ public:
         mStats.numMapErrors  = _numMapErrs;
         mStats.numLokErrors  = _numLokErrs;
         mStats.numFlexFiles  = _flexNum;
+        mStats.numHugeAdvised= _numHugeAdvised;
+        mStats.numHugeErrs   = _numHugeErrs;
+        mStats.numInterleave = _numInterleave;
+        mStats.numPlaceErrs  = _numPlaceErrs;
         return mStats;
     }
 
@@ -227,11 +254,18 @@ public:
     //!
     //! @param  dbDir  - Directory path to where managed files reside.
     //! @param  memSZ  - Size of memory to manage in bytes.
+    //! @param  hugePg - When true advise huge pages for mapped files.
+    //! @param  intlv  - When true interleave locked memory across NUMA nodes.
+    //!                  This is ignored when only one node is allowed.
     //-----------------------------------------------------------------------------
 
-    Memory(std::string const& dbDir, uint64_t memSZ)
+    Memory(std::string const& dbDir, uint64_t memSZ,
+           bool hugePg=false, bool intlv=false)
           : _dbDir(dbDir), _maxBytes(memSZ), _lokBytes(0), _rsvBytes(0),
-            _numMapErrs(0), _numLokErrs(0), _flexNum(0) {}
+            _numMapErrs(0), _numLokErrs(0), _flexNum(0),
+            _numHugeAdvised(0), _numHugeErrs(0), _numInterleave(0),
+            _numPlaceErrs(0), _hugePages(hugePg), _nodeMask(0),
+            _interleave(intlv && _allowedNodes()) {}
 
     ~Memory() {}
 
@@ -245,6 +279,16 @@ private:
     std::atomic_uint   _numMapErrs;
     std::atomic_uint   _numLokErrs;
     std::atomic_uint   _flexNum;
+    std::atomic_uint   _numHugeAdvised;
+    std::atomic_uint   _numHugeErrs;
+    std::atomic_uint   _numInterleave;
+    std::atomic_uint   _numPlaceErrs;
+
+    bool               _allowedNodes();
+
+    bool               _hugePages;   // Set at construction time
+    unsigned long      _nodeMask;    // Ditto, NUMA nodes to interleave over
+    bool               _interleave;  // Ditto
 };
 }}} // namespace lsst:qserv:memman
 #endif  // LSST_QSERV_MEMMAN_MEMORY_H
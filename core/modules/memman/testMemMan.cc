@@ -0,0 +1,232 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+  /**
+  * @brief Test retention and eviction of locked files, and the mapping options.
+  */
+
+// System headers
+#include <cstdint>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// Qserv headers
+#include "memman/MemManReal.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE MemMan
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::memman::MemMan;
+using lsst::qserv::memman::MemManReal;
+using lsst::qserv::memman::TableInfo;
+
+namespace {
+
+uint64_t const FILE_SIZE = 4096;
+
+/// A directory of chunk tables T_<chunk>.MYD of FILE_SIZE bytes each, small
+/// enough for the default RLIMIT_MEMLOCK.
+struct DbDir {
+    explicit DbDir(int chunks) : path("/tmp/testMemMan." + std::to_string(::getpid())) {
+        ::mkdir(path.c_str(), 0700);
+        for (int chunk=1; chunk <= chunks; ++chunk) {
+            std::ofstream out(file(chunk));
+            out << std::string(FILE_SIZE, 'x');
+        }
+    }
+    ~DbDir() {
+        for (auto const& name : files) {
+            ::unlink(name.c_str());
+        }
+        ::rmdir(path.c_str());
+    }
+    std::string file(int chunk) {
+        files.push_back(path + "/T_" + std::to_string(chunk) + ".MYD");
+        return files.back();
+    }
+    std::string path;
+    std::vector<std::string> files;
+};
+
+/// @return the memory policy mode of this thread.
+int threadPolicy() {
+    int mode = -1;
+    unsigned long mask[2] = {0, 0};
+    BOOST_REQUIRE(syscall(SYS_get_mempolicy, &mode, mask, sizeof(mask) * 8, 0, 0) == 0);
+    return mode;
+}
+
+/// @return the number of NUMA nodes this process may use.
+int allowedNodes() {
+    int mode = -1;
+    unsigned long mask[2] = {0, 0};
+    if (syscall(SYS_get_mempolicy, &mode, mask, sizeof(mask) * 8, 0, MPOL_F_MEMS_ALLOWED)) {
+        return 0;
+    }
+    return __builtin_popcountl(mask[0]) + __builtin_popcountl(mask[1]);
+}
+
+/// Prepare and lock table T of chunk, then unlock it.
+void use(MemMan& mm, int chunk, int rating) {
+    std::vector<TableInfo> tables{TableInfo("T", TableInfo::LockType::REQUIRED,
+                                            TableInfo::LockType::NOLOCK, rating)};
+    MemMan::Handle handle = mm.prepare(tables, chunk);
+    BOOST_REQUIRE_MESSAGE(handle != MemMan::HandleType::INVALID, "prepare errno=" << errno);
+    BOOST_REQUIRE_EQUAL(mm.lock(handle), 0);
+    BOOST_REQUIRE(mm.unlock(handle));
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(RetainOnUnlock) {
+    DbDir dir(1);
+    MemManReal mm(dir.path, 4 * FILE_SIZE);
+    MemMan::Statistics before = mm.getStatistics();
+
+    // The file stays locked once unlocked, and is found again.
+    use(mm, 1, 0);
+    MemMan::Statistics stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.bytesRetained, FILE_SIZE);
+    BOOST_CHECK_EQUAL(stats.bytesLocked, FILE_SIZE);
+    BOOST_CHECK_EQUAL(stats.numFiles, before.numFiles + 1);
+    BOOST_CHECK_EQUAL(stats.numRetMiss, before.numRetMiss + 1);
+    BOOST_CHECK_EQUAL(stats.numRetHits, before.numRetHits);
+
+    use(mm, 1, 0);
+    stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numRetMiss, before.numRetMiss + 1);
+    BOOST_CHECK_EQUAL(stats.numRetHits, before.numRetHits + 1);
+    BOOST_CHECK_EQUAL(stats.bytesRetained, FILE_SIZE);
+
+    // unlockAll() lets go of retained files.
+    mm.unlockAll();
+    stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.bytesRetained, 0u);
+    BOOST_CHECK_EQUAL(stats.bytesLocked, 0u);
+    BOOST_CHECK_EQUAL(stats.numEvicted, before.numEvicted + 1);
+}
+
+BOOST_AUTO_TEST_CASE(EvictionOrder) {
+    DbDir dir(5);
+    MemManReal mm(dir.path, 3 * FILE_SIZE);
+    MemMan::Statistics before = mm.getStatistics();
+
+    // Fill memory with retained files. Chunk 3 is as cheap to read again as
+    // chunk 2, but has tasks queued.
+    use(mm, 1, 5);
+    use(mm, 2, 1);
+    use(mm, 3, 1);
+    mm.addDemand(3, 1);
+    BOOST_CHECK_EQUAL(mm.getStatistics().bytesRetained, 3 * FILE_SIZE);
+
+    // The lowest scan rating without demand goes first.
+    use(mm, 4, 9);
+    MemMan::Statistics stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numEvicted, before.numEvicted + 1);
+    BOOST_CHECK_EQUAL(stats.bytesRetained, 3 * FILE_SIZE);
+
+    // Then the next lowest, still sparing chunk 3.
+    use(mm, 5, 0);
+    stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numEvicted, before.numEvicted + 2);
+
+    // Chunks 3, 4 and 5 are retained, 1 and 2 were evicted.
+    uint32_t hits = stats.numRetHits;
+    uint32_t misses = stats.numRetMiss;
+    mm.addDemand(3, -1);
+    use(mm, 3, 1);
+    stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numRetHits, hits + 1);
+    BOOST_CHECK_EQUAL(stats.numRetMiss, misses);
+    use(mm, 2, 1);
+    stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numRetMiss, misses + 1);
+    BOOST_CHECK_EQUAL(stats.numEvicted, before.numEvicted + 3);
+    BOOST_CHECK_EQUAL(stats.numRetMiss, before.numRetMiss + 6);
+}
+
+BOOST_AUTO_TEST_CASE(NoEvictionWithoutRoom) {
+    // Retained files are kept when evicting them all would not make room.
+    DbDir dir(2);
+    MemManReal mm(dir.path, FILE_SIZE);
+    MemMan::Statistics before = mm.getStatistics();
+    use(mm, 1, 0);
+    std::ofstream(dir.file(2)) << std::string(2 * FILE_SIZE, 'y');
+    std::vector<TableInfo> tables{TableInfo("T")};
+    BOOST_CHECK(mm.prepare(tables, 2) == MemMan::HandleType::INVALID);
+    MemMan::Statistics stats = mm.getStatistics();
+    BOOST_CHECK_EQUAL(stats.numEvicted, before.numEvicted);
+    BOOST_CHECK_EQUAL(stats.bytesRetained, FILE_SIZE);
+    BOOST_CHECK_EQUAL(stats.numErrors, before.numErrors + 1);
+}
+
+BOOST_AUTO_TEST_CASE(MapOptions) {
+    DbDir dir(2);
+
+    // Without options, neither huge pages nor NUMA placement are tried.
+    {
+        MemManReal mm(dir.path, 4 * FILE_SIZE);
+        use(mm, 1, 0);
+        MemMan::Statistics stats = mm.getStatistics();
+        BOOST_CHECK_EQUAL(stats.numHugeAdvised + stats.numHugeErrors, 0u);
+        BOOST_CHECK_EQUAL(stats.numInterleave + stats.numPlaceErrors, 0u);
+    }
+
+    // Each mapped file is advised to use huge pages, which the kernel may
+    // refuse for the file system.
+    MemMan::MapOptions opts;
+    opts.hugePages = true;
+    {
+        MemManReal mm(dir.path, 4 * FILE_SIZE, opts);
+        use(mm, 1, 0);
+        use(mm, 2, 0);
+        MemMan::Statistics stats = mm.getStatistics();
+        BOOST_CHECK_EQUAL(stats.numHugeAdvised + stats.numHugeErrors, 2u);
+        BOOST_CHECK_EQUAL(stats.numMapErrors, 0u);
+    }
+
+    // Locking interleaved switches the policy of the thread for mlock() only,
+    // and is skipped with a single node.
+    opts.hugePages = false;
+    opts.interleave = true;
+    {
+        int const mode = threadPolicy();
+        MemManReal mm(dir.path, 4 * FILE_SIZE, opts);
+        use(mm, 1, 0);
+        BOOST_CHECK_EQUAL(threadPolicy(), mode);
+        MemMan::Statistics stats = mm.getStatistics();
+        BOOST_CHECK_EQUAL(stats.numInterleave + stats.numPlaceErrors, allowedNodes() > 1 ? 1u : 0u);
+        BOOST_CHECK_EQUAL(stats.bytesLocked, FILE_SIZE);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "proto/ColumnarRows.h"
+
+// System headers
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// Qserv headers
+#include "global/Bug.h"
+#include "util/DoubleToString.h"
+
+namespace {
+
+/// Parse a decimal integer in the canonical form MySQL returns it in: an
+/// optional '-', then digits without leading zeros. Anything else is left
+/// as text, since formatting the parsed value would not reproduce it.
+bool parseInt64(char const* s, std::size_t len, std::int64_t& value) {
+    char const* const end = s + len;
+    bool negative = false;
+    if (s != end && *s == '-') {
+        negative = true;
+        ++s;
+    }
+    if (s == end || end - s > 19 || (*s == '0' && end - s > 1) || (negative && *s == '0')) {
+        return false;
+    }
+    std::uint64_t v = 0;
+    for (; s != end; ++s) {
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+        v = v * 10 + (*s - '0'); // 19 digits cannot overflow uint64
+    }
+    std::uint64_t const limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+    if (v > limit + (negative ? 1 : 0)) {
+        return false;
+    }
+    value = negative ? static_cast<std::int64_t>(0 - v) : static_cast<std::int64_t>(v);
+    return true;
+}
+
+/// Parse a finite floating point number.
+bool parseDouble(char const* s, std::size_t len, double& value) {
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    std::memcpy(buf, s, len);
+    buf[len] = '\0';
+    char* end = nullptr;
+    value = std::strtod(buf, &end);
+    return end == buf + len && std::isfinite(value);
+}
+
+std::size_t formatInt64(std::int64_t value, char* dest) {
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    std::uint64_t v = value < 0 ? 0 - static_cast<std::uint64_t>(value) : value;
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    std::size_t size = buf + sizeof(buf) - p;
+    std::memcpy(dest, p, size);
+    return size;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+////////////////////////////////////////////////////////////////////////
+// ColumnarRowsBuilder
+////////////////////////////////////////////////////////////////////////
+
+ColumnarRowsBuilder::ColumnarRowsBuilder(ColumnarRows& rows,
+                                         std::vector<ResultColumn::Encoding> const& encodings)
+    : _rows(rows) {
+    if (_rows.column_size() != 0) {
+        throw Bug("ColumnarRowsBuilder: ColumnarRows already has columns");
+    }
+    _rows.set_rowcount(0);
+    for (auto encoding : encodings) {
+        ResultColumn* column = _rows.add_column();
+        column->set_encoding(encoding);
+        _columns.push_back(column);
+    }
+}
+
+std::size_t ColumnarRowsBuilder::addRow(char const* const* row, unsigned long const* lengths) {
+    std::uint32_t const rowIdx = _rows.rowcount();
+    std::size_t size = 0;
+    for (unsigned i = 0; i < _columns.size(); ++i) {
+        ResultColumn& column = *_columns[i];
+        if (!row[i]) {
+            _setNull(column, rowIdx);
+            switch (column.encoding()) {
+            case ResultColumn::INT64: column.add_intvalue(0); size += 8; break;
+            case ResultColumn::DOUBLE: column.add_doublevalue(0); size += 8; break;
+            default: column.add_offset(column.data().size()); size += 1; break;
+            }
+            continue;
+        }
+        if (column.encoding() == ResultColumn::INT64) {
+            std::int64_t value;
+            if (parseInt64(row[i], lengths[i], value)) {
+                column.add_intvalue(value);
+                size += 8;
+                continue;
+            }
+            _toText(column, rowIdx);
+        } else if (column.encoding() == ResultColumn::DOUBLE) {
+            double value;
+            if (parseDouble(row[i], lengths[i], value)) {
+                column.add_doublevalue(value);
+                size += 8;
+                continue;
+            }
+            _toText(column, rowIdx);
+        }
+        column.mutable_data()->append(row[i], lengths[i]);
+        column.add_offset(column.data().size());
+        size += lengths[i] + 2; // value and its offset varint
+    }
+    _rows.set_rowcount(rowIdx + 1);
+    return size;
+}
+
+void ColumnarRowsBuilder::_setNull(ResultColumn& column, std::uint32_t rowIdx) {
+    std::string& bitmap = *column.mutable_nullbitmap();
+    std::size_t const byteIdx = rowIdx / 8;
+    if (bitmap.size() <= byteIdx) {
+        bitmap.resize(byteIdx + 1, '\0');
+    }
+    bitmap[byteIdx] |= static_cast<char>(1 << (rowIdx % 8));
+}
+
+/// Re-encode the first rowCount rows of a numeric column as TEXT.
+void ColumnarRowsBuilder::_toText(ResultColumn& column, std::uint32_t rowCount) {
+    ColumnarRows single;
+    single.set_rowcount(rowCount);
+    single.add_column()->Swap(&column);
+    ColumnarRowsReader reader(single);
+    ResultColumn& numeric = *single.mutable_column(0);
+    column.set_encoding(ResultColumn::TEXT);
+    column.set_nullbitmap(numeric.nullbitmap());
+    std::string& data = *column.mutable_data();
+    char buf[ColumnarRowsReader::maxNumberSize];
+    for (std::uint32_t r = 0; r < rowCount; ++r) {
+        if (!reader.isNull(0, r)) {
+            data.append(buf, reader.formatNumber(0, r, buf));
+        }
+        column.add_offset(data.size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// ColumnarRowsReader
+////////////////////////////////////////////////////////////////////////
+
+bool ColumnarRowsReader::isNull(int col, int row) const {
+    std::string const& bitmap = _rows.column(col).nullbitmap();
+    std::size_t const byteIdx = row / 8;
+    return byteIdx < bitmap.size() && (bitmap[byteIdx] & (1 << (row % 8)));
+}
+
+void ColumnarRowsReader::getText(int col, int row, char const*& data, std::size_t& size) const {
+    ResultColumn const& column = _rows.column(col);
+    std::uint32_t const begin = (row == 0) ? 0 : column.offset(row - 1);
+    data = column.data().data() + begin;
+    size = column.offset(row) - begin;
+}
+
+std::size_t ColumnarRowsReader::formatNumber(int col, int row, char* dest) const {
+    ResultColumn const& column = _rows.column(col);
+    if (column.encoding() == ResultColumn::INT64) {
+        return formatInt64(column.intvalue(row), dest);
+    }
+    return util::doubleToString(column.doublevalue(row), dest);
+}
+
+void ColumnarRowsReader::appendRowsTo(Result& result) const {
+    int const rowCount = getRowCount();
+    int const colCount = getColumnCount();
+    char buf[maxNumberSize];
+    for (int r = 0; r < rowCount; ++r) {
+        RowBundle* rb = result.add_row();
+        for (int c = 0; c < colCount; ++c) {
+            if (isNull(c, r)) {
+                rb->add_column();
+                rb->add_isnull(true);
+                continue;
+            }
+            if (isText(c)) {
+                char const* data;
+                std::size_t size;
+                getText(c, r, data, size);
+                rb->add_column(data, size);
+            } else {
+                rb->add_column(buf, formatNumber(c, r, buf));
+            }
+            rb->add_isnull(false);
+        }
+    }
+}
+
+}}} // namespace lsst::qserv::proto
@@ -0,0 +1,102 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_PROTO_COLUMNARROWS_H
+#define LSST_QSERV_PROTO_COLUMNARROWS_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// ColumnarRowsBuilder appends rows, as text cells returned by MySQL, to a
+/// protocol 3 ColumnarRows message.
+///
+/// INT64 and DOUBLE columns store parsed values. If a cell of such a column
+/// does not parse exactly (e.g. an unsigned BIGINT past INT64_MAX), the
+/// column falls back to TEXT for the rest of the message.
+class ColumnarRowsBuilder {
+public:
+    /// @param rows message to append to, which must have no columns yet
+    /// @param encodings requested encoding of each column
+    ColumnarRowsBuilder(ColumnarRows& rows,
+                        std::vector<ResultColumn::Encoding> const& encodings);
+
+    /// Append a row. row[i] is nullptr for NULL cells.
+    /// @return an estimate of the bytes the row adds to the message
+    std::size_t addRow(char const* const* row, unsigned long const* lengths);
+
+private:
+    void _setNull(ResultColumn& column, std::uint32_t rowIdx);
+    void _toText(ResultColumn& column, std::uint32_t rowCount);
+
+    ColumnarRows& _rows;
+    std::vector<ResultColumn*> _columns;
+};
+
+/// ColumnarRowsReader gives cell access to a ColumnarRows message, as text
+/// that MySQL reads back to the same values.
+class ColumnarRowsReader {
+public:
+    explicit ColumnarRowsReader(ColumnarRows const& rows) : _rows(rows) {}
+
+    int getRowCount() const { return _rows.rowcount(); }
+    int getColumnCount() const { return _rows.column_size(); }
+
+    bool isNull(int col, int row) const;
+    bool isText(int col) const {
+        return _rows.column(col).encoding() == ResultColumn::TEXT;
+    }
+
+    /// Get the bytes of a non-NULL cell of a TEXT column.
+    void getText(int col, int row, char const*& data, std::size_t& size) const;
+
+    /// Format a non-NULL cell of a numeric column as text.
+    /// @param dest buffer of at least maxNumberSize bytes
+    /// @return the number of bytes written
+    std::size_t formatNumber(int col, int row, char* dest) const;
+
+    /// Append the rows to result as RowBundles, i.e. protocol 2 rows.
+    void appendRowsTo(Result& result) const;
+
+    static std::size_t const maxNumberSize = 32;
+
+private:
+    ColumnarRows const& _rows;
+};
+
+/// @return the number of rows of result, whichever protocol it uses
+inline int getResultRowCount(Result const& result) {
+    return result.has_columnar() ? static_cast<int>(result.columnar().rowcount())
+                                 : result.row_size();
+}
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_COLUMNARROWS_H
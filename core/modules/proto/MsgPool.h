@@ -0,0 +1,122 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_PROTO_MSGPOOL_H
+#define LSST_QSERV_PROTO_MSGPOOL_H
+
+// System headers
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "proto/WorkerResponse.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// Clear a message for reuse. Protobuf Clear() keeps the elements of
+/// repeated fields and the capacity of strings, which the next Add*(),
+/// set_*() or ParseFrom*() call then reuses.
+inline void clearForReuse(Result& msg) { msg.Clear(); }
+inline void clearForReuse(WorkerResponse& msg) {
+    msg.headerSize = 0;
+    msg.protoHeader.Clear();
+    msg.result.Clear();
+}
+
+/// MsgPool recycles result messages, so that filling or parsing the next
+/// ~2MB message reuses the RowBundles, cell strings and columns of an
+/// earlier one instead of allocating each again.
+///
+/// This stands in for protobuf arenas, which need protobuf 3 and a
+/// cc_enable_arenas option. A recycled message keeps the memory of the
+/// largest message it held, so the pool keeps at most maxMsgs of them.
+template <class T>
+class MsgPool {
+public:
+    typedef std::shared_ptr<T> Ptr;
+
+    explicit MsgPool(std::size_t maxMsgs) : _maxMsgs(maxMsgs) {}
+    MsgPool(MsgPool const&) = delete;
+    MsgPool& operator=(MsgPool const&) = delete;
+
+    /// @return a cleared message, which goes back to the pool once the
+    ///         last pointer to it is gone. The pool must outlive it.
+    Ptr acquire() {
+        T* msg = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (!_free.empty()) {
+                msg = _free.back().release();
+                _free.pop_back();
+            }
+        }
+        if (msg) {
+            ++_reused;
+        } else {
+            msg = new T();
+            ++_allocated;
+        }
+        return Ptr(msg, [this](T* m) { _release(m); });
+    }
+
+    /// @return the number of messages waiting to be reused
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _free.size();
+    }
+
+    std::size_t getAllocated() const { return _allocated; } ///< Messages created
+    std::size_t getReused() const { return _reused; } ///< Acquisitions served by the pool
+
+    /// @return the pool shared by everything in this process. It is never
+    ///         destroyed, as messages may be released during exit.
+    static MsgPool& getPool() {
+        static MsgPool* pool = new MsgPool(64);
+        return *pool;
+    }
+
+private:
+    void _release(T* m) {
+        std::unique_ptr<T> msg(m);
+        clearForReuse(*msg);
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_free.size() < _maxMsgs) {
+            _free.push_back(std::move(msg));
+        }
+    }
+
+    std::size_t const _maxMsgs;
+    std::vector<std::unique_ptr<T>> _free;
+    mutable std::mutex _mtx;
+    std::atomic<std::size_t> _allocated{0};
+    std::atomic<std::size_t> _reused{0};
+};
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_MSGPOOL_H
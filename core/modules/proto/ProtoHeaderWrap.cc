@@ -29,6 +29,7 @@
 // Qserv headers
 #include "proto/ProtoHeaderWrap.h"
 #include "util/common.h"
+#include "util/StringHash.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.parser.ProtoHeaderWrap");
@@ -66,4 +67,36 @@ bool ProtoHeaderWrap::unwrap(std::shared_ptr<WorkerResponse>& response, std::vec
     return true;
 }
 
+void ProtoHeaderWrap::setChecksum(ProtoHeader& header, ProtoHeader::ChecksumType type,
+                                  char const* buffer, size_t bufferSize) {
+    switch (type) {
+    case ProtoHeader::CRC32C:
+        header.set_checksumtype(type);
+        header.set_checksum(util::StringHash::getCrc32c(buffer, bufferSize));
+        break;
+    case ProtoHeader::XXHASH64:
+        header.set_checksumtype(type);
+        header.set_checksum(util::StringHash::getXxHash64(buffer, bufferSize));
+        break;
+    default:
+        // Leave checksumtype unset, so that czars predating it can verify.
+        header.set_md5(util::StringHash::getMd5(buffer, bufferSize));
+        break;
+    }
+}
+
+bool ProtoHeaderWrap::checkChecksum(ProtoHeader const& header,
+                                    char const* buffer, size_t bufferSize) {
+    switch (header.checksumtype()) {
+    case ProtoHeader::CRC32C:
+        return header.has_checksum()
+            && header.checksum() == util::StringHash::getCrc32c(buffer, bufferSize);
+    case ProtoHeader::XXHASH64:
+        return header.has_checksum()
+            && header.checksum() == util::StringHash::getXxHash64(buffer, bufferSize);
+    default:
+        return header.md5() == util::StringHash::getMd5(buffer, bufferSize);
+    }
+}
+
 }}} // namespace lsst::qserv::proto
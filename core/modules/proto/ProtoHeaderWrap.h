@@ -52,6 +52,14 @@ public:
 
     static std::string wrap(std::string& protoHeaderString);
     static bool unwrap(std::shared_ptr<WorkerResponse>& response, std::vector<char>& buffer);
+
+    /// Checksum the result message in buffer into header, using type.
+    static void setChecksum(ProtoHeader& header, ProtoHeader::ChecksumType type,
+                            char const* buffer, size_t bufferSize);
+    /// @return true if the result message in buffer matches the checksum
+    /// of header, whichever type it is.
+    static bool checkChecksum(ProtoHeader const& header,
+                              char const* buffer, size_t bufferSize);
 };
 
 }}} // end namespace
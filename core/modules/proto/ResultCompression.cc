@@ -0,0 +1,153 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "proto/ResultCompression.h"
+
+// System headers
+#include <chrono>
+
+// Third-party headers
+#include <zlib.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/ProtoHeaderWrap.h"
+#include "util/Lz4.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.proto.ResultCompression");
+
+typedef std::chrono::steady_clock Clock;
+
+std::uint64_t usecSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+ResultCompression::AtomicStats ResultCompression::_compressStats;
+ResultCompression::AtomicStats ResultCompression::_uncompressStats;
+
+std::uint64_t ResultCompression::AtomicStats::add(std::uint64_t rawBytes, std::uint64_t wireBytes,
+                                                  std::uint64_t cpuUsec) {
+    _rawBytes += rawBytes;
+    _wireBytes += wireBytes;
+    _cpuUsec += cpuUsec;
+    return ++_messages;
+}
+
+ResultCompression::Stats ResultCompression::AtomicStats::get() const {
+    Stats stats;
+    stats.messages = _messages;
+    stats.rawBytes = _rawBytes;
+    stats.wireBytes = _wireBytes;
+    stats.cpuUsec = _cpuUsec;
+    return stats;
+}
+
+bool ResultCompression::compress(ProtoHeader& header, ProtoHeader::CompressionType type,
+                                 std::string const& msg, std::string& out) {
+    auto start = Clock::now();
+    std::size_t size = 0;
+    switch (type) {
+    case ProtoHeader::LZ4:
+        out.resize(util::Lz4::compressBound(msg.size()));
+        size = util::Lz4::compress(msg.data(), msg.size(), &out[0]);
+        break;
+    case ProtoHeader::ZLIB: {
+        uLongf destLen = compressBound(msg.size());
+        out.resize(destLen);
+        if (compress2(reinterpret_cast<Bytef*>(&out[0]), &destLen,
+                      reinterpret_cast<Bytef const*>(msg.data()), msg.size(), Z_BEST_SPEED) != Z_OK) {
+            LOGS(_log, LOG_LVL_WARN, "zlib failed to compress, sending the result uncompressed");
+            return false;
+        }
+        size = destLen;
+        break;
+    }
+    default:
+        return false;
+    }
+    if (size >= msg.size()) {
+        return false;
+    }
+    out.resize(size);
+    std::uint64_t const usec = usecSince(start);
+    std::uint64_t const messages = _compressStats.add(msg.size(), size, usec);
+    header.set_compression(type);
+    header.set_rawsize(msg.size());
+    LOGS(_log, LOG_LVL_DEBUG, "compressed " << ProtoHeader::CompressionType_Name(type)
+         << " raw=" << msg.size() << " wire=" << size
+         << " ratio=" << double(msg.size()) / size << " usec=" << usec);
+    if (messages % 1000 == 0) {
+        LOGS(_log, LOG_LVL_INFO, "Result compression totals: " << getCompressStats());
+    }
+    return true;
+}
+
+bool ResultCompression::uncompress(ProtoHeader const& header, char const* data, std::size_t size,
+                                   std::vector<char>& out) {
+    if (!header.has_rawsize() || header.rawsize() > ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT) {
+        LOGS(_log, LOG_LVL_ERROR, "Compressed result has a bad raw size " << header.rawsize());
+        return false;
+    }
+    auto start = Clock::now();
+    out.resize(header.rawsize());
+    bool ok = false;
+    switch (header.compression()) {
+    case ProtoHeader::LZ4:
+        ok = util::Lz4::decompress(data, size, out.data(), out.size());
+        break;
+    case ProtoHeader::ZLIB: {
+        uLongf destLen = out.size();
+        ok = ::uncompress(reinterpret_cast<Bytef*>(out.data()), &destLen,
+                          reinterpret_cast<Bytef const*>(data), size) == Z_OK
+            && destLen == out.size();
+        break;
+    }
+    default:
+        break;
+    }
+    if (!ok) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to uncompress "
+             << ProtoHeader::CompressionType_Name(header.compression()) << " result");
+        return false;
+    }
+    _uncompressStats.add(out.size(), size, usecSince(start));
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& os, ResultCompression::Stats const& stats) {
+    return os << "messages=" << stats.messages << " rawBytes=" << stats.rawBytes
+              << " wireBytes=" << stats.wireBytes << " ratio=" << stats.getRatio()
+              << " cpuMs=" << stats.cpuUsec / 1000;
+}
+
+}}} // namespace lsst::qserv::proto
@@ -0,0 +1,91 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_PROTO_RESULTCOMPRESSION_H
+#define LSST_QSERV_PROTO_RESULTCOMPRESSION_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// ResultCompression compresses serialized Result messages on the worker
+/// and restores them on the czar. The codec and the uncompressed size
+/// travel in the ProtoHeader; the checksum covers the bytes on the wire.
+class ResultCompression {
+public:
+    /// Process-wide totals of one direction.
+    struct Stats {
+        std::uint64_t messages{0};
+        std::uint64_t rawBytes{0};  ///< uncompressed
+        std::uint64_t wireBytes{0}; ///< compressed
+        std::uint64_t cpuUsec{0};   ///< time spent in the codec
+
+        double getRatio() const { return wireBytes ? double(rawBytes) / wireBytes : 0; }
+    };
+
+    /// Compress msg with type into out, and record the codec and the
+    /// uncompressed size in header.
+    /// @return false, leaving header untouched, if type is NONE or the
+    ///         message does not shrink; msg is then sent as is.
+    static bool compress(ProtoHeader& header, ProtoHeader::CompressionType type,
+                         std::string const& msg, std::string& out);
+
+    /// Uncompress the result message data, as described by header, into out.
+    /// @return false if the message is corrupt or its codec unknown
+    static bool uncompress(ProtoHeader const& header, char const* data, std::size_t size,
+                           std::vector<char>& out);
+
+    static Stats getCompressStats() { return _compressStats.get(); }
+    static Stats getUncompressStats() { return _uncompressStats.get(); }
+
+private:
+    class AtomicStats {
+    public:
+        /// @return the number of messages so far
+        std::uint64_t add(std::uint64_t rawBytes, std::uint64_t wireBytes, std::uint64_t cpuUsec);
+        Stats get() const;
+    private:
+        std::atomic<std::uint64_t> _messages{0};
+        std::atomic<std::uint64_t> _rawBytes{0};
+        std::atomic<std::uint64_t> _wireBytes{0};
+        std::atomic<std::uint64_t> _cpuUsec{0};
+    };
+
+    static AtomicStats _compressStats;
+    static AtomicStats _uncompressStats;
+};
+
+std::ostream& operator<<(std::ostream& os, ResultCompression::Stats const& stats);
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_RESULTCOMPRESSION_H
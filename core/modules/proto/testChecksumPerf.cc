@@ -0,0 +1,127 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of result message throughput under each ChecksumType. Each
+/// message goes through what the worker and the czar do with it:
+/// serialize, checksum and wrap the header, then unwrap, verify and parse.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testChecksumPerf [messages [rows]]
+
+// System headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/ProtoHeaderWrap.h"
+#include "proto/worker.pb.h"
+#include "proto/WorkerResponse.h"
+
+namespace proto = lsst::qserv::proto;
+
+namespace {
+
+/// Build a Result message of nRows rows of numeric-looking columns.
+void makeResult(proto::Result& result, int nRows) {
+    int const nCols = 10;
+    auto schema = result.mutable_rowschema();
+    for(int c=0; c < nCols; ++c) {
+        auto cs = schema->add_columnschema();
+        cs->set_name("col" + std::to_string(c));
+        cs->set_hasdefault(false);
+        cs->set_sqltype("DOUBLE");
+    }
+    for(int r=0; r < nRows; ++r) {
+        proto::RowBundle* rb = result.add_row();
+        for(int c=0; c < nCols; ++c) {
+            rb->add_column(std::to_string(r * 1.000123 + c));
+            rb->add_isnull(false);
+        }
+    }
+    result.set_continues(false);
+    result.set_queryid(1);
+    result.set_jobid(1);
+    result.set_largeresult(false);
+    result.set_rowcount(nRows);
+    result.set_transmitsize(0);
+}
+
+/// Send nMsgs copies of result through the checksummed path and report
+/// end-to-end and checksum-only throughput.
+void runCase(std::string const& name, proto::ProtoHeader::ChecksumType type,
+             proto::Result const& result, int nMsgs) {
+    std::chrono::duration<double> checksumTime{0};
+    unsigned long long total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i < nMsgs; ++i) {
+        // Worker side
+        std::string msg;
+        result.SerializeToString(&msg);
+        proto::ProtoHeader header;
+        header.set_protocol(2);
+        header.set_size(msg.size());
+        auto csStart = std::chrono::steady_clock::now();
+        proto::ProtoHeaderWrap::setChecksum(header, type, msg.data(), msg.size());
+        checksumTime += std::chrono::steady_clock::now() - csStart;
+        std::string headerString;
+        header.SerializeToString(&headerString);
+        std::string wrapped = proto::ProtoHeaderWrap::wrap(headerString);
+
+        // Czar side
+        std::vector<char> headerBuf(wrapped.begin(), wrapped.end());
+        auto response = std::make_shared<proto::WorkerResponse>();
+        if (!proto::ProtoHeaderWrap::unwrap(response, headerBuf)) {
+            std::cerr << name << ": unwrap failed" << std::endl;
+            exit(1);
+        }
+        csStart = std::chrono::steady_clock::now();
+        bool ok = proto::ProtoHeaderWrap::checkChecksum(response->protoHeader, msg.data(), msg.size());
+        checksumTime += std::chrono::steady_clock::now() - csStart;
+        if (!ok || !response->result.ParseFromString(msg)) {
+            std::cerr << name << ": verification failed" << std::endl;
+            exit(1);
+        }
+        total += msg.size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double mb = total / (1024.0 * 1024.0);
+    std::cout << name << ": " << nMsgs << " msgs, " << mb << " MB, "
+              << mb / elapsed.count() << " MB/s end-to-end, "
+              << 2 * mb / checksumTime.count() << " MB/s checksum" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int nMsgs = argc > 1 ? std::atoi(argv[1]) : 50;
+    int nRows = argc > 2 ? std::atoi(argv[2]) : 10000;
+    proto::Result result;
+    makeResult(result, nRows);
+    runCase("MD5", proto::ProtoHeader::MD5, result, nMsgs);
+    runCase("CRC32C", proto::ProtoHeader::CRC32C, result, nMsgs);
+    runCase("XXHASH64", proto::ProtoHeader::XXHASH64, result, nMsgs);
+    return 0;
+}
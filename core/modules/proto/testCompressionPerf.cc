@@ -0,0 +1,121 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of result message compression under each CompressionType, on
+/// an Object-like result of ids, flags and doubles: ratio, and compression
+/// (worker) and uncompression (czar) throughput in raw MB/s.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testCompressionPerf [messages [rows]]
+
+// System headers
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/ResultCompression.h"
+#include "proto/worker.pb.h"
+
+namespace proto = lsst::qserv::proto;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// Build a Result message of nRows rows like a full-sky Object query returns.
+void makeResult(proto::Result& result, int nRows) {
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> ra(0, 360);
+    std::uniform_real_distribution<double> flux(0, 1e-28);
+    char buf[32];
+    for(int r=0; r < nRows; ++r) {
+        proto::RowBundle* rb = result.add_row();
+        rb->add_column(std::to_string(386942193000000000LL + 3 * r));
+        rb->add_column(std::to_string(r % 4));
+        for(int c=0; c < 8; ++c) {
+            std::snprintf(buf, sizeof(buf), "%.17g", c < 2 ? ra(gen) : flux(gen));
+            rb->add_column(buf);
+        }
+        rb->add_column(); // NULL
+        for(int c=0; c < 11; ++c) {
+            rb->add_isnull(c == 10);
+        }
+    }
+    result.mutable_rowschema();
+    result.set_continues(false);
+    result.set_queryid(1);
+    result.set_jobid(1);
+    result.set_largeresult(false);
+    result.set_rowcount(nRows);
+    result.set_transmitsize(0);
+}
+
+void runCase(std::string const& name, proto::ProtoHeader::CompressionType type,
+             std::string const& msg, int nMsgs) {
+    std::chrono::duration<double> compressTime{0};
+    std::chrono::duration<double> uncompressTime{0};
+    std::size_t wireSize = 0;
+    // Buffers are reused, as the worker buffer pool and MergingHandler do.
+    std::string wire;
+    std::vector<char> raw;
+    for(int i=0; i < nMsgs; ++i) {
+        proto::ProtoHeader header;
+        header.set_size(0);
+        auto start = Clock::now();
+        if (!proto::ResultCompression::compress(header, type, msg, wire)) {
+            std::cerr << name << ": compression failed" << std::endl;
+            exit(1);
+        }
+        compressTime += Clock::now() - start;
+        start = Clock::now();
+        if (!proto::ResultCompression::uncompress(header, wire.data(), wire.size(), raw)) {
+            std::cerr << name << ": uncompression failed" << std::endl;
+            exit(1);
+        }
+        uncompressTime += Clock::now() - start;
+        wireSize = wire.size();
+    }
+    double mb = double(msg.size()) * nMsgs / (1024.0 * 1024.0);
+    std::cout << name << ": raw=" << msg.size() << " wire=" << wireSize
+              << " ratio=" << double(msg.size()) / wireSize
+              << " compress MB/s=" << mb / compressTime.count()
+              << " uncompress MB/s=" << mb / uncompressTime.count() << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int nMsgs = argc > 1 ? std::atoi(argv[1]) : 20;
+    int nRows = argc > 2 ? std::atoi(argv[2]) : 10000;
+    proto::Result result;
+    makeResult(result, nRows);
+    std::string msg;
+    result.SerializeToString(&msg);
+    runCase("LZ4", proto::ProtoHeader::LZ4, msg, nMsgs);
+    runCase("ZLIB", proto::ProtoHeader::ZLIB, msg, nMsgs);
+    return 0;
+}
@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of heap allocations per result message, with a new message
+/// per transmit as before and with messages recycled by proto::MsgPool.
+/// Encoding fills rows the way wdb::QueryRunner does and serializes them;
+/// decoding parses them into a WorkerResponse like ccontrol::MergingHandler.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testMsgPoolPerf [messages [rows]]
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+// Qserv headers
+#include "proto/MsgPool.h"
+#include "proto/worker.pb.h"
+#include "proto/WorkerResponse.h"
+
+namespace proto = lsst::qserv::proto;
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+typedef std::chrono::steady_clock Clock;
+
+/// Fill result with nRows rows of an Object-like query, as
+/// QueryRunner::_fillRows does with the cells of a MYSQL_ROW.
+void fillResult(proto::Result& result, int nRows, int msgNum) {
+    char buf[32];
+    result.mutable_rowschema();
+    for(int r=0; r < nRows; ++r) {
+        proto::RowBundle* rb = result.add_row();
+        rb->add_column(std::to_string(386942193000000000LL + 3 * (msgNum * nRows + r)));
+        rb->add_column(std::to_string(r % 4));
+        for(int c=0; c < 8; ++c) {
+            std::snprintf(buf, sizeof(buf), "%.17g", (c + 1) * 1.0e-3 * (r + 1));
+            rb->add_column(buf);
+        }
+        rb->add_column(); // NULL
+        for(int c=0; c < 11; ++c) {
+            rb->add_isnull(c == 10);
+        }
+    }
+    result.set_continues(false);
+    result.set_queryid(1);
+    result.set_jobid(1);
+    result.set_largeresult(false);
+    result.set_rowcount(nRows);
+    result.set_transmitsize(0);
+}
+
+void report(std::string const& name, std::size_t allocs, Clock::duration elapsed, int nMsgs) {
+    double const secs = std::chrono::duration<double>(elapsed).count();
+    std::cout << name << ": allocations/msg=" << double(allocs) / nMsgs
+              << " msgs/s=" << nMsgs / secs << std::endl;
+}
+
+void encode(bool pooled, int nMsgs, int nRows, std::string& msg) {
+    proto::MsgPool<proto::Result> pool(1);
+    std::shared_ptr<proto::Result> result;
+    std::size_t const before = allocations;
+    auto start = Clock::now();
+    for(int i=0; i < nMsgs; ++i) {
+        if (pooled && result) {
+            result->Clear();
+        } else {
+            result = pooled ? pool.acquire() : std::make_shared<proto::Result>();
+        }
+        fillResult(*result, nRows, i);
+        result->SerializeToString(&msg);
+    }
+    report(pooled ? "encode pooled" : "encode fresh", allocations - before,
+           Clock::now() - start, nMsgs);
+}
+
+void decode(bool pooled, int nMsgs, std::string const& msg) {
+    proto::MsgPool<proto::WorkerResponse> pool(1);
+    std::size_t const before = allocations;
+    auto start = Clock::now();
+    for(int i=0; i < nMsgs; ++i) {
+        auto response = pooled ? pool.acquire() : std::make_shared<proto::WorkerResponse>();
+        if (!response->result.ParseFromArray(msg.data(), msg.size())) {
+            std::cerr << "parse failed" << std::endl;
+            exit(1);
+        }
+    }
+    report(pooled ? "decode pooled" : "decode fresh", allocations - before,
+           Clock::now() - start, nMsgs);
+}
+
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char* argv[]) {
+    int nMsgs = argc > 1 ? std::atoi(argv[1]) : 50;
+    int nRows = argc > 2 ? std::atoi(argv[2]) : 10000;
+    std::string msg;
+    encode(false, nMsgs, nRows, msg);
+    encode(true, nMsgs, nRows, msg);
+    std::cout << "message bytes=" << msg.size() << std::endl;
+    decode(false, nMsgs, msg);
+    decode(true, nMsgs, msg);
+    return 0;
+}
@@ -36,11 +36,14 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "proto/MsgPool.h"
 #include "proto/ProtoHeaderWrap.h"
+#include "proto/ResultCompression.h"
 #include "proto/ScanTableInfo.h"
 #include "proto/TaskMsgDigest.h"
 #include "proto/worker.pb.h"
 #include "proto/WorkerResponse.h"
+#include "util/StringHash.h"
 
 #include "proto/FakeProtocolFixture.h"
 
@@ -192,6 +195,105 @@ BOOST_AUTO_TEST_CASE(ProtoHeaderWrap) {
     BOOST_CHECK(compareProtoHeaders(response->protoHeader, *ph));
 }
 
+BOOST_AUTO_TEST_CASE(ProtoHeaderChecksum) {
+    std::string msg("Result message bytes, long enough to cover the 32-byte stripes.");
+    for (auto type : {proto::ProtoHeader::MD5, proto::ProtoHeader::CRC32C, proto::ProtoHeader::XXHASH64}) {
+        proto::ProtoHeader ph;
+        ph.set_size(msg.size());
+        proto::ProtoHeaderWrap::setChecksum(ph, type, msg.data(), msg.size());
+        // MD5 leaves checksumtype unset, so older czars can still verify it.
+        BOOST_CHECK_EQUAL(ph.has_checksumtype(), type != proto::ProtoHeader::MD5);
+        BOOST_CHECK_EQUAL(ph.checksumtype(), type);
+
+        // Round trip through the wire format.
+        std::string str;
+        ph.SerializeToString(&str);
+        proto::ProtoHeader ph2;
+        BOOST_CHECK(ph2.ParseFromString(str));
+        BOOST_CHECK(proto::ProtoHeaderWrap::checkChecksum(ph2, msg.data(), msg.size()));
+
+        std::string corrupt(msg);
+        corrupt[10] ^= 0x01;
+        BOOST_CHECK(!proto::ProtoHeaderWrap::checkChecksum(ph2, corrupt.data(), corrupt.size()));
+    }
+    // Known values.
+    std::string check("123456789");
+    BOOST_CHECK_EQUAL(util::StringHash::getCrc32c(check.data(), check.size()), 0xE3069283U);
+    BOOST_CHECK_EQUAL(util::StringHash::getXxHash64("", 0), 0xEF46DB3751D8E999ULL);
+    BOOST_CHECK_EQUAL(util::StringHash::getXxHash64("abc", 3), 0x44BC2CF5AD770999ULL);
+}
+
+BOOST_AUTO_TEST_CASE(ResultCompression) {
+    std::string msg;
+    for (int i = 0; i < 2000; ++i) {
+        msg += "386942193" + std::to_string(i) + "\t0.123456789\tNULL\n";
+    }
+    for (auto type : {proto::ProtoHeader::LZ4, proto::ProtoHeader::ZLIB}) {
+        proto::ProtoHeader ph;
+        ph.set_size(0);
+        std::string wire;
+        BOOST_REQUIRE(proto::ResultCompression::compress(ph, type, msg, wire));
+        BOOST_CHECK_EQUAL(ph.compression(), type);
+        BOOST_CHECK_EQUAL(ph.rawsize(), msg.size());
+        BOOST_CHECK(wire.size() < msg.size() / 2);
+
+        std::vector<char> raw;
+        BOOST_REQUIRE(proto::ResultCompression::uncompress(ph, wire.data(), wire.size(), raw));
+        BOOST_CHECK(std::string(raw.begin(), raw.end()) == msg);
+
+        // Truncated or mislabelled messages are rejected.
+        BOOST_CHECK(!proto::ResultCompression::uncompress(ph, wire.data(), wire.size() / 2, raw));
+        proto::ProtoHeader wrongSize(ph);
+        wrongSize.set_rawsize(msg.size() + 1);
+        BOOST_CHECK(!proto::ResultCompression::uncompress(wrongSize, wire.data(), wire.size(), raw));
+    }
+    // NONE, or a message that does not shrink, is sent as is.
+    proto::ProtoHeader ph;
+    ph.set_size(0);
+    std::string wire;
+    BOOST_CHECK(!proto::ResultCompression::compress(ph, proto::ProtoHeader::NONE, msg, wire));
+    BOOST_CHECK(!proto::ResultCompression::compress(ph, proto::ProtoHeader::LZ4, "abc", wire));
+    BOOST_CHECK(!ph.has_compression());
+    BOOST_CHECK(proto::ResultCompression::getCompressStats().messages >= 2);
+}
+
+BOOST_AUTO_TEST_CASE(MsgPool) {
+    proto::MsgPool<proto::Result> pool(1);
+    proto::RowBundle const* firstRow;
+    {
+        auto result = pool.acquire();
+        result->add_row()->add_column("386942193000000000");
+        result->set_rowcount(1);
+        firstRow = &result->row(0);
+    }
+    BOOST_CHECK_EQUAL(pool.size(), 1U);
+    {
+        // The message comes back cleared, and reuses its RowBundle.
+        auto result = pool.acquire();
+        BOOST_CHECK_EQUAL(result->row_size(), 0);
+        BOOST_CHECK(!result->has_rowcount());
+        BOOST_CHECK(result->add_row() == firstRow);
+        BOOST_CHECK_EQUAL(firstRow->column_size(), 0);
+
+        // Only maxMsgs messages are kept.
+        auto other = pool.acquire();
+        BOOST_CHECK_EQUAL(pool.getAllocated(), 2U);
+        BOOST_CHECK_EQUAL(pool.getReused(), 1U);
+    }
+    BOOST_CHECK_EQUAL(pool.size(), 1U);
+
+    auto& responses = proto::MsgPool<proto::WorkerResponse>::getPool();
+    auto response = responses.acquire();
+    response->headerSize = 10;
+    response->protoHeader.set_wname("worker");
+    response->result.set_continues(1);
+    response.reset();
+    response = responses.acquire();
+    BOOST_CHECK_EQUAL(response->headerSize, 0);
+    BOOST_CHECK(!response->protoHeader.has_wname());
+    BOOST_CHECK(!response->result.has_continues());
+}
+
 BOOST_AUTO_TEST_CASE(ScanTableInfo) {
     lsst::qserv::proto::ScanTableInfo stiA{"dba", "fruit", false, 1};
     lsst::qserv::proto::ScanTableInfo stiB{"dba", "fruit", true, 1};
@@ -43,6 +43,7 @@
 #include "boost/lexical_cast.hpp"
 
 // Qserv headers
+#include "global/sqltoken.h"
 #include "qproc/ChunkSpec.h"
 #include "query/QueryTemplate.h"
 
@@ -177,6 +178,96 @@ QueryMapping::apply(qproc::ChunkSpecSingle const& s,
     return t.generate(m);
 }
 
+QueryMapping::ChunkTemplate
+QueryMapping::compile(query::QueryTemplate const& t) const {
+    typedef ChunkTemplate::Segment Segment;
+    typedef std::vector<Segment> SegmentVector;
+    for(auto const& sub : _subs) {
+        if (sub.second == HTM1) { throw std::range_error("HTM unimplemented"); }
+        if (sub.second != INVALID && sub.second != CHUNK && sub.second != SUBCHUNK) {
+            throw std::range_error("Unknown mapping parameter");
+        }
+    }
+    // Append seg to segs, joining adjacent literals.
+    auto appendSegment = [](SegmentVector& segs, Segment const& seg) {
+        if (seg.param == INVALID && !segs.empty() && segs.back().param == INVALID) {
+            segs.back().text += seg.text;
+        } else {
+            segs.push_back(seg);
+        }
+    };
+    ChunkTemplate ct;
+    // Text of the previous entry as generate() sees it, for spacing.
+    // Placeholders stand for numbers, so a digit stands in for them.
+    std::string lastEntry;
+    for(auto const& e : t.getEntries()) {
+        if (!e) {
+            throw std::invalid_argument("NULL QueryTemplate::Entry");
+        }
+        // Replace one tag after the other, as Mapping::mapEntry does.
+        SegmentVector segs{Segment{e->getValue(), INVALID}};
+        for(auto const& sub : _subs) {
+            if (sub.first.empty()) continue;
+            SegmentVector split;
+            for(auto const& seg : segs) {
+                if (seg.param != INVALID) {
+                    split.push_back(seg);
+                    continue;
+                }
+                std::size_t i = 0;
+                while(true) {
+                    std::size_t j = seg.text.find(sub.first, i);
+                    appendSegment(split, Segment{seg.text.substr(i, j - i), INVALID});
+                    if (j == std::string::npos) {
+                        break;
+                    }
+                    appendSegment(split, sub.second == INVALID ?
+                                  Segment{"INVALID", INVALID} : Segment{"", sub.second});
+                    i = j + sub.first.size();
+                }
+            }
+            segs.swap(split);
+        }
+        std::string entry;
+        for(auto const& seg : segs) {
+            entry += seg.param == INVALID ? seg.text : std::string("0");
+        }
+        if (entry.empty()) {
+            continue;
+        }
+        if (!lastEntry.empty() &&
+           sql::sqlShouldSeparate(lastEntry, *lastEntry.rbegin(), entry.at(0))) {
+            appendSegment(ct._segments, Segment{" ", INVALID});
+        }
+        for(auto const& seg : segs) {
+            if (seg.param != INVALID || !seg.text.empty()) {
+                appendSegment(ct._segments, seg);
+            }
+        }
+        lastEntry.swap(entry);
+    }
+    for(auto const& seg : ct._segments) {
+        ct._textSize += seg.text.size();
+    }
+    return ct;
+}
+
+std::string
+QueryMapping::ChunkTemplate::generate(int chunkId, int subChunkId) const {
+    std::string const chunk = std::to_string(chunkId);
+    std::string const subChunk = std::to_string(subChunkId);
+    std::string q;
+    q.reserve(_textSize + _segments.size() * 10);
+    for(auto const& seg : _segments) {
+        switch(seg.param) {
+        case CHUNK:    q += chunk; break;
+        case SUBCHUNK: q += subChunk; break;
+        default:       q += seg.text; break;
+        }
+    }
+    return q;
+}
+
 void
 QueryMapping::update(QueryMapping const& m) {
     // Update this mapping to reflect the union of the two mappings.
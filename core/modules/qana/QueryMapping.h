@@ -33,6 +33,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 // Forward declarations
 namespace lsst {
@@ -77,6 +78,26 @@ public:
     typedef std::map<std::string,Parameter> ParameterMap;
     typedef std::set<std::string> StringSet;
 
+    /// ChunkTemplate is a QueryTemplate rendered once for a QueryMapping,
+    /// into literal text and chunk/subchunk placeholders. Generating the
+    /// query of one more chunk is then a few appends, instead of mapping and
+    /// spacing every template entry again.
+    class ChunkTemplate {
+    public:
+        /// @return the query that apply() would generate for chunkId and
+        ///         subChunkId, which must not be negative.
+        std::string generate(int chunkId, int subChunkId=0) const;
+
+    private:
+        friend class QueryMapping;
+        struct Segment {
+            std::string text; ///< literal text, if param is INVALID
+            Parameter param;  ///< CHUNK or SUBCHUNK placeholder
+        };
+        std::vector<Segment> _segments;
+        std::size_t _textSize{0};
+    };
+
     QueryMapping();
 
     std::string apply(qproc::ChunkSpec const& s,
@@ -84,6 +105,9 @@ public:
     std::string apply(qproc::ChunkSpecSingle const& s,
                       query::QueryTemplate const& t) const;
 
+    /// Render t once for repeated generation.
+    ChunkTemplate compile(query::QueryTemplate const& t) const;
+
     // Modifiers
     void insertSubChunkTable(std::string const& table) {
         _subChunkTables.insert(table); }
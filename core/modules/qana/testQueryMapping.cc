@@ -0,0 +1,109 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+  /**
+  *
+  * @brief Test that compiled query templates generate the same queries as
+  * QueryMapping::apply().
+  *
+  */
+
+// System headers
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "qana/QueryMapping.h"
+#include "qproc/ChunkSpec.h"
+#include "query/QueryTemplate.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE QueryMapping
+#include "boost/test/included/unit_test.hpp"
+
+using lsst::qserv::qana::QueryMapping;
+using lsst::qserv::qproc::ChunkSpec;
+using lsst::qserv::qproc::ChunkSpecSingle;
+using lsst::qserv::query::QueryTemplate;
+
+namespace {
+
+QueryTemplate makeTemplate(std::vector<std::string> const& entries) {
+    QueryTemplate t;
+    for (auto const& e : entries) {
+        t.append(e);
+    }
+    return t;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(CompileChunk) {
+    QueryMapping qm;
+    qm.insertChunkEntry("%CC%");
+    // Spacing depends on the characters next to substituted numbers.
+    QueryTemplate t = makeTemplate({"SELECT", "o.ra", ",", "COUNT(*)", "AS", "n",
+        "FROM", "LSST.Object_%CC%", "AS", "o", "WHERE", "o.chunkId", "=", "%CC%",
+        "AND", "(", "%CC%", ")", "_", "%CC%", "'%CC%'", "%SS%", "GROUP BY", "o.ra"});
+    auto ct = qm.compile(t);
+    for (int chunkId : {0, 7, 6630, 1234567890}) {
+        ChunkSpec s(chunkId, {});
+        BOOST_CHECK_EQUAL(ct.generate(chunkId), qm.apply(s, t));
+    }
+    BOOST_CHECK_EQUAL(ct.generate(6630),
+        "SELECT o.ra,COUNT(*) AS n FROM LSST.Object_6630 AS o WHERE o.chunkId=6630 "
+        "AND (6630)_ 6630 '6630'%SS% GROUP BY o.ra");
+}
+
+BOOST_AUTO_TEST_CASE(CompileSubChunk) {
+    QueryMapping qm;
+    qm.insertChunkEntry("%CC%");
+    qm.insertSubChunkEntry("%SS%");
+    QueryTemplate t = makeTemplate({"SELECT", "o1.id", ",", "o2.id", "FROM",
+        "Subchunks_LSST_%CC%.Object_%CC%_%SS%", "AS", "o1", ",",
+        "Subchunks_LSST_%CC%.ObjectFullOverlap_%CC%_%SS%", "AS", "o2",
+        "WHERE", "%SS%%CC%", "<", "%CC%%SS%"});
+    auto ct = qm.compile(t);
+    for (int subChunkId : {0, 12, 999}) {
+        ChunkSpecSingle s;
+        s.chunkId = 3440;
+        s.subChunkId = subChunkId;
+        BOOST_CHECK_EQUAL(ct.generate(s.chunkId, s.subChunkId), qm.apply(s, t));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CompileInvalid) {
+    QueryMapping qm;
+    qm.insertEntry("%XX%", QueryMapping::INVALID);
+    qm.insertChunkEntry("%CC%");
+    QueryTemplate t = makeTemplate({"SELECT", "%XX%", "FROM", "T_%CC%", "%XX%%CC%"});
+    ChunkSpec s(5, {});
+    BOOST_CHECK_EQUAL(qm.compile(t).generate(5), qm.apply(s, t));
+
+    qm.insertEntry("%HH%", QueryMapping::HTM1);
+    BOOST_CHECK_THROW(qm.compile(t), std::range_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
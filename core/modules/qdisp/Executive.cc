@@ -79,12 +79,16 @@ std::string getErrorText(XrdSsiErrInfo & e) {
     return os.str();
 }
 
+std::mutex submitPoolMutex; ///< Protects Executive::_submitPool
+
 } // anonymous namespace
 
 namespace lsst {
 namespace qserv {
 namespace qdisp {
 
+util::ThreadPool::Ptr Executive::_submitPool;
+
 ////////////////////////////////////////////////////////////////////////
 // class Executive implementation
 ////////////////////////////////////////////////////////////////////////
@@ -111,10 +115,37 @@ void Executive::setQueryId(QueryId id) {
 }
 
 
-/// Add a new job to executive queue, if not already in. Not thread-safe.
+int Executive::setSubmitPoolSize(int size) {
+    std::lock_guard<std::mutex> lock(submitPoolMutex);
+    size = std::max(0, size);
+    if (_submitPool == nullptr) {
+        if (size > 0) {
+            _submitPool = util::ThreadPool::newThreadPool(size, nullptr);
+        }
+    } else {
+        _submitPool->resize(size);
+        if (size == 0) {
+            _submitPool.reset();
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "Executive::setSubmitPoolSize sz=" << size);
+    return size;
+}
+
+
+std::chrono::steady_clock::time_point Executive::getFirstDispatchTime() const {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(_firstDispatch.load()));
+}
+
+
+/// Add a new job to executive queue, if not already in. Thread-safe: the
+/// job maps are updated under the _cancelled mutex, and the call may block
+/// until fewer than Config::maxJobsInFlight jobs are incomplete.
 ///
 void Executive::add(JobDescription const& jobDesc) {
     LOGS(_log, LOG_LVL_DEBUG, "Executive::add(" << jobDesc << ")");
+    _waitForInflightSlot();
     JobQuery::Ptr jobQuery;
     {
         std::lock_guard<std::recursive_mutex> lock(_cancelled.getMutex());
@@ -148,7 +179,57 @@ void Executive::add(JobDescription const& jobDesc) {
     LOGS(_log, LOG_LVL_DEBUG, msg);
     _messageStore->addMessage(jobDesc.resource().chunk(), ccontrol::MSG_MGR_ADD, msg);
 
-    jobQuery->runJob();
+    _dispatch(jobQuery);
+}
+
+
+void Executive::scheduleRetry(int attempt, RetryScheduler::Func const& retry) {
+    auto scheduler = _config.retryScheduler;
+    if (scheduler == nullptr) {
+        scheduler = RetryScheduler::getDefault();
+    }
+    scheduler->schedule(_config.serviceUrl, attempt, retry);
+}
+
+
+/// Block until fewer than _config.maxJobsInFlight jobs are incomplete, or
+/// the query is cancelled.
+void Executive::_waitForInflightSlot() {
+    int const maxJobs = _config.maxJobsInFlight;
+    if (maxJobs <= 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_incompleteJobsMutex);
+    while (static_cast<int>(_incompleteJobs.size()) >= maxJobs) {
+        // _cancelled is not read under _incompleteJobsMutex, as it is locked
+        // before _incompleteJobsMutex elsewhere. The timeout covers a
+        // squash() between the two.
+        lock.unlock();
+        if (_cancelled) {
+            return;
+        }
+        lock.lock();
+        _jobCompleted.wait_for(lock, std::chrono::seconds(1));
+    }
+}
+
+
+/// Hand jobQuery to XrdSsi on a submit pool thread, or on this one if
+/// there is no pool.
+void Executive::_dispatch(JobQuery::Ptr const& jobQuery) {
+    util::ThreadPool::Ptr pool;
+    {
+        std::lock_guard<std::mutex> lock(submitPoolMutex);
+        pool = _submitPool;
+    }
+    if (pool == nullptr) {
+        jobQuery->runJob();
+        return;
+    }
+    auto cmd = std::make_shared<util::Command>([jobQuery](util::CmdData*) {
+        jobQuery->runJob();
+    });
+    pool->getQueue()->queCmd(cmd);
 }
 
 
@@ -160,6 +241,9 @@ bool Executive::xrdSsiProvision(std::shared_ptr<QueryResource> &jobQueryResource
     std::lock_guard<std::recursive_mutex> lock(_cancelled.getMutex());
     if (!_cancelled) {
         jobQueryResource = sourceQR;
+        std::chrono::steady_clock::rep none = 0;
+        _firstDispatch.compare_exchange_strong(none,
+            std::chrono::steady_clock::now().time_since_epoch().count());
         getXrdSsiService()->Provision(jobQueryResource.get());
         return true;
     }
@@ -172,6 +256,7 @@ bool Executive::xrdSsiProvision(std::shared_ptr<QueryResource> &jobQueryResource
 ///
 bool Executive::_addJobToMap(JobQuery::Ptr const& job) {
     auto entry = std::pair<int, JobQuery::Ptr>(job->getIdInt(), job);
+    std::lock_guard<std::recursive_mutex> lock(_jobsMutex);
     return _jobMap.insert(entry).second;
 }
 
@@ -272,6 +357,10 @@ void Executive::squash() {
     for (auto const& job : jobsToCancel) {
         job->cancel();
     }
+    {
+        std::lock_guard<std::mutex> lock(_incompleteJobsMutex);
+        _jobCompleted.notify_all(); // Wake add() if it waits for a slot.
+    }
     LOGS_DEBUG(getIdStr() << " Executive::squash done");
 }
 
@@ -351,6 +440,7 @@ void Executive::_unTrack(int jobId) {
         if (i != _incompleteJobs.end()) {
             _incompleteJobs.erase(i);
             untracked = true;
+            _jobCompleted.notify_one();
             if (_incompleteJobs.empty()) _allJobsComplete.notify_all();
         }
         size = _incompleteJobs.size();
@@ -28,6 +28,8 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <sstream>
 #include <vector>
@@ -39,6 +41,8 @@
 #include "qdisp/JobDescription.h"
 #include "qdisp/JobStatus.h"
 #include "qdisp/ResponseHandler.h"
+#include "qdisp/RetryScheduler.h"
+#include "util/EventThread.h"
 #include "util/InstanceCount.h"
 #include "util/MultiError.h"
 #include "util/threadSafe.h"
@@ -69,6 +73,9 @@ public:
         Config(int,int) : serviceUrl(getMockStr()) {}
 
         std::string serviceUrl; ///< XrdSsi service URL, e.g. localhost:1094
+        int maxJobsInFlight{0}; ///< Cap on incomplete jobs of the query, 0 for none
+        RetryScheduler::Ptr retryScheduler; ///< Runs job retries, the default one if null
+        int maxAttempts{5}; ///< Runs of a job, the first included, before the query fails
         static std::string getMockStr() {return "Mock";};
     };
 
@@ -79,9 +86,31 @@ public:
 
     ~Executive();
 
-    /// Add an item with a reference number
+    /// Add an item with a reference number. Blocks while the query has
+    /// Config::maxJobsInFlight incomplete jobs. The job is handed to XrdSsi
+    /// by the submit pool, if there is one, so that the caller can go on
+    /// producing jobs while earlier ones start.
     void add(JobDescription const& s);
 
+    /// Set the number of threads handing jobs of all queries to XrdSsi.
+    /// With 0, add() hands each job over itself.
+    /// @return the new size
+    static int setSubmitPoolSize(int size);
+
+    /// Run retry after the backoff for a failed attempt of one of this
+    /// query's jobs, at most Config::retryScheduler's maxPerService at once.
+    /// The czar only sees the XrdSsi service, so retries are capped per
+    /// service URL.
+    void scheduleRetry(int attempt, RetryScheduler::Func const& retry);
+
+    /// @return the number of runs of a job, the first included, before the
+    ///         query fails.
+    int getMaxAttempts() const { return _config.maxAttempts; }
+
+    /// @return when the first job was handed to XrdSsi, or time_point()
+    ///         if none was yet.
+    std::chrono::steady_clock::time_point getFirstDispatchTime() const;
+
     /// Block until execution is completed
     /// @return true if execution was successful
     bool join();
@@ -122,6 +151,8 @@ private:
     bool _track(int refNum, std::shared_ptr<JobQuery> const& r);
     void _unTrack(int refNum);
     bool _addJobToMap(std::shared_ptr<JobQuery> const& job);
+    void _waitForInflightSlot();
+    void _dispatch(std::shared_ptr<JobQuery> const& jobQuery);
 
     void _reapRequesters(std::unique_lock<std::mutex> const& requestersLock);
 
@@ -152,8 +183,14 @@ private:
     mutable std::mutex _errorsMutex;
 
     std::condition_variable _allJobsComplete;
+    std::condition_variable _jobCompleted; ///< Signals a job leaving _incompleteJobs
     mutable std::recursive_mutex _jobsMutex;
 
+    /// steady_clock ticks when the first job was handed to XrdSsi, 0 before.
+    std::atomic<std::chrono::steady_clock::rep> _firstDispatch{0};
+
+    static util::ThreadPool::Ptr _submitPool; ///< Hands jobs to XrdSsi, may be null.
+
     QueryId _id{0}; ///< Unique identifier for this query.
     std::string    _idStr{QueryIdHelper::makeIdStr(0, true)};
     util::InstanceCount _instC{"Executive"};
@@ -30,6 +30,8 @@
 // System headers
 #include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
 
 // Qserv headers
 #include "global/ResourceUnit.h"
@@ -46,9 +48,9 @@ class ResponseHandler;
  */
 class JobDescription {
 public:
-    JobDescription(int id, ResourceUnit const& resource, std::string const& payload,
+    JobDescription(int id, ResourceUnit const& resource, std::string payload,
         std::shared_ptr<ResponseHandler> const& respHandler)
-        : _id{id}, _resource{resource}, _payload{payload}, _respHandler{respHandler} {};
+        : _id{id}, _resource{resource}, _payload{std::move(payload)}, _respHandler{respHandler} {};
 
     int id() const { return _id; }
     ResourceUnit const& resource() const { return _resource; }
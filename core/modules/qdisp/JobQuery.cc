@@ -75,7 +75,7 @@ bool JobQuery::runJob() {
     if (!cancelled && handlerReset) {
         auto qr = std::make_shared<QueryResource>(shared_from_this());
         std::lock_guard<std::recursive_mutex> lock(_rmutex);
-        if ( _runAttemptsCount < _getMaxRetries() ) {
+        if ( _runAttemptsCount < executive->getMaxAttempts() ) {
             ++_runAttemptsCount;
         } else {
             LOGS(_log, LOG_LVL_ERROR, getIdStr() << " hit maximum number of retries ("
@@ -104,18 +104,21 @@ void JobQuery::provisioningFailed(std::string const& msg, int code) {
          << " code=" << code << "\n    desc=" << _jobDescription);
     _jobStatus->updateInfo(JobStatus::PROVISION_NACK, code, msg);
     _jobDescription.respHandler()->errorFlush(msg, code);
+    auto executive = _executive.lock();
+    if (executive == nullptr) {
+        LOGS(_log, LOG_LVL_ERROR, getIdStr() << " can't retry, executive == nullptr");
+        return;
+    }
     LOGS(_log, LOG_LVL_INFO, getIdStr() << " will retry");
-    // Running in a separate thread as xrootd is waiting for this one to return.
-    auto retryFunc = [](std::weak_ptr<JobQuery> jqWeak, int sleepSeconds) {
-        sleep(sleepSeconds);
+    // xrootd is waiting for this thread to return, and thousands of jobs may
+    // fail together, so the retry waits in the executive's RetryScheduler.
+    std::weak_ptr<JobQuery> jqWeak = shared_from_this();
+    executive->scheduleRetry(_getRunAttemptsCount(), [jqWeak]() {
         auto jobQuery = jqWeak.lock();
         if (jobQuery == nullptr) return;
         LOGS(_log, LOG_LVL_DEBUG, jobQuery->getIdStr() << " retrying provisioningFailed");
         jobQuery->runJob();
-    };
-    std::weak_ptr<JobQuery> jqWeak = shared_from_this();
-    std::thread retryThrd(retryFunc, jqWeak, _getRetrySleepSeconds());
-    retryThrd.detach();
+    });
 }
 
 /// Cancel response handling. Return true if this is the first time cancel has been called.
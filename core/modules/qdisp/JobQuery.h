@@ -105,8 +105,6 @@ protected:
         std::lock_guard<std::recursive_mutex> lock(_rmutex);
         return _runAttemptsCount;
     }
-    int _getMaxRetries() const { return 5; } // Arbitrary value until solid value with reason determined.
-    int _getRetrySleepSeconds() const { return 30; } // As above or until added to config file.
 
     // Values that don't change once set.
     std::weak_ptr<Executive>  _executive;
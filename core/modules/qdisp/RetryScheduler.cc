@@ -0,0 +1,204 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/RetryScheduler.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <functional>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qdisp.RetryScheduler");
+
+/// Calls a function when going out of scope, even by an exception.
+class OnExit {
+public:
+    explicit OnExit(std::function<void()> const& func) : _func(func) {}
+    OnExit(OnExit const&) = delete;
+    OnExit& operator=(OnExit const&) = delete;
+    ~OnExit() { _func(); }
+private:
+    std::function<void()> _func;
+};
+}
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+RetryScheduler::RetryScheduler(Config const& config)
+    : _config(config),
+      _wheel(std::max(1, config.slots)),
+      _random(std::random_device()()) {
+    _pool = util::ThreadPool::newThreadPool(std::max(1, _config.threads), nullptr);
+    _wheelThread = std::thread(&RetryScheduler::_turnWheel, this);
+}
+
+
+RetryScheduler::~RetryScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+        _stopCv.notify_all();
+    }
+    _wheelThread.join();
+    _pool->endAll();
+    _pool->waitForResize(0);
+    LOGS(_log, LOG_LVL_DEBUG, "~RetryScheduler dropped " << _waiting << " retries");
+}
+
+
+std::chrono::milliseconds RetryScheduler::getDelay(int attempt) {
+    int const doublings = std::min(std::max(attempt, 1) - 1, 30);
+    double delay = std::min(_config.baseDelay.count() * std::ldexp(1.0, doublings),
+                            double(_config.maxDelay.count()));
+    double const jitter = std::min(std::max(_config.jitter, 0.0), 1.0);
+    std::uniform_real_distribution<double> dist(0.0, jitter);
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        delay *= 1.0 - dist(_random);
+    }
+    return std::chrono::milliseconds(static_cast<long>(delay));
+}
+
+
+void RetryScheduler::schedule(std::string const& service, int attempt, Func const& func) {
+    auto delay = getDelay(attempt);
+    long const slots = _wheel.size();
+    long ticks = std::max(1L, static_cast<long>(
+        std::ceil(double(delay.count()) / std::max(1L, long(_config.tick.count())))));
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_stop) {
+        return;
+    }
+    auto& slot = _wheel[(_cursor + ticks) % slots];
+    slot.push_back(Entry{static_cast<int>((ticks - 1) / slots), service, func});
+    ++_waiting;
+    LOGS(_log, LOG_LVL_DEBUG, "retry of attempt " << attempt << " on " << service
+         << " in " << delay.count() << "ms, waiting=" << _waiting);
+}
+
+
+/// Advance the wheel every tick, and release the retries that are due.
+void RetryScheduler::_turnWheel() {
+    auto next = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (!_stop) {
+        next += _config.tick;
+        _stopCv.wait_until(lock, next, [this]() { return _stop; });
+        if (_stop) {
+            break;
+        }
+        _cursor = (_cursor + 1) % _wheel.size();
+        auto& slot = _wheel[_cursor];
+        std::vector<Entry> later;
+        std::vector<std::string> due;
+        for (auto& entry : slot) {
+            if (entry.rounds > 0) {
+                --entry.rounds;
+                later.push_back(std::move(entry));
+            } else {
+                _services[entry.service].ready.push_back(std::move(entry.func));
+                due.push_back(std::move(entry.service));
+            }
+        }
+        slot.swap(later);
+        std::sort(due.begin(), due.end());
+        due.erase(std::unique(due.begin(), due.end()), due.end());
+        for (auto const& service : due) {
+            _release(service, _services[service]);
+        }
+    }
+}
+
+
+/// Run the ready retries of service it has slots for. Call with _mtx locked.
+void RetryScheduler::_release(std::string const& service, Service& srv) {
+    while (!_stop && !srv.ready.empty() && srv.running < _config.maxPerService) {
+        Func func = std::move(srv.ready.front());
+        srv.ready.pop_front();
+        --_waiting;
+        ++_running;
+        srv.maxRunning = std::max(srv.maxRunning, ++srv.running);
+        auto cmd = std::make_shared<util::Command>([this, service, func](util::CmdData*) {
+            // Give the slot back however func() ends, or the counts would
+            // stay up and throttle this service's retries for good.
+            OnExit finished([this, &service]() { _finished(service); });
+            {
+                std::lock_guard<std::mutex> lock(_mtx);
+                if (_stop) {
+                    return;
+                }
+            }
+            try {
+                func();
+            } catch (std::exception const& e) {
+                LOGS(_log, LOG_LVL_ERROR, "retry on " << service << " failed: " << e.what());
+            }
+        });
+        _pool->getQueue()->queCmd(cmd);
+    }
+}
+
+
+void RetryScheduler::_finished(std::string const& service) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    --_running;
+    auto& srv = _services[service];
+    --srv.running;
+    _release(service, srv);
+}
+
+
+int RetryScheduler::getWaiting() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _waiting;
+}
+
+
+int RetryScheduler::getRunning() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _running;
+}
+
+
+int RetryScheduler::getMaxRunning(std::string const& service) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _services.find(service);
+    return iter == _services.end() ? 0 : iter->second.maxRunning;
+}
+
+
+RetryScheduler::Ptr RetryScheduler::getDefault() {
+    // Never destroyed, as jobs may still schedule retries during exit.
+    static Ptr* scheduler = new Ptr(std::make_shared<RetryScheduler>(Config()));
+    return *scheduler;
+}
+
+}}} // namespace lsst::qserv::qdisp
@@ -0,0 +1,129 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_RETRYSCHEDULER_H
+#define LSST_QSERV_QDISP_RETRYSCHEDULER_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "util/EventThread.h"
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+/// RetryScheduler runs delayed retries of failed jobs with a fixed number of
+/// threads, however many jobs are waiting.
+///
+/// Retries wait on a timer wheel: one thread advances it every tick and
+/// moves the retries that are due to a queue per service. The delay doubles
+/// with each attempt, up to a maximum, and a random part of it is dropped so
+/// that jobs failing together do not come back together. At most
+/// maxPerService retries against one service run at once, on a ThreadPool;
+/// the rest wait in their service's queue, in order. The czar reaches all
+/// workers through one XrdSsi service, so this caps the retries of the czar
+/// rather than of a worker.
+///
+/// The default delays add up to about two minutes over the retries of a job,
+/// enough for a worker to restart.
+class RetryScheduler {
+public:
+    typedef std::shared_ptr<RetryScheduler> Ptr;
+    typedef std::function<void()> Func;
+
+    struct Config {
+        std::chrono::milliseconds tick{100};        ///< Resolution of the wheel
+        int slots{1024};                            ///< Ticks in one turn of the wheel
+        std::chrono::milliseconds baseDelay{15000}; ///< Delay before a first retry
+        std::chrono::milliseconds maxDelay{60000};  ///< Cap on the doubled delay
+        double jitter{0.25};  ///< Fraction of the delay that is random, 0 to 1
+        int maxPerService{16}; ///< Retries of one service running at once
+        int threads{2};       ///< Threads running retries
+    };
+
+    explicit RetryScheduler(Config const& config);
+    RetryScheduler(RetryScheduler const&) = delete;
+    RetryScheduler& operator=(RetryScheduler const&) = delete;
+
+    /// Retries that have not run are dropped.
+    ~RetryScheduler();
+
+    /// Run func after the delay for attempt, as a retry against service.
+    /// @param attempt - the attempt that failed, 1 for the first.
+    void schedule(std::string const& service, int attempt, Func const& func);
+
+    /// @return a jittered delay for a retry after attempt failed.
+    std::chrono::milliseconds getDelay(int attempt);
+
+    int getWaiting() const;  ///< @return retries scheduled but not yet run
+    int getRunning() const;  ///< @return retries running now
+    int getMaxRunning(std::string const& service) const; ///< @return peak concurrency of service
+    int getThreadCount() const { return _config.threads + 1; } ///< Including the wheel
+
+    /// @return the scheduler shared by queries that are not given one.
+    static Ptr getDefault();
+
+private:
+    struct Entry {
+        int rounds;         ///< Turns of the wheel left before it is due
+        std::string service;
+        Func func;
+    };
+    struct Service {
+        std::deque<Func> ready; ///< Due, waiting for a slot
+        int running{0};
+        int maxRunning{0};
+    };
+
+    void _turnWheel();
+    void _release(std::string const& service, Service& srv);
+    void _finished(std::string const& service);
+
+    Config const _config;
+    std::vector<std::vector<Entry>> _wheel;
+    std::size_t _cursor{0};
+    std::map<std::string, Service> _services;
+    int _waiting{0};
+    int _running{0};
+    std::mt19937 _random;
+    bool _stop{false};
+    mutable std::mutex _mtx;
+    std::condition_variable _stopCv;
+    util::ThreadPool::Ptr _pool;
+    std::thread _wheelThread;
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_RETRYSCHEDULER_H
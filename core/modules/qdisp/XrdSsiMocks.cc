@@ -24,6 +24,7 @@
  */
 
 // System headers
+#include <cerrno>
 #include <cstddef>
 #include <string>
 #include <stdlib.h>
@@ -63,6 +64,9 @@ public:
 
 util::FlagNotify<bool> XrdSsiServiceMock::_go(true);
 util::Sequential<int> XrdSsiServiceMock::_count(0);
+std::atomic<int> XrdSsiServiceMock::_failures(0);
+std::mutex XrdSsiServiceMock::_failedMtx;
+std::set<std::string> XrdSsiServiceMock::_failed;
 
 /** Class to fake being a request to xrootd.
  * Fire up thread that sleeps for a bit and then indicates it was successful.
@@ -80,12 +84,37 @@ void XrdSsiServiceMock::Provision(Resource *resP, unsigned short timeOut, bool u
     }
     _count.incr();
 
+    if (mockProvisionFail(qr)) {
+        return;
+    }
+
     std::thread t(&XrdSsiServiceMock::mockProvisionTest, this, qr, timeOut);
     // Thread must live past the end of this function, and the calling body
     // is not really dealing with threads, and this is for testing only.
     t.detach();
 }
 
+/** Fail the first attempt of up to _failures jobs, as if xrootd could not
+ * reach a worker. There is no thread per failure, so that many failures
+ * can be simulated at once.
+ * @return true if qr failed.
+ */
+bool XrdSsiServiceMock::mockProvisionFail(QueryResource *qr) {
+    if (_failures <= 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_failedMtx);
+        if (_failures <= 0 || !_failed.insert(qr->getJobQuery()->getIdStr()).second) {
+            return false;
+        }
+        --_failures;
+    }
+    qr->eInfo.Set("XrdSsiServiceMock::Provision simulated failure", EHOSTUNREACH);
+    qr->ProvisionDone(nullptr);
+    return true;
+}
+
 /** Mock class for testing Executive.
  * The payload of qr should contain the number of milliseconds this function will
  * sleep before returning.
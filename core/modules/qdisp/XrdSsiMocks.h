@@ -27,6 +27,12 @@
 #define LSST_QSERV_QDISP_XRDSSIMOCKS_H
 
 
+// System headers
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+
 // External headers
 #include "XrdSsi/XrdSsiService.hh"
 #include "XrdSsi/XrdSsiSession.hh"
@@ -55,10 +61,15 @@ public:
     }
 protected:
     void mockProvisionTest(QueryResource *resP, unsigned short timeOut);
+    bool mockProvisionFail(QueryResource *qr);
+
+    static std::mutex _failedMtx;
+    static std::set<std::string> _failed; ///< Jobs that failed once
 public:
     virtual ~XrdSsiServiceMock() {}
     static util::FlagNotify<bool> _go;
     static util::Sequential<int> _count;
+    static std::atomic<int> _failures; ///< Number of jobs whose first Provision() is to fail
 };
 
 /** Class used to fake calls to XrdSsiSession::ProcessRequest.
@@ -22,7 +22,11 @@
  */
 
 // System headers
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <unistd.h>
 
 // Third-party headers
@@ -42,6 +46,7 @@
 #include "qdisp/Executive.h"
 #include "qdisp/JobQuery.h"
 #include "qdisp/MessageStore.h"
+#include "qdisp/RetryScheduler.h"
 #include "qdisp/XrdSsiMocks.h"
 #include "util/threadSafe.h"
 
@@ -257,6 +262,154 @@ BOOST_AUTO_TEST_CASE(Executive) {
     LOGS_DEBUG("Executive test end");
 }
 
+BOOST_AUTO_TEST_CASE(ExecutiveSubmitPool) {
+    LOGS_DEBUG("ExecutiveSubmitPool test");
+    util::Flag<bool> done(false);
+    std::thread timeoutT(&timeoutFunc, std::ref(done), 5000);
+    BOOST_CHECK(qdisp::Executive::setSubmitPoolSize(2) == 2);
+    std::string str = qdisp::Executive::Config::getMockStr();
+    qdisp::Executive::Config::Ptr conf = std::make_shared<qdisp::Executive::Config>(str);
+    conf->maxJobsInFlight = 3;
+    std::shared_ptr<qdisp::MessageStore> ms = std::make_shared<qdisp::MessageStore>();
+    qdisp::Executive::Ptr ex = qdisp::Executive::newExecutive(conf, ms);
+    BOOST_CHECK(ex->getFirstDispatchTime() == std::chrono::steady_clock::time_point());
+    SequentialInt sequence(0);
+    SequentialInt chunkId(1234);
+
+    // With the mock jobs held, add() must stop after maxJobsInFlight jobs.
+    int const provisioned = qdisp::XrdSsiServiceMock::_count.get();
+    qdisp::XrdSsiServiceMock::_go.exchangeNotify(false);
+    util::Flag<bool> added(false);
+    std::thread adder([&]() {
+        executiveTest(ex, sequence, chunkId, "10", 8);
+        added.exchange(true);
+    });
+    while (qdisp::XrdSsiServiceMock::_count.get() < provisioned + 3) {
+        usleep(10000);
+    }
+    usleep(200000);
+    BOOST_CHECK(qdisp::XrdSsiServiceMock::_count.get() == provisioned + 3);
+    BOOST_CHECK(added.get() == false);
+    BOOST_CHECK(ex->getFirstDispatchTime() != std::chrono::steady_clock::time_point());
+
+    qdisp::XrdSsiServiceMock::_go.exchangeNotify(true);
+    adder.join();
+    ex->join();
+    BOOST_CHECK(qdisp::XrdSsiServiceMock::_count.get() == provisioned + 8);
+    BOOST_CHECK(ex->getEmpty() == true);
+    BOOST_CHECK(qdisp::Executive::setSubmitPoolSize(0) == 0);
+    done.exchange(true);
+    timeoutT.join();
+}
+
+BOOST_AUTO_TEST_CASE(RetryScheduler) {
+    qdisp::RetryScheduler::Config config;
+    config.tick = std::chrono::milliseconds(1);
+    config.slots = 64;
+    config.baseDelay = std::chrono::milliseconds(100);
+    config.maxDelay = std::chrono::milliseconds(1000);
+    config.maxPerService = 4;
+    config.threads = 8;
+    qdisp::RetryScheduler scheduler(config);
+    for (int j=0; j < 100; ++j) {
+        auto d1 = scheduler.getDelay(1).count();
+        auto d3 = scheduler.getDelay(3).count();
+        auto d10 = scheduler.getDelay(10).count();
+        BOOST_CHECK(d1 >= 50 && d1 <= 100);
+        BOOST_CHECK(d3 >= 200 && d3 <= 400);
+        BOOST_CHECK(d10 >= 500 && d10 <= 1000);
+    }
+
+    // With the default delays, the retries of a job span about two minutes,
+    // as long as a worker may take to restart.
+    qdisp::RetryScheduler defaultScheduler{qdisp::RetryScheduler::Config()};
+    qdisp::Executive::Config defaultExecutive(qdisp::Executive::Config::getMockStr());
+    for (int j=0; j < 20; ++j) {
+        long window = 0;
+        for (int attempt=1; attempt < defaultExecutive.maxAttempts; ++attempt) {
+            window += defaultScheduler.getDelay(attempt).count();
+        }
+        BOOST_CHECK(window >= 120000 && window <= 170000);
+    }
+
+    // Retries of one service never run more than maxPerService at once, even
+    // when they are all due together.
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    std::atomic<int> ran{0};
+    for (int j=0; j < 200; ++j) {
+        scheduler.schedule("worker", 1, [&]() {
+            int r = ++running;
+            int m = maxRunning;
+            while (r > m && !maxRunning.compare_exchange_weak(m, r)) {}
+            usleep(1000);
+            --running;
+            ++ran;
+        });
+    }
+    scheduler.schedule("other", 1, [&]() { ++ran; });
+    while (ran < 201) {
+        usleep(10000);
+    }
+    BOOST_CHECK(maxRunning <= 4);
+    BOOST_CHECK(scheduler.getMaxRunning("worker") == 4);
+    BOOST_CHECK(scheduler.getMaxRunning("other") == 1);
+    BOOST_CHECK(scheduler.getWaiting() == 0);
+
+    // A retry that throws still gives its slot back.
+    std::atomic<int> thrown{0};
+    for (int j=0; j < 8; ++j) {
+        scheduler.schedule("thrower", 1, [&]() {
+            ++thrown;
+            throw std::runtime_error("retry failed");
+        });
+    }
+    while (thrown < 8 || scheduler.getRunning() > 0) {
+        usleep(10000);
+    }
+    scheduler.schedule("thrower", 1, [&]() { ++ran; });
+    while (ran < 202) {
+        usleep(10000);
+    }
+    BOOST_CHECK(scheduler.getRunning() == 0);
+    BOOST_CHECK(scheduler.getMaxRunning("thrower") <= 4);
+}
+
+BOOST_AUTO_TEST_CASE(ExecutiveRetry) {
+    // 50k jobs all fail to provision at once. Their retries must be
+    // spread out and capped by a scheduler with a fixed number of threads.
+    int const jobs = 50000;
+    LOGS_DEBUG("ExecutiveRetry test");
+    qdisp::RetryScheduler::Config schedConfig;
+    schedConfig.tick = std::chrono::milliseconds(1);
+    schedConfig.slots = 256;
+    schedConfig.baseDelay = std::chrono::milliseconds(20);
+    schedConfig.maxDelay = std::chrono::milliseconds(200);
+    schedConfig.maxPerService = 32;
+    schedConfig.threads = 4;
+    auto scheduler = std::make_shared<qdisp::RetryScheduler>(schedConfig);
+    std::string str = qdisp::Executive::Config::getMockStr();
+    qdisp::Executive::Config::Ptr conf = std::make_shared<qdisp::Executive::Config>(str);
+    conf->retryScheduler = scheduler;
+    std::shared_ptr<qdisp::MessageStore> ms = std::make_shared<qdisp::MessageStore>();
+    qdisp::Executive::Ptr ex = qdisp::Executive::newExecutive(conf, ms);
+    ResourceUnit ru;
+
+    int const provisioned = qdisp::XrdSsiServiceMock::_count.get();
+    qdisp::XrdSsiServiceMock::_failures = jobs;
+    for (int jobId=1; jobId <= jobs; ++jobId) {
+        qdisp::JobDescription jobDesc(jobId, ru, "0", std::make_shared<ResponseHandlerTest>());
+        ex->add(jobDesc);
+    }
+    BOOST_CHECK_EQUAL(qdisp::XrdSsiServiceMock::_failures, 0);
+    BOOST_CHECK(scheduler->getThreadCount() == 5);
+    ex->join();
+    BOOST_CHECK(ex->getEmpty() == true);
+    BOOST_CHECK_EQUAL(qdisp::XrdSsiServiceMock::_count.get(), provisioned + 2*jobs);
+    BOOST_CHECK(scheduler->getWaiting() == 0);
+    BOOST_CHECK(scheduler->getMaxRunning(str) <= 32);
+}
+
 BOOST_AUTO_TEST_CASE(MessageStore) {
     LOGS_DEBUG("MessageStore test start");
     qdisp::MessageStore ms;
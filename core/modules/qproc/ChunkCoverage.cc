@@ -0,0 +1,336 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qproc/ChunkCoverage.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+
+// LSST headers
+#include "lsst/log/Log.h"
+#include "lsst/sphgeom/Box.h"
+#include "lsst/sphgeom/Circle.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.ChunkCoverage");
+
+double const PI = 3.1415926535897932384626433832795;
+
+/// Dilation of chunk and subchunk bounds, as in sphgeom::Chunker.
+double const BOX_EPSILON = 5.0e-10;
+
+/// @return the number of segments of width at least width a latitude band
+///         is cut into, as sphgeom::Chunker computes it.
+int segments(double latMin, double latMax, double width) {
+    double const lat = std::max(std::fabs(latMin), std::fabs(latMax));
+    if (lat > 0.5 * PI - 4.85e-6) {
+        return 1;
+    }
+    double const cw = std::cos(width);
+    double const sl = std::sin(lat);
+    double const cl = std::cos(lat);
+    double const x = cw - sl * sl;
+    double const u = cl * cl;
+    double const y = std::sqrt(std::fabs(u * u - x * x));
+    return static_cast<int>(std::floor(2.0 * PI / std::fabs(std::atan2(y, x))));
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+ChunkCoverage::ChunkCoverage(css::StripingParams const& sp, std::size_t cacheSize)
+    : _chunker(sp.stripes, sp.subStripes),
+      _numStripes(sp.stripes),
+      _numSubStripesPerStripe(sp.subStripes),
+      _subStripeHeight(PI / (sp.stripes * sp.subStripes)),
+      _cache("ChunkCoverage stripes=" + std::to_string(sp.stripes), cacheSize) {
+    // Chunk ids are stripe*2*stripes + chunk.
+    _numChunks.assign(_numStripes, 0);
+    for (auto chunkId : _chunker.getAllChunks()) {
+        int const stripe = chunkId / (2 * _numStripes);
+        if (stripe < 0 || stripe >= _numStripes) {
+            LOGS(_log, LOG_LVL_WARN, "ChunkCoverage unexpected chunk " << chunkId
+                 << ", using sphgeom::Chunker only");
+            return;
+        }
+        ++_numChunks[stripe];
+    }
+    int const numSubStripes = _numStripes * _numSubStripesPerStripe;
+    for (int ss = 0; ss < numSubStripes; ++ss) {
+        double const latMin = ss * _subStripeHeight - 0.5 * PI;
+        double const latMax = (ss + 1) * _subStripeHeight - 0.5 * PI;
+        int const numChunks = _numChunks[ss / _numSubStripesPerStripe];
+        int const numSubChunks = numChunks > 0 ? segments(latMin, latMax, _subStripeHeight) / numChunks : 0;
+        _numSubChunks.push_back(numSubChunks);
+        _maxSubChunksPerSubStripeChunk = std::max(_maxSubChunksPerSubStripeChunk, numSubChunks);
+        _latMin.push_back(latMin - BOX_EPSILON);
+        _latMax.push_back(latMax + BOX_EPSILON);
+        _sinLatMin.push_back(std::sin(_latMin.back()));
+        _cosLatMin.push_back(std::cos(_latMin.back()));
+        _sinLatMax.push_back(std::sin(_latMax.back()));
+        _cosLatMax.push_back(std::cos(_latMax.back()));
+    }
+    _fast = _check();
+    if (!_fast) {
+        LOGS(_log, LOG_LVL_WARN, "ChunkCoverage numbering differs from sphgeom::Chunker for stripes="
+             << _numStripes << " subStripes=" << _numSubStripesPerStripe << ", using it only");
+    }
+}
+
+
+ChunkCoverage::SubChunksVector ChunkCoverage::compute(lsst::sphgeom::Region const& region) const {
+    SubChunksVector out;
+    if (_fast) {
+        if (auto circle = dynamic_cast<lsst::sphgeom::Circle const*>(&region)) {
+            if (_computeCircle(*circle, out)) {
+                return out;
+            }
+        } else if (auto box = dynamic_cast<lsst::sphgeom::Box const*>(&region)) {
+            _computeBox(*box, out);
+            return out;
+        }
+    }
+    return _chunker.getSubChunksIntersecting(region);
+}
+
+
+ChunkCoverage::CoveragePtr ChunkCoverage::find(std::string const& key) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    CoveragePtr* coverage = _cache.find(key);
+    if (coverage == nullptr) {
+        _cache.addMiss();
+        return nullptr;
+    }
+    _cache.addHit();
+    return *coverage;
+}
+
+
+void ChunkCoverage::insert(std::string const& key, CoveragePtr const& coverage) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _cache.insert(key, coverage);
+}
+
+
+ChunkCoverage::Stats ChunkCoverage::getStats() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto const lruStats = _cache.getStats();
+    Stats stats;
+    stats.hits = lruStats.hits;
+    stats.misses = lruStats.misses;
+    stats.regions = lruStats.size;
+    return stats;
+}
+
+
+bool ChunkCoverage::_computeCircle(lsst::sphgeom::Circle const& circle, SubChunksVector& out) const {
+    if (circle.isEmpty()) {
+        return true;
+    }
+    double const r = circle.getOpeningAngle().asRadians();
+    if (circle.isFull() || r > 0.25 * PI) {
+        // Not a cone search, leave it to the Chunker.
+        return false;
+    }
+    lsst::sphgeom::UnitVector3d const& center = circle.getCenter();
+    double const lat = std::atan2(center.z(), std::hypot(center.x(), center.y()));
+    double const lon = std::atan2(center.y(), center.x());
+    double const sinLat = std::sin(lat);
+    double const cosLat = std::cos(lat);
+    double const cosR = std::cos(r);
+
+    // The latitude range of the circle, and the latitude where it spans the
+    // widest longitude range, a pole if it contains one.
+    double const circleMin = std::max(lat - r, -0.5 * PI);
+    double const circleMax = std::min(lat + r, 0.5 * PI);
+    double const sinCircleMin = std::sin(circleMin);
+    double const cosCircleMin = std::cos(circleMin);
+    double const sinCircleMax = std::sin(circleMax);
+    double const cosCircleMax = std::cos(circleMax);
+    double const sinWidest = sinLat / cosR;
+    double const latWidest = sinWidest >= 1.0 ? 0.5 * PI : (sinWidest <= -1.0 ? -0.5 * PI : std::asin(sinWidest));
+    double const sinLatWidest = std::sin(latWidest);
+    double const cosLatWidest = std::cos(latWidest);
+
+    int const ssBegin = _subStripe(circleMin - BOX_EPSILON);
+    int const n = _subStripe(circleMax + BOX_EPSILON) + 1 - ssBegin;
+    double const* latMin = &_latMin[ssBegin];
+    double const* latMax = &_latMax[ssBegin];
+    double const* sinLatMin = &_sinLatMin[ssBegin];
+    double const* cosLatMin = &_cosLatMin[ssBegin];
+    double const* sinLatMax = &_sinLatMax[ssBegin];
+    double const* cosLatMax = &_cosLatMax[ssBegin];
+    std::vector<double> halfWidths(n);
+    double* cosHalf = halfWidths.data();
+
+    // The widest longitude range of the circle within a substripe is at the
+    // latitude closest to latWidest in both. Only selects, no branches, so
+    // that the loop vectorizes.
+    for (int i = 0; i < n; ++i) {
+        bool const minOfBand = latMin[i] > circleMin;
+        double const lo = minOfBand ? latMin[i] : circleMin;
+        double const sinLo = minOfBand ? sinLatMin[i] : sinCircleMin;
+        double const cosLo = minOfBand ? cosLatMin[i] : cosCircleMin;
+        bool const maxOfBand = latMax[i] < circleMax;
+        double const hi = maxOfBand ? latMax[i] : circleMax;
+        double const sinHi = maxOfBand ? sinLatMax[i] : sinCircleMax;
+        double const cosHi = maxOfBand ? cosLatMax[i] : cosCircleMax;
+        bool const below = latWidest < lo;
+        bool const above = latWidest > hi;
+        double const sinPhi = below ? sinLo : (above ? sinHi : sinLatWidest);
+        double const cosPhi = below ? cosLo : (above ? cosHi : cosLatWidest);
+        // From cos(r) = sin(phi)sin(lat) + cos(phi)cos(lat)cos(half); all
+        // longitudes at a pole.
+        double const denom = cosPhi * cosLat;
+        double const cosH = denom > 1e-15 ? (cosR - sinPhi * sinLat) / denom : -1.0;
+        // 2 marks a substripe the circle misses
+        cosHalf[i] = lo <= hi ? cosH : 2.0;
+    }
+    for (int i = 0; i < n; ++i) {
+        double const cosH = cosHalf[i];
+        cosHalf[i] = cosH >= 2.0 ? -1.0 : (cosH <= -1.0 ? PI : (cosH >= 1.0 ? 0.0 : std::acos(cosH)));
+    }
+    _collect(ssBegin, lon, halfWidths, out);
+    return true;
+}
+
+
+void ChunkCoverage::_computeBox(lsst::sphgeom::Box const& box, SubChunksVector& out) const {
+    if (box.isEmpty()) {
+        return;
+    }
+    double lon = 0.0;
+    double half = PI;
+    if (!box.getLon().isFull()) {
+        double const a = box.getLon().getA().asRadians();
+        double b = box.getLon().getB().asRadians();
+        if (b < a) {
+            // Wraps through 0
+            b += 2.0 * PI;
+        }
+        lon = 0.5 * (a + b);
+        half = 0.5 * (b - a);
+    }
+    int const ssBegin = _subStripe(box.getLat().getA().asRadians() - BOX_EPSILON);
+    int const ssEnd = _subStripe(box.getLat().getB().asRadians() + BOX_EPSILON) + 1;
+    _collect(ssBegin, lon, std::vector<double>(ssEnd - ssBegin, half), out);
+}
+
+
+void ChunkCoverage::_collect(int ssBegin, double lon, std::vector<double> const& halfWidths,
+                             SubChunksVector& out) const {
+    std::vector<std::pair<std::int32_t, std::int32_t>> ids; // chunk id, subchunk id
+    for (std::size_t i = 0; i < halfWidths.size(); ++i) {
+        double const half = halfWidths[i];
+        if (half < 0.0) {
+            continue;
+        }
+        int const ss = ssBegin + i;
+        int const stripe = ss / _numSubStripesPerStripe;
+        int const numSubChunks = _numSubChunks[ss];
+        // Subchunks of the substripe are numbered from longitude 0, chunk
+        // after chunk.
+        std::int64_t const total = static_cast<std::int64_t>(_numChunks[stripe]) * numSubChunks;
+        double const width = 2.0 * PI / total;
+        std::int64_t first = 0;
+        std::int64_t last = total - 1;
+        if (half + BOX_EPSILON < PI) {
+            first = static_cast<std::int64_t>(std::floor((lon - half - BOX_EPSILON) / width));
+            last = static_cast<std::int64_t>(std::floor((lon + half + BOX_EPSILON) / width));
+            if (last - first >= total) {
+                first = 0;
+                last = total - 1;
+            }
+        }
+        std::int32_t const y = ss - stripe * _numSubStripesPerStripe;
+        for (std::int64_t k = first; k <= last; ++k) {
+            std::int64_t const index = (k % total + total) % total;
+            std::int32_t const chunk = index / numSubChunks;
+            std::int32_t const x = index - chunk * numSubChunks;
+            ids.emplace_back(stripe * 2 * _numStripes + chunk, y * _maxSubChunksPerSubStripeChunk + x);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    for (auto const& id : ids) {
+        if (out.empty() || out.back().chunkId != id.first) {
+            out.emplace_back();
+            out.back().chunkId = id.first;
+        }
+        out.back().subChunkIds.push_back(id.second);
+    }
+}
+
+
+int ChunkCoverage::_subStripe(double lat) const {
+    int const ss = static_cast<int>(std::floor((lat + 0.5 * PI) / _subStripeHeight));
+    return std::min(std::max(ss, 0), _numStripes * _numSubStripesPerStripe - 1);
+}
+
+
+bool ChunkCoverage::_check() const {
+    std::vector<std::int32_t> expected;
+    for (int stripe = 0; stripe < _numStripes; ++stripe) {
+        for (int chunk = 0; chunk < _numChunks[stripe]; ++chunk) {
+            expected.push_back(stripe * 2 * _numStripes + chunk);
+        }
+    }
+    std::vector<std::int32_t> chunks = _chunker.getAllChunks();
+    std::sort(chunks.begin(), chunks.end());
+    if (chunks != expected) {
+        return false;
+    }
+    // Subchunk ids are y*maxSubChunksPerSubStripeChunk + x, for the
+    // substripe y of the stripe and the subchunk x of the chunk in it.
+    for (int stripe = 0; stripe < _numStripes; ++stripe) {
+        expected.clear();
+        for (int y = 0; y < _numSubStripesPerStripe; ++y) {
+            for (int x = 0; x < _numSubChunks[stripe * _numSubStripesPerStripe + y]; ++x) {
+                expected.push_back(y * _maxSubChunksPerSubStripeChunk + x);
+            }
+        }
+        std::vector<std::int32_t> subChunks = _chunker.getAllSubChunks(stripe * 2 * _numStripes);
+        std::sort(subChunks.begin(), subChunks.end());
+        if (subChunks != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+ChunkCoverage::Ptr ChunkCoverageMap::get(css::StripingParams const& sp) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    ChunkCoverage::Ptr& coverage = _coverages[std::make_pair(sp.stripes, sp.subStripes)];
+    if (!coverage) {
+        coverage = std::make_shared<ChunkCoverage>(sp, _cacheSize);
+    }
+    return coverage;
+}
+
+}}} // namespace lsst::qserv::qproc
@@ -0,0 +1,158 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QPROC_CHUNKCOVERAGE_H
+#define LSST_QSERV_QPROC_CHUNKCOVERAGE_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// LSST headers
+#include "lsst/sphgeom/Chunker.h"
+
+// Qserv headers
+#include "css/StripingParams.h"
+#include "util/LruCache.h"
+
+// Forward declarations
+namespace lsst {
+namespace sphgeom {
+    class Box;
+    class Circle;
+    class Region;
+}} // End of forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+/// ChunkCoverage finds the subchunks of one partitioning intersecting a
+/// region, and keeps the coverage of recently seen regions.
+///
+/// The latitude bounds of all substripes, and their numbers of chunks and
+/// subchunks, are precomputed into flat arrays. For a circle, one
+/// branch-free loop over the arrays gives the longitude range the circle
+/// covers in each substripe it spans. A box covers the same longitude range
+/// in all. The subchunks in these ranges then follow from integer
+/// arithmetic on subchunk indexes. Other regions, and circles of radius over
+/// 45 degrees, are passed to the sphgeom::Chunker. The arrays are checked
+/// against the numbering of the Chunker when built, and left unused if they
+/// differ.
+class ChunkCoverage {
+public:
+    using Ptr = std::shared_ptr<ChunkCoverage>;
+    using SubChunksVector = std::vector<lsst::sphgeom::SubChunks>;
+    using CoveragePtr = std::shared_ptr<SubChunksVector const>;
+
+    struct Stats {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+        std::uint64_t regions{0}; ///< Regions in the cache
+    };
+
+    /// @param sp - the partitioning.
+    /// @param cacheSize - regions whose coverage is kept, the least recently
+    ///                    used go first.
+    ChunkCoverage(css::StripingParams const& sp, std::size_t cacheSize);
+    ChunkCoverage(ChunkCoverage const&) = delete;
+    ChunkCoverage& operator=(ChunkCoverage const&) = delete;
+
+    lsst::sphgeom::Chunker const& getChunker() const { return _chunker; }
+
+    /// @return true if circles and boxes are computed from the arrays.
+    bool isFast() const { return _fast; }
+
+    /// @return the subchunks intersecting region, by increasing chunk id
+    ///         and subchunk id when computed from the arrays.
+    SubChunksVector compute(lsst::sphgeom::Region const& region) const;
+
+    /// @return the coverage kept for key, or nullptr.
+    CoveragePtr find(std::string const& key);
+
+    void insert(std::string const& key, CoveragePtr const& coverage);
+
+    Stats getStats() const;
+
+private:
+    bool _computeCircle(lsst::sphgeom::Circle const& circle, SubChunksVector& out) const;
+    void _computeBox(lsst::sphgeom::Box const& box, SubChunksVector& out) const;
+
+    /// Collect the subchunks of substripes [ssBegin, ssBegin + halfWidths.size())
+    /// within halfWidths[i] of longitude lon, none if negative.
+    void _collect(int ssBegin, double lon, std::vector<double> const& halfWidths,
+                  SubChunksVector& out) const;
+
+    /// @return the substripe of latitude lat, in radians, clamped to the valid ones.
+    int _subStripe(double lat) const;
+
+    bool _check() const;
+
+    lsst::sphgeom::Chunker const _chunker;
+    int const _numStripes;
+    int const _numSubStripesPerStripe;
+    double const _subStripeHeight;
+    int _maxSubChunksPerSubStripeChunk{0};
+    bool _fast{false};
+
+    std::vector<int> _numChunks;     ///< Per stripe
+    // Per substripe, latitude bounds in radians dilated by BOX_EPSILON
+    std::vector<double> _latMin;
+    std::vector<double> _latMax;
+    std::vector<double> _sinLatMin;
+    std::vector<double> _cosLatMin;
+    std::vector<double> _sinLatMax;
+    std::vector<double> _cosLatMax;
+    std::vector<int> _numSubChunks;  ///< Per substripe, in one chunk
+
+    mutable std::mutex _mtx; ///< Protects _cache
+    util::LruCache<std::string, CoveragePtr> _cache;
+};
+
+
+/// ChunkCoverageMap hands out one ChunkCoverage per partitioning, shared by
+/// all queries.
+class ChunkCoverageMap {
+public:
+    using Ptr = std::shared_ptr<ChunkCoverageMap>;
+
+    /// @param cacheSize - regions whose coverage is kept per partitioning.
+    explicit ChunkCoverageMap(std::size_t cacheSize) : _cacheSize(cacheSize) {}
+    ChunkCoverageMap(ChunkCoverageMap const&) = delete;
+    ChunkCoverageMap& operator=(ChunkCoverageMap const&) = delete;
+
+    ChunkCoverage::Ptr get(css::StripingParams const& sp);
+
+private:
+    std::size_t const _cacheSize;
+    std::mutex _mtx;
+    std::map<std::pair<int, int>, ChunkCoverage::Ptr> _coverages; ///< By stripes, subStripes
+};
+
+}}} // namespace lsst::qserv::qproc
+
+#endif // LSST_QSERV_QPROC_CHUNKCOVERAGE_H
@@ -147,7 +147,6 @@ lsst::qserv::qproc::ChunkSpec convertSgSubChunks(SubChunks const& sc) {
 namespace lsst {
 namespace qserv {
 namespace qproc {
-typedef std::vector<std::shared_ptr<Region> > RegionPtrVector;
 
 ////////////////////////////////////////////////////////////////////////
 // IndexMap::PartitioningMap definition and implementation
@@ -159,28 +158,29 @@ public:
         NoRegion() : std::invalid_argument("No region specified")
             {}
     };
-    explicit PartitioningMap(css::StripingParams const& sp) {
-        _chunker = std::make_shared<lsst::sphgeom::Chunker>(sp.stripes,
-                                                            sp.subStripes);
-
+    PartitioningMap(css::StripingParams const& sp, ChunkCoverage::Ptr const& coverage)
+        : _coverage(coverage) {
+        if (_coverage) {
+            // Share the Chunker of coverage
+            _chunker = std::shared_ptr<lsst::sphgeom::Chunker const>(_coverage, &_coverage->getChunker());
+        } else {
+            _chunker = std::make_shared<lsst::sphgeom::Chunker>(sp.stripes,
+                                                                sp.subStripes);
+        }
     }
     /// @return un-canonicalized vector<SubChunks> of concatenated region
     /// results. Regions are assumed to be joined by implicit "OR" and not "AND"
     /// Throws NoRegion if no region is passed.
-    SubChunksVector getIntersect(RegionPtrVector const& rv) {
+    SubChunksVector getIntersect(query::ConstraintVector const& cv) {
         SubChunksVector scv;
         bool hasRegion = false;
-        for(RegionPtrVector::const_iterator i=rv.begin(), e=rv.end();
-            i != e;
-            ++i) {
-            if (*i) {
-                SubChunksVector area = getCoverage(**i);
-                scv.insert(scv.end(), area.begin(), area.end());
+        for (auto const& c : cv) {
+            ChunkCoverage::CoveragePtr area = getCoverage(c);
+            if (area) {
+                scv.insert(scv.end(), area->begin(), area->end());
                 hasRegion = true;
-            } else {
-                // Ignore null-regions
-                continue;
             }
+            // Ignore constraints that are not regions
         }
         if (!hasRegion) {
             throw NoRegion();
@@ -188,35 +188,67 @@ public:
         return scv;
     }
 
-    inline SubChunksVector getCoverage(Region const& r) {
-        return _chunker->getSubChunksIntersecting(r);
+    /// @return the coverage of the region of c, nullptr if c is not a region.
+    ChunkCoverage::CoveragePtr getCoverage(query::Constraint const& c) {
+        if (!_coverage) {
+            std::shared_ptr<Region> region = getRegion(c);
+            if (!region) {
+                return nullptr;
+            }
+            return std::make_shared<SubChunksVector>(_chunker->getSubChunksIntersecting(*region));
+        }
+        if (funcMap.fMap.find(c.name) == funcMap.fMap.end()) {
+            return nullptr;
+        }
+        // Equal constraints have equal regions, and are not parsed again.
+        std::string key = c.name;
+        for (auto const& param : c.params) {
+            key += ' ';
+            key += param;
+        }
+        ChunkCoverage::CoveragePtr area = _coverage->find(key);
+        if (!area) {
+            std::shared_ptr<Region> region = getRegion(c);
+            area = std::make_shared<SubChunksVector>(_coverage->compute(*region));
+            _coverage->insert(key, area);
+        }
+        return area;
     }
-    ChunkSpecVector getAllChunks() const {
+    /// @return all chunks not in emptyChunks, if not nullptr.
+    ChunkSpecVector getAllChunks(css::ChunkBitmap const* emptyChunks) const {
         Int32Vector allChunks = _chunker->getAllChunks();
         ChunkSpecVector csv;
         csv.reserve(allChunks.size());
         for(IntVector::const_iterator i=allChunks.begin(), e=allChunks.end();
             i != e; ++i) {
+            // Skip empty chunks before listing their subchunks
+            if (emptyChunks && emptyChunks->contains(*i)) {
+                continue;
+            }
             csv.push_back(ChunkSpec(*i, _chunker->getAllSubChunks(*i)));
         }
         return csv;
     }
 private:
-    std::shared_ptr<lsst::sphgeom::Chunker> _chunker;
+    ChunkCoverage::Ptr _coverage;
+    std::shared_ptr<lsst::sphgeom::Chunker const> _chunker;
 };
 
 ////////////////////////////////////////////////////////////////////////
 // IndexMap implementation
 ////////////////////////////////////////////////////////////////////////
 IndexMap::IndexMap(css::StripingParams const& sp,
-                   std::shared_ptr<SecondaryIndex> si)
-    : _pm(std::make_shared<PartitioningMap>(sp)),
-      _si(si) {
+                   std::shared_ptr<SecondaryIndex> si,
+                   css::ChunkBitmap::Ptr const& emptyChunks,
+                   ChunkCoverage::Ptr const& coverage)
+    : _pm(std::make_shared<PartitioningMap>(sp, coverage)),
+      _si(si),
+      _emptyChunks(emptyChunks) {
 }
 
 // Compute the chunks list for the whole partitioning scheme
 ChunkSpecVector IndexMap::getAllChunks() {
-    return _pm->getAllChunks();
+    return _pm->getAllChunks(_emptyChunks.get());
 }
 
 //  Compute chunks coverage of spatial and secondary index constraints
@@ -231,6 +263,7 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
     bool hasRegion = true;
     try {
         indexSpecs = _si->lookup(cv);
+        _removeEmpty(indexSpecs);
         LOGS(_log, LOG_LVL_TRACE, "Index specs: " << util::printable(indexSpecs));
     } catch(SecondaryIndex::NoIndexConstraint& e) {
         LOGS(_log, LOG_LVL_DEBUG, "No secondary index constraint");
@@ -238,11 +271,9 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
     }
 
     // Spatial area lookups
-    RegionPtrVector rv;
-    std::transform(cv.begin(), cv.end(), std::back_inserter(rv), getRegion);
     SubChunksVector scv;
     try {
-        scv = _pm->getIntersect(rv);
+        scv = _pm->getIntersect(cv);
     } catch(PartitioningMap::NoRegion& e) {
         hasRegion = false;
     } catch(std::invalid_argument& a) {
@@ -251,8 +282,13 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
         throw QueryProcessingError(e.what());
     }
     ChunkSpecVector regionSpecs;
-    std::transform(scv.begin(), scv.end(),
-                   std::back_inserter(regionSpecs), convertSgSubChunks);
+    regionSpecs.reserve(scv.size());
+    for (auto const& subChunks : scv) {
+        // AND the coverage with the non-empty chunks
+        if (!_emptyChunks || !_emptyChunks->contains(subChunks.chunkId)) {
+            regionSpecs.push_back(convertSgSubChunks(subChunks));
+        }
+    }
 
     // FIXME: Index and spatial lookup are supported in AND format only right now.
     if (hasIndex && hasRegion) {
@@ -270,6 +306,15 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
     }
 }
 
+void IndexMap::_removeEmpty(ChunkSpecVector& specs) const {
+    if (!_emptyChunks) {
+        return;
+    }
+    specs.erase(std::remove_if(specs.begin(), specs.end(),
+                               [this](ChunkSpec const& cs) { return _emptyChunks->contains(cs.chunkId); }),
+                specs.end());
+}
+
 }}} // namespace lsst::qserv::qproc
 
 
@@ -31,8 +31,10 @@
   */
 
 // Qserv headers
+#include "css/ChunkBitmap.h"
 #include "css/StripingParams.h"
 #include "query/Constraint.h"
+#include "qproc/ChunkCoverage.h"
 #include "qproc/ChunkSpec.h"
 
 namespace lsst {
@@ -43,8 +45,13 @@ class SecondaryIndex;
 
 class IndexMap {
 public:
+    /// @param emptyChunks: chunks left out of all results, none if nullptr.
+    /// @param coverage: computes and keeps the coverage of regions, which a
+    ///                  sphgeom::Chunker of sp computes if nullptr.
     IndexMap(css::StripingParams const& sp,
-             std::shared_ptr<SecondaryIndex> si);
+             std::shared_ptr<SecondaryIndex> si,
+             css::ChunkBitmap::Ptr const& emptyChunks=nullptr,
+             ChunkCoverage::Ptr const& coverage=nullptr);
 
     /** Compute the chunks list for the whole partitioning scheme
      *
@@ -70,8 +77,11 @@ public:
 
     class PartitioningMap;
 private:
+    void _removeEmpty(ChunkSpecVector& specs) const;
+
     std::shared_ptr<PartitioningMap> _pm;
     std::shared_ptr<SecondaryIndex> _si;
+    css::ChunkBitmap::Ptr _emptyChunks;
 };
 
 }}} // namespace lsst::qserv::qproc
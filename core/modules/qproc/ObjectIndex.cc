@@ -0,0 +1,316 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qproc/ObjectIndex.h"
+
+// System headers
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "util/MappedFile.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.ObjectIndex");
+
+using lsst::qserv::util::MappedFile;
+
+char const MAGIC[MappedFile::MAGIC_SIZE] = {'Q', 'S', 'O', 'B', 'J', 'I', 'X', '2'};
+
+/// The start of an index file. The arrays follow in the order of the
+/// members of ObjectIndex, each starting on a multiple of its alignment.
+struct FileHeader {
+    char magic[MappedFile::MAGIC_SIZE];
+    std::uint64_t size;
+    std::uint64_t blockCount;
+    std::uint64_t pairCount;
+    std::uint64_t fingerprint;
+};
+
+std::uint64_t fileBytes(std::uint64_t size, std::uint64_t blockCount, std::uint64_t pairCount) {
+    return sizeof(FileHeader) + 8 * blockCount + 8 * (blockCount + 1) + 8 * pairCount + 8 * size;
+}
+
+/// The arrays of an index built in memory.
+struct Arrays {
+    std::vector<std::int64_t> fences;
+    std::vector<std::uint64_t> starts;
+    std::vector<std::int32_t> pairs;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> codes;
+};
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+ObjectIndex::Ptr ObjectIndex::build(std::vector<Entry> entries) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](Entry const& a, Entry const& b) { return a.key < b.key; });
+    auto last = std::unique(entries.begin(), entries.end(),
+                            [](Entry const& a, Entry const& b) { return a.key == b.key; });
+    entries.erase(last, entries.end());
+
+    using Pair = std::pair<std::int32_t, std::int32_t>;
+    std::vector<Pair> pairs;
+    pairs.reserve(entries.size());
+    for (auto const& entry : entries) {
+        pairs.emplace_back(entry.chunkId, entry.subChunkId);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    if (pairs.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("ObjectIndex: too many distinct (chunkId, subChunkId)");
+    }
+
+    auto arrays = std::make_shared<Arrays>();
+    arrays->pairs.reserve(2 * pairs.size());
+    for (auto const& pair : pairs) {
+        arrays->pairs.push_back(pair.first);
+        arrays->pairs.push_back(pair.second);
+    }
+    arrays->offsets.reserve(entries.size());
+    arrays->codes.reserve(entries.size());
+    std::uint64_t const maxOffset = std::numeric_limits<std::uint32_t>::max();
+    for (std::uint64_t j=0; j < entries.size(); ++j) {
+        Entry const& entry = entries[j];
+        // Start a block when the last one is full, or the key is too far
+        // from its fence for an offset.
+        if (arrays->fences.empty() || j - arrays->starts.back() == BLOCK_SIZE
+            || static_cast<std::uint64_t>(entry.key) - static_cast<std::uint64_t>(arrays->fences.back())
+               > maxOffset) {
+            arrays->fences.push_back(entry.key);
+            arrays->starts.push_back(j);
+        }
+        arrays->offsets.push_back(static_cast<std::uint32_t>(
+            static_cast<std::uint64_t>(entry.key) - static_cast<std::uint64_t>(arrays->fences.back())));
+        auto pair = std::lower_bound(pairs.begin(), pairs.end(), Pair(entry.chunkId, entry.subChunkId));
+        arrays->codes.push_back(static_cast<std::uint32_t>(pair - pairs.begin()));
+    }
+    arrays->starts.push_back(entries.size());
+
+    Ptr index(new ObjectIndex());
+    index->_size = entries.size();
+    index->_blockCount = arrays->fences.size();
+    index->_pairCount = pairs.size();
+    index->_fences = arrays->fences.data();
+    index->_starts = arrays->starts.data();
+    index->_pairs = arrays->pairs.data();
+    index->_offsets = arrays->offsets.data();
+    index->_codes = arrays->codes.data();
+    index->_storage = arrays;
+    return index;
+}
+
+
+ObjectIndex::Ptr ObjectIndex::load(std::string const& path) {
+    auto file = MappedFile::map(path, "ObjectIndex");
+    std::uint64_t const bytes = file->size();
+    FileHeader const* header = reinterpret_cast<FileHeader const*>(file->data());
+    // Bound the counts by the file size first, so that fileBytes() cannot overflow.
+    if (!file->hasHeader(MAGIC, sizeof(FileHeader))
+        || header->size > bytes || header->blockCount > bytes || header->pairCount > bytes
+        || fileBytes(header->size, header->blockCount, header->pairCount) != bytes) {
+        throw std::runtime_error("ObjectIndex: " + path + " is not an index file");
+    }
+    // Read the file in now rather than during the first queries.
+    file->willNeed();
+
+    Ptr index(new ObjectIndex());
+    index->_size = header->size;
+    index->_blockCount = header->blockCount;
+    index->_pairCount = header->pairCount;
+    char const* pos = file->data() + sizeof(FileHeader);
+    index->_fences = reinterpret_cast<std::int64_t const*>(pos);
+    pos += 8 * index->_blockCount;
+    index->_starts = reinterpret_cast<std::uint64_t const*>(pos);
+    pos += 8 * (index->_blockCount + 1);
+    index->_pairs = reinterpret_cast<std::int32_t const*>(pos);
+    pos += 8 * index->_pairCount;
+    index->_offsets = reinterpret_cast<std::uint32_t const*>(pos);
+    pos += 4 * index->_size;
+    index->_codes = reinterpret_cast<std::uint32_t const*>(pos);
+    index->_fingerprint = header->fingerprint;
+    index->_storage = file;
+    if (!index->_isConsistent()) {
+        throw std::runtime_error("ObjectIndex: " + path + " is corrupt");
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "ObjectIndex mapped " << path << " keys=" << index->_size);
+    return index;
+}
+
+
+void ObjectIndex::save(std::string const& path, std::uint64_t fingerprint) const {
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.size = _size;
+    header.blockCount = _blockCount;
+    header.pairCount = _pairCount;
+    header.fingerprint = fingerprint;
+    MappedFile::save(path, {{&header, sizeof(header)},
+                            {_fences, 8 * _blockCount},
+                            {_starts, 8 * (_blockCount + 1)},
+                            {_pairs, 8 * _pairCount},
+                            {_offsets, 4 * _size},
+                            {_codes, 4 * _size}},
+                     "ObjectIndex");
+}
+
+
+/// @return true if the arrays only refer to entries, blocks and pairs
+///         within bounds, and keys are in order. This reads all of them.
+bool ObjectIndex::_isConsistent() const {
+    if ((_blockCount == 0) != (_size == 0) || _blockCount > _size
+        || _starts[0] != 0 || _starts[_blockCount] != _size) {
+        return false;
+    }
+    for (std::uint64_t b=0; b < _blockCount; ++b) {
+        if (_starts[b + 1] <= _starts[b] || _starts[b + 1] - _starts[b] > BLOCK_SIZE
+            || (b > 0 && _fences[b] <= _fences[b - 1])) {
+            return false;
+        }
+    }
+    for (std::uint64_t j=0; j < _size; ++j) {
+        if (_codes[j] >= _pairCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+std::uint64_t ObjectIndex::getBytes() const {
+    return fileBytes(_size, _blockCount, _pairCount) - sizeof(FileHeader);
+}
+
+
+std::vector<std::int64_t> ObjectIndex::lookup(std::vector<std::int64_t> keys, Visitor const& found) const {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (_size == 0) {
+        return keys;
+    }
+    std::vector<std::int64_t> missing;
+    std::uint64_t block = 0;
+    for (auto key : keys) {
+        std::uint64_t const next = _findBlock(key, block);
+        if (next == _blockCount) {
+            missing.push_back(key); // Before the first key
+            continue;
+        }
+        block = next;
+        std::uint64_t const entry = _lowerBound(block, key);
+        if (entry < _starts[block + 1] && _fences[block] + static_cast<std::int64_t>(_offsets[entry]) == key) {
+            _visit(entry, found);
+        } else {
+            missing.push_back(key);
+        }
+    }
+    return missing;
+}
+
+
+void ObjectIndex::lookupRange(std::int64_t minKey, std::int64_t maxKey, Visitor const& found) const {
+    if (_size == 0 || minKey > maxKey) {
+        return;
+    }
+    std::uint64_t block = _findBlock(minKey, 0);
+    std::uint64_t entry = 0;
+    if (block == _blockCount) {
+        block = 0;
+    } else {
+        entry = _lowerBound(block, minKey);
+    }
+    for (; block < _blockCount; ++block) {
+        std::int64_t const fence = _fences[block];
+        if (fence > maxKey) {
+            break;
+        }
+        std::uint64_t const end = _starts[block + 1];
+        for (; entry < end; ++entry) {
+            if (fence + static_cast<std::int64_t>(_offsets[entry]) > maxKey) {
+                return;
+            }
+            _visit(entry, found);
+        }
+    }
+}
+
+
+/// @return the last block whose fence is not above key, searching from
+///         block first onwards, or _blockCount if key is before them all.
+///         Gallops ahead first, as batches of sorted keys move forward in
+///         small steps.
+std::uint64_t ObjectIndex::_findBlock(std::int64_t key, std::uint64_t first) const {
+    if (_fences[first] > key) {
+        return _blockCount;
+    }
+    std::uint64_t low = first;
+    std::uint64_t high = first + 1;
+    std::uint64_t step = 1;
+    while (high < _blockCount && _fences[high] <= key) {
+        low = high;
+        step *= 2;
+        high = low + step;
+    }
+    high = std::min(high, _blockCount);
+    return std::upper_bound(_fences + low, _fences + high, key) - _fences - 1;
+}
+
+
+/// @return the first entry of block not below key, or the end of the block.
+///         key must not be below the fence of block.
+std::uint64_t ObjectIndex::_lowerBound(std::uint64_t block, std::int64_t key) const {
+    std::uint64_t const begin = _starts[block];
+    std::uint64_t const end = _starts[block + 1];
+    std::uint64_t const diff = static_cast<std::uint64_t>(key) - static_cast<std::uint64_t>(_fences[block]);
+    if (diff > std::numeric_limits<std::uint32_t>::max()) {
+        return end;
+    }
+    // Count the offsets below diff. Blocks are short and the loop has no
+    // branch on the data, so compilers turn it into SIMD compares.
+    std::uint32_t const target = static_cast<std::uint32_t>(diff);
+    std::uint64_t count = 0;
+    for (std::uint64_t j=begin; j < end; ++j) {
+        count += _offsets[j] < target ? 1 : 0;
+    }
+    return begin + count;
+}
+
+
+void ObjectIndex::_visit(std::uint64_t entry, Visitor const& found) const {
+    std::uint64_t const code = _codes[entry];
+    found(_pairs[2 * code], _pairs[2 * code + 1]);
+}
+
+}}} // namespace lsst::qserv::qproc
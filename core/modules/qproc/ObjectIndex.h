@@ -0,0 +1,125 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QPROC_OBJECTINDEX_H
+#define LSST_QSERV_QPROC_OBJECTINDEX_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+/// ObjectIndex is a read-only map from the key of a director table to the
+/// (chunkId, subChunkId) of its row, the content of one secondary index
+/// table held in memory.
+///
+/// Keys are kept sorted and cut into blocks of up to BLOCK_SIZE keys. The
+/// first key of each block is a fence pointer, and the keys of a block are
+/// stored as 32 bit offsets from it. Each distinct (chunkId, subChunkId)
+/// pair is stored once, and keys refer to it by a 32 bit code, so an entry
+/// takes 8 bytes. The fences are small enough to stay in cache, so a lookup
+/// touches one block of offsets and one code.
+///
+/// save() writes the arrays to a file that load() maps back without parsing.
+/// The file also keeps a fingerprint of the table the index was read from,
+/// for its user to tell whether the file is still current.
+class ObjectIndex {
+public:
+    using Ptr = std::shared_ptr<ObjectIndex>;
+
+    /// Called with the (chunkId, subChunkId) of each key found.
+    using Visitor = std::function<void(std::int32_t chunkId, std::int32_t subChunkId)>;
+
+    struct Entry {
+        std::int64_t key;
+        std::int32_t chunkId;
+        std::int32_t subChunkId;
+    };
+
+    static unsigned int const BLOCK_SIZE = 64;
+
+    /// @return an index of entries, given in any order. Of entries with the
+    ///         same key, the first one is kept.
+    static Ptr build(std::vector<Entry> entries);
+
+    /// @return the index in file path, written by save(). The file is mapped
+    ///         read-only and must not change while the index is in use.
+    /// @throws std::runtime_error if the file cannot be mapped, is not an
+    ///         index, or its arrays are inconsistent.
+    static Ptr load(std::string const& path);
+
+    /// Write the index to path, through a temporary file renamed at the end.
+    /// @param fingerprint identifies the source of the index, see getFingerprint()
+    /// @throws std::runtime_error on failure.
+    void save(std::string const& path, std::uint64_t fingerprint) const;
+
+    /// @return the fingerprint given to save() for a loaded index, 0 for an
+    ///         index built in memory.
+    std::uint64_t getFingerprint() const { return _fingerprint; }
+
+    ObjectIndex(ObjectIndex const&) = delete;
+    ObjectIndex& operator=(ObjectIndex const&) = delete;
+
+    std::uint64_t size() const { return _size; }               ///< Keys
+    std::uint64_t getPairCount() const { return _pairCount; }  ///< Distinct (chunkId, subChunkId)
+    std::uint64_t getBytes() const;                            ///< Size of the arrays
+
+    /// Look up a batch of keys, in any order. Keys are sorted first, so that
+    /// the blocks are visited in order.
+    /// @return the keys not found, sorted and without duplicates.
+    std::vector<std::int64_t> lookup(std::vector<std::int64_t> keys, Visitor const& found) const;
+
+    /// Visit every key in [minKey, maxKey], in key order.
+    void lookupRange(std::int64_t minKey, std::int64_t maxKey, Visitor const& found) const;
+
+private:
+    ObjectIndex() = default;
+
+    bool _isConsistent() const;
+    std::uint64_t _findBlock(std::int64_t key, std::uint64_t first) const;
+    std::uint64_t _lowerBound(std::uint64_t block, std::int64_t key) const;
+    void _visit(std::uint64_t entry, Visitor const& found) const;
+
+    std::uint64_t _size{0};
+    std::uint64_t _blockCount{0};
+    std::uint64_t _pairCount{0};
+    std::uint64_t _fingerprint{0};
+
+    // The arrays, in memory owned by _storage.
+    std::int64_t const* _fences{nullptr};     ///< [_blockCount] first key of each block
+    std::uint64_t const* _starts{nullptr};    ///< [_blockCount + 1] first entry of each block
+    std::int32_t const* _pairs{nullptr};      ///< [2 * _pairCount] chunkId, subChunkId
+    std::uint32_t const* _offsets{nullptr};   ///< [_size] key minus the fence of its block
+    std::uint32_t const* _codes{nullptr};     ///< [_size] pair of each key
+
+    std::shared_ptr<void const> _storage; ///< Heap arrays or the file mapping
+};
+
+}}} // namespace lsst::qserv::qproc
+
+#endif // LSST_QSERV_QPROC_OBJECTINDEX_H
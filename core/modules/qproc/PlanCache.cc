@@ -0,0 +1,373 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qproc/PlanCache.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "css/CssAccess.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.PlanCache");
+
+/// Placeholders are PLACEHOLDER followed by INDEX_DIGITS digits of the index
+/// of their literal: that number for an integer, after "0." for a decimal,
+/// and in quotes for a string.
+char const PLACEHOLDER[] = "79193";
+std::size_t const PLACEHOLDER_SIZE = 5;
+std::size_t const INDEX_DIGITS = 11;
+
+using lsst::qserv::qproc::PlanCache;
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c));
+}
+
+std::string placeholder(std::size_t index, PlanCache::Literal::Kind kind) {
+    char digits[INDEX_DIGITS + 1];
+    std::snprintf(digits, sizeof(digits), "%011zu", index);
+    std::string core = PLACEHOLDER + std::string(digits);
+    switch (kind) {
+    case PlanCache::Literal::DECIMAL: return "0." + core;
+    case PlanCache::Literal::STRING:  return "'" + core + "'";
+    default:                          return core;
+    }
+}
+
+/// Keywords ending a WHERE clause.
+bool endsWhere(std::string const& upper) {
+    static std::set<std::string> const words{
+        "GROUP", "HAVING", "ORDER", "LIMIT", "PROCEDURE", "INTO", "FOR", "LOCK", "UNION"};
+    return words.count(upper) > 0;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+PlanCache::PlanCache(std::size_t maxPlans, std::chrono::milliseconds checkInterval)
+    : _checkInterval{checkInterval}, _plans{"PlanCache", std::max<std::size_t>(maxPlans, 1)} {
+    _plans.setReporter([this](std::ostream& os) {
+        os << " uncacheable=" << _uncacheable << " invalidated=" << _invalidated
+           << " savedMs=" << _savedMs;
+    });
+    LOGS(_log, LOG_LVL_DEBUG, "PlanCache maxPlans=" << _plans.getMaxSize()
+         << " checkInterval=" << _checkInterval.count() << "ms");
+}
+
+
+bool PlanCache::makeShape(std::string const& sql, Shape& shape) {
+    shape = Shape();
+    std::size_t const size = sql.size();
+    bool inWhere = false;
+    int depth = 0;
+    auto addLiteral = [&shape](Literal::Kind kind, std::string const& text) {
+        static char const* const keys[] = {"?i", "?d", "?s"};
+        shape.key += keys[kind];
+        shape.placeholderSql += placeholder(shape.literals.size(), kind);
+        shape.literals.push_back(Literal{kind, text});
+    };
+    auto addText = [&shape](std::string const& text) {
+        shape.key += text;
+        shape.placeholderSql += text;
+    };
+    std::size_t j = 0;
+    while (j < size) {
+        char const c = sql[j];
+        if (c == '\'' || c == '"' || c == '`') {
+            std::size_t k = j + 1;
+            while (k < size) {
+                if (sql[k] == '\\' && c != '`') {
+                    k += 2;
+                } else if (sql[k] == c && k + 1 < size && sql[k+1] == c) {
+                    k += 2; // Doubled quote
+                } else if (sql[k] == c) {
+                    break;
+                } else {
+                    ++k;
+                }
+            }
+            if (k >= size) {
+                return false;
+            }
+            std::string const text = sql.substr(j, k + 1 - j);
+            if (inWhere && c == '\'') {
+                addLiteral(Literal::STRING, text);
+            } else {
+                addText(text);
+            }
+            j = k + 1;
+        } else if ((c == '-' && j + 1 < size && sql[j+1] == '-') || c == '#'
+                   || (c == '/' && j + 1 < size && sql[j+1] == '*') || c == '?') {
+            return false;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (shape.key.empty() || shape.key.back() != ' ') {
+                shape.key += ' ';
+            }
+            shape.placeholderSql += c;
+            ++j;
+        } else if (isDigit(c) || (c == '.' && j + 1 < size && isDigit(sql[j+1])
+                                  && (j == 0 || !isWordChar(sql[j-1])))) {
+            std::size_t k = j;
+            bool integer = true;
+            while (k < size && isDigit(sql[k])) ++k;
+            if (k < size && sql[k] == '.') {
+                integer = false;
+                ++k;
+                while (k < size && isDigit(sql[k])) ++k;
+            }
+            if (k < size && (sql[k] == 'e' || sql[k] == 'E')) {
+                std::size_t e = k + 1;
+                if (e < size && (sql[e] == '+' || sql[e] == '-')) ++e;
+                if (e < size && isDigit(sql[e])) {
+                    integer = false;
+                    k = e;
+                    while (k < size && isDigit(sql[k])) ++k;
+                }
+            }
+            if (k < size && isWordChar(sql[k])) {
+                // A word starting with digits, e.g. 0x1F, is kept whole.
+                while (k < size && isWordChar(sql[k])) ++k;
+                addText(sql.substr(j, k - j));
+            } else if (inWhere) {
+                addLiteral(integer ? Literal::INTEGER : Literal::DECIMAL, sql.substr(j, k - j));
+            } else {
+                addText(sql.substr(j, k - j));
+            }
+            j = k;
+        } else if (isWordChar(c)) {
+            std::size_t k = j;
+            std::string upper;
+            while (k < size && isWordChar(sql[k])) {
+                upper += std::toupper(static_cast<unsigned char>(sql[k]));
+                ++k;
+            }
+            if (depth == 0) {
+                if (upper == "WHERE") {
+                    inWhere = true;
+                } else if (endsWhere(upper)) {
+                    inWhere = false;
+                }
+            }
+            addText(sql.substr(j, k - j));
+            j = k;
+        } else {
+            if (c == '(') {
+                ++depth;
+            } else if (c == ')' && --depth < 0) {
+                return false;
+            }
+            addText(std::string(1, c));
+            ++j;
+        }
+    }
+    return depth == 0;
+}
+
+
+bool PlanCache::bind(std::string const& text, Literals const& literals, std::string& out) {
+    out.clear();
+    std::size_t const size = text.size();
+    std::size_t pos = 0;
+    std::size_t found = 0;
+    while ((found = text.find(PLACEHOLDER, found)) != std::string::npos) {
+        std::size_t const end = found + PLACEHOLDER_SIZE + INDEX_DIGITS;
+        bool digits = end <= size && (end == size || !isDigit(text[end]));
+        for (std::size_t k = found + PLACEHOLDER_SIZE; digits && k < end; ++k) {
+            digits = isDigit(text[k]);
+        }
+        if (!digits) {
+            ++found;
+            continue;
+        }
+        // Tell the kind of placeholder from what surrounds it.
+        Literal::Kind kind;
+        std::size_t start = found;
+        std::size_t stop = end;
+        if (found >= 2 && text[found-1] == '.' && text[found-2] == '0'
+            && (found == 2 || !isWordChar(text[found-3]))) {
+            kind = Literal::DECIMAL;
+            start = found - 2;
+        } else if (found >= 1 && text[found-1] == '\'' && end < size && text[end] == '\'') {
+            kind = Literal::STRING;
+            start = found - 1;
+            stop = end + 1;
+        } else if (found == 0 || (!isWordChar(text[found-1]) && text[found-1] != '.')) {
+            kind = Literal::INTEGER;
+        } else {
+            ++found; // Part of a word or number
+            continue;
+        }
+        std::size_t const index = std::stoull(text.substr(found + PLACEHOLDER_SIZE, INDEX_DIGITS));
+        if (index >= literals.size() || literals[index].kind != kind) {
+            return false;
+        }
+        out.append(text, pos, start - pos);
+        out += literals[index].text;
+        pos = stop;
+        found = stop;
+    }
+    out.append(text, pos, std::string::npos);
+    return true;
+}
+
+
+std::string PlanCache::cssState(css::CssAccess& css, std::vector<query::DbTablePair> const& tables) {
+    std::ostringstream os;
+    try {
+        std::set<std::string> dbs;
+        for (auto const& t : tables) {
+            if (t.db.empty()) {
+                continue;
+            }
+            dbs.insert(t.db);
+            if (!css.containsTable(t.db, t.table)) {
+                os << t.db << "." << t.table << ":none;";
+                continue;
+            }
+            css::TableParams const p = css.getTableParams(t.db, t.table);
+            os << t.db << "." << t.table << ":" << p.partitioning.dirDb << "," << p.partitioning.dirTable
+               << "," << p.partitioning.dirColName << "," << p.partitioning.latColName
+               << "," << p.partitioning.lonColName << "," << p.partitioning.overlap
+               << "," << p.partitioning.partitioned << "," << p.partitioning.subChunks
+               << "," << p.match.dirTable1 << "," << p.match.dirColName1
+               << "," << p.match.dirTable2 << "," << p.match.dirColName2
+               << "," << p.match.flagColName
+               << "," << p.sharedScan.lockInMem << "," << p.sharedScan.scanRating << ";";
+        }
+        for (auto const& db : dbs) {
+            if (!css.containsDb(db)) {
+                os << db << ":none;";
+                continue;
+            }
+            css::StripingParams const s = css.getDbStriping(db);
+            os << db << ":" << s.stripes << "," << s.subStripes << "," << s.partitioningId
+               << "," << s.overlap << ";";
+        }
+    } catch (std::exception const& e) {
+        LOGS(_log, LOG_LVL_WARN, "PlanCache cannot read CSS: " << e.what());
+        return std::string();
+    }
+    return os.str();
+}
+
+
+PlanCache::Plan::Ptr PlanCache::find(std::string const& key, css::CssAccess& css) {
+    Plan::Ptr plan;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        Entry* entry = _plans.find(key);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        plan = entry->plan;
+        auto now = std::chrono::steady_clock::now();
+        if (!plan->cacheable || now - entry->checked < _checkInterval) {
+            return plan;
+        }
+        // Meanwhile, other queries take the plan without checking it.
+        entry->checked = now;
+    }
+    // CSS is read without holding the mutex.
+    std::string const state = cssState(css, plan->tables);
+    if (!state.empty() && state == plan->cssState) {
+        return plan;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "PlanCache CSS changed for " << key);
+    std::lock_guard<std::mutex> lock(_mtx);
+    Entry* entry = _plans.find(key);
+    if (entry != nullptr && entry->plan == plan) {
+        _plans.erase(key);
+        ++_invalidated;
+    }
+    return nullptr;
+}
+
+
+void PlanCache::insert(std::string const& key, Plan::Ptr const& plan) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _plans.insert(key, Entry{plan, std::chrono::steady_clock::now()});
+}
+
+
+void PlanCache::invalidate(std::string const& db) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _invalidated += _plans.eraseIf([&db](std::string const&, Entry const& entry) {
+        auto const& tables = entry.plan->tables;
+        return std::any_of(tables.begin(), tables.end(),
+                           [&db](query::DbTablePair const& t) { return t.db == db; });
+    });
+}
+
+
+void PlanCache::addHit(Plan const& plan, double bindMs) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _savedMs += std::max(0.0, plan.analysisMs - bindMs);
+    _plans.addHit();
+}
+
+
+void PlanCache::addMiss() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _plans.addMiss();
+}
+
+
+void PlanCache::addUncacheable() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    ++_uncacheable;
+    _plans.addMiss();
+}
+
+
+PlanCache::Stats PlanCache::getStats() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto const lruStats = _plans.getStats();
+    Stats stats;
+    stats.hits = lruStats.hits;
+    stats.misses = lruStats.misses - _uncacheable;
+    stats.uncacheable = _uncacheable;
+    stats.invalidated = _invalidated;
+    stats.plans = lruStats.size;
+    stats.savedMs = _savedMs;
+    return stats;
+}
+
+}}} // namespace lsst::qserv::qproc
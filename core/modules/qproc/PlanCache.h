@@ -0,0 +1,162 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QPROC_PLANCACHE_H
+#define LSST_QSERV_QPROC_PLANCACHE_H
+
+// System headers
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "qana/QueryPlugin.h"
+#include "query/DbTablePair.h"
+#include "query/QueryTemplate.h"
+#include "util/LruCache.h"
+
+// Forward declarations
+namespace lsst {
+namespace qserv {
+namespace css {
+    class CssAccess;
+}
+namespace query {
+    class QueryContext;
+    class SelectStmt;
+}}} // End of forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+/// PlanCache keeps the analysis of queries by their shape, so that queries
+/// differing only in the literals of their WHERE clause are analyzed once.
+///
+/// The shape of a query is its text with the numbers and strings of its
+/// WHERE clause cut out. A shape is analyzed with placeholders for the
+/// literals, numbers that analysis carries through to its output as they
+/// are. Queries of that shape then take the output, with their own literals
+/// bound to the placeholders.
+///
+/// Analysis may depend on the value of a literal, e.g. on whether it is an
+/// integer. So a shape is only cached once the plan bound to the literals of
+/// a query matches the analysis of that query, and is remembered as
+/// uncacheable otherwise. Plans are checked against the CSS metadata of
+/// their tables, at most once per checkInterval, and dropped when it
+/// changed.
+class PlanCache {
+public:
+    using Ptr = std::shared_ptr<PlanCache>;
+
+    /// A literal cut out of a query.
+    struct Literal {
+        enum Kind { INTEGER, DECIMAL, STRING };
+        Kind kind;
+        std::string text; ///< As in the query, with the quotes of a string
+    };
+    using Literals = std::vector<Literal>;
+
+    /// A query split into its shape and literals.
+    struct Shape {
+        std::string key;             ///< Text with literals as ?i, ?d or ?s
+        std::string placeholderSql;  ///< Text with placeholders for literals
+        Literals literals;
+    };
+
+    /// The analysis of a shape, with placeholders for its literals.
+    struct Plan {
+        using Ptr = std::shared_ptr<Plan const>;
+        bool cacheable{false};
+        std::shared_ptr<query::SelectStmt> stmt;
+        std::shared_ptr<query::SelectStmt> stmtMerge;
+        bool hasMerge{false};
+        std::shared_ptr<query::QueryContext> context;
+        std::shared_ptr<std::vector<qana::QueryPlugin::Ptr>> plugins;
+        std::vector<query::QueryTemplate> parallelTemplates;
+        std::vector<query::DbTablePair> tables; ///< Tables of the FROM list
+        std::string cssState;  ///< The CSS metadata of tables, see cssState()
+        double analysisMs{0};  ///< Time to analyze a query of this shape
+    };
+
+    struct Stats {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};       ///< Including plans dropped for CSS changes
+        std::uint64_t uncacheable{0};  ///< Queries of uncacheable shapes
+        std::uint64_t invalidated{0};  ///< Plans dropped for CSS changes
+        std::uint64_t plans{0};        ///< Shapes in the cache
+        double savedMs{0};             ///< Analysis time saved by hits
+    };
+
+    /// @param maxPlans - shapes kept, the least recently used go first.
+    /// @param checkInterval - time between checks of the CSS metadata of a plan.
+    PlanCache(std::size_t maxPlans, std::chrono::milliseconds checkInterval);
+    PlanCache(PlanCache const&) = delete;
+    PlanCache& operator=(PlanCache const&) = delete;
+
+    /// Split sql into shape.
+    /// @return false if sql has no shape, e.g. for comments or unbalanced quotes.
+    static bool makeShape(std::string const& sql, Shape& shape);
+
+    /// Replace the placeholders in text by literals.
+    /// @return false if a placeholder has no literal of its kind.
+    static bool bind(std::string const& text, Literals const& literals, std::string& out);
+
+    /// @return a description of the CSS metadata analysis takes from tables,
+    ///         empty if it cannot be read.
+    static std::string cssState(css::CssAccess& css, std::vector<query::DbTablePair> const& tables);
+
+    /// @return the plan of key, checking it against css if due, or nullptr.
+    Plan::Ptr find(std::string const& key, css::CssAccess& css);
+
+    void insert(std::string const& key, Plan::Ptr const& plan);
+
+    /// Drop the plans on tables of db.
+    void invalidate(std::string const& db);
+
+    void addHit(Plan const& plan, double bindMs);
+    void addMiss();
+    void addUncacheable();
+
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        Plan::Ptr plan;
+        std::chrono::steady_clock::time_point checked;
+    };
+
+    std::chrono::milliseconds const _checkInterval;
+
+    mutable std::mutex _mtx; ///< Protects all below
+    util::LruCache<std::string, Entry> _plans; ///< Counts uncacheable queries as misses
+    std::uint64_t _uncacheable{0};
+    std::uint64_t _invalidated{0};
+    double _savedMs{0};
+};
+
+}}} // namespace lsst::qserv::qproc
+
+#endif // LSST_QSERV_QPROC_PLANCACHE_H
@@ -37,8 +37,10 @@
 // System headers
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -62,15 +64,30 @@
 #include "qana/QueryPlugin.h"
 #include "qproc/QueryProcessingBug.h"
 #include "query/Constraint.h"
+#include "query/FromList.h"
 #include "query/QsRestrictor.h"
 #include "query/QueryContext.h"
 #include "query/SelectStmt.h"
 #include "query/SelectList.h"
+#include "query/TableRef.h"
 #include "query/typedefs.h"
 #include "util/IterableFormatter.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.QuerySession");
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Collect the tables of a FROM list, joins included.
+struct TableCollector : public lsst::qserv::query::TableRef::FuncC {
+    void operator()(lsst::qserv::query::TableRef const& t) override {
+        tables.insert(lsst::qserv::query::DbTablePair(t.getDb(), t.getTable()));
+    }
+    std::set<lsst::qserv::query::DbTablePair> tables;
+};
+
 }
 
 namespace lsst {
@@ -92,6 +109,33 @@ void QuerySession::setDefaultDb(std::string const& defaultDb) {
 void QuerySession::analyzeQuery(std::string const& sql) {
     _original = sql;
     _isFinal = false;
+    PlanCache::Shape shape;
+    std::string key;
+    bool shaped = _planCache != nullptr && PlanCache::makeShape(sql, shape);
+    if (shaped) {
+        key = _defaultDb + "\n" + shape.key;
+        auto start = std::chrono::steady_clock::now();
+        auto plan = _planCache->find(key, *_css);
+        if (plan != nullptr && !plan->cacheable) {
+            _planCache->addUncacheable();
+            shaped = false;
+        } else if (plan != nullptr && _usePlan(*plan, shape.literals)) {
+            _planCache->addHit(*plan, msSince(start));
+            LOGS(_log, LOG_LVL_DEBUG, "Query plan from cache:\n " << *this);
+            return;
+        } else {
+            _planCache->addMiss();
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    _analyze(sql);
+    if (shaped && _error.empty()) {
+        _cachePlan(key, shape, msSince(start));
+    }
+}
+
+/// Parse sql and run the analysis plugins on it.
+void QuerySession::_analyze(std::string const& sql) {
     _initContext();
     assert(_context.get());
 
@@ -104,10 +148,13 @@ void QuerySession::analyzeQuery(std::string const& sql) {
         _applyLogicPlugins();
         _generateConcrete();
         _applyConcretePlugins();
+        _parallelTemplates.clear();
+        for (auto const& stmt : _stmtParallel) {
+            _parallelTemplates.push_back(stmt->getQueryTemplate());
+        }
 
         LOGS(_log, LOG_LVL_DEBUG, "Query Plugins applied:\n " << *this);
         LOGS(_log, LOG_LVL_TRACE, "ORDER BY clause for mysql-proxy: " << getProxyOrderBy());
-
     } catch(QueryProcessingBug& b) {
         _error = std::string("QuerySession bug:") + b.what();
     } catch(qana::AnalysisError& e) {
@@ -216,7 +263,7 @@ QuerySession::getDbStriping() {
     return _context->getDbStriping();
 }
 
-std::shared_ptr<IntSet const>
+css::ChunkBitmap::Ptr
 QuerySession::getEmptyChunks() {
     // FIXME: do we need to catch an exception here?
     return _css->getEmptyChunks().getEmpty(_context->dominantDb);
@@ -248,6 +295,7 @@ void QuerySession::finalize() {
 }
 
 QuerySession::Iter QuerySession::cQueryBegin() {
+    _compileChunkTemplates();
     return Iter(*this, _chunks.begin());
 }
 
@@ -332,9 +380,116 @@ void QuerySession::_applyConcretePlugins() {
     }
 }
 
+/// Take the analysis from plan, with literals bound to its placeholders.
+/// @return false if a placeholder has no literal of its kind.
+bool QuerySession::_usePlan(PlanCache::Plan const& plan, PlanCache::Literals const& literals) {
+    std::string value;
+    std::vector<query::QueryTemplate> templates;
+    for (auto const& t : plan.parallelTemplates) {
+        query::QueryTemplate bound;
+        for (auto const& e : t.getEntries()) {
+            if (!PlanCache::bind(e->getValue(), literals, value)) {
+                return false;
+            }
+            if (value == e->getValue()) {
+                bound.append(e);
+            } else {
+                bound.append(value);
+            }
+        }
+        templates.push_back(bound);
+    }
+    auto context = std::make_shared<query::QueryContext>(*plan.context);
+    if (plan.context->restrictors) {
+        context->restrictors = std::make_shared<query::QueryContext::RestrList>();
+        for (auto const& r : *plan.context->restrictors) {
+            auto restrictor = std::make_shared<query::QsRestrictor>(*r);
+            for (auto& param : restrictor->_params) {
+                if (!PlanCache::bind(param, literals, value)) {
+                    return false;
+                }
+                param = value;
+            }
+            context->restrictors->push_back(restrictor);
+        }
+    }
+    _context = context;
+    _stmt = plan.stmt;
+    _stmtParallel.clear();
+    _parallelTemplates.swap(templates);
+    // The merger changes its statement.
+    _stmtMerge = plan.stmtMerge->clone();
+    _hasMerge = plan.hasMerge;
+    _isDummy = false;
+    _plugins = plan.plugins;
+    _error.clear();
+    return true;
+}
+
+/// Analyze the shape of the query just analyzed, and cache it if binding
+/// the literals of the query to that plan gives the same analysis.
+void QuerySession::_cachePlan(std::string const& key, PlanCache::Shape const& shape, double analysisMs) {
+    QuerySession shaped(_css);
+    shaped.setDefaultDb(_defaultDb);
+    shaped._analyze(shape.placeholderSql);
+
+    auto plan = std::make_shared<PlanCache::Plan>();
+    plan->analysisMs = analysisMs;
+    if (shaped._error.empty()) {
+        plan->stmt = shaped._stmt;
+        plan->stmtMerge = shaped._stmtMerge;
+        plan->hasMerge = shaped._hasMerge;
+        plan->context = shaped._context;
+        plan->plugins = shaped._plugins;
+        plan->parallelTemplates = shaped._parallelTemplates;
+        QuerySession bound(_css);
+        plan->cacheable = bound._usePlan(*plan, shape.literals) && bound._describe() == _describe();
+    }
+    if (plan->cacheable) {
+        TableCollector collector;
+        for (auto const& tableRef : plan->stmt->getFromList().getTableRefList()) {
+            tableRef->apply(collector);
+        }
+        plan->tables.assign(collector.tables.begin(), collector.tables.end());
+        plan->cssState = PlanCache::cssState(*_css, plan->tables);
+        plan->cacheable = !plan->cssState.empty();
+    }
+    if (!plan->cacheable) {
+        // Only what is needed to tell that the shape is uncacheable.
+        plan = std::make_shared<PlanCache::Plan>();
+        LOGS(_log, LOG_LVL_DEBUG, "Query plan not cacheable: " << shape.key);
+    }
+    _planCache->insert(key, plan);
+}
+
+/// @return the results of the analysis used to run the query.
+std::string QuerySession::_describe() const {
+    std::ostringstream os;
+    for (auto const& t : _parallelTemplates) {
+        os << t.sqlFragment() << "\n";
+    }
+    os << "merge: " << _hasMerge << " " << _context->needsMerge << " "
+       << _stmtMerge->getQueryTemplate().sqlFragment() << "\n";
+    os << "order by: " << getProxyOrderBy() << "\n";
+    auto constraints = getConstraints();
+    if (constraints) {
+        os << "constraints: " << util::printable(*constraints) << "\n";
+    }
+    os << "db: " << _context->dominantDb << " chunks: " << _context->hasChunks()
+       << " " << _context->hasSubChunks() << " " << _context->chunkCount << "\n";
+    if (_context->queryMapping) {
+        os << "subchunk tables: " << util::printable(_context->queryMapping->getSubChunkTables()) << "\n";
+    }
+    os << "scan: " << _context->scanInfo.scanRating;
+    for (auto const& tbl : _context->scanInfo.infoTables) {
+        os << " " << tbl.db << "." << tbl.table << " " << tbl.lockInMemory << " " << tbl.scanRating;
+    }
+    return os.str();
+}
+
 /// Some code useful for debugging.
 void QuerySession::print(std::ostream& os) const {
-    query::QueryTemplate par = _stmtParallel.front()->getQueryTemplate();
+    query::QueryTemplate par = _parallelTemplates.front();
     query::QueryTemplate mer = _stmtMerge->getQueryTemplate();
     os << "QuerySession description:\n";
     os << "  original: " << this->_original << "\n";
@@ -350,40 +505,42 @@ void QuerySession::print(std::ostream& os) const {
     }
 }
 
-std::vector<std::string> QuerySession::_buildChunkQueries(ChunkSpec const& s) const {
-    std::vector<std::string> q;
+/// Render the parallel statements once, so that each chunk only
+/// substitutes its numbers into them.
+void QuerySession::_compileChunkTemplates() {
     // This logic may be pushed over to the qserv worker in the future.
-    if (_stmtParallel.empty() || !_stmtParallel.front()) {
-        throw QueryProcessingBug("Attempted buildChunkQueries without _stmtParallel");
+    if (_parallelTemplates.empty()) {
+        throw QueryProcessingBug("Attempted buildChunkQueries without parallel statements");
     }
 
     if (!_context->queryMapping) {
         throw QueryProcessingBug("Missing QueryMapping in _context");
     }
     qana::QueryMapping const& queryMapping = *_context->queryMapping;
+    _chunkTemplates.clear();
+    for(auto const& t : _parallelTemplates) {
+        _chunkTemplates.push_back(queryMapping.compile(t));
+    }
+}
 
-    typedef std::vector<query::QueryTemplate> QueryTplVector;
-    typedef QueryTplVector::const_iterator QueryTplVectorIter;
-    QueryTplVector queryTemplates;
-
-    typedef query::SelectStmtPtrVector::const_iterator Iter;
-    for(Iter i=_stmtParallel.begin(), e=_stmtParallel.end();
-        i != e; ++i) {
-        queryTemplates.push_back((**i).getQueryTemplate());
+std::vector<std::string> QuerySession::_buildChunkQueries(ChunkSpec const& s) const {
+    std::vector<std::string> q;
+    if (_chunkTemplates.empty()) {
+        throw QueryProcessingBug("Attempted buildChunkQueries without compiled templates");
     }
-    if (!queryMapping.hasSubChunks()) { // Non-subchunked?
+    if (!_context->queryMapping->hasSubChunks()) { // Non-subchunked?
         LOGS(_log, LOG_LVL_DEBUG, "Non-subchunked");
-
-        for(QueryTplVectorIter i=queryTemplates.begin(), e=queryTemplates.end(); i != e; ++i) {
-            q.push_back(_context->queryMapping->apply(s, *i));
+        int const subChunkId = s.subChunks.empty() ? 0 : s.subChunks.front();
+        for(auto const& tpl : _chunkTemplates) {
+            q.push_back(tpl.generate(s.chunkId, subChunkId));
         }
     } else { // subchunked:
         ChunkSpecSingle::Vector sVector = ChunkSpecSingle::makeVector(s);
-        typedef ChunkSpecSingle::Vector::const_iterator ChunkIter;
-        for(ChunkIter i=sVector.begin(), e=sVector.end(); i != e; ++i) {
-            for(QueryTplVectorIter j=queryTemplates.begin(), je=queryTemplates.end(); j != je; ++j) {
-                LOGS(_log, LOG_LVL_DEBUG, "adding query " << _context->queryMapping->apply(*i, *j));
-                q.push_back(_context->queryMapping->apply(*i, *j));
+        q.reserve(sVector.size() * _chunkTemplates.size());
+        for(auto const& single : sVector) {
+            for(auto const& tpl : _chunkTemplates) {
+                q.push_back(tpl.generate(single.chunkId, single.subChunkId));
+                LOGS(_log, LOG_LVL_DEBUG, "adding query " << q.back());
             }
         }
     }
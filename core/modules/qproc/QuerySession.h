@@ -40,12 +40,16 @@
 #include "boost/iterator/iterator_facade.hpp"
 
 // Qserv headers
+#include "css/ChunkBitmap.h"
 #include "css/CssAccess.h"
 #include "global/intTypes.h"
+#include "qana/QueryMapping.h"
 #include "qana/QueryPlugin.h"
 #include "qproc/ChunkQuerySpec.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/PlanCache.h"
 #include "query/Constraint.h"
+#include "query/QueryTemplate.h"
 #include "query/typedefs.h"
 
 
@@ -79,6 +83,10 @@ public:
     std::string const& getOriginal() const { return _original; }
     void setDefaultDb(std::string const& db);
 
+    /// Take the analysis of queries differing from earlier ones only in the
+    /// literals of their WHERE clause from planCache. nullptr analyzes all.
+    void setPlanCache(PlanCache::Ptr const& planCache) { _planCache = planCache; }
+
     /**
      * @brief Analyze SQL query issued by user
      *
@@ -96,10 +104,16 @@ public:
     void addChunk(ChunkSpec const& cs);
     void setDummy();
 
+    /// The WHERE clause of the statement has placeholders for literals when
+    /// the analysis came from the plan cache.
     query::SelectStmt const& getStmt() const { return *_stmt; }
 
+    /// Empty when the analysis came from the plan cache, see getParallelTemplates().
     query::SelectStmtPtrVector const& getStmtParallel() const { return _stmtParallel; }
 
+    /// The parallel statements as rendered for the chunk queries.
+    std::vector<query::QueryTemplate> const& getParallelTemplates() const { return _parallelTemplates; }
+
     /** @brief Return the ORDER BY clause to run on mysql-proxy at result retrieval.
      *
      *  Indeed, MySQL results order is undefined with simple "SELECT *" clause.
@@ -118,7 +132,7 @@ public:
     bool containsTable(std::string const& dbName, std::string const& tableName) const;
     bool validateDominantDb() const;
     css::StripingParams getDbStriping();
-    std::shared_ptr<IntSet const> getEmptyChunks();
+    css::ChunkBitmap::Ptr getEmptyChunks();
     std::string const& getError() const { return _error; }
 
     std::shared_ptr<query::SelectStmt> getMergeStmt() const;
@@ -151,6 +165,10 @@ private:
     typedef std::vector<qana::QueryPlugin::Ptr> QueryPluginPtrVector;
 
     // Pipeline helpers
+    void _analyze(std::string const& sql);
+    bool _usePlan(PlanCache::Plan const& plan, PlanCache::Literals const& literals);
+    void _cachePlan(std::string const& key, PlanCache::Shape const& shape, double analysisMs);
+    std::string _describe() const;
     void _initContext();
     void _preparePlugins();
     void _applyLogicPlugins();
@@ -158,6 +176,7 @@ private:
     void _applyConcretePlugins();
 
     // Iterator help
+    void _compileChunkTemplates();
     std::vector<std::string> _buildChunkQueries(ChunkSpec const& s) const;
 
     // Fields
@@ -182,6 +201,12 @@ private:
     */
     query::SelectStmtPtrVector _stmtParallel;
 
+    /// _stmtParallel rendered, or taken from the plan cache
+    std::vector<query::QueryTemplate> _parallelTemplates;
+
+    /// _parallelTemplates compiled for the queryMapping, by cQueryBegin()
+    std::vector<qana::QueryMapping::ChunkTemplate> _chunkTemplates;
+
     /**
     * Store the query used to aggregate results on the czar.
     * Aggregation is optional, so this variable may be empty
@@ -205,6 +230,7 @@ private:
 
     ChunkSpecVector _chunks; ///< Chunk coverage
     std::shared_ptr<QueryPluginPtrVector> _plugins; ///< Analysis plugin chain
+    PlanCache::Ptr _planCache;
 
 };
 
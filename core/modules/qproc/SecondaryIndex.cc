@@ -33,6 +33,12 @@
 
 // System headers
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -46,9 +52,11 @@
 #include "global/constants.h"
 #include "global/stringUtil.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/ObjectIndex.h"
 #include "query/Constraint.h"
 #include "sql/SqlConnection.h"
 #include "util/IterableFormatter.h"
+#include "util/StringHash.h"
 
 namespace {
 
@@ -56,6 +64,17 @@ LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.SecondaryIndex");
 
 enum QueryType { IN, BETWEEN };
 
+/// @return false if str is not a whole integer.
+bool parseKey(std::string const& str, std::int64_t& key) {
+    try {
+        std::size_t pos = 0;
+        key = std::stoll(str, &pos);
+        return pos == str.size();
+    } catch (std::exception const&) {
+        return false;
+    }
+}
+
 } // anonymous namespace
 
 namespace lsst {
@@ -84,11 +103,11 @@ public:
             ++i) {
             if (i->name == "sIndex"){
                 hasIndex = true;
-                _sqlLookup(output, i->params, IN);
+                _lookup(output, i->params, IN);
             }
             else if (i->name == "sIndexBetween") {
                 hasIndex = true;
-                _sqlLookup(output, i->params, BETWEEN);
+                _lookup(output, i->params, BETWEEN);
             }
         }
         if (!hasIndex) {
@@ -99,7 +118,12 @@ public:
     }
 
 
-private:
+protected:
+    /// Add the results of one index constraint to output.
+    virtual void _lookup(ChunkSpecVector& output, StringVector const& params, QueryType const& query_type) {
+        _sqlLookup(output, params, query_type);
+    }
+
     static std::string _buildIndexTableName(
         std::string const& db,
         std::string const& table) {
@@ -209,6 +233,238 @@ private:
     sql::SqlConnection _sqlConnection;
 };
 
+/// MemoryBackend answers lookups on some director tables from an ObjectIndex
+/// of their secondary index, and the rest from MySQL. The indexes are read
+/// from MySQL when the backend is made, or mapped from files saved in
+/// indexDir by an earlier run. A file is only used if the fingerprint it was
+/// saved with still matches the secondary index table, see _fingerprint().
+///
+/// Every checkInterval a thread compares the fingerprints again, and builds
+/// a new index for each table that changed, swapped in once complete. In
+/// between, keys added to a table are still found, as IN keys missing from
+/// the index are looked up in MySQL, but BETWEEN ranges may miss them.
+class MemoryBackend : public MySqlBackend {
+public:
+    MemoryBackend(mysql::MySqlConfig const& c, std::vector<std::string> const& tables,
+                  std::string const& indexDir, std::chrono::seconds checkInterval)
+        : MySqlBackend(c), _checkConnection(c, true), _indexDir(indexDir),
+          _checkInterval(checkInterval) {
+        for (auto const& table : tables) {
+            auto dot = table.find('.');
+            if (dot == std::string::npos) {
+                LOGS(_log, LOG_LVL_ERROR, "SecondaryIndex: expected db.table, not " << table);
+                continue;
+            }
+            std::string db = table.substr(0, dot);
+            std::string name = table.substr(dot + 1);
+            Table& entry = _tables[_buildIndexTableName(db, name)];
+            entry.db = db;
+            entry.table = name;
+            try {
+                _loadIndex(entry);
+            } catch (std::exception const& e) {
+                // MySQL answers for the table until a check succeeds.
+                LOGS(_log, LOG_LVL_ERROR, "SecondaryIndex: cannot load " << table << ": " << e.what());
+            }
+        }
+        if (_checkInterval.count() > 0 && !_tables.empty()) {
+            _checker = std::thread(&MemoryBackend::_checkLoop, this);
+        }
+    }
+
+    ~MemoryBackend() {
+        {
+            std::lock_guard<std::mutex> lock(_stopMtx);
+            _stop = true;
+        }
+        _stopCv.notify_all();
+        if (_checker.joinable()) {
+            _checker.join();
+        }
+    }
+
+protected:
+    void _lookup(ChunkSpecVector& output, StringVector const& params, QueryType const& query_type) override {
+        auto iter = _tables.find(_buildIndexTableName(params[0], params[1]));
+        std::shared_ptr<ObjectIndex const> index;
+        if (iter != _tables.end()) {
+            index = std::atomic_load(&iter->second.index);
+        }
+        if (index == nullptr) {
+            _sqlLookup(output, params, query_type);
+            return;
+        }
+        if (query_type == QueryType::BETWEEN && params.size() != 5) {
+            throw Bug("Incorrect parameters for bounded secondary index lookup ");
+        }
+        std::vector<std::int64_t> keys;
+        keys.reserve(params.size() - 3);
+        for (auto i = std::next(params.begin(), 3); i != params.end(); ++i) {
+            std::int64_t key;
+            if (!parseKey(*i, key)) {
+                // Not an integer, let MySQL compare it.
+                _sqlLookup(output, params, query_type);
+                return;
+            }
+            keys.push_back(key);
+        }
+
+        // As in _sqlLookup, gather the subchunks of each chunk.
+        std::map<int, Int32Vector> tmp;
+        auto found = [&tmp](std::int32_t chunkId, std::int32_t subChunkId) {
+            tmp[chunkId].push_back(subChunkId);
+        };
+        std::vector<std::int64_t> missing;
+        if (query_type == QueryType::IN) {
+            missing = index->lookup(std::move(keys), found);
+        } else {
+            index->lookupRange(keys[0], keys[1], found);
+        }
+        for(auto i=tmp.begin(), e=tmp.end();
+            i != e; ++i) {
+            output.push_back(ChunkSpec(i->first, i->second));
+        }
+        if (!missing.empty()) {
+            // The keys may have been added since the index was built.
+            StringVector missingParams(params.begin(), std::next(params.begin(), 3));
+            for (auto key : missing) {
+                missingParams.push_back(std::to_string(key));
+            }
+            _sqlLookup(output, missingParams, query_type);
+        }
+    }
+
+private:
+    struct Table {
+        std::string db;
+        std::string table;
+        std::uint64_t fingerprint{0}; ///< Of index, used by the checker thread only
+        std::shared_ptr<ObjectIndex const> index; ///< Accessed only with std::atomic_load/store
+    };
+
+    /// Read the index of entry from its file or MySQL, and swap it in.
+    void _loadIndex(Table& entry) {
+        auto start = std::chrono::steady_clock::now();
+        std::string path;
+        std::string const indexTable = _buildIndexTableName(entry.db, entry.table);
+        std::uint64_t const fingerprint = _fingerprint(entry.db, entry.table);
+        if (!_indexDir.empty()) {
+            path = _indexDir + "/" + sanitizeName(entry.db) + "__" + sanitizeName(entry.table) + ".idx";
+            struct stat st;
+            if (::stat(path.c_str(), &st) == 0) {
+                try {
+                    auto index = ObjectIndex::load(path);
+                    if (index->getFingerprint() == fingerprint) {
+                        LOGS(_log, LOG_LVL_INFO, "SecondaryIndex: mapped " << path
+                             << " keys=" << index->size());
+                        entry.fingerprint = fingerprint;
+                        std::atomic_store(&entry.index, std::shared_ptr<ObjectIndex const>(index));
+                        return;
+                    }
+                    LOGS(_log, LOG_LVL_INFO, "SecondaryIndex: " << indexTable
+                         << " changed since " << path << " was saved, rebuilding it");
+                } catch (std::exception const& e) {
+                    LOGS(_log, LOG_LVL_WARN, "SecondaryIndex: " << e.what() << ", rebuilding it");
+                }
+            }
+        }
+        // The table is (key, chunkId, subChunkId), see the data loader.
+        std::vector<ObjectIndex::Entry> entries;
+        for(std::shared_ptr<sql::SqlResultIter> results
+                = _checkConnection.getQueryIter("SELECT * FROM " + indexTable);
+            not results->done();
+            ++(*results)) {
+            StringVector const& row = **results;
+            ObjectIndex::Entry indexEntry;
+            if (row.size() < 3 || !parseKey(row[0], indexEntry.key)) {
+                throw Bug("SecondaryIndex: " + indexTable + " has no integer key");
+            }
+            indexEntry.chunkId = std::stoi(row[1]);
+            indexEntry.subChunkId = std::stoi(row[2]);
+            entries.push_back(indexEntry);
+        }
+        auto index = ObjectIndex::build(std::move(entries));
+        auto msec = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        LOGS(_log, LOG_LVL_INFO, "SecondaryIndex: loaded " << indexTable << " keys=" << index->size()
+             << " pairs=" << index->getPairCount() << " bytes=" << index->getBytes()
+             << " in " << msec << " ms");
+        if (!path.empty()) {
+            try {
+                index->save(path, fingerprint);
+            } catch (std::exception const& e) {
+                LOGS(_log, LOG_LVL_WARN, "SecondaryIndex: " << e.what());
+            }
+        }
+        entry.fingerprint = fingerprint;
+        std::atomic_store(&entry.index, std::shared_ptr<ObjectIndex const>(index));
+    }
+
+    /// @return a fingerprint of the secondary index table of db.table. The
+    ///         data loader drops and creates the table before filling it, and
+    ///         only adds rows afterwards, so its creation time and row count
+    ///         change whenever its content does.
+    std::uint64_t _fingerprint(std::string const& db, std::string const& table) {
+        std::string const name = sanitizeName(db) + "__" + sanitizeName(table);
+        std::string text;
+        // Equality on both columns keeps MySQL from opening every table.
+        std::string const createSql = "SELECT CREATE_TIME FROM information_schema.TABLES"
+            " WHERE TABLE_SCHEMA='" + std::string(SEC_INDEX_DB) + "' AND TABLE_NAME='" + name + "'";
+        std::string const countSql = "SELECT COUNT(*) FROM " + _buildIndexTableName(db, table);
+        for (auto const& query : {createSql, countSql}) {
+            for(std::shared_ptr<sql::SqlResultIter> results = _checkConnection.getQueryIter(query);
+                not results->done();
+                ++(*results)) {
+                for (auto const& cell : **results) {
+                    text += cell + "\t";
+                }
+            }
+        }
+        return util::StringHash::getXxHash64(text.data(), text.size());
+    }
+
+    /// Rebuild the index of each table whose fingerprint changed.
+    void _check() {
+        for (auto& kv : _tables) {
+            Table& entry = kv.second;
+            try {
+                if (std::atomic_load(&entry.index) != nullptr
+                    && _fingerprint(entry.db, entry.table) == entry.fingerprint) {
+                    continue;
+                }
+                _loadIndex(entry);
+            } catch (std::exception const& e) {
+                LOGS(_log, LOG_LVL_WARN, "SecondaryIndex: cannot check " << kv.first
+                     << ", keeping the old index: " << e.what());
+            }
+        }
+    }
+
+    void _checkLoop() {
+        std::unique_lock<std::mutex> lock(_stopMtx);
+        while (not _stopCv.wait_for(lock, _checkInterval, [this] { return _stop; })) {
+            lock.unlock();
+            _check();
+            lock.lock();
+        }
+    }
+
+    /// Used to build and check the indexes, first by the constructor and then
+    /// only by the checker thread.
+    sql::SqlConnection _checkConnection;
+    std::string const _indexDir;
+    std::chrono::seconds const _checkInterval;
+
+    /// By index table name. Set up by the constructor, only the index of an
+    /// entry changes afterwards.
+    std::map<std::string, Table> _tables;
+
+    std::mutex _stopMtx;
+    std::condition_variable _stopCv;
+    bool _stop = false; ///< Protected by _stopMtx
+    std::thread _checker;
+};
+
 class FakeBackend : public SecondaryIndex::Backend {
 public:
     FakeBackend() {}
@@ -237,6 +493,15 @@ SecondaryIndex::SecondaryIndex(mysql::MySqlConfig const& c)
     : _backend(std::make_shared<MySqlBackend>(c)) {
 }
 
+SecondaryIndex::SecondaryIndex(mysql::MySqlConfig const& c, std::vector<std::string> const& memoryTables,
+                               std::string const& indexDir, std::chrono::seconds checkInterval) {
+    if (memoryTables.empty()) {
+        _backend = std::make_shared<MySqlBackend>(c);
+    } else {
+        _backend = std::make_shared<MemoryBackend>(c, memoryTables, indexDir, checkInterval);
+    }
+}
+
 SecondaryIndex::SecondaryIndex()
     : _backend(std::make_shared<FakeBackend>()) {
 }
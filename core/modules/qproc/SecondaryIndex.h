@@ -31,8 +31,11 @@
   */
 
 // System headers
+#include <chrono>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
@@ -53,6 +56,20 @@ class SecondaryIndex {
 public:
     explicit SecondaryIndex(mysql::MySqlConfig const& c);
 
+    /** Construct an instance holding the index of some tables in memory
+     *
+     *  @param memoryTables: director tables, as db.table, whose index is
+     *                       loaded now. Others are looked up in MySQL.
+     *  @param indexDir:     directory for mapped copies of those indexes,
+     *                       made on the first run. Empty to reload them
+     *                       from MySQL every time.
+     *  @param checkInterval: time between checks of the indexes against
+     *                       MySQL, rebuilding those that changed. 0 to
+     *                       never check them again.
+     */
+    SecondaryIndex(mysql::MySqlConfig const& c, std::vector<std::string> const& memoryTables,
+                   std::string const& indexDir, std::chrono::seconds checkInterval);
+
     /** Construct a fake instance
      *
      *  Used for testing purpose
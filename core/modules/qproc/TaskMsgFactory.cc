@@ -33,6 +33,7 @@
 #include "qproc/TaskMsgFactory.h"
 
 // System headers
+#include <cstddef>
 #include <stdexcept>
 
 // Third-party headers
@@ -60,13 +61,19 @@ namespace qproc {
 ////////////////////////////////////////////////////////////////////////
 class TaskMsgFactory::Impl {
 public:
-    Impl(uint64_t session, std::string const& resultTable)
-        : _session(session), _resultTable(resultTable) {
+    Impl(uint64_t session, std::string const& resultTable,
+         proto::ProtoHeader::ChecksumType resultChecksum, int maxResultProtocol,
+         int resultCompression)
+        : _session(session), _resultTable(resultTable), _resultChecksum(resultChecksum),
+          _maxResultProtocol(maxResultProtocol), _resultCompression(resultCompression) {
     }
-    std::shared_ptr<proto::TaskMsg> makeMsg(ChunkQuerySpec const& s,
-                                            std::string const& chunkResultName,
-                                            uint64_t queryId, int jobId);
+    proto::TaskMsg const& makeMsg(ChunkQuerySpec const& s,
+                                  std::string const& chunkResultName,
+                                  uint64_t queryId, int jobId);
 private:
+    void _initSkeleton(ChunkQuerySpec const& s, uint64_t queryId);
+    bool _skeletonFits(ChunkQuerySpec const& s, uint64_t queryId) const;
+
     template <class C1, class C2, class C3>
     void addFragment(proto::TaskMsg& m, std::string const& resultName,
                      C1 const& subChunkTables,
@@ -79,36 +86,63 @@ private:
             i != queries.end(); ++i) {
             frag->add_query(*i);
         }
-        proto::TaskMsg_Subchunk sc;
+        proto::TaskMsg_Subchunk* sc = frag->mutable_subchunks();
         for(typename C1::const_iterator i=subChunkTables.begin();
             i != subChunkTables.end(); ++i) {
-            sc.add_table(*i);
+            sc->add_table(*i);
+        }
+        for(auto id : subChunkIds) {
+            sc->add_id(id);
         }
-        // For each int in subChunks, apply: sc.add_subchunk(1000000);
-        std::for_each(
-            subChunkIds.begin(), subChunkIds.end(),
-            std::bind1st(std::mem_fun(&proto::TaskMsg_Subchunk::add_id), &sc));
-        frag->mutable_subchunks()->CopyFrom(sc);
     }
 
     uint64_t _session;
     std::string _resultTable;
-    std::shared_ptr<proto::TaskMsg> _taskMsg;
+    proto::ProtoHeader::ChecksumType _resultChecksum;
+    int _maxResultProtocol;
+    int _resultCompression;
+    /// Holds the fields shared by all chunks of a query, which are set
+    /// once; makeMsg() only replaces the per-chunk ones.
+    std::unique_ptr<proto::TaskMsg> _taskMsg;
+    proto::ScanInfo _scanInfo; ///< Scan tables in _taskMsg
 };
 
-std::shared_ptr<proto::TaskMsg>
-TaskMsgFactory::Impl::makeMsg(ChunkQuerySpec const& s,
-                              std::string const& chunkResultName,
-                              uint64_t queryId, int jobId) {
-    std::string resultTable = _resultTable;
-    if (!chunkResultName.empty()) { resultTable = chunkResultName; }
-    _taskMsg = std::make_shared<proto::TaskMsg>();
+bool TaskMsgFactory::Impl::_skeletonFits(ChunkQuerySpec const& s, uint64_t queryId) const {
+    if (!_taskMsg || _taskMsg->db() != s.db || _taskMsg->queryid() != queryId
+        || _scanInfo.scanRating != s.scanInfo.scanRating
+        || _scanInfo.infoTables.size() != s.scanInfo.infoTables.size()) {
+        return false;
+    }
+    for(std::size_t i = 0; i < s.scanInfo.infoTables.size(); ++i) {
+        proto::ScanTableInfo const& a = _scanInfo.infoTables[i];
+        proto::ScanTableInfo const& b = s.scanInfo.infoTables[i];
+        if (a.db != b.db || a.table != b.table || a.lockInMemory != b.lockInMemory
+            || a.scanRating != b.scanRating) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TaskMsgFactory::Impl::_initSkeleton(ChunkQuerySpec const& s, uint64_t queryId) {
+    _taskMsg.reset(new proto::TaskMsg());
+    _scanInfo = s.scanInfo;
     // shared
     _taskMsg->set_session(_session);
     _taskMsg->set_db(s.db);
     _taskMsg->set_protocol(2);
+    if (_maxResultProtocol > 2) {
+        _taskMsg->set_maxprotocol(_maxResultProtocol);
+    }
     _taskMsg->set_queryid(queryId);
-    _taskMsg->set_jobid(jobId);
+    if (_resultChecksum != proto::ProtoHeader::MD5) {
+        _taskMsg->set_checksumtype(_resultChecksum);
+    }
+    _taskMsg->set_compressionok(true);
+    if (proto::ProtoHeader::CompressionType_IsValid(_resultCompression)) {
+        _taskMsg->set_resultcompression(
+            static_cast<proto::ProtoHeader::CompressionType>(_resultCompression));
+    }
     // scanTables (for shared scans)
     // check if more than 1 db in scanInfo
     std::string db;
@@ -126,9 +160,21 @@ TaskMsgFactory::Impl::makeMsg(ChunkQuerySpec const& s,
     }
 
     _taskMsg->set_scanpriority(s.scanInfo.scanRating);
+}
 
+proto::TaskMsg const&
+TaskMsgFactory::Impl::makeMsg(ChunkQuerySpec const& s,
+                              std::string const& chunkResultName,
+                              uint64_t queryId, int jobId) {
+    std::string const& resultTable = chunkResultName.empty() ? _resultTable : chunkResultName;
+    if (!_skeletonFits(s, queryId)) {
+        _initSkeleton(s, queryId);
+    }
     // per-chunk
+    _taskMsg->set_jobid(jobId);
     _taskMsg->set_chunkid(s.chunkId);
+    // Cleared fragments are kept, and reused by add_fragment().
+    _taskMsg->clear_fragment();
     // per-fragment
     // TODO refactor to simplify
     if (s.nextFragment.get()) {
@@ -154,23 +200,30 @@ TaskMsgFactory::Impl::makeMsg(ChunkQuerySpec const& s,
         addFragment(*_taskMsg, resultTable,
                     s.subChunkTables, s.subChunkIds, s.queries);
     }
-    return _taskMsg;
+    return *_taskMsg;
 }
 
 
 ////////////////////////////////////////////////////////////////////////
 // class TaskMsgFactory
 ////////////////////////////////////////////////////////////////////////
-TaskMsgFactory::TaskMsgFactory(uint64_t session)
-    : _impl(std::make_shared<Impl>(session, "Asdfasfd" )) {
+TaskMsgFactory::TaskMsgFactory(uint64_t session, proto::ProtoHeader::ChecksumType resultChecksum,
+                               int maxResultProtocol, int resultCompression)
+    : _impl(std::make_shared<Impl>(session, "Asdfasfd", resultChecksum, maxResultProtocol,
+                                   resultCompression)) {
 }
 
 void TaskMsgFactory::serializeMsg(ChunkQuerySpec const& s,
                                   std::string const& chunkResultName,
                                   uint64_t queryId, int jobId,
-                                  std::ostream& os) {
-    std::shared_ptr<proto::TaskMsg> m = _impl->makeMsg(s, chunkResultName, queryId, jobId);
-    m->SerializeToOstream(&os);
+                                  std::string& msg) {
+    proto::TaskMsg const& m = _impl->makeMsg(s, chunkResultName, queryId, jobId);
+    // Checking the fields is enough; parsing msg back is not needed.
+    if (!m.IsInitialized()) {
+        throw QueryProcessingBug("Error serializing TaskMsg: missing "
+                                 + m.InitializationErrorString());
+    }
+    m.SerializeToString(&msg);
 }
 
 }}} // namespace lsst::qserv::qproc
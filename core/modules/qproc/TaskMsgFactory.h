@@ -32,8 +32,11 @@
   */
 
 // System headers
-#include <iostream>
 #include <memory>
+#include <string>
+
+// Qserv headers
+#include "proto/worker.pb.h"
 
 namespace lsst {
 namespace qserv {
@@ -44,13 +47,21 @@ class ChunkQuerySpec;
 /// TaskMsgFactory is a factory for TaskMsg (protobuf) objects.
 class TaskMsgFactory {
 public:
-    TaskMsgFactory(uint64_t session);
+    /// @param resultChecksum checksum workers are asked to use for results
+    /// @param maxResultProtocol highest result protocol workers may use
+    /// @param resultCompression ProtoHeader::CompressionType workers are
+    ///        asked to use for results, 0 leaving the choice to workers
+    TaskMsgFactory(uint64_t session,
+                   proto::ProtoHeader::ChecksumType resultChecksum=proto::ProtoHeader::MD5,
+                   int maxResultProtocol=2, int resultCompression=0);
 
-    /// Construct a TaskMsg and serialize it to a stream
+    /// Construct a TaskMsg and serialize it into msg. The fields shared by
+    /// all chunks of a query are set once, and kept while s.db, s.scanInfo
+    /// and queryId stay the same.
     void serializeMsg(ChunkQuerySpec const& s,
                       std::string const& chunkResultName,
                       uint64_t queryId, int jobId,
-                      std::ostream& os);
+                      std::string& msg);
 private:
     class Impl;
 
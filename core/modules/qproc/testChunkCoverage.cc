@@ -0,0 +1,213 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+ /**
+  * @file
+  *
+  * @brief Test the coverage of circles and boxes against sphgeom::Chunker.
+  */
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+// LSST headers
+#include "lsst/sphgeom/Box.h"
+#include "lsst/sphgeom/Circle.h"
+
+// Qserv headers
+#include "css/StripingParams.h"
+#include "qproc/ChunkCoverage.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ChunkCoverage
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::css::StripingParams;
+using lsst::qserv::qproc::ChunkCoverage;
+using lsst::qserv::qproc::ChunkCoverageMap;
+using lsst::sphgeom::Angle;
+using lsst::sphgeom::Box;
+using lsst::sphgeom::Circle;
+using lsst::sphgeom::LonLat;
+using lsst::sphgeom::Region;
+using lsst::sphgeom::UnitVector3d;
+
+namespace {
+
+double const PI = 3.1415926535897932384626433832795;
+
+typedef std::set<std::pair<int, int>> IdSet;
+
+IdSet toSet(ChunkCoverage::SubChunksVector const& scv) {
+    IdSet ids;
+    for (auto const& sc : scv) {
+        for (auto subChunkId : sc.subChunkIds) {
+            ids.insert(std::make_pair(sc.chunkId, subChunkId));
+        }
+    }
+    return ids;
+}
+
+bool isSubset(IdSet const& a, IdSet const& b) {
+    return std::includes(b.begin(), b.end(), a.begin(), a.end());
+}
+
+/// Check that the coverage of region is no coarser than that of the
+/// Chunker, and holds the subchunks of all points.
+void checkRegion(ChunkCoverage const& coverage, Region const& region,
+                 std::vector<UnitVector3d> const& points) {
+    IdSet const fast = toSet(coverage.compute(region));
+    IdSet const exact = toSet(coverage.getChunker().getSubChunksIntersecting(region));
+    BOOST_CHECK(!fast.empty());
+    BOOST_CHECK(isSubset(fast, exact));
+    for (auto const& p : points) {
+        Circle const dot(p, Angle(1e-12));
+        BOOST_CHECK(isSubset(toSet(coverage.getChunker().getSubChunksIntersecting(dot)), fast));
+    }
+}
+
+/// @return count points at distance d from center.
+std::vector<UnitVector3d> ring(UnitVector3d const& c, double d, int count) {
+    // u and v are orthogonal to c and each other
+    double ux = -c.y(), uy = c.x(), uz = 0.0;
+    if (std::hypot(ux, uy) < 1e-6) {
+        ux = 1.0; uy = 0.0;
+    }
+    double const un = std::sqrt(ux * ux + uy * uy + uz * uz);
+    ux /= un; uy /= un; uz /= un;
+    double const vx = c.y() * uz - c.z() * uy;
+    double const vy = c.z() * ux - c.x() * uz;
+    double const vz = c.x() * uy - c.y() * ux;
+    std::vector<UnitVector3d> points;
+    for (int i = 0; i < count; ++i) {
+        double const t = 2.0 * PI * i / count;
+        double const s = std::sin(d);
+        points.emplace_back(c.x() * std::cos(d) + s * (ux * std::cos(t) + vx * std::sin(t)),
+                            c.y() * std::cos(d) + s * (uy * std::cos(t) + vy * std::sin(t)),
+                            c.z() * std::cos(d) + s * (uz * std::cos(t) + vz * std::sin(t)));
+    }
+    return points;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Numbering) {
+    // The arrays match the numbering of the Chunker.
+    for (auto sp : {StripingParams(85, 12, 1, 0.01), StripingParams(18, 10, 2, 0.01),
+                    StripingParams(340, 3, 3, 0.01)}) {
+        ChunkCoverage coverage(sp, 0);
+        BOOST_CHECK(coverage.isFast());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Circles) {
+    ChunkCoverage coverage(StripingParams(85, 12, 1, 0.01), 0);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> lon(0.0, 360.0);
+    std::uniform_real_distribution<double> sinLat(-1.0, 1.0);
+    std::vector<LonLat> centers;
+    for (int i = 0; i < 60; ++i) {
+        centers.push_back(LonLat::fromDegrees(lon(rng), std::asin(sinLat(rng)) * 180.0 / PI));
+    }
+    // Across longitude 0, at and near the poles
+    centers.push_back(LonLat::fromDegrees(0.0, 10.0));
+    centers.push_back(LonLat::fromDegrees(359.999, -30.0));
+    centers.push_back(LonLat::fromDegrees(20.0, 90.0));
+    centers.push_back(LonLat::fromDegrees(100.0, -89.9));
+    centers.push_back(LonLat::fromDegrees(200.0, 88.5));
+    for (auto const& center : centers) {
+        for (double radius : {0.001, 0.01, 0.1, 1.0, 5.0}) {
+            UnitVector3d const c(center);
+            double const r = radius * PI / 180.0;
+            std::vector<UnitVector3d> points = ring(c, r * (1.0 - 1e-6), 64);
+            points.push_back(c);
+            checkRegion(coverage, Circle(c, Angle(r)), points);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Boxes) {
+    ChunkCoverage coverage(StripingParams(85, 12, 1, 0.01), 0);
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<double> lon(0.0, 360.0);
+    std::uniform_real_distribution<double> lat(-90.0, 90.0);
+    std::uniform_real_distribution<double> size(0.001, 10.0);
+    for (int i = 0; i < 100; ++i) {
+        double const lon0 = lon(rng);
+        double const lat0 = lat(rng);
+        double const lon1 = lon0 + size(rng);
+        double const lat1 = std::min(lat0 + size(rng), 90.0);
+        Box const box = Box::fromDegrees(lon0, lat0, lon1, lat1);
+        std::vector<UnitVector3d> points;
+        for (int j = 0; j <= 8; ++j) {
+            for (int k = 0; k <= 8; ++k) {
+                double const eps = 1e-7;
+                points.emplace_back(LonLat::fromDegrees(lon0 + eps + (lon1 - lon0 - 2 * eps) * j / 8,
+                                                        lat0 + eps + (lat1 - lat0 - 2 * eps) * k / 8));
+            }
+        }
+        checkRegion(coverage, box, points);
+    }
+    // The full sky is all subchunks.
+    IdSet const all = toSet(coverage.compute(Box::fromDegrees(0.0, -90.0, 360.0, 90.0)));
+    std::size_t count = 0;
+    for (auto chunkId : coverage.getChunker().getAllChunks()) {
+        count += coverage.getChunker().getAllSubChunks(chunkId).size();
+    }
+    BOOST_CHECK_EQUAL(all.size(), count);
+}
+
+BOOST_AUTO_TEST_CASE(Cache) {
+    ChunkCoverage coverage(StripingParams(18, 10, 2, 0.01), 2);
+    auto area = std::make_shared<ChunkCoverage::SubChunksVector>(
+        coverage.compute(Circle(UnitVector3d(LonLat::fromDegrees(10.0, 10.0)), Angle(0.001))));
+    BOOST_CHECK(coverage.find("a") == nullptr);
+    coverage.insert("a", area);
+    coverage.insert("b", area);
+    BOOST_CHECK(coverage.find("a") == area);
+    coverage.insert("c", area);
+    BOOST_CHECK(coverage.find("b") == nullptr);
+    BOOST_CHECK(coverage.find("a") == area);
+    BOOST_CHECK(coverage.find("c") == area);
+    auto stats = coverage.getStats();
+    BOOST_CHECK_EQUAL(stats.hits, 3u);
+    BOOST_CHECK_EQUAL(stats.misses, 2u);
+    BOOST_CHECK_EQUAL(stats.regions, 2u);
+
+    ChunkCoverageMap coverages(2);
+    auto one = coverages.get(StripingParams(18, 10, 2, 0.01));
+    BOOST_CHECK(coverages.get(StripingParams(18, 10, 5, 0.05)) == one);
+    BOOST_CHECK(coverages.get(StripingParams(85, 12, 1, 0.01)) != one);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of the coverage of cones of typical radii, in computations per
+/// second, for a partitioning of 85 stripes of 12 substripes:
+///  - chunker: sphgeom::Chunker, as IndexMap without a ChunkCoverage;
+///  - arrays: ChunkCoverage::compute();
+///  - cached: ChunkCoverage::find() of cones seen before.
+/// Each computation includes making the circle from its parameters.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testChunkCoveragePerf [cones]
+
+// System headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "css/StripingParams.h"
+#include "qproc/ChunkCoverage.h"
+#include "qproc/geomAdapter.h"
+
+using namespace lsst::qserv;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double const RADII[] = {1.0 / 3600, 10.0 / 3600, 1.0 / 60, 0.1, 0.5, 1.0, 3.0}; // degrees
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// @return the cache key of a cone, as IndexMap makes it.
+std::string key(std::vector<double> const& params) {
+    std::string key = "qserv_areaspec_circle";
+    for (double param : params) {
+        key += ' ';
+        key += std::to_string(param);
+    }
+    return key;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int const nCones = argc > 1 ? std::atoi(argv[1]) : 10000;
+    qproc::ChunkCoverage coverage(css::StripingParams(85, 12, 1, 0.01), nCones);
+    std::cout << "arrays used: " << (coverage.isFast() ? "yes" : "no") << std::endl;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> lon(0.0, 360.0);
+    std::uniform_real_distribution<double> lat(-60.0, 60.0);
+
+    for (double radius : RADII) {
+        std::vector<std::vector<double>> cones;
+        for (int i = 0; i < nCones; ++i) {
+            cones.push_back({lon(rng), lat(rng), radius});
+        }
+        std::size_t subChunks = 0;
+        auto start = Clock::now();
+        for (auto const& params : cones) {
+            auto circle = qproc::getCircleFromParams(params);
+            for (auto const& sc : coverage.getChunker().getSubChunksIntersecting(*circle)) {
+                subChunks += sc.subChunkIds.size();
+            }
+        }
+        double const chunkerRate = nCones / secondsSince(start);
+
+        std::vector<qproc::ChunkCoverage::CoveragePtr> areas;
+        start = Clock::now();
+        for (auto const& params : cones) {
+            auto circle = qproc::getCircleFromParams(params);
+            areas.push_back(std::make_shared<qproc::ChunkCoverage::SubChunksVector>(coverage.compute(*circle)));
+        }
+        double const arraysRate = nCones / secondsSince(start);
+        for (int i = 0; i < nCones; ++i) {
+            coverage.insert(key(cones[i]), areas[i]);
+        }
+
+        start = Clock::now();
+        for (auto const& params : cones) {
+            coverage.find(key(params));
+        }
+        double const cachedRate = nCones / secondsSince(start);
+
+        std::cout << "radiusArcsec=" << radius * 3600 << " subChunks/cone=" << double(subChunks) / nCones
+                  << " chunker/s=" << chunkerRate << " arrays/s=" << arraysRate
+                  << " cached/s=" << cachedRate << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of the rate at which UserQuerySelect::submit() can turn chunks
+/// of a synthetic full-sky plan into job payloads, in jobs/s:
+///  - "per-chunk": the template is mapped and spaced for every chunk, a new
+///    TaskMsg is built, serialized to a stream, parsed back and copied;
+///  - "compiled": the template is compiled once, and a TaskMsg skeleton is
+///    patched and serialized straight into the payload string.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testDispatchPerf [chunks]
+
+// System headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "proto/ProtoImporter.h"
+#include "proto/worker.pb.h"
+#include "qana/QueryMapping.h"
+#include "qproc/ChunkQuerySpec.h"
+#include "qproc/ChunkSpec.h"
+#include "qproc/TaskMsgFactory.h"
+#include "query/QueryTemplate.h"
+
+using namespace lsst::qserv;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// The parallel statement of a full-sky Object query with a cut.
+query::QueryTemplate makeTemplate() {
+    query::QueryTemplate t;
+    for (auto e : {"SELECT", "o.objectId", ",", "o.ra_PS", ",", "o.decl_PS", ",",
+                   "o.uFlux_PS", ",", "o.gFlux_PS", ",", "o.rFlux_PS", "FROM",
+                   "LSST.Object_%CC%", "AS", "o", "WHERE", "scisql_fluxToAbMag(",
+                   "o.rFlux_PS", ")", "<", "21.5", "AND", "o.chunkId", "=", "%CC%"}) {
+        t.append(std::string(e));
+    }
+    return t;
+}
+
+qproc::ChunkQuerySpec makeSpec() {
+    qproc::ChunkQuerySpec cs;
+    cs.db = "LSST";
+    cs.scanInfo.infoTables.push_back(proto::ScanTableInfo("LSST", "Object", false, 15));
+    cs.scanInfo.scanRating = 15;
+    return cs;
+}
+
+/// TaskMsgFactory::serializeMsg() as it was before compiling.
+void serializeFresh(qproc::ChunkQuerySpec const& s, std::string const& resultName,
+                    uint64_t queryId, int jobId, std::ostream& os) {
+    proto::TaskMsg m;
+    m.set_session(1);
+    m.set_db(s.db);
+    m.set_protocol(2);
+    m.set_queryid(queryId);
+    m.set_jobid(jobId);
+    m.set_compressionok(true);
+    for (auto const& sTbl : s.scanInfo.infoTables) {
+        sTbl.copyToScanTable(m.add_scantable());
+    }
+    m.set_scanpriority(s.scanInfo.scanRating);
+    m.set_chunkid(s.chunkId);
+    proto::TaskMsg::Fragment* frag = m.add_fragment();
+    frag->set_resulttable(resultName);
+    for (auto const& q : s.queries) {
+        frag->add_query(q);
+    }
+    proto::TaskMsg_Subchunk sc;
+    frag->mutable_subchunks()->CopyFrom(sc);
+    m.SerializeToOstream(&os);
+}
+
+void report(std::string const& name, int nChunks, Clock::duration elapsed, std::size_t bytes) {
+    double const secs = std::chrono::duration<double>(elapsed).count();
+    std::cout << name << ": jobs/s=" << nChunks / secs << " seconds=" << secs
+              << " payload bytes=" << bytes << std::endl;
+}
+
+void perChunk(int nChunks, qana::QueryMapping const& qm, query::QueryTemplate const& t) {
+    qproc::ChunkQuerySpec cs = makeSpec();
+    proto::ProtoImporter<proto::TaskMsg> pi;
+    std::size_t bytes = 0;
+    auto start = Clock::now();
+    for (int chunkId = 0; chunkId < nChunks; ++chunkId) {
+        qproc::ChunkSpec spec(chunkId, {});
+        cs.chunkId = chunkId;
+        cs.queries = std::vector<std::string>{qm.apply(spec, t)};
+        std::ostringstream ss;
+        serializeFresh(cs, "r_1_" + std::to_string(chunkId) + "_0", 1, chunkId, ss);
+        std::string msg = ss.str();
+        pi(msg.data(), msg.size());
+        std::string payload = ss.str();
+        bytes += payload.size();
+    }
+    if (pi.getNumAccepted() != nChunks) {
+        std::cerr << "parse failed" << std::endl;
+        exit(1);
+    }
+    report("per-chunk", nChunks, Clock::now() - start, bytes);
+}
+
+void compiled(int nChunks, qana::QueryMapping const& qm, query::QueryTemplate const& t) {
+    qproc::ChunkQuerySpec cs = makeSpec();
+    qproc::TaskMsgFactory factory(1);
+    std::size_t bytes = 0;
+    auto start = Clock::now();
+    auto ct = qm.compile(t);
+    for (int chunkId = 0; chunkId < nChunks; ++chunkId) {
+        cs.chunkId = chunkId;
+        cs.queries = std::vector<std::string>{ct.generate(chunkId)};
+        std::string msg;
+        factory.serializeMsg(cs, "r_1_" + std::to_string(chunkId) + "_0", 1, chunkId, msg);
+        std::string payload(std::move(msg));
+        bytes += payload.size();
+    }
+    report("compiled", nChunks, Clock::now() - start, bytes);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int nChunks = argc > 1 ? std::atoi(argv[1]) : 100000;
+    qana::QueryMapping qm;
+    qm.insertChunkEntry("%CC%");
+    query::QueryTemplate t = makeTemplate();
+    perChunk(nChunks, qm, t);
+    compiled(nChunks, qm, t);
+    return 0;
+}
@@ -35,6 +35,7 @@
 #include <iterator>
 #include <list>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -42,8 +43,12 @@
 #include "boost/algorithm/string.hpp"
 
 // Qserv headers
+#include "css/ChunkBitmap.h"
+#include "css/StripingParams.h"
 #include "global/intTypes.h"
+#include "qproc/ChunkCoverage.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/IndexMap.h"
 #include "qproc/SecondaryIndex.h"
 #include "query/Constraint.h"
 
@@ -54,8 +59,10 @@
 
 namespace test = boost::test_tools;
 
+using lsst::qserv::qproc::ChunkCoverage;
 using lsst::qserv::qproc::ChunkSpec;
 using lsst::qserv::qproc::ChunkSpecVector;
+using lsst::qserv::qproc::IndexMap;
 using lsst::qserv::qproc::SecondaryIndex;
 using lsst::qserv::query::Constraint;
 using lsst::qserv::query::ConstraintVector;
@@ -121,6 +128,54 @@ BOOST_AUTO_TEST_CASE(SecLookupMultipleObjectIdBETWEEN) {
               std::ostream_iterator<ChunkSpec>(std::cout, ",\n"));
 }
 
+BOOST_AUTO_TEST_CASE(EmptyChunks) {
+    lsst::qserv::css::StripingParams sp(18, 10, 0, 0.01);
+    auto fakeIndex = std::make_shared<SecondaryIndex>();
+    IndexMap all(sp, fakeIndex);
+    ChunkSpecVector allChunks = all.getAllChunks();
+    BOOST_REQUIRE(allChunks.size() > 3);
+
+    // Empty chunks are left out of all chunks and of index lookups,
+    // the fake index finds chunks 100 to 102.
+    auto empty = lsst::qserv::css::ChunkBitmap::build({allChunks[0].chunkId, allChunks[3].chunkId, 101});
+    IndexMap nonEmpty(sp, fakeIndex, empty);
+    ChunkSpecVector chunks = nonEmpty.getAllChunks();
+    BOOST_CHECK_EQUAL(chunks.size(), allChunks.size() - 2);
+    for (auto const& cs : chunks) {
+        BOOST_CHECK(!empty->contains(cs.chunkId));
+    }
+
+    ConstraintVector cv;
+    char const* argv[] = {"LSST", "Object", "objectId", "1"};
+    cv.push_back(makeConstraint("sIndex", 4, argv));
+    chunks = nonEmpty.getChunks(cv);
+    BOOST_REQUIRE_EQUAL(chunks.size(), 2U);
+    BOOST_CHECK_EQUAL(chunks[0].chunkId, 100);
+    BOOST_CHECK_EQUAL(chunks[1].chunkId, 102);
+}
+
+BOOST_AUTO_TEST_CASE(Coverage) {
+    // A ChunkCoverage keeps the coverage of each region, and the fake index
+    // lookup of each query ANDs it with nothing.
+    lsst::qserv::css::StripingParams sp(85, 12, 0, 0.01);
+    auto coverage = std::make_shared<ChunkCoverage>(sp, 10);
+    IndexMap plain(sp, std::make_shared<SecondaryIndex>());
+    IndexMap cached(sp, std::make_shared<SecondaryIndex>(), nullptr, coverage);
+    char const* circle[] = {"10.5", "-4.2", "0.5"};
+    char const* box[] = {"359.5", "20", "0.5", "21"};
+    ConstraintVector cv;
+    cv.push_back(makeConstraint("qserv_areaspec_circle", 3, circle));
+    cv.push_back(makeConstraint("qserv_areaspec_box", 4, box));
+    for (int i = 0; i < 2; ++i) {
+        ChunkSpecVector chunks = cached.getChunks(cv);
+        BOOST_CHECK(chunks == plain.getChunks(cv));
+    }
+    auto stats = coverage->getStats();
+    BOOST_CHECK_EQUAL(stats.regions, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+}
+
 #if 0 // TODO
 BOOST_AUTO_TEST_CASE(IndLookupArea) {
     // Lookup area using IndexMap interface
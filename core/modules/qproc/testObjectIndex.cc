@@ -0,0 +1,206 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+ /**
+  * @file
+  *
+  * @brief Test the in-memory secondary index.
+  */
+
+// System headers
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "qproc/ObjectIndex.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ObjectIndex
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::qproc::ObjectIndex;
+
+namespace {
+
+typedef std::vector<std::pair<std::int32_t, std::int32_t>> Found;
+
+/// Keys 0, 10, ..., with an offset too large for one block in the middle,
+/// and a negative key. Key k is in chunk k % 7, subchunk k % 3.
+std::vector<ObjectIndex::Entry> makeEntries() {
+    std::vector<ObjectIndex::Entry> entries;
+    auto add = [&entries](std::int64_t key) {
+        entries.push_back(ObjectIndex::Entry{key, static_cast<std::int32_t>(key % 7),
+                                             static_cast<std::int32_t>(key % 3)});
+    };
+    for (std::int64_t key = 0; key < 5000; key += 10) {
+        add(key);
+    }
+    add(10000000000LL);
+    add(10000000010LL);
+    add(-50);
+    return entries;
+}
+
+Found lookup(ObjectIndex const& index, std::vector<std::int64_t> const& keys) {
+    Found found;
+    index.lookup(keys, [&found](std::int32_t c, std::int32_t s) { found.emplace_back(c, s); });
+    return found;
+}
+
+Found lookupRange(ObjectIndex const& index, std::int64_t minKey, std::int64_t maxKey) {
+    Found found;
+    index.lookupRange(minKey, maxKey, [&found](std::int32_t c, std::int32_t s) { found.emplace_back(c, s); });
+    return found;
+}
+
+void checkIndex(ObjectIndex const& index) {
+    BOOST_CHECK_EQUAL(index.size(), 503u);
+    BOOST_CHECK_EQUAL(index.getPairCount(), 22u); // One per residue of key mod 21, and -50
+
+    // Found keys come back in key order, each once.
+    Found found = lookup(index, {4990, 20, -50, 25, 20, 10000000010LL, 6000, -1, 10000000005LL});
+    Found expected{{-50 % 7, -50 % 3}, {20 % 7, 20 % 3}, {4990 % 7, 4990 % 3},
+                   {10000000010LL % 7, 10000000010LL % 3}};
+    BOOST_CHECK(found == expected);
+    BOOST_CHECK(lookup(index, {}).empty());
+    BOOST_CHECK(lookup(index, {-100, 5, 4999, 9999999999LL}).empty());
+
+    // Keys not found are returned, sorted and each once.
+    std::vector<std::int64_t> missing = index.lookup({4999, 20, -100, 4999, 6000, 10000000011LL},
+                                                     [](std::int32_t, std::int32_t) {});
+    BOOST_CHECK(missing == std::vector<std::int64_t>({-100, 4999, 6000, 10000000011LL}));
+
+    BOOST_CHECK_EQUAL(lookupRange(index, 15, 45).size(), 3u);
+    BOOST_CHECK_EQUAL(lookupRange(index, -1000, 1000000000000LL).size(), 503u);
+    BOOST_CHECK_EQUAL(lookupRange(index, 4985, 10000000000LL).size(), 2u);
+    BOOST_CHECK_EQUAL(lookupRange(index, 635, 635).size(), 0u);
+    BOOST_CHECK_EQUAL(lookupRange(index, 640, 640).size(), 1u);
+    BOOST_CHECK(lookupRange(index, 50, 40).empty());
+    BOOST_CHECK(lookupRange(index, 10000000011LL, 10000000020LL).empty());
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Build) {
+    auto index = ObjectIndex::build(makeEntries());
+    checkIndex(*index);
+}
+
+BOOST_AUTO_TEST_CASE(Duplicates) {
+    std::vector<ObjectIndex::Entry> entries{{5, 1, 2}, {3, 4, 5}, {5, 6, 7}};
+    auto index = ObjectIndex::build(entries);
+    BOOST_CHECK_EQUAL(index->size(), 2u);
+    BOOST_CHECK(lookup(*index, {5}) == Found({{1, 2}}));
+
+    auto empty = ObjectIndex::build({});
+    BOOST_CHECK_EQUAL(empty->size(), 0u);
+    BOOST_CHECK(lookup(*empty, {5}).empty());
+    BOOST_CHECK(empty->lookup({5, 5}, [](std::int32_t, std::int32_t) {}) == std::vector<std::int64_t>({5}));
+    BOOST_CHECK(lookupRange(*empty, 0, 10).empty());
+}
+
+BOOST_AUTO_TEST_CASE(SaveLoad) {
+    std::string const path = "/tmp/testObjectIndex." + std::to_string(::getpid()) + ".idx";
+    auto built = ObjectIndex::build(makeEntries());
+    BOOST_CHECK_EQUAL(built->getFingerprint(), 0u);
+    built->save(path, 1234);
+    auto index = ObjectIndex::load(path);
+    checkIndex(*index);
+    BOOST_CHECK_EQUAL(index->getFingerprint(), 1234u);
+    std::remove(path.c_str());
+
+    BOOST_CHECK_THROW(ObjectIndex::load(path), std::runtime_error);
+    FILE* f = std::fopen(path.c_str(), "w");
+    std::fputs("not an index, but longer than a header", f);
+    std::fclose(f);
+    BOOST_CHECK_THROW(ObjectIndex::load(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Corrupt) {
+    std::string const path = "/tmp/testObjectIndex." + std::to_string(::getpid()) + ".idx";
+    ObjectIndex::build(makeEntries())->save(path, 1);
+    std::string good;
+    {
+        std::ifstream in(path, std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    // The header is 5 words, then come the fences, the block starts, the
+    // pairs, the offsets and the codes.
+    auto word = [&good](std::size_t j) {
+        std::uint64_t w;
+        std::memcpy(&w, good.data() + 8 * j, 8);
+        return w;
+    };
+    std::uint64_t const size = word(1);
+    std::uint64_t const blockCount = word(2);
+    std::size_t const startsPos = 40 + 8 * blockCount;
+    std::size_t const codesPos = good.size() - 4 * size;
+    auto check = [&path](std::string const& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+        out.close();
+        BOOST_CHECK_THROW(ObjectIndex::load(path), std::runtime_error);
+    };
+
+    // Truncated
+    check(good.substr(0, good.size() - 4));
+    // Counts too large for the file, whose sizes would overflow
+    std::string bad = good;
+    std::uint64_t const huge = std::uint64_t(1) << 62;
+    std::memcpy(&bad[8], &huge, 8);
+    check(bad);
+    // Block start past the last entry
+    bad = good;
+    std::uint64_t const past = size + 100;
+    std::memcpy(&bad[startsPos + 8], &past, 8);
+    check(bad);
+    // Pair code past the last pair
+    bad = good;
+    std::uint32_t const code = 0xffffffff;
+    std::memcpy(&bad[codesPos], &code, 4);
+    check(bad);
+
+    // The original still loads.
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(good.data(), good.size());
+    }
+    checkIndex(*ObjectIndex::load(path));
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+ /**
+  * @file
+  *
+  * @brief Test the shapes, binding and bookkeeping of the plan cache.
+  */
+
+// System headers
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "css/CssAccess.h"
+#include "qproc/PlanCache.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE PlanCache
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::css::CssAccess;
+using lsst::qserv::qproc::PlanCache;
+using lsst::qserv::query::DbTablePair;
+
+namespace {
+
+char const* testData = "\
+/\t\\N\n\
+/css_meta\t\\N\n\
+/css_meta/version\t1\n\
+/DBS\t\\N\n\
+/DBS/LSST\tLSST\n\
+/DBS/LSST/TABLES\t\\N\n\
+/DBS/LSST/TABLES/Object\tREADY\n\
+";
+
+PlanCache::Plan::Ptr makePlan(std::string const& db, std::string const& cssState) {
+    auto plan = std::make_shared<PlanCache::Plan>();
+    plan->cacheable = true;
+    plan->tables.push_back(DbTablePair(db, "Object"));
+    plan->cssState = cssState;
+    plan->analysisMs = 5;
+    return plan;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Shape) {
+    PlanCache::Shape shape;
+    BOOST_CHECK(PlanCache::makeShape(
+        "SELECT  ra, 2.5*flux FROM LSST.Object WHERE objectId IN (42, 43) "
+        "AND name = 'it''s' AND x > 1.5e3 ORDER BY ra LIMIT 10", shape));
+    BOOST_CHECK_EQUAL(shape.key,
+        "SELECT ra, 2.5*flux FROM LSST.Object WHERE objectId IN (?i, ?i) "
+        "AND name = ?s AND x > ?d ORDER BY ra LIMIT 10");
+    BOOST_REQUIRE_EQUAL(shape.literals.size(), 4u);
+    BOOST_CHECK_EQUAL(shape.literals[0].kind, PlanCache::Literal::INTEGER);
+    BOOST_CHECK_EQUAL(shape.literals[0].text, "42");
+    BOOST_CHECK_EQUAL(shape.literals[2].kind, PlanCache::Literal::STRING);
+    BOOST_CHECK_EQUAL(shape.literals[2].text, "'it''s'");
+    BOOST_CHECK_EQUAL(shape.literals[3].kind, PlanCache::Literal::DECIMAL);
+    BOOST_CHECK_EQUAL(shape.literals[3].text, "1.5e3");
+
+    // Queries differing in their WHERE literals share a shape.
+    PlanCache::Shape other;
+    BOOST_CHECK(PlanCache::makeShape(
+        "SELECT  ra, 2.5*flux FROM LSST.Object WHERE objectId IN (7, 8) "
+        "AND name = 'x' AND x > 0.25 ORDER BY ra LIMIT 10", other));
+    BOOST_CHECK_EQUAL(other.key, shape.key);
+    BOOST_CHECK_EQUAL(other.placeholderSql, shape.placeholderSql);
+
+    // Literals of function arguments in the WHERE clause are cut out too,
+    // words starting with digits are not.
+    BOOST_CHECK(PlanCache::makeShape("SELECT * FROM T WHERE f(a, 3) > 0x1F", shape));
+    BOOST_CHECK_EQUAL(shape.key, "SELECT * FROM T WHERE f(a, ?i) > 0x1F");
+
+    BOOST_CHECK(!PlanCache::makeShape("SELECT * FROM T WHERE a = 1 -- comment", shape));
+    BOOST_CHECK(!PlanCache::makeShape("SELECT * FROM T /* comment */", shape));
+    BOOST_CHECK(!PlanCache::makeShape("SELECT * FROM T WHERE a = ?", shape));
+    BOOST_CHECK(!PlanCache::makeShape("SELECT * FROM T WHERE a = 'open", shape));
+    BOOST_CHECK(!PlanCache::makeShape("SELECT * FROM T WHERE (a = 1", shape));
+}
+
+BOOST_AUTO_TEST_CASE(Bind) {
+    PlanCache::Shape shape;
+    std::string const sql = "SELECT a FROM T WHERE a BETWEEN 1 AND 2.5 AND b = 'x' LIMIT 3";
+    BOOST_REQUIRE(PlanCache::makeShape(sql, shape));
+    std::string out;
+    BOOST_CHECK(PlanCache::bind(shape.placeholderSql, shape.literals, out));
+    BOOST_CHECK_EQUAL(out, sql);
+
+    // Text without placeholders binds to itself.
+    BOOST_CHECK(PlanCache::bind("SELECT 791930 FROM T", shape.literals, out));
+    BOOST_CHECK_EQUAL(out, "SELECT 791930 FROM T");
+
+    // A literal of another kind, or none, does not bind.
+    PlanCache::Literals literals{{PlanCache::Literal::STRING, "'a'"}};
+    BOOST_CHECK(!PlanCache::bind(shape.placeholderSql, literals, out));
+    BOOST_CHECK(!PlanCache::bind(shape.placeholderSql, PlanCache::Literals(), out));
+}
+
+BOOST_AUTO_TEST_CASE(Lru) {
+    auto css = CssAccess::createFromData(testData, "");
+    PlanCache cache(2, std::chrono::seconds(3600));
+    cache.insert("a", makePlan("LSST", ""));
+    cache.insert("b", makePlan("Other", ""));
+    BOOST_CHECK(cache.find("a", *css) != nullptr);
+    cache.insert("c", makePlan("LSST", ""));
+    BOOST_CHECK(cache.find("b", *css) == nullptr);
+    BOOST_CHECK(cache.find("a", *css) != nullptr);
+    BOOST_CHECK(cache.find("c", *css) != nullptr);
+    BOOST_CHECK_EQUAL(cache.getStats().plans, 2u);
+
+    cache.invalidate("LSST");
+    BOOST_CHECK(cache.find("a", *css) == nullptr);
+    BOOST_CHECK(cache.find("c", *css) == nullptr);
+    BOOST_CHECK_EQUAL(cache.getStats().plans, 0u);
+    BOOST_CHECK_EQUAL(cache.getStats().invalidated, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(CssCheck) {
+    auto css = CssAccess::createFromData(testData, "");
+    std::vector<DbTablePair> tables{DbTablePair("LSST", "Object")};
+    std::string const state = PlanCache::cssState(*css, tables);
+    BOOST_CHECK(!state.empty());
+
+    PlanCache cache(10, std::chrono::milliseconds(0));
+    cache.insert("a", makePlan("LSST", state));
+    BOOST_CHECK(cache.find("a", *css) != nullptr);
+
+    css->setTableStatus("LSST", "Object", "DELETING");
+    BOOST_CHECK(PlanCache::cssState(*css, tables) != state);
+    BOOST_CHECK(cache.find("a", *css) == nullptr);
+    BOOST_CHECK_EQUAL(cache.getStats().invalidated, 1u);
+
+    // Uncacheable plans are not checked.
+    auto plan = std::make_shared<PlanCache::Plan>();
+    cache.insert("b", plan);
+    BOOST_CHECK(cache.find("b", *css) == plan);
+
+    cache.addHit(*makePlan("LSST", state), 1);
+    cache.addMiss();
+    cache.addUncacheable();
+    auto stats = cache.getStats();
+    BOOST_CHECK_EQUAL(stats.hits, 1u);
+    BOOST_CHECK_EQUAL(stats.misses, 1u);
+    BOOST_CHECK_EQUAL(stats.uncacheable, 1u);
+    BOOST_CHECK_CLOSE(stats.savedMs, 4.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -34,11 +34,14 @@
 
 // System headers
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // Third-party headers
 #include "boost/algorithm/string.hpp"
@@ -52,6 +55,7 @@
 #include "parser/parseExceptions.h"
 #include "parser/SelectParser.h"
 #include "qdisp/ChunkMeta.h"
+#include "qproc/PlanCache.h"
 #include "qproc/QuerySession.h"
 #include "query/QsRestrictor.h"
 #include "query/QueryContext.h"
@@ -62,6 +66,7 @@
 using lsst::qserv::parser::SelectParser;
 using lsst::qserv::qproc::ChunkQuerySpec;
 using lsst::qserv::qproc::ChunkSpec;
+using lsst::qserv::qproc::PlanCache;
 using lsst::qserv::qproc::QuerySession;
 using lsst::qserv::query::QsRestrictor;
 using lsst::qserv::query::QueryContext;
@@ -700,6 +705,45 @@ BOOST_AUTO_TEST_CASE(FuncExprPred) {
     BOOST_CHECK_EQUAL(queries[0], expected);
 }
 
+BOOST_AUTO_TEST_CASE(PlanCacheHit) {
+    // A query differing from an earlier one only in its constants takes the
+    // analysis of the earlier one from the plan cache, and must give the same
+    // chunk queries as a full analysis.
+    auto chunkQueries = [this](std::string const& stmt, PlanCache::Ptr const& planCache)
+            -> std::vector<std::string> {
+        auto qs = std::make_shared<QuerySession>(qsTest);
+        qs->setPlanCache(planCache);
+        qs->analyzeQuery(stmt);
+        BOOST_CHECK_EQUAL(qs->getError(), "");
+        qs->addChunk(ChunkSpec::makeFake(100, true));
+        std::vector<std::string> queries;
+        for (QuerySession::Iter i = qs->cQueryBegin(), e = qs->cQueryEnd(); i != e; ++i) {
+            ChunkQuerySpec& cs = *i;
+            queries.insert(queries.end(), cs.queries.begin(), cs.queries.end());
+        }
+        return queries;
+    };
+    std::string const first = "SELECT objectId, iFlux_PS FROM Object "
+        "WHERE iFlux_PS > 0.5 AND objectId < 100 AND filterId = 'u' ORDER BY objectId;";
+    std::string const second = "SELECT objectId, iFlux_PS FROM Object "
+        "WHERE iFlux_PS > 2.25 AND objectId < 386950783579546 AND filterId = 'g' ORDER BY objectId;";
+
+    auto planCache = std::make_shared<PlanCache>(10, std::chrono::seconds(3600));
+    auto firstQueries = chunkQueries(first, planCache);
+    BOOST_CHECK_EQUAL(planCache->getStats().plans, 1u);
+    BOOST_CHECK_EQUAL(planCache->getStats().hits, 0u);
+    auto cachedQueries = chunkQueries(second, planCache);
+    BOOST_CHECK_EQUAL(planCache->getStats().hits, 1u);
+
+    auto expected = chunkQueries(second, nullptr);
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_CHECK_EQUAL_COLLECTIONS(cachedQueries.begin(), cachedQueries.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK(firstQueries != cachedQueries);
+    BOOST_CHECK(expected[0].find("2.25") != std::string::npos);
+    BOOST_CHECK(expected[0].find("'g'") != std::string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 ////////////////////////////////////////////////////////////////////////
 
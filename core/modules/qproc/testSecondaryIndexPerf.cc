@@ -0,0 +1,169 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of secondary index lookups of 1, 1k and 100k keys, in ms per
+/// lookup:
+///  - with no arguments, or the number of objects, an ObjectIndex of
+///    synthetic objects is built, saved, mapped back and looked up;
+///  - given a MySQL user, socket and director table, SecondaryIndex looks up
+///    keys of that table with the MySQL backend, then with the table held in
+///    memory.
+/// It is not run as a unit test; run it by hand.
+/// Usage: testSecondaryIndexPerf [objects]
+///        testSecondaryIndexPerf <user> <socket> <db> <table>
+
+// System headers
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "global/constants.h"
+#include "mysql/MySqlConfig.h"
+#include "qproc/ObjectIndex.h"
+#include "qproc/SecondaryIndex.h"
+#include "query/Constraint.h"
+#include "sql/SqlConnection.h"
+
+using namespace lsst::qserv;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int const BATCHES[] = {1, 1000, 100000};
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// @return n keys drawn from keys.
+std::vector<std::int64_t> sample(std::vector<std::int64_t> const& keys, int n, std::mt19937_64& rng) {
+    std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+    std::vector<std::int64_t> out;
+    for (int j=0; j < n; ++j) {
+        out.push_back(keys[pick(rng)]);
+    }
+    return out;
+}
+
+/// Objects with increasing ids and gaps, spread over 1000 chunks of 100 subchunks.
+void synthetic(int nObjects) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> gap(1, 16);
+    std::vector<qproc::ObjectIndex::Entry> entries;
+    std::vector<std::int64_t> keys;
+    std::int64_t key = 433327840428032LL;
+    for (int j=0; j < nObjects; ++j) {
+        key += gap(rng);
+        keys.push_back(key);
+        entries.push_back(qproc::ObjectIndex::Entry{key, 1000 + j % 1000, (j / 1000) % 100});
+    }
+    auto start = Clock::now();
+    auto built = qproc::ObjectIndex::build(entries);
+    std::cout << "build: keys=" << built->size() << " bytes=" << built->getBytes()
+              << " ms=" << msSince(start) << std::endl;
+    std::string const path = "/tmp/testSecondaryIndexPerf.idx";
+    built->save(path, 1);
+    start = Clock::now();
+    auto mapped = qproc::ObjectIndex::load(path);
+    std::cout << "load: ms=" << msSince(start) << std::endl;
+
+    for (auto n : BATCHES) {
+        auto batch = sample(keys, n, rng);
+        int const reps = n < 1000 ? 10000 : (n < 100000 ? 100 : 10);
+        std::size_t found = 0;
+        start = Clock::now();
+        for (int r=0; r < reps; ++r) {
+            mapped->lookup(batch, [&found](std::int32_t, std::int32_t) { ++found; });
+        }
+        std::cout << "mapped keys=" << n << ": ms=" << msSince(start) / reps
+                  << " found=" << found / reps << std::endl;
+    }
+    std::size_t found = 0;
+    start = Clock::now();
+    mapped->lookupRange(keys[0], keys[keys.size() / 100], [&found](std::int32_t, std::int32_t) { ++found; });
+    std::cout << "mapped range: ms=" << msSince(start) << " found=" << found << std::endl;
+    std::remove(path.c_str());
+}
+
+/// @return the sIndex constraint on keys of db.table.
+query::ConstraintVector makeConstraint(std::string const& db, std::string const& table,
+                                       std::vector<std::int64_t> const& keys) {
+    query::Constraint c;
+    c.name = "sIndex";
+    c.params = {db, table, "objectId"};
+    for (auto key : keys) {
+        c.params.push_back(std::to_string(key));
+    }
+    return query::ConstraintVector{c};
+}
+
+void compare(mysql::MySqlConfig const& config, std::string const& db, std::string const& table) {
+    // The key column comes first in the index table.
+    std::vector<std::int64_t> keys;
+    sql::SqlConnection conn(config);
+    std::string const indexTable = std::string(SEC_INDEX_DB) + "." + db + "__" + table;
+    for (auto results = conn.getQueryIter("SELECT * FROM " + indexTable); !results->done(); ++(*results)) {
+        keys.push_back(std::stoll((**results)[0]));
+    }
+    if (keys.empty()) {
+        std::cerr << indexTable << " is empty" << std::endl;
+        exit(1);
+    }
+
+    qproc::SecondaryIndex fromMySql(config);
+    auto start = Clock::now();
+    qproc::SecondaryIndex inMemory(config, {db + "." + table}, "", std::chrono::seconds(0));
+    std::cout << "memory load: keys=" << keys.size() << " ms=" << msSince(start) << std::endl;
+
+    std::mt19937_64 rng(42);
+    for (auto n : BATCHES) {
+        auto cv = makeConstraint(db, table, sample(keys, n, rng));
+        int const reps = n < 1000 ? 100 : (n < 100000 ? 10 : 1);
+        for (auto backend : {&fromMySql, &inMemory}) {
+            std::size_t chunks = 0;
+            start = Clock::now();
+            for (int r=0; r < reps; ++r) {
+                chunks = backend->lookup(cv).size();
+            }
+            std::cout << (backend == &fromMySql ? "mysql" : "memory") << " keys=" << n
+                      << ": ms=" << msSince(start) / reps << " chunks=" << chunks << std::endl;
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    if (argc == 5) {
+        compare(mysql::MySqlConfig(argv[1], "", argv[2]), argv[3], argv[4]);
+    } else {
+        synthetic(argc > 1 ? std::atoi(argv[1]) : 10000000);
+    }
+    return 0;
+}
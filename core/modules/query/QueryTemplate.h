@@ -134,6 +134,8 @@ public:
     std::string generate(EntryMapping const& em) const;
     void clear();
 
+    EntryPtrVector const& getEntries() const { return _entries; }
+
     template <class T>
     static std::ostream& renderDbg(std::ostream& os, T const& t) {
         QueryTemplate qt;
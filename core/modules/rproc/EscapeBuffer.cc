@@ -0,0 +1,176 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// The vector kernels scan 16 (SSE2) or 32 (AVX2) bytes at a time for the
+/// six bytes that need escaping. Clean blocks are stored as-is, and the
+/// clean prefix of a dirty block is copied before escaping the first dirty
+/// byte, so numeric text never takes the per-byte path.
+
+// Class header
+#include "rproc/EscapeBuffer.h"
+
+// System headers
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define QSERV_ESCAPE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+namespace {
+
+/// Write the escape sequence for c, which must need escaping.
+inline char* escapeByte(char* dest, char c) {
+    *dest++ = '\\';
+    switch(c) {
+      case '\0':   *dest++ = '0'; break;
+      case '\b':   *dest++ = 'b'; break;
+      case '\n':   *dest++ = 'n'; break;
+      case '\r':   *dest++ = 'r'; break;
+      case '\t':   *dest++ = 't'; break;
+      default:     *dest++ = 'Z'; break; // '\032'
+    }
+    return dest;
+}
+
+inline char* escapeTail(char* dest, char const* src, char const* end) {
+    for(; src != end; ++src) {
+        switch(*src) {
+          case '\0': case '\b': case '\n': case '\r': case '\t': case '\032':
+            dest = escapeByte(dest, *src);
+            break;
+          default:
+            *dest++ = *src;
+            break;
+        }
+    }
+    return dest;
+}
+
+#ifdef QSERV_ESCAPE_X86
+
+std::size_t escapeBufferSse2(char* dest, char const* src, std::size_t srcLength) {
+    char* const destBegin = dest;
+    char const* const end = src + srcLength;
+    __m128i const nul = _mm_setzero_si128();
+    __m128i const bs = _mm_set1_epi8('\b');
+    __m128i const nl = _mm_set1_epi8('\n');
+    __m128i const cr = _mm_set1_epi8('\r');
+    __m128i const tab = _mm_set1_epi8('\t');
+    __m128i const ctlZ = _mm_set1_epi8('\032');
+    while(end - src >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, nul), _mm_cmpeq_epi8(v, bs)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, ctlZ)));
+        unsigned mask = _mm_movemask_epi8(m);
+        if (mask == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), v);
+            dest += 16;
+            src += 16;
+            continue;
+        }
+        unsigned clean = __builtin_ctz(mask);
+        memcpy(dest, src, clean);
+        dest = escapeByte(dest + clean, src[clean]);
+        src += clean + 1;
+    }
+    return escapeTail(dest, src, end) - destBegin;
+}
+
+__attribute__((target("avx2")))
+std::size_t escapeBufferAvx2(char* dest, char const* src, std::size_t srcLength) {
+    char* const destBegin = dest;
+    char const* const end = src + srcLength;
+    __m256i const nul = _mm256_setzero_si256();
+    __m256i const bs = _mm256_set1_epi8('\b');
+    __m256i const nl = _mm256_set1_epi8('\n');
+    __m256i const cr = _mm256_set1_epi8('\r');
+    __m256i const tab = _mm256_set1_epi8('\t');
+    __m256i const ctlZ = _mm256_set1_epi8('\032');
+    while(end - src >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, nul), _mm256_cmpeq_epi8(v, bs)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cr))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, ctlZ)));
+        unsigned mask = _mm256_movemask_epi8(m);
+        if (mask == 0) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), v);
+            dest += 32;
+            src += 32;
+            continue;
+        }
+        unsigned clean = __builtin_ctz(mask);
+        memcpy(dest, src, clean);
+        dest = escapeByte(dest + clean, src[clean]);
+        src += clean + 1;
+    }
+    // Finish with 16-byte blocks before going byte-at-a-time.
+    std::size_t done = dest - destBegin;
+    return done + escapeBufferSse2(dest, src, end - src);
+}
+
+#endif // QSERV_ESCAPE_X86
+
+std::vector<EscapeBufferKernel> makeKernels() {
+    std::vector<EscapeBufferKernel> kernels;
+    kernels.push_back(EscapeBufferKernel{"scalar", &escapeBufferScalar});
+#ifdef QSERV_ESCAPE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back(EscapeBufferKernel{"sse2", &escapeBufferSse2});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(EscapeBufferKernel{"avx2", &escapeBufferAvx2});
+    }
+#endif
+    return kernels;
+}
+
+} // anonymous namespace
+
+std::size_t escapeBufferScalar(char* dest, char const* src, std::size_t srcLength) {
+    return escapeTail(dest, src, src + srcLength) - dest;
+}
+
+std::vector<EscapeBufferKernel> const& escapeBufferKernels() {
+    static std::vector<EscapeBufferKernel> const kernels = makeKernels();
+    return kernels;
+}
+
+std::string const& escapeBufferKernel() {
+    return escapeBufferKernels().back().name;
+}
+
+std::size_t escapeBuffer(char* dest, char const* src, std::size_t srcLength) {
+    static EscapeBufferFunc const func = escapeBufferKernels().back().func;
+    return func(dest, src, srcLength);
+}
+
+}}} // namespace lsst::qserv::rproc
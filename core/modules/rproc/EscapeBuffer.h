@@ -0,0 +1,62 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_ESCAPEBUFFER_H
+#define LSST_QSERV_RPROC_ESCAPEBUFFER_H
+
+// System headers
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// Escape a byte buffer for LOAD DATA INFILE, using the same rules as
+/// escapeString() in ProtoRowBuffer.cc (\0 \b \n \r \t \032).
+/// dest must have room for 2 * srcLength bytes.
+/// @return the number of bytes written to dest
+typedef std::size_t (*EscapeBufferFunc)(char* dest, char const* src, std::size_t srcLength);
+
+/// Escape using the fastest kernel supported by the CPU. The kernel is
+/// chosen once, on first use.
+std::size_t escapeBuffer(char* dest, char const* src, std::size_t srcLength);
+
+/// @return the name of the kernel used by escapeBuffer()
+std::string const& escapeBufferKernel();
+
+/// Byte-at-a-time kernel, available everywhere.
+std::size_t escapeBufferScalar(char* dest, char const* src, std::size_t srcLength);
+
+/// A named escape kernel
+struct EscapeBufferKernel {
+    std::string name;
+    EscapeBufferFunc func;
+};
+
+/// @return all kernels usable on this CPU, scalar first and the
+/// preferred one last.
+std::vector<EscapeBufferKernel> const& escapeBufferKernels();
+
+}}} // namespace lsst::qserv::rproc
+#endif // LSST_QSERV_RPROC_ESCAPEBUFFER_H
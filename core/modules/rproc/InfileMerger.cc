@@ -39,6 +39,7 @@
 #include "rproc/InfileMerger.h"
 
 // System headers
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <iostream>
@@ -55,8 +56,10 @@
 
 // Qserv headers
 #include "global/intTypes.h"
+#include "proto/ColumnarRows.h"
 #include "proto/WorkerResponse.h"
 #include "proto/ProtoImporter.h"
+#include "proto/ResultCompression.h"
 #include "query/SelectStmt.h"
 #include "rproc/ProtoRowBuffer.h"
 #include "sql/Schema.h"
@@ -102,19 +105,29 @@ std::mutex largeResultPoolMutex;
 // InfileMerger public
 ////////////////////////////////////////////////////////////////////////
 InfileMerger::InfileMerger(InfileMergerConfig const& c)
-    : _config{c},
-      _mysqlConn{_config.mySqlConfig} {
+    : _config{c} {
     _fixupTargetName();
     if (_config.mergeStmt) {
         _config.mergeStmt->setFromListAsTable(_mergeTable);
     }
-    if (!_setupConnection()) {
+    _shards.reset(new MergeShards(_mergeTable, _config.mergeConnections));
+    for (int j = 0; j < _shards->size(); ++j) {
+        _slots.emplace_back(new MergeSlot(_config.mySqlConfig));
+    }
+    // Only the first connection is opened up front, the others are opened
+    // the first time concurrent merges need them.
+    if (!_setupConnection(*_slots[0])) {
         throw InfileMergerError(util::ErrorCode::MYSQLCONNECT, "InfileMerger mysql connect failure.");
     }
 
     if (_largeResultPool == nullptr) {
         throw InfileMergerError(util::ErrorCode::INTERNAL, "InfileMerger largeResultPool uninitialized");
     }
+    if (_config.mergeStmt && _config.aggregateInMemory) {
+        _aggregator = ResultAggregator::newAggregator(*_config.mergeStmt);
+        LOGS(_log, LOG_LVL_DEBUG, "InfileMerger in-memory aggregation "
+             << (_aggregator ? "enabled" : "not possible"));
+    }
 }
 
 InfileMerger::~InfileMerger() {
@@ -139,6 +152,9 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
         return false;
     }
     // TODO: Check session id (once session id mgmt is implemented)
+    proto::ProtoHeader const& protoHeader = response->protoHeader;
+    _wireBytes += protoHeader.size();
+    _rawBytes += protoHeader.has_rawsize() ? protoHeader.rawsize() : protoHeader.size();
 
     std::string queryIdStr = QueryIdHelper::makeIdStr(
             response->result.queryid(), response->result.jobid());
@@ -150,7 +166,7 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
          << " sizes=" << static_cast<short>(response->headerSize)
          << ", " << response->protoHeader.size()
          << ", rowCount=" << response->result.rowcount()
-         << ", row_size=" << response->result.row_size()
+         << ", row_size=" << proto::getResultRowCount(response->result)
          << ", errCode=" << response->result.has_errorcode()
          << " hasErMsg=" << response->result.has_errormsg() << ")");
 
@@ -166,19 +182,16 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
     }
 
     // Nothing to do if size is zero.
-    if (response->result.row_size() == 0) {
+    if (proto::getResultRowCount(response->result) == 0) {
+        return true;
+    }
+    if (_foldInMemory(*response)) {
         return true;
     }
 
     bool ret = false;
     auto runSql = [this, &response, &queryIdStr, &ret](util::CmdData*){
-        std::string const virtFile = _infileMgr.prepareSrc(newProtoRowBuffer(response->result));
-        std::string const infileStatement = sql::formLoadInfile(_mergeTable, virtFile);
-        auto start = std::chrono::system_clock::now();
-        ret = _applyMysql(infileStatement);
-        auto end = std::chrono::system_clock::now();
-        auto mergeDur = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        LOGS(_log, LOG_LVL_DEBUG, queryIdStr << " mergeDur=" << mergeDur.count());
+        ret = _loadResult(response->result, queryIdStr);
     };
     if (largeResult) {
         // Queuing on the limited size thread pool should keep the czar from getting
@@ -202,22 +215,118 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
 }
 
 
-bool InfileMerger::_applyMysql(std::string const& query) {
-    std::lock_guard<std::mutex> lock(_mysqlMutex);
-    if (!_mysqlConn.connected()) {
-        // should have connected during construction
-        // Try reconnecting--maybe we timed out.
-        if (!_setupConnection()) {
+/// Load the rows of a Result message with LOAD DATA on an idle slot.
+bool InfileMerger::_loadResult(proto::Result& result, std::string const& queryIdStr) {
+    bool ret = false;
+    int slotId = _shards->acquire();
+    MergeSlot& slot = *_slots[slotId];
+    if (_setupSlotTable(slotId)) {
+        std::string const virtFile = slot.infileMgr.prepareSrc(newProtoRowBuffer(result));
+        std::string const infileStatement = sql::formLoadInfile(_shards->getTable(slotId), virtFile);
+        auto start = std::chrono::system_clock::now();
+        ret = _applyMysql(slot, infileStatement);
+        auto end = std::chrono::system_clock::now();
+        auto mergeDur = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        LOGS(_log, LOG_LVL_DEBUG, queryIdStr << " mergeDur=" << mergeDur.count()
+             << " slot=" << slotId);
+    }
+    _shards->release(slotId, proto::getResultRowCount(result), ret);
+    return ret;
+}
+
+/// Fold a response into the in-memory aggregator, if there is one.
+/// If the aggregator gives up part way, the folded rows are removed from
+/// the response and what was folded so far is loaded.
+/// @return true if all rows of the response were folded
+bool InfileMerger::_foldInMemory(proto::WorkerResponse& response) {
+    std::lock_guard<std::mutex> lock(_aggMutex);
+    if (!_aggregator) {
+        return false;
+    }
+    if (response.result.has_columnar()) {
+        // Aggregate results are small, folding works on rows.
+        proto::ColumnarRowsReader(response.result.columnar()).appendRowsTo(response.result);
+        response.result.clear_columnar();
+    }
+    auto start = std::chrono::system_clock::now();
+    int folded = _aggregator->fold(response.result);
+    auto end = std::chrono::system_clock::now();
+    auto foldDur = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    LOGS(_log, LOG_LVL_DEBUG, "InfileMerger folded " << folded << " rows in "
+         << foldDur.count() << "us, groups=" << _aggregator->getGroupCount());
+    if (_aggregator->isActive()) {
+        return true;
+    }
+    response.result.mutable_row()->DeleteSubrange(0, folded);
+    _flushAggregator();
+    return false;
+}
+
+/// Load the folded rows and stop folding. The caller must hold _aggMutex.
+bool InfileMerger::_flushAggregator() {
+    if (!_aggregator) {
+        return true;
+    }
+    bool ok = true;
+    proto::Result folded;
+    if (_aggregator->exportTo(folded)) {
+        LOGS(_log, LOG_LVL_DEBUG, "InfileMerger loading " << folded.row_size()
+             << " groups folded from " << _aggregator->getFoldedRowCount() << " rows");
+        ok = _loadResult(folded, "aggregate");
+    }
+    _aggregator.reset();
+    return ok;
+}
+
+/// Apply a query on a slot's connection. The caller must hold the slot.
+bool InfileMerger::_applyMysql(MergeSlot& slot, std::string const& query) {
+    if (!slot.mysqlConn.connected()) {
+        // Slot 0 connected during construction, the others connect on first
+        // use. Also try reconnecting--maybe we timed out.
+        if (!_setupConnection(slot)) {
             LOGS(_log, LOG_LVL_ERROR, "InfileMerger::_applyMysql _setupConnection() failed!!!");
             return false; // Reconnection failed. This is an error.
         }
     }
 
-    int rc = mysql_real_query(_mysqlConn.getMySql(),
+    int rc = mysql_real_query(slot.mysqlConn.getMySql(),
                               query.data(), query.size());
     return rc == 0;
 }
 
+/// Make sure the table a slot loads into exists. Shard tables are
+/// copies of the merge table's schema. The caller must hold the slot.
+bool InfileMerger::_setupSlotTable(int slotId) {
+    if (!_shards->needsTable(slotId)) {
+        return true;
+    }
+    std::string const& table = _shards->getTable(slotId);
+    std::string createShard = "CREATE TABLE " + table + " LIKE " + _mergeTable;
+    if (not _applySqlLocal(createShard)) {
+        LOGS(_log, LOG_LVL_ERROR, "InfileMerger failed to create shard " << table);
+        return false;
+    }
+    _shards->setTableReady(slotId);
+    return true;
+}
+
+/// Fold the shard tables into the merge table and drop them.
+bool InfileMerger::_consolidateShards() {
+    bool ok = true;
+    for (auto const& table : _shards->consolidate()) {
+        std::string insertSelect = "INSERT INTO " + _mergeTable + " SELECT * FROM " + table;
+        LOGS(_log, LOG_LVL_DEBUG, "Consolidating w/" << insertSelect);
+        ok = _applySqlLocal(insertSelect) && ok;
+        sql::SqlErrorObject eObj;
+        if (!_sqlConn || !_sqlConn->dropTable(table, eObj, false, _config.mySqlConfig.dbName)) {
+            LOGS(_log, LOG_LVL_DEBUG, "Failure cleaning up shard " << table);
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "InfileMerger loaded " << _shards->getStats(0).rows
+         << " rows in " << _shards->getStats(0).loads << " loads into " << _mergeTable);
+    return ok;
+}
+
 
 bool InfileMerger::finalize() {
     bool finalizeOk = true;
@@ -225,6 +334,11 @@ bool InfileMerger::finalize() {
     if (_isFinished) {
         LOGS(_log, LOG_LVL_ERROR, "InfileMerger::finalize(), but _isFinished == true");
     }
+    {
+        std::lock_guard<std::mutex> lock(_aggMutex);
+        finalizeOk = _flushAggregator();
+    }
+    finalizeOk = _consolidateShards() && finalizeOk;
     if (_mergeTable != _config.targetTable) {
         // Aggregation needed: Do the aggregation.
         std::string mergeSelect = _config.mergeStmt->getQueryTemplate().sqlFragment();
@@ -232,7 +346,7 @@ bool InfileMerger::finalize() {
         std::string createMerge = "CREATE TABLE " + _config.targetTable
             + " ENGINE=MyISAM " + mergeSelect;
         LOGS(_log, LOG_LVL_DEBUG, "Merging w/" << createMerge);
-        finalizeOk = _applySqlLocal(createMerge);
+        finalizeOk = _applySqlLocal(createMerge) && finalizeOk;
 
         // Cleanup merge table.
         sql::SqlErrorObject eObj;
@@ -250,6 +364,14 @@ bool InfileMerger::finalize() {
         }
     }
     LOGS(_log, LOG_LVL_DEBUG, "Merged " << _mergeTable << " into " << _config.targetTable);
+    std::uint64_t const wireBytes = _wireBytes;
+    std::uint64_t const rawBytes = _rawBytes;
+    if (rawBytes != wireBytes) {
+        LOGS(_log, LOG_LVL_INFO, "Result compression for " << _config.targetTable
+             << ": wireBytes=" << wireBytes << " rawBytes=" << rawBytes
+             << " ratio=" << double(rawBytes) / wireBytes
+             << ", czar totals: " << proto::ResultCompression::getUncompressStats());
+    }
     _isFinished = true;
     return finalizeOk;
 }
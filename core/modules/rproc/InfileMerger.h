@@ -30,14 +30,20 @@
 /// (see individual class documentation for more information)
 
 // System headers
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "mysql/LocalInfile.h"
 #include "mysql/MySqlConfig.h"
 #include "mysql/MySqlConnection.h"
+#include "proto/worker.pb.h"
+#include "rproc/MergeShards.h"
+#include "rproc/ResultAggregator.h"
 #include "util/Error.h"
 #include "util/EventThread.h"
 
@@ -89,6 +95,18 @@ public:
     mysql::MySqlConfig const mySqlConfig;
     std::string targetTable;
     std::shared_ptr<query::SelectStmt> mergeStmt;
+    /// Number of MySQL connections loading results in parallel. Each
+    /// connection loads into its own shard of the merge table.
+    int mergeConnections{1};
+    /// Fold aggregate query results in memory before loading them.
+    bool aggregateInMemory{true};
+    /// Checksum workers are asked to use for result messages.
+    proto::ProtoHeader::ChecksumType resultChecksum{proto::ProtoHeader::MD5};
+    /// Highest result protocol workers may use, 3 being columnar.
+    int maxResultProtocol{2};
+    /// ProtoHeader::CompressionType workers are asked to use for result
+    /// messages, 0 leaving the choice to each worker.
+    int resultCompression{0};
 };
 
 /// InfileMerger is a row-based merger that imports rows from result messages
@@ -103,6 +121,16 @@ public:
 /// Bytes 1 - size_ph : ProtoHeader message (containing size of result message)
 /// Bytes size_ph - size_ph + size_rm : Result message
 /// At present, Result messages are not chained.
+///
+/// Results are loaded over a pool of InfileMergerConfig::mergeConnections
+/// MySQL connections. The first connection loads into the merge table
+/// itself, the others into shard tables with the same schema, which
+/// finalize() folds back into the merge table before post-processing.
+///
+/// For aggregate queries, results are first folded in memory by a
+/// ResultAggregator, and only the folded rows are loaded, by finalize().
+/// If the aggregator gives up, what it folded is loaded and merging
+/// continues through MySQL.
 class InfileMerger {
 public:
     explicit InfileMerger(InfileMergerConfig const& c);
@@ -129,7 +157,20 @@ public:
     bool isFinished() const;
 
 private:
-    bool _applyMysql(std::string const& query);
+    /// A MySQL connection loading results into one shard of the merge table.
+    /// Slot j loads into _shards.getTable(j).
+    struct MergeSlot {
+        explicit MergeSlot(mysql::MySqlConfig const& config) : mysqlConn(config) {}
+        mysql::MySqlConnection mysqlConn;
+        mysql::LocalInfile::Mgr infileMgr;
+    };
+
+    bool _setupSlotTable(int slotId);
+    bool _consolidateShards();
+    bool _foldInMemory(proto::WorkerResponse& response);
+    bool _flushAggregator();
+    bool _loadResult(proto::Result& result, std::string const& queryIdStr);
+    bool _applyMysql(MergeSlot& slot, std::string const& query);
     bool _merge(std::shared_ptr<proto::WorkerResponse>& response);
     int _readHeader(proto::ProtoHeader& header, char const* buffer, int length);
     int _readResult(proto::Result& result, char const* buffer, int length);
@@ -140,9 +181,9 @@ private:
     bool _applySqlLocal(std::string const& sql);
     void _fixupTargetName();
 
-    bool _setupConnection() {
-        if (_mysqlConn.connect()) {
-            _infileMgr.attach(_mysqlConn.getMySql());
+    bool _setupConnection(MergeSlot& slot) {
+        if (slot.mysqlConn.connect()) {
+            slot.infileMgr.attach(slot.mysqlConn.getMySql());
             return true;
         }
         return false;
@@ -157,9 +198,14 @@ private:
     std::mutex _sqlMutex; ///< Protection for SQL connection
     bool _needCreateTable{true}; ///< Does the target table need creating?
 
-    mysql::MySqlConnection _mysqlConn;
-    std::mutex _mysqlMutex;
-    lsst::qserv::mysql::LocalInfile::Mgr _infileMgr;
+    std::vector<std::unique_ptr<MergeSlot>> _slots; ///< Merge connections
+    std::unique_ptr<MergeShards> _shards; ///< Tables the slots load into
+
+    ResultAggregator::Ptr _aggregator; ///< In-memory folding, if possible
+    std::mutex _aggMutex; ///< Protects _aggregator
+
+    std::atomic<std::uint64_t> _wireBytes{0}; ///< Result bytes received
+    std::atomic<std::uint64_t> _rawBytes{0}; ///< Result bytes once uncompressed
 
     // The limited size pool will keep large queries from using up all the czar's time.
     static util::ThreadPool::Ptr _largeResultPool;
@@ -0,0 +1,112 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/MergeShards.h"
+
+// System headers
+#include <algorithm>
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+MergeShards::MergeShards(std::string const& mergeTable, int count)
+    : _shards(std::max(1, count)) {
+    for (unsigned j = 0; j < _shards.size(); ++j) {
+        _shards[j].table = (j == 0) ? mergeTable : mergeTable + "_s" + std::to_string(j);
+    }
+    // The merge table is created by InfileMerger before any load.
+    _shards[0].tableReady = true;
+}
+
+int MergeShards::acquire() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (true) {
+        for (unsigned j = 0; j < _shards.size(); ++j) {
+            if (!_shards[j].busy) {
+                _shards[j].busy = true;
+                return j;
+            }
+        }
+        _cv.wait(lock);
+    }
+}
+
+void MergeShards::release(int shardId, std::uint64_t rows, bool loaded) {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        Shard& shard = _shards[shardId];
+        shard.busy = false;
+        if (loaded) {
+            ++shard.stats.loads;
+            shard.stats.rows += rows;
+        }
+    }
+    _cv.notify_one();
+}
+
+bool MergeShards::needsTable(int shardId) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return !_shards[shardId].tableReady;
+}
+
+void MergeShards::setTableReady(int shardId) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _shards[shardId].tableReady = true;
+}
+
+MergeShards::Stats MergeShards::getStats(int shardId) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _shards[shardId].stats;
+}
+
+MergeShards::Stats MergeShards::getTotal() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Stats total;
+    for (auto const& shard : _shards) {
+        total.loads += shard.stats.loads;
+        total.rows += shard.stats.rows;
+    }
+    return total;
+}
+
+std::vector<std::string> MergeShards::consolidate() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::vector<std::string> tables;
+    Stats& merged = _shards[0].stats;
+    for (unsigned j = 1; j < _shards.size(); ++j) {
+        Shard& shard = _shards[j];
+        if (!shard.tableReady) {
+            continue;
+        }
+        tables.push_back(shard.table);
+        merged.loads += shard.stats.loads;
+        merged.rows += shard.stats.rows;
+        shard.stats = Stats();
+        shard.tableReady = false;
+    }
+    return tables;
+}
+
+}}} // namespace lsst::qserv::rproc
@@ -0,0 +1,114 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_MERGESHARDS_H
+#define LSST_QSERV_RPROC_MERGESHARDS_H
+
+// System headers
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// MergeShards keeps track of the tables InfileMerger loads results into
+/// over several connections.
+///
+/// Shard 0 is the merge table itself, shard j > 0 is a table named
+/// <mergeTable>_s<j> with the same schema, created the first time a load
+/// lands on it. A load claims an idle shard with acquire() and gives it
+/// back with release(), recording how many rows it loaded. consolidate()
+/// lists the shard tables to fold back into the merge table, and moves
+/// their row counts to shard 0.
+///
+/// MergeShards only does the bookkeeping, the SQL is left to InfileMerger.
+class MergeShards {
+public:
+    /// Row and load counts of a shard.
+    struct Stats {
+        std::uint64_t loads{0};
+        std::uint64_t rows{0};
+    };
+
+    /// @param mergeTable name of the merge table, used as shard 0
+    /// @param count number of shards, at least 1
+    MergeShards(std::string const& mergeTable, int count);
+
+    MergeShards(MergeShards const&) = delete;
+    MergeShards& operator=(MergeShards const&) = delete;
+
+    int size() const { return static_cast<int>(_shards.size()); }
+
+    /// @return the table shard shardId loads into
+    std::string const& getTable(int shardId) const { return _shards[shardId].table; }
+
+    /// Wait for an idle shard and claim it. The lowest idle shard is
+    /// preferred, so queries with little concurrency stay on shard 0.
+    /// @return the shard index
+    int acquire();
+
+    /// Give back a shard claimed by acquire().
+    /// @param rows number of rows loaded while the shard was held
+    /// @param loaded false if the load failed, in which case nothing is counted
+    void release(int shardId, std::uint64_t rows, bool loaded=true);
+
+    /// @return true if the table of a shard has to be created before
+    ///         loading into it. Only the holder of the shard may call this.
+    bool needsTable(int shardId) const;
+
+    /// Record that the table of a shard exists.
+    void setTableReady(int shardId);
+
+    /// @return the accounting of one shard
+    Stats getStats(int shardId) const;
+
+    /// @return the accounting summed over all shards
+    Stats getTotal() const;
+
+    /// Take the shard tables created so far, to be folded into the merge
+    /// table, moving their accounting to shard 0. The tables returned are
+    /// forgotten: they are expected to be dropped once folded, and would
+    /// be created again by a later load.
+    /// No shard may be held while this runs.
+    /// @return the shard tables, lowest shard first
+    std::vector<std::string> consolidate();
+
+private:
+    struct Shard {
+        std::string table;
+        bool tableReady{false}; ///< true once table exists
+        bool busy{false}; ///< true while a load holds this shard
+        Stats stats;
+    };
+
+    std::vector<Shard> _shards;
+    mutable std::mutex _mtx; ///< Protects _shards
+    std::condition_variable _cv; ///< Signalled when a shard is released
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_MERGESHARDS_H
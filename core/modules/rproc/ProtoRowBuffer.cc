@@ -23,17 +23,22 @@
 #include "rproc/ProtoRowBuffer.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <memory>
 #include <string.h>
+#include <vector>
 
 // Third-party headers
 #include <mysql/mysql.h>
 
 // Qserv headers
+#include "proto/ColumnarRows.h"
 #include "proto/worker.pb.h"
+#include "rproc/EscapeBuffer.h"
 #include "sql/Schema.h"
 
 ////////////////////////////////////////////////////////////////////////
@@ -60,6 +65,9 @@ namespace rproc {
 /// \Z     ASCII 26 (Control+Z)
 /// \N     NULL
 ///
+/// This is the reference implementation; row encoding uses the vectorized
+/// escapeBuffer(), which must produce identical output.
+///
 /// @return the number of bytes written to dest
 template <typename Iter, typename CIter>
 inline int escapeString(Iter destBegin, CIter srcBegin, CIter srcEnd) {
@@ -101,33 +109,24 @@ inline int copyColumn(T& dest, std::string const& rawColumn) {
 ////////////////////////////////////////////////////////////////////////
 
 /// ProtoRowBuffer is an implementation of RowBuffer designed to allow a
-/// LocalInfile object to use a Protobufs Result message as a row source
+/// LocalInfile object to use a Protobufs Result message as a row source.
+/// Rows are encoded directly into the caller's buffer, as many as fit per
+/// fetch(). A row that might not fit is staged in _pending and handed out
+/// across as many fetch() calls as needed, tracked by a read cursor.
+/// Rows are read from RowBundles or, for protocol 3, from ColumnarRows.
 class ProtoRowBuffer : public mysql::RowBuffer {
 public:
     ProtoRowBuffer(proto::Result& res);
     virtual unsigned fetch(char* buffer, unsigned bufLen);
 
 private:
-    void _initCurrentRow();
     void _initSchema();
-    void _readNextRow();
-    // Copy a row bundle into a destination STL char container
-    template <typename T>
-    int _copyRowBundle(T& dest, proto::RowBundle const& rb) {
-        int sizeBefore = dest.size();
-        for(int ci=0, ce=rb.column_size(); ci != ce; ++ci) {
-            if (ci != 0) {
-                dest.insert(dest.end(), _colSep.begin(), _colSep.end());
-            }
-
-            if (!rb.isnull(ci)) {
-                copyColumn(dest, rb.column(ci));
-            } else {
-                dest.insert(dest.end(), _nullToken.begin(), _nullToken.end() );
-            }
-        }
-        return dest.size() - sizeBefore;
-    }
+    unsigned _maxRowSize() const;
+    unsigned _encodeRow(char* dest) const;
+    unsigned _maxColumnarRowSize() const;
+    char* _encodeColumnarRow(char* cursor) const;
+    void _stageRow();
+    unsigned _fetchPending(char* buffer, unsigned bufLen);
 
     std::string _colSep; ///< Column separator
     std::string _rowSep; ///< Row separator
@@ -135,9 +134,11 @@ private:
     proto::Result& _result; ///< Ref to Resultmessage
 
     sql::Schema _schema; ///< Schema object
-    int _rowIdx; ///< Row index
+    int _rowIdx; ///< Index of the next row to encode
     int _rowTotal; ///< Total row count
-    std::vector<char> _currentRow; ///< char buffer representing current row.
+    std::vector<char> _pending; ///< Encoded row that did not fit in a fetch
+    unsigned _pendingPos; ///< Read cursor into _pending
+    std::unique_ptr<proto::ColumnarRowsReader> _columnar; ///< Protocol 3 rows
 };
 
 ProtoRowBuffer::ProtoRowBuffer(proto::Result& res)
@@ -146,31 +147,29 @@ ProtoRowBuffer::ProtoRowBuffer(proto::Result& res)
       _nullToken("\\N"),
       _result(res),
       _rowIdx(0),
-      _rowTotal(res.row_size()),
-      _currentRow(0) {
-    _initSchema();
-    if (_result.row_size() > 0) {
-        _initCurrentRow();
+      _rowTotal(proto::getResultRowCount(res)),
+      _pendingPos(0) {
+    if (res.has_columnar()) {
+        _columnar.reset(new proto::ColumnarRowsReader(res.columnar()));
     }
+    _initSchema();
 }
 
-/// Fetch a up to a single row from from the Result message
+/// Fill buffer with as many rows from the Result message as will fit.
+/// Returns 0 only when all rows have been fetched.
 unsigned ProtoRowBuffer::fetch(char* buffer, unsigned bufLen) {
-    unsigned fetched = 0;
-    if (bufLen <= _currentRow.size()) {
-        memcpy(buffer, &_currentRow[0], bufLen);
-        _currentRow.erase(_currentRow.begin(), _currentRow.begin() + bufLen);
-        fetched = bufLen;
-    } else { // Want more than we have.
-        if (_currentRow.size()) {
-            memcpy(buffer, &_currentRow[0], _currentRow.size());
-            fetched = _currentRow.size();
-            _currentRow.clear();
+    unsigned fetched = _fetchPending(buffer, bufLen);
+    while ((fetched < bufLen) && (_rowIdx < _rowTotal)) {
+        unsigned remaining = bufLen - fetched;
+        if (_maxRowSize() <= remaining) {
+            fetched += _encodeRow(buffer + fetched);
+            ++_rowIdx;
+        } else {
+            // The row may not fit, continue it across calls.
+            _stageRow();
+            fetched += _fetchPending(buffer + fetched, remaining);
         }
     }
-    if ((_currentRow.size() == 0) && (_rowIdx < _rowTotal)) {
-        _readNextRow();
-    }
     return fetched;
 }
 
@@ -195,23 +194,128 @@ void ProtoRowBuffer::_initSchema() {
         _schema.columns.push_back(cs);
     }
 }
-/// Import the next row into the buffer
-void ProtoRowBuffer::_readNextRow() {
-    ++_rowIdx;
-    if (_rowIdx >= _rowTotal) {
-        return;
+
+/// @return an upper bound on the encoded size of the row at _rowIdx,
+/// assuming every byte needs escaping.
+unsigned ProtoRowBuffer::_maxRowSize() const {
+    if (_columnar) {
+        return _maxColumnarRowSize();
+    }
+    proto::RowBundle const& rb = _result.row(_rowIdx);
+    unsigned size = (_rowIdx != 0) ? _rowSep.size() : 0;
+    unsigned const nullSize = _nullToken.size();
+    for(int ci=0, ce=rb.column_size(); ci != ce; ++ci) {
+        unsigned colSize = 2 + 2 * rb.column(ci).size();
+        size += std::max(colSize, nullSize);
+    }
+    if (rb.column_size() > 1) {
+        size += (rb.column_size() - 1) * _colSep.size();
+    }
+    return size;
+}
+
+/// Encode the row at _rowIdx, preceded by a row separator for all but the
+/// first row. dest must have room for _maxRowSize() bytes.
+/// @return the number of bytes written to dest
+unsigned ProtoRowBuffer::_encodeRow(char* dest) const {
+    char* cursor = dest;
+    if (_rowIdx != 0) {
+        cursor = std::copy(_rowSep.begin(), _rowSep.end(), cursor);
+    }
+    if (_columnar) {
+        return _encodeColumnarRow(cursor) - dest;
+    }
+    proto::RowBundle const& rb = _result.row(_rowIdx);
+    for(int ci=0, ce=rb.column_size(); ci != ce; ++ci) {
+        if (ci != 0) {
+            cursor = std::copy(_colSep.begin(), _colSep.end(), cursor);
+        }
+        if (!rb.isnull(ci)) {
+            std::string const& col = rb.column(ci);
+            *cursor++ = '\'';
+            cursor += escapeBuffer(cursor, col.data(), col.size());
+            *cursor++ = '\'';
+        } else {
+            cursor = std::copy(_nullToken.begin(), _nullToken.end(), cursor);
+        }
+    }
+    return cursor - dest;
+}
+
+/// _maxRowSize() for a row of ColumnarRows. Numbers are formatted as
+/// text and need no escaping.
+unsigned ProtoRowBuffer::_maxColumnarRowSize() const {
+    unsigned size = (_rowIdx != 0) ? _rowSep.size() : 0;
+    unsigned const nullSize = _nullToken.size();
+    int const colCount = _columnar->getColumnCount();
+    for(int ci=0; ci != colCount; ++ci) {
+        unsigned colSize = nullSize;
+        if (!_columnar->isNull(ci, _rowIdx)) {
+            if (_columnar->isText(ci)) {
+                char const* data;
+                size_t dataSize;
+                _columnar->getText(ci, _rowIdx, data, dataSize);
+                colSize = 2 + 2 * dataSize;
+            } else {
+                colSize = 2 + proto::ColumnarRowsReader::maxNumberSize;
+            }
+        }
+        size += std::max(colSize, nullSize);
+    }
+    if (colCount > 1) {
+        size += (colCount - 1) * _colSep.size();
+    }
+    return size;
+}
+
+/// Encode the columns of the row at _rowIdx of ColumnarRows.
+/// @return the end of what was written
+char* ProtoRowBuffer::_encodeColumnarRow(char* cursor) const {
+    for(int ci=0, ce=_columnar->getColumnCount(); ci != ce; ++ci) {
+        if (ci != 0) {
+            cursor = std::copy(_colSep.begin(), _colSep.end(), cursor);
+        }
+        if (_columnar->isNull(ci, _rowIdx)) {
+            cursor = std::copy(_nullToken.begin(), _nullToken.end(), cursor);
+            continue;
+        }
+        *cursor++ = '\'';
+        if (_columnar->isText(ci)) {
+            char const* data;
+            size_t dataSize;
+            _columnar->getText(ci, _rowIdx, data, dataSize);
+            cursor += escapeBuffer(cursor, data, dataSize);
+        } else {
+            cursor += _columnar->formatNumber(ci, _rowIdx, cursor);
+        }
+        *cursor++ = '\'';
     }
-    _currentRow.clear();
-    // Row separator
-    _currentRow.insert(_currentRow.end(), _rowSep.begin(), _rowSep.end());
-    _copyRowBundle(_currentRow, _result.row(_rowIdx));
+    return cursor;
 }
 
-/// Setup the row byte buffer
-void ProtoRowBuffer::_initCurrentRow() {
-    // Copy row and reserve 2x size.
-    int rowSize = _copyRowBundle(_currentRow, _result.row(_rowIdx));
-    _currentRow.reserve(rowSize*2); // for future usage
+/// Encode the row at _rowIdx into _pending and advance to the next row.
+void ProtoRowBuffer::_stageRow() {
+    _pending.resize(_maxRowSize());
+    _pending.resize(_encodeRow(&_pending[0]));
+    _pendingPos = 0;
+    ++_rowIdx;
+}
+
+/// Copy as much of the staged row as fits into buffer.
+/// @return the number of bytes copied
+unsigned ProtoRowBuffer::_fetchPending(char* buffer, unsigned bufLen) {
+    unsigned available = _pending.size() - _pendingPos;
+    if (available == 0) {
+        return 0;
+    }
+    unsigned copySize = std::min(available, bufLen);
+    memcpy(buffer, &_pending[_pendingPos], copySize);
+    _pendingPos += copySize;
+    if (_pendingPos == _pending.size()) {
+        _pending.clear();
+        _pendingPos = 0;
+    }
+    return copySize;
 }
 
 ////////////////////////////////////////////////////////////////////////
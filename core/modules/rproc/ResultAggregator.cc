@@ -0,0 +1,373 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/ResultAggregator.h"
+
+// System headers
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+// Third-party headers
+#include "boost/algorithm/string/case_conv.hpp"
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "query/FuncExpr.h"
+#include "query/GroupByClause.h"
+#include "query/SelectList.h"
+#include "query/SelectStmt.h"
+#include "query/ValueExpr.h"
+#include "query/ValueFactor.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.rproc.ResultAggregator");
+
+using lsst::qserv::rproc::ResultAggregator;
+namespace query = lsst::qserv::query;
+
+/// Collects how a merge statement's select list uses merge table columns.
+struct SelectListScan {
+    ResultAggregator::OpMap ops; ///< Columns combined by an aggregate
+    std::set<std::string> plain; ///< Columns referenced outside aggregates
+    bool ok{true};
+
+    void scan(query::ValueExpr const& ve) {
+        for (auto const& fo : ve.getFactorOps()) {
+            if (fo.factor) scan(*fo.factor);
+        }
+    }
+
+    void scan(query::ValueFactor const& vf) {
+        switch (vf.getType()) {
+        case query::ValueFactor::COLUMNREF:
+            plain.insert(boost::to_lower_copy(vf.getColumnRef()->column));
+            break;
+        case query::ValueFactor::CONST:
+            break;
+        case query::ValueFactor::EXPR:
+            scan(*vf.getExpr());
+            break;
+        case query::ValueFactor::FUNCTION:
+            for (auto const& p : vf.getFuncExpr()->params) {
+                if (p) scan(*p);
+            }
+            break;
+        case query::ValueFactor::AGGFUNC:
+            _scanAgg(*vf.getFuncExpr());
+            break;
+        default: // STAR
+            ok = false;
+            break;
+        }
+    }
+
+private:
+    void _scanAgg(query::FuncExpr const& fe) {
+        std::string name = boost::to_upper_copy(fe.name);
+        ResultAggregator::Op op;
+        if (name == "SUM") op = ResultAggregator::SUM;
+        else if (name == "MIN") op = ResultAggregator::MIN;
+        else if (name == "MAX") op = ResultAggregator::MAX;
+        else { ok = false; return; }
+        if (fe.params.size() != 1 || !fe.params[0] || !fe.params[0]->isColumnRef()) {
+            ok = false;
+            return;
+        }
+        std::string col = boost::to_lower_copy(fe.params[0]->getColumnRef()->column);
+        auto ins = ops.insert(std::make_pair(col, op));
+        if (!ins.second && ins.first->second != op) {
+            ok = false; // One column combined two ways.
+        }
+    }
+};
+
+/// Parse a MySQL text value as an integer or a double.
+/// @return false if value is not numeric.
+bool parseNumber(std::string const& value, bool& isInt, std::int64_t& i, double& d) {
+    if (value.empty()) return false;
+    char const* begin = value.c_str();
+    char const* end = begin + value.size();
+    char* parseEnd = nullptr;
+    errno = 0;
+    long long ll = std::strtoll(begin, &parseEnd, 10);
+    if (parseEnd == end && errno == 0) {
+        isInt = true;
+        i = ll;
+        return true;
+    }
+    errno = 0;
+    d = std::strtod(begin, &parseEnd);
+    if (parseEnd == end && errno == 0) {
+        isInt = false;
+        return true;
+    }
+    return false;
+}
+
+inline double asDouble(bool isInt, std::int64_t i, double d) {
+    return isInt ? static_cast<double>(i) : d;
+}
+
+/// @return true if the MySQL column type folds exactly from its text form.
+bool isFoldableType(int mysqlType) {
+    switch (mysqlType) {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONGLONG:
+    case MYSQL_TYPE_FLOAT:
+    case MYSQL_TYPE_DOUBLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+ResultAggregator::ResultAggregator(OpMap const& ops, std::set<std::string> const& groupKeys,
+                                   std::size_t maxGroups)
+    : _ops(ops), _groupKeys(groupKeys), _maxGroups(maxGroups) {
+}
+
+ResultAggregator::Ptr ResultAggregator::newAggregator(query::SelectStmt& mergeStmt) {
+    if (mergeStmt.hasWhereClause()) {
+        return nullptr;
+    }
+    auto valueExprs = mergeStmt.getSelectList().getValueExprList();
+    if (!valueExprs) {
+        return nullptr;
+    }
+    SelectListScan s;
+    for (auto const& ve : *valueExprs) {
+        if (ve) s.scan(*ve);
+    }
+    if (!s.ok || s.ops.empty()) {
+        return nullptr;
+    }
+    std::set<std::string> groupKeys;
+    if (mergeStmt.hasGroupBy()) {
+        query::ValueExprPtrVector groupExprs;
+        mergeStmt.getGroupBy().findValueExprs(groupExprs);
+        for (auto const& ve : groupExprs) {
+            if (!ve || !ve->isColumnRef()) {
+                return nullptr;
+            }
+            groupKeys.insert(boost::to_lower_copy(ve->getColumnRef()->column));
+        }
+    }
+    // Columns used outside aggregates must be group keys, or their values
+    // could differ between the rows being folded.
+    for (auto const& col : s.plain) {
+        if (groupKeys.count(col) == 0) {
+            return nullptr;
+        }
+    }
+    return std::make_shared<ResultAggregator>(s.ops, groupKeys);
+}
+
+/// Map result columns to group keys and accumulators.
+bool ResultAggregator::_initSchema(proto::Result const& result) {
+    proto::RowSchema const& rs = result.rowschema();
+    for (int j = 0, e = rs.columnschema_size(); j != e; ++j) {
+        proto::ColumnSchema const& cs = rs.columnschema(j);
+        std::string name = boost::to_lower_copy(cs.name());
+        auto opIter = _ops.find(name);
+        if (_groupKeys.count(name) != 0) {
+            _keyCols.push_back(j);
+        } else if (opIter != _ops.end()) {
+            if (cs.has_mysqltype() && !isFoldableType(cs.mysqltype())) {
+                LOGS(_log, LOG_LVL_DEBUG, "ResultAggregator: column " << name
+                     << " has type " << cs.mysqltype() << ", not folding");
+                return false;
+            }
+            _accCols.push_back(j);
+            _accOps.push_back(opIter->second);
+        } else {
+            LOGS(_log, LOG_LVL_DEBUG, "ResultAggregator: no op for column " << name);
+            return false;
+        }
+    }
+    rs.SerializeToString(&_schema);
+    _hasSchema = true;
+    return true;
+}
+
+/// Combine value into acc.
+/// @return false if the value is not numeric or the sum overflows.
+bool ResultAggregator::_combine(Op op, Accumulator& acc, std::string const& value) const {
+    bool isInt;
+    std::int64_t i = 0;
+    double d = 0;
+    if (!parseNumber(value, isInt, i, d)) {
+        return false;
+    }
+    if (acc.isNull) {
+        acc.isNull = false;
+        acc.isInt = isInt;
+        acc.i = i;
+        acc.d = d;
+        return true;
+    }
+    switch (op) {
+    case SUM:
+        if (acc.isInt && isInt) {
+            if ((i > 0 && acc.i > std::numeric_limits<std::int64_t>::max() - i)
+                || (i < 0 && acc.i < std::numeric_limits<std::int64_t>::min() - i)) {
+                return false; // MySQL would switch to DECIMAL here.
+            }
+            acc.i += i;
+        } else {
+            acc.d = asDouble(acc.isInt, acc.i, acc.d) + asDouble(isInt, i, d);
+            acc.isInt = false;
+        }
+        break;
+    case MIN:
+    case MAX: {
+        bool less = (acc.isInt && isInt) ? (i < acc.i)
+            : (asDouble(isInt, i, d) < asDouble(acc.isInt, acc.i, acc.d));
+        bool greater = (acc.isInt && isInt) ? (i > acc.i)
+            : (asDouble(isInt, i, d) > asDouble(acc.isInt, acc.i, acc.d));
+        if ((op == MIN && less) || (op == MAX && greater)) {
+            acc.isInt = isInt;
+            acc.i = i;
+            acc.d = d;
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+int ResultAggregator::fold(proto::Result const& result) {
+    if (!_active) {
+        return 0;
+    }
+    if (!_hasSchema && !_initSchema(result)) {
+        _active = false;
+        return 0;
+    }
+    std::string key;
+    std::vector<Accumulator> accs;
+    int rowIdx = 0;
+    for (int const rowCount = result.row_size(); rowIdx != rowCount; ++rowIdx) {
+        proto::RowBundle const& row = result.row(rowIdx);
+        // Length-prefixed key cells, so that distinct keys never collide.
+        key.clear();
+        for (int col : _keyCols) {
+            if (row.isnull(col)) {
+                key += 'N';
+            } else {
+                std::string const& cell = row.column(col);
+                key += 'V' + std::to_string(cell.size()) + ':';
+                key += cell;
+            }
+        }
+        auto groupIter = _groups.find(key);
+        if (groupIter == _groups.end() && _groups.size() >= _maxGroups) {
+            LOGS(_log, LOG_LVL_DEBUG, "ResultAggregator: more than " << _maxGroups << " groups");
+            break;
+        }
+        // Combine into a copy so that a failing row leaves no trace.
+        if (groupIter != _groups.end()) {
+            accs = groupIter->second.accs;
+        } else {
+            accs.assign(_accCols.size(), Accumulator());
+        }
+        bool rowOk = true;
+        for (unsigned a = 0; a < _accCols.size() && rowOk; ++a) {
+            int col = _accCols[a];
+            if (!row.isnull(col)) {
+                rowOk = _combine(_accOps[a], accs[a], row.column(col));
+            }
+        }
+        if (!rowOk) {
+            LOGS(_log, LOG_LVL_DEBUG, "ResultAggregator: cannot fold row " << rowIdx);
+            break;
+        }
+        if (groupIter == _groups.end()) {
+            Group& g = _groups[key];
+            for (int col : _keyCols) {
+                g.keyIsNull.push_back(row.isnull(col));
+                g.keys.push_back(row.column(col));
+            }
+            g.accs.swap(accs);
+        } else {
+            groupIter->second.accs.swap(accs);
+        }
+        ++_foldedRows;
+    }
+    if (rowIdx != result.row_size()) {
+        _active = false;
+    }
+    return rowIdx;
+}
+
+bool ResultAggregator::exportTo(proto::Result& result) const {
+    if (!_hasSchema || _groups.empty()) {
+        return false;
+    }
+    result.mutable_rowschema()->ParseFromString(_schema);
+    int const colCount = _keyCols.size() + _accCols.size();
+    char buf[32];
+    for (auto const& entry : _groups) {
+        Group const& g = entry.second;
+        proto::RowBundle* row = result.add_row();
+        for (int col = 0; col < colCount; ++col) {
+            row->add_column();
+            row->add_isnull(false);
+        }
+        for (unsigned k = 0; k < _keyCols.size(); ++k) {
+            row->set_column(_keyCols[k], g.keys[k]);
+            row->set_isnull(_keyCols[k], g.keyIsNull[k]);
+        }
+        for (unsigned a = 0; a < _accCols.size(); ++a) {
+            Accumulator const& acc = g.accs[a];
+            if (acc.isNull) {
+                row->set_isnull(_accCols[a], true);
+            } else if (acc.isInt) {
+                row->set_column(_accCols[a], std::to_string(acc.i));
+            } else {
+                std::snprintf(buf, sizeof(buf), "%.17g", acc.d);
+                row->set_column(_accCols[a], buf);
+            }
+        }
+    }
+    result.set_rowcount(result.row_size());
+    return true;
+}
+
+}}} // namespace lsst::qserv::rproc
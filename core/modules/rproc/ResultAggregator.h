@@ -0,0 +1,140 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_RESULTAGGREGATOR_H
+#define LSST_QSERV_RPROC_RESULTAGGREGATOR_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations
+namespace lsst {
+namespace qserv {
+namespace proto {
+    class Result;
+}
+namespace query {
+    class SelectStmt;
+}
+}} // End of forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// ResultAggregator folds worker Result rows of an aggregate query into
+/// one row per group, in memory.
+///
+/// Worker results of an aggregate query carry partial aggregates (QS1_SUM,
+/// QS2_COUNT...) that the merge statement combines with SUM, MIN or MAX.
+/// Those combinations are themselves re-aggregable, so folding rows with
+/// the same GROUP BY key ahead of time and loading only the folded rows
+/// leaves the merge statement's result unchanged, while the merge table
+/// shrinks from one row per chunk and group to one row per group.
+///
+/// Folding gives up (see fold()) on anything it cannot reproduce exactly,
+/// e.g. DECIMAL columns, non-numeric values or integer overflow. The
+/// caller then loads what has been folded so far with exportTo() and
+/// merges the remaining rows through MySQL as usual.
+///
+/// ResultAggregator is not thread-safe.
+class ResultAggregator {
+public:
+    typedef std::shared_ptr<ResultAggregator> Ptr;
+
+    /// How a merge table column is combined across worker results.
+    enum Op { SUM, MIN, MAX };
+    /// Combining op per merge table column, keyed by lower-case name
+    typedef std::map<std::string, Op> OpMap;
+
+    /// @param ops combining op for each aggregated column
+    /// @param groupKeys lower-case names of the GROUP BY columns
+    /// @param maxGroups give up past this many groups
+    ResultAggregator(OpMap const& ops, std::set<std::string> const& groupKeys,
+                     std::size_t maxGroups=defaultMaxGroups);
+
+    /// @return an aggregator for results merged by mergeStmt, or nullptr if
+    /// mergeStmt does anything other than combine columns with SUM, MIN and
+    /// MAX, grouped by plain columns. DISTINCT is accepted, as mergeStmt
+    /// still runs over the folded rows.
+    static Ptr newAggregator(query::SelectStmt& mergeStmt);
+
+    /// Fold the rows of result into the accumulators.
+    /// @return the number of leading rows of result that were folded. If
+    /// less than result.row_size(), the aggregator has given up and folds
+    /// nothing more.
+    int fold(proto::Result const& result);
+
+    /// @return true until fold() has given up
+    bool isActive() const { return _active; }
+
+    /// Append the folded rows, one per group, to result and copy the row
+    /// schema of the folded results into it.
+    /// @return false if nothing has been folded
+    bool exportTo(proto::Result& result) const;
+
+    std::size_t getGroupCount() const { return _groups.size(); }
+    std::uint64_t getFoldedRowCount() const { return _foldedRows; }
+
+    static std::size_t const defaultMaxGroups = 1000000;
+
+private:
+    /// Running value of one aggregated column within a group.
+    struct Accumulator {
+        bool isNull{true};
+        bool isInt{true};
+        std::int64_t i{0};
+        double d{0};
+    };
+    /// Folded state of one group: its key cells and accumulators.
+    struct Group {
+        std::vector<std::string> keys;
+        std::vector<bool> keyIsNull;
+        std::vector<Accumulator> accs;
+    };
+
+    bool _initSchema(proto::Result const& result);
+    bool _combine(Op op, Accumulator& acc, std::string const& value) const;
+
+    OpMap const _ops;
+    std::set<std::string> const _groupKeys;
+    std::size_t const _maxGroups;
+
+    bool _active{true};
+    bool _hasSchema{false};
+    std::string _schema; ///< Serialized RowSchema of the first result
+    std::vector<int> _keyCols; ///< Result column index of each key
+    std::vector<int> _accCols; ///< Result column index of each accumulator
+    std::vector<Op> _accOps; ///< Combining op of each accumulator
+    std::unordered_map<std::string, Group> _groups;
+    std::uint64_t _foldedRows{0};
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_RESULTAGGREGATOR_H
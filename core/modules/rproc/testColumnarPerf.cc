@@ -0,0 +1,151 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Benchmark of result protocol 2 (RowBundles) against protocol 3
+/// (ColumnarRows) on a float-heavy, Object-like result: worker encoding
+/// from MySQL text cells, message size, czar decoding and LOAD DATA
+/// encoding. It is not run as a unit test; run it by hand.
+/// Usage: testColumnarPerf [rows]
+
+// System headers
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/ColumnarRows.h"
+#include "proto/worker.pb.h"
+#include "rproc/ProtoRowBuffer.h"
+
+namespace proto = lsst::qserv::proto;
+namespace rproc = lsst::qserv::rproc;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int const nIntCols = 2;
+int const nDoubleCols = 30;
+
+/// MySQL text cells of one result row: ids, then doubles.
+struct TextRows {
+    std::vector<std::string> cells;
+    int nRows;
+    int nCols;
+};
+
+void makeTextRows(TextRows& t, int nRows) {
+    std::mt19937 gen(777);
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    t.nRows = nRows;
+    t.nCols = nIntCols + nDoubleCols;
+    char buf[32];
+    for(int r=0; r < nRows; ++r) {
+        t.cells.push_back(std::to_string(386942193000000000LL + r));
+        t.cells.push_back(std::to_string(r % 1000));
+        for(int c=0; c < nDoubleCols; ++c) {
+            std::snprintf(buf, sizeof(buf), "%.17g", dist(gen));
+            t.cells.push_back(buf);
+        }
+    }
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void runCase(std::string const& name, TextRows const& t, bool columnar) {
+    proto::Result result;
+    result.mutable_rowschema();
+    result.set_continues(false);
+    result.set_queryid(1);
+    result.set_jobid(1);
+    result.set_largeresult(false);
+    result.set_rowcount(t.nRows);
+    result.set_transmitsize(0);
+    auto start = Clock::now();
+    std::vector<char const*> row(t.nCols);
+    std::vector<unsigned long> lengths(t.nCols);
+    std::unique_ptr<proto::ColumnarRowsBuilder> builder;
+    if (columnar) {
+        std::vector<proto::ResultColumn::Encoding> encodings(nIntCols, proto::ResultColumn::INT64);
+        encodings.resize(t.nCols, proto::ResultColumn::DOUBLE);
+        builder.reset(new proto::ColumnarRowsBuilder(*result.mutable_columnar(), encodings));
+    }
+    for(int r=0; r < t.nRows; ++r) {
+        for(int c=0; c < t.nCols; ++c) {
+            std::string const& cell = t.cells[r * t.nCols + c];
+            row[c] = cell.c_str();
+            lengths[c] = cell.size();
+        }
+        if (columnar) {
+            builder->addRow(&row[0], &lengths[0]);
+        } else {
+            proto::RowBundle* rb = result.add_row();
+            for(int c=0; c < t.nCols; ++c) {
+                rb->add_column(row[c], lengths[c]);
+                rb->add_isnull(false);
+            }
+        }
+    }
+    std::string msg;
+    result.SerializeToString(&msg);
+    double encodeSec = secondsSince(start);
+
+    start = Clock::now();
+    proto::Result decoded;
+    decoded.ParseFromString(msg);
+    double decodeSec = secondsSince(start);
+
+    start = Clock::now();
+    auto rowBuffer = rproc::newProtoRowBuffer(decoded);
+    std::vector<char> buffer(1024*1024);
+    unsigned long long loadBytes = 0;
+    while(unsigned fetched = rowBuffer->fetch(&buffer[0], buffer.size())) {
+        loadBytes += fetched;
+    }
+    double loadSec = secondsSince(start);
+
+    std::cout << name << ": rows=" << t.nRows
+              << " msgMB=" << msg.size() / (1024.0 * 1024.0)
+              << " encodeSec=" << encodeSec
+              << " decodeSec=" << decodeSec
+              << " loadDataSec=" << loadSec
+              << " loadDataMB=" << loadBytes / (1024.0 * 1024.0) << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int nRows = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    TextRows t;
+    makeTextRows(t, nRows);
+    runCase("protocol2", t, false);
+    runCase("protocol3", t, true);
+    return 0;
+}
@@ -0,0 +1,160 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "rproc/MergeShards.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE MergeShards_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::rproc::MergeShards;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Tables) {
+    MergeShards shards("r.result_1_m", 3);
+    BOOST_CHECK_EQUAL(shards.size(), 3);
+    BOOST_CHECK_EQUAL(shards.getTable(0), "r.result_1_m");
+    BOOST_CHECK_EQUAL(shards.getTable(1), "r.result_1_m_s1");
+    BOOST_CHECK_EQUAL(shards.getTable(2), "r.result_1_m_s2");
+    // The merge table is created up front, shards on first use.
+    BOOST_CHECK(!shards.needsTable(0));
+    BOOST_CHECK(shards.needsTable(1));
+    BOOST_CHECK(shards.needsTable(2));
+
+    MergeShards one("r.result_2", 0);
+    BOOST_CHECK_EQUAL(one.size(), 1);
+    BOOST_CHECK_EQUAL(one.getTable(0), "r.result_2");
+}
+
+BOOST_AUTO_TEST_CASE(Selection) {
+    MergeShards shards("m", 3);
+    // Without concurrency every load stays on the merge table.
+    for (int j = 0; j < 5; ++j) {
+        int id = shards.acquire();
+        BOOST_CHECK_EQUAL(id, 0);
+        shards.release(id, 1);
+    }
+    // Concurrent loads get the lowest idle shard.
+    int a = shards.acquire();
+    int b = shards.acquire();
+    int c = shards.acquire();
+    BOOST_CHECK_EQUAL(a, 0);
+    BOOST_CHECK_EQUAL(b, 1);
+    BOOST_CHECK_EQUAL(c, 2);
+    shards.release(b, 0);
+    BOOST_CHECK_EQUAL(shards.acquire(), 1);
+    shards.release(a, 0);
+    shards.release(1, 0);
+    shards.release(c, 0);
+    BOOST_CHECK_EQUAL(shards.acquire(), 0);
+    shards.release(0, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Exclusive) {
+    // A shard is never held by two loads at once, and a load waits when
+    // all shards are held.
+    int const nShards = 2;
+    MergeShards shards("m", nShards);
+    std::vector<std::atomic<int>> holders(nShards);
+    for (auto& h : holders) h = 0;
+    std::atomic<int> overlaps{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 500; ++j) {
+                int id = shards.acquire();
+                if (++holders[id] != 1) ++overlaps;
+                --holders[id];
+                shards.release(id, 2);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    BOOST_CHECK_EQUAL(overlaps, 0);
+    auto total = shards.getTotal();
+    BOOST_CHECK_EQUAL(total.loads, 8u * 500);
+    BOOST_CHECK_EQUAL(total.rows, 8u * 500 * 2);
+}
+
+BOOST_AUTO_TEST_CASE(Accounting) {
+    MergeShards shards("m", 3);
+    int a = shards.acquire();
+    int b = shards.acquire();
+    shards.release(b, 7);
+    shards.release(a, 10);
+    a = shards.acquire();
+    b = shards.acquire();
+    shards.release(a, 5);
+    shards.release(b, 100, false); // failed load, not counted
+
+    BOOST_CHECK_EQUAL(shards.getStats(0).loads, 2u);
+    BOOST_CHECK_EQUAL(shards.getStats(0).rows, 15u);
+    BOOST_CHECK_EQUAL(shards.getStats(1).loads, 1u);
+    BOOST_CHECK_EQUAL(shards.getStats(1).rows, 7u);
+    BOOST_CHECK_EQUAL(shards.getStats(2).loads, 0u);
+    BOOST_CHECK_EQUAL(shards.getTotal().loads, 3u);
+    BOOST_CHECK_EQUAL(shards.getTotal().rows, 22u);
+}
+
+BOOST_AUTO_TEST_CASE(Consolidate) {
+    MergeShards shards("m", 4);
+    int ids[3];
+    for (auto& id : ids) id = shards.acquire();
+    for (auto id : ids) {
+        if (id != 0) shards.setTableReady(id);
+    }
+    shards.release(ids[0], 4);
+    shards.release(ids[1], 6);
+    shards.release(ids[2], 8);
+
+    // Shard 3 was never used, so it has no table to fold.
+    auto tables = shards.consolidate();
+    BOOST_REQUIRE_EQUAL(tables.size(), 2u);
+    BOOST_CHECK_EQUAL(tables[0], "m_s1");
+    BOOST_CHECK_EQUAL(tables[1], "m_s2");
+
+    // All rows are now accounted to the merge table.
+    BOOST_CHECK_EQUAL(shards.getStats(0).rows, 18u);
+    BOOST_CHECK_EQUAL(shards.getStats(0).loads, 3u);
+    for (int j = 1; j < shards.size(); ++j) {
+        BOOST_CHECK_EQUAL(shards.getStats(j).rows, 0u);
+        BOOST_CHECK(shards.needsTable(j));
+    }
+    BOOST_CHECK_EQUAL(shards.getTotal().rows, 18u);
+
+    // Folded shards are dropped, so nothing is left to fold.
+    BOOST_CHECK(shards.consolidate().empty());
+    BOOST_CHECK_EQUAL(shards.getStats(0).rows, 18u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
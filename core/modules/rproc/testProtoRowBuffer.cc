@@ -21,7 +21,11 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+// System headers
+#include <random>
+
 // Qserv headers
+#include "proto/ColumnarRows.h"
 #include "proto/worker.pb.h"
 #include "proto/FakeProtocolFixture.h"
 
@@ -37,6 +41,33 @@ namespace gio = google::protobuf::io;
 struct Fixture {
     Fixture(void) {}
     ~Fixture(void) { }
+
+    /// Fill result with nRows rows of three columns, the last one null.
+    void makeResult(lsst::qserv::proto::Result& result, int nRows) {
+        result.mutable_rowschema();
+        for(int i=0; i < nRows; ++i) {
+            lsst::qserv::proto::RowBundle* rb = result.add_row();
+            rb->add_column(std::to_string(i));
+            rb->add_isnull(false);
+            rb->add_column(std::string("tab\there ") + std::string(i % 7, 'x'));
+            rb->add_isnull(false);
+            rb->add_column("");
+            rb->add_isnull(true);
+        }
+    }
+
+    /// Drain a RowBuffer using fetch() calls of at most bufLen bytes.
+    std::string drain(lsst::qserv::mysql::RowBuffer& rowBuffer, unsigned bufLen) {
+        std::string out;
+        std::vector<char> buffer(bufLen);
+        while(true) {
+            unsigned fetched = rowBuffer.fetch(&buffer[0], bufLen);
+            if (fetched == 0) break;
+            BOOST_REQUIRE(fetched <= bufLen);
+            out.append(&buffer[0], fetched);
+        }
+        return out;
+    }
 };
 using lsst::qserv::rproc::copyColumn;
 using lsst::qserv::rproc::escapeString;
@@ -68,6 +99,30 @@ BOOST_AUTO_TEST_CASE(TestEscapeEmptyString) {
     BOOST_CHECK_EQUAL(target.substr(0, count), "");
 }
 
+BOOST_AUTO_TEST_CASE(TestEscapeBufferKernels) {
+    // Random binary blobs, biased towards bytes that need escaping, of
+    // lengths covering the vector block sizes and their tails.
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    std::uniform_int_distribution<int> specialDist(0, 5);
+    char const specials[] = {'\0', '\b', '\n', '\r', '\t', '\032'};
+    for(auto const& kernel : lsst::qserv::rproc::escapeBufferKernels()) {
+        for(int trial=0; trial < 2000; ++trial) {
+            std::string src(trial % 131, 'X');
+            for(auto& c : src) {
+                c = (byteDist(gen) < 16) ? specials[specialDist(gen)]
+                                         : static_cast<char>(byteDist(gen));
+            }
+            std::string expected(src.size() * 2, 'X');
+            int eCount = escapeString(expected.begin(), src.begin(), src.end());
+            std::string target(src.size() * 2, 'X');
+            std::size_t count = kernel.func(&target[0], src.data(), src.size());
+            BOOST_REQUIRE_EQUAL(count, static_cast<std::size_t>(eCount));
+            BOOST_REQUIRE_EQUAL(target.substr(0, count), expected.substr(0, eCount));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TestCopyColumn) {
     std::string simple = "Hello my name is bob";
     std::string eSimple = "'" + simple + "'";
@@ -77,4 +132,76 @@ BOOST_AUTO_TEST_CASE(TestCopyColumn) {
     BOOST_CHECK_EQUAL(target, eSimple);
 }
 
+BOOST_AUTO_TEST_CASE(TestFetch) {
+    lsst::qserv::proto::Result result;
+    makeResult(result, 3);
+    std::string expected = "'0'\t'tab\\there '\t\\N\n"
+        "'1'\t'tab\\there x'\t\\N\n"
+        "'2'\t'tab\\there xx'\t\\N";
+    auto rowBuffer = lsst::qserv::rproc::newProtoRowBuffer(result);
+    BOOST_CHECK_EQUAL(drain(*rowBuffer, 4096), expected);
+}
+
+BOOST_AUTO_TEST_CASE(TestFetchPartialRows) {
+    lsst::qserv::proto::Result result;
+    makeResult(result, 100);
+    std::string expected = drain(*lsst::qserv::rproc::newProtoRowBuffer(result), 1 << 20);
+    // Buffers smaller than a row, and sizes that split rows at odd offsets.
+    for(unsigned bufLen : {1, 2, 7, 31, 64, 1000}) {
+        auto rowBuffer = lsst::qserv::rproc::newProtoRowBuffer(result);
+        BOOST_CHECK_EQUAL(drain(*rowBuffer, bufLen), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestFetchEmpty) {
+    lsst::qserv::proto::Result result;
+    makeResult(result, 0);
+    auto rowBuffer = lsst::qserv::rproc::newProtoRowBuffer(result);
+    BOOST_CHECK_EQUAL(drain(*rowBuffer, 100), "");
+}
+
+BOOST_AUTO_TEST_CASE(TestFetchColumnar) {
+    // The same cells as protocol 2 rows and as protocol 3 columns must
+    // load identically.
+    using lsst::qserv::proto::ResultColumn;
+    lsst::qserv::proto::Result rowResult;
+    lsst::qserv::proto::Result colResult;
+    lsst::qserv::proto::ColumnarRowsBuilder builder(
+        *colResult.mutable_columnar(),
+        {ResultColumn::INT64, ResultColumn::DOUBLE, ResultColumn::TEXT, ResultColumn::INT64});
+    for(int i=0; i < 100; ++i) {
+        std::string cells[] = {std::to_string(i - 50), std::to_string(i * 0.25),
+                               std::string("tab\there ") + std::string(i % 7, 'x'),
+                               "18446744073709551615"}; // falls back to TEXT
+        // std::to_string pads doubles with zeros, MySQL does not.
+        cells[1].erase(cells[1].find_last_not_of('0') + 1);
+        if (cells[1].back() == '.') cells[1].pop_back();
+        char const* row[4];
+        unsigned long lengths[4];
+        lsst::qserv::proto::RowBundle* rb = rowResult.add_row();
+        for(int c=0; c < 4; ++c) {
+            bool isNull = (i + c) % 9 == 0;
+            row[c] = isNull ? nullptr : cells[c].c_str();
+            lengths[c] = cells[c].size();
+            rb->add_column(isNull ? std::string() : cells[c]);
+            rb->add_isnull(isNull);
+        }
+        builder.addRow(row, lengths);
+    }
+    BOOST_CHECK_EQUAL(colResult.columnar().column(0).encoding(), ResultColumn::INT64);
+    BOOST_CHECK_EQUAL(colResult.columnar().column(1).encoding(), ResultColumn::DOUBLE);
+    BOOST_CHECK_EQUAL(colResult.columnar().column(3).encoding(), ResultColumn::TEXT);
+
+    std::string expected = drain(*lsst::qserv::rproc::newProtoRowBuffer(rowResult), 1 << 20);
+    for(unsigned bufLen : {1, 7, 64, 1 << 20}) {
+        auto rowBuffer = lsst::qserv::rproc::newProtoRowBuffer(colResult);
+        BOOST_CHECK_EQUAL(drain(*rowBuffer, bufLen), expected);
+    }
+
+    // Converted back to rows, for in-memory aggregation.
+    lsst::qserv::proto::Result converted;
+    lsst::qserv::proto::ColumnarRowsReader(colResult.columnar()).appendRowsTo(converted);
+    BOOST_CHECK_EQUAL(drain(*lsst::qserv::rproc::newProtoRowBuffer(converted), 1 << 20), expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// Micro-benchmark for ProtoRowBuffer::fetch() and the escapeBuffer()
+/// kernels. It is not run as a unit test; run it by hand and compare the
+/// MB/s figures between builds.
+/// Usage: testProtoRowBufferPerf [rows [bufferSize]]
+
+// System headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "rproc/EscapeBuffer.h"
+#include "rproc/ProtoRowBuffer.h"
+
+namespace proto = lsst::qserv::proto;
+namespace rproc = lsst::qserv::rproc;
+
+namespace {
+
+/// Build a Result message of nRows rows and nCols numeric-looking columns.
+void makeResult(proto::Result& result, int nRows, int nCols) {
+    auto schema = result.mutable_rowschema();
+    for(int c=0; c < nCols; ++c) {
+        auto cs = schema->add_columnschema();
+        cs->set_name("col" + std::to_string(c));
+        cs->set_hasdefault(false);
+        cs->set_sqltype("DOUBLE");
+    }
+    for(int r=0; r < nRows; ++r) {
+        proto::RowBundle* rb = result.add_row();
+        for(int c=0; c < nCols; ++c) {
+            rb->add_column(std::to_string(r * 1.000123 + c));
+            rb->add_isnull((r + c) % 17 == 0);
+        }
+    }
+}
+
+/// Drain the whole Result through fetch() and report throughput.
+void runCase(std::string const& name, int nRows, int nCols, unsigned bufLen) {
+    proto::Result result;
+    makeResult(result, nRows, nCols);
+    std::vector<char> buffer(bufLen);
+    unsigned long long total = 0;
+    unsigned long long calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto rowBuffer = rproc::newProtoRowBuffer(result);
+    while(true) {
+        unsigned fetched = rowBuffer->fetch(&buffer[0], bufLen);
+        if (fetched == 0) break;
+        total += fetched;
+        ++calls;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double mb = total / (1024.0 * 1024.0);
+    std::cout << name << ": rows=" << nRows << " cols=" << nCols
+              << " bytes=" << total << " fetches=" << calls
+              << " seconds=" << elapsed.count()
+              << " MB/s=" << mb / elapsed.count() << std::endl;
+}
+
+/// Escape src repeatedly with every available kernel and report throughput.
+void runEscape(std::string const& name, std::string const& src) {
+    std::vector<char> dest(2 * src.size());
+    int const reps = 20;
+    for(auto const& kernel : rproc::escapeBufferKernels()) {
+        std::size_t written = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0; i < reps; ++i) {
+            written += kernel.func(&dest[0], src.data(), src.size());
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double mb = (src.size() * static_cast<double>(reps)) / (1024.0 * 1024.0);
+        std::cout << "escape " << name << " " << kernel.name
+                  << ": written=" << written
+                  << " MB/s=" << mb / elapsed.count() << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int nRows = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    unsigned bufLen = (argc > 2) ? std::atoi(argv[2]) : 1024*1024;
+    runCase("narrow", nRows, 4, bufLen);
+    runCase("wide", nRows / 10, 300, bufLen);
+
+    // Numeric text, which needs no escaping, and random binary blobs.
+    std::string numeric;
+    while(numeric.size() < 32*1024*1024) {
+        numeric += std::to_string(numeric.size() * 0.000731);
+    }
+    std::string binary(numeric.size(), '\0');
+    std::mt19937 gen(4321);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    for(auto& c : binary) c = static_cast<char>(byteDist(gen));
+    std::cout << "escapeBuffer uses " << rproc::escapeBufferKernel() << std::endl;
+    runEscape("numeric", numeric);
+    runEscape("binary", binary);
+    return 0;
+}
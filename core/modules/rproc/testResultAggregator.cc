@@ -0,0 +1,215 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <map>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "parser/SelectParser.h"
+#include "proto/worker.pb.h"
+#include "query/SelectStmt.h"
+#include "rproc/ResultAggregator.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ResultAggregator_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::parser::SelectParser;
+using lsst::qserv::proto::Result;
+using lsst::qserv::rproc::ResultAggregator;
+
+struct Fixture {
+    Fixture(void) {
+        ops["qs1_count"] = ResultAggregator::SUM;
+        ops["qs2_min"] = ResultAggregator::MIN;
+        ops["qs3_max"] = ResultAggregator::MAX;
+        keys.insert("filterid");
+    }
+    ~Fixture(void) { }
+
+    /// Make a result with columns filterId, QS1_COUNT, QS2_MIN, QS3_MAX.
+    /// Empty strings in a row stand for NULL.
+    void makeResult(Result& r, std::vector<std::vector<std::string>> const& rows) {
+        auto rs = r.mutable_rowschema();
+        for (auto const& name : {"filterId", "QS1_COUNT", "QS2_MIN", "QS3_MAX"}) {
+            auto cs = rs->add_columnschema();
+            cs->set_name(name);
+            cs->set_hasdefault(false);
+            cs->set_sqltype("BIGINT");
+        }
+        for (auto const& row : rows) {
+            auto rb = r.add_row();
+            for (auto const& cell : row) {
+                rb->add_column(cell);
+                rb->add_isnull(cell.empty());
+            }
+        }
+    }
+
+    /// @return exported rows keyed by their first column
+    std::map<std::string, std::vector<std::string>> exported(ResultAggregator const& agg) {
+        Result r;
+        std::map<std::string, std::vector<std::string>> rows;
+        if (!agg.exportTo(r)) return rows;
+        BOOST_CHECK_EQUAL(r.rowschema().columnschema_size(), 4);
+        for (int j = 0; j < r.row_size(); ++j) {
+            std::vector<std::string> cells;
+            for (int c = 0; c < r.row(j).column_size(); ++c) {
+                cells.push_back(r.row(j).isnull(c) ? "NULL" : r.row(j).column(c));
+            }
+            rows[cells[0]] = cells;
+        }
+        return rows;
+    }
+
+    /// @return the aggregator for merge statement sql, nullptr if it has none
+    ResultAggregator::Ptr newAggregator(std::string const& sql) {
+        SelectParser::Ptr p = SelectParser::newInstance(sql);
+        p->setup();
+        return ResultAggregator::newAggregator(*p->getSelectStmt());
+    }
+
+    ResultAggregator::OpMap ops;
+    std::set<std::string> keys;
+};
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(FoldGroups) {
+    ResultAggregator agg(ops, keys);
+    Result r1, r2;
+    makeResult(r1, {{"1", "10", "5", "7"}, {"2", "3", "-1", "2.5"}});
+    makeResult(r2, {{"1", "4", "6", "9"}, {"2", "1", "", ""}, {"3", "2", "0", "0"}});
+    BOOST_CHECK_EQUAL(agg.fold(r1), 2);
+    BOOST_CHECK_EQUAL(agg.fold(r2), 3);
+    BOOST_CHECK(agg.isActive());
+    BOOST_CHECK_EQUAL(agg.getGroupCount(), 3u);
+    BOOST_CHECK_EQUAL(agg.getFoldedRowCount(), 5u);
+    auto rows = exported(agg);
+    BOOST_REQUIRE_EQUAL(rows.size(), 3u);
+    BOOST_CHECK_EQUAL(rows["1"][1], "14");
+    BOOST_CHECK_EQUAL(rows["1"][2], "5");
+    BOOST_CHECK_EQUAL(rows["1"][3], "9");
+    BOOST_CHECK_EQUAL(rows["2"][1], "4");
+    BOOST_CHECK_EQUAL(rows["2"][2], "-1");
+    BOOST_CHECK_EQUAL(rows["2"][3], "2.5");
+    BOOST_CHECK_EQUAL(rows["3"][1], "2");
+}
+
+BOOST_AUTO_TEST_CASE(NullKeyAndValues) {
+    ResultAggregator agg(ops, keys);
+    Result r;
+    makeResult(r, {{"", "1", "", ""}, {"", "2", "", ""}});
+    BOOST_CHECK_EQUAL(agg.fold(r), 2);
+    auto rows = exported(agg);
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows["NULL"][1], "3");
+    BOOST_CHECK_EQUAL(rows["NULL"][2], "NULL");
+}
+
+BOOST_AUTO_TEST_CASE(GiveUpOnNonNumeric) {
+    ResultAggregator agg(ops, keys);
+    Result r;
+    makeResult(r, {{"1", "1", "1", "1"}, {"1", "1", "abc", "1"}, {"1", "1", "1", "1"}});
+    BOOST_CHECK_EQUAL(agg.fold(r), 1);
+    BOOST_CHECK(!agg.isActive());
+    // The failed row must not have been partially applied.
+    auto rows = exported(agg);
+    BOOST_CHECK_EQUAL(rows["1"][1], "1");
+    BOOST_CHECK_EQUAL(agg.fold(r), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GiveUpOnOverflow) {
+    ResultAggregator agg(ops, keys);
+    Result r;
+    makeResult(r, {{"1", "9223372036854775807", "1", "1"}, {"1", "1", "1", "1"}});
+    BOOST_CHECK_EQUAL(agg.fold(r), 1);
+    BOOST_CHECK(!agg.isActive());
+}
+
+BOOST_AUTO_TEST_CASE(GiveUpOnTooManyGroups) {
+    ResultAggregator agg(ops, keys, 2);
+    Result r;
+    makeResult(r, {{"1", "1", "1", "1"}, {"2", "1", "1", "1"}, {"1", "1", "1", "1"},
+                   {"3", "1", "1", "1"}});
+    BOOST_CHECK_EQUAL(agg.fold(r), 3);
+    BOOST_CHECK_EQUAL(agg.getGroupCount(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(UnknownColumn) {
+    ResultAggregator::OpMap partialOps;
+    partialOps["qs1_count"] = ResultAggregator::SUM;
+    ResultAggregator agg(partialOps, keys);
+    Result r;
+    makeResult(r, {{"1", "1", "1", "1"}});
+    BOOST_CHECK_EQUAL(agg.fold(r), 0);
+    BOOST_CHECK(!agg.isActive());
+    BOOST_CHECK(exported(agg).empty());
+}
+
+BOOST_AUTO_TEST_CASE(AcceptMergeStmt) {
+    auto agg = newAggregator("SELECT filterId, SUM(QS1_COUNT) AS n, MIN(QS2_MIN), max(qs3_max) "
+                             "FROM m GROUP BY filterId");
+    BOOST_REQUIRE(agg);
+    Result r;
+    makeResult(r, {{"1", "10", "5", "7"}, {"1", "4", "6", "9"}});
+    BOOST_CHECK_EQUAL(agg->fold(r), 2);
+    BOOST_CHECK(agg->isActive());
+    BOOST_CHECK_EQUAL(exported(*agg)["1"][1], "14");
+
+    // No grouping
+    BOOST_CHECK(newAggregator("SELECT SUM(QS1_COUNT), MIN(QS2_MIN) FROM m"));
+    // Aggregates within expressions, as AVG is merged
+    BOOST_CHECK(newAggregator("SELECT filterId, SUM(QS1_SUM)/SUM(QS2_COUNT) AS a, MAX(QS3_MAX)+1 "
+                              "FROM m GROUP BY filterId"));
+    // The same column combined the same way twice
+    BOOST_CHECK(newAggregator("SELECT SUM(QS1_COUNT), SUM(QS1_COUNT)*2 FROM m"));
+    // DISTINCT is applied by the merge statement, which runs over the folded rows.
+    BOOST_CHECK(newAggregator("SELECT DISTINCT filterId, SUM(QS1_COUNT) FROM m GROUP BY filterId"));
+    BOOST_CHECK(newAggregator("SELECT DISTINCT SUM(QS1_COUNT) FROM m GROUP BY filterId"));
+}
+
+BOOST_AUTO_TEST_CASE(RejectMergeStmt) {
+    // Columns outside aggregates that are not group keys
+    BOOST_CHECK(!newAggregator("SELECT filterId, SUM(QS1_COUNT) FROM m"));
+    BOOST_CHECK(!newAggregator("SELECT filterId, objectId, SUM(QS1_COUNT) FROM m GROUP BY filterId"));
+    BOOST_CHECK(!newAggregator("SELECT DISTINCT objectId, SUM(QS1_COUNT) FROM m GROUP BY filterId"));
+    // Nothing to fold
+    BOOST_CHECK(!newAggregator("SELECT filterId FROM m GROUP BY filterId"));
+    BOOST_CHECK(!newAggregator("SELECT DISTINCT filterId FROM m"));
+    BOOST_CHECK(!newAggregator("SELECT * FROM m"));
+    // One column combined two ways
+    BOOST_CHECK(!newAggregator("SELECT SUM(QS1_COUNT), MAX(QS1_COUNT) FROM m"));
+    // Aggregates other than SUM, MIN and MAX, or not over a plain column
+    BOOST_CHECK(!newAggregator("SELECT filterId, SUM(QS1_COUNT), AVG(QS2_MIN) FROM m GROUP BY filterId"));
+    BOOST_CHECK(!newAggregator("SELECT COUNT(*) FROM m"));
+    BOOST_CHECK(!newAggregator("SELECT SUM(QS1_COUNT + QS2_MIN) FROM m"));
+    // Filtering
+    BOOST_CHECK(!newAggregator("SELECT SUM(QS1_COUNT) FROM m WHERE filterId = 1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,369 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/DoubleToString.h"
+
+// System headers
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/// A floating point number f * 2^e with a 64 bit significand.
+struct DiyFp {
+    DiyFp() : f(0), e(0) {}
+    DiyFp(std::uint64_t f_, int e_) : f(f_), e(e_) {}
+
+    explicit DiyFp(double d) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        int const biasedE = static_cast<int>((bits & expMask) >> 52);
+        std::uint64_t const significand = bits & significandMask;
+        if (biasedE != 0) {
+            f = significand + hiddenBit;
+            e = biasedE - expBias;
+        } else {
+            f = significand;
+            e = 1 - expBias;
+        }
+    }
+
+    DiyFp operator-(DiyFp const& rhs) const { return DiyFp(f - rhs.f, e); }
+
+    /// Product rounded to 64 bits.
+    DiyFp operator*(DiyFp const& rhs) const {
+        std::uint64_t const m32 = 0xFFFFFFFF;
+        std::uint64_t const a = f >> 32, b = f & m32;
+        std::uint64_t const c = rhs.f >> 32, d = rhs.f & m32;
+        std::uint64_t const ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+        tmp += 1U << 31;
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+    }
+
+    DiyFp normalize() const {
+        DiyFp res = *this;
+        while (!(res.f & hiddenBit)) {
+            res.f <<= 1;
+            --res.e;
+        }
+        res.f <<= 11;
+        res.e -= 11;
+        return res;
+    }
+
+    /// Compute the normalized boundaries m- and m+ halfway to the
+    /// neighbouring doubles. Both get the exponent of m+.
+    void normalizedBoundaries(DiyFp& minus, DiyFp& plus) const {
+        DiyFp pl(DiyFp((f << 1) + 1, e - 1));
+        while (!(pl.f & (hiddenBit << 1))) {
+            pl.f <<= 1;
+            --pl.e;
+        }
+        pl.f <<= 10;
+        pl.e -= 10;
+        DiyFp mi = (f == hiddenBit) ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+        mi.f <<= mi.e - pl.e;
+        mi.e = pl.e;
+        minus = mi;
+        plus = pl;
+    }
+
+    static std::uint64_t const expMask = 0x7FF0000000000000ULL;
+    static std::uint64_t const significandMask = 0x000FFFFFFFFFFFFFULL;
+    static std::uint64_t const hiddenBit = 0x0010000000000000ULL;
+    static int const expBias = 0x3FF + 52;
+
+    std::uint64_t f;
+    int e;
+};
+
+/// Normalized, rounded 10^k for k = -348, -340, ..., 340, computed once
+/// with exact big integer arithmetic.
+class CachedPowers {
+public:
+    static int const minExp10 = -348;
+    static int const count = 87;
+
+    CachedPowers() {
+        for (int i = 0; i < count; ++i) {
+            _powers[i] = _pow10(minExp10 + 8 * i);
+        }
+    }
+
+    DiyFp const& get(int i) const { return _powers[i]; }
+
+private:
+    typedef std::vector<std::uint32_t> Big; // little endian 32 bit limbs
+
+    static Big _bigPow10(int k) {
+        Big b(1, 1);
+        for (int i = 0; i < k; ++i) {
+            std::uint64_t carry = 0;
+            for (auto& limb : b) {
+                std::uint64_t const v = static_cast<std::uint64_t>(limb) * 10 + carry;
+                limb = static_cast<std::uint32_t>(v);
+                carry = v >> 32;
+            }
+            if (carry) b.push_back(static_cast<std::uint32_t>(carry));
+        }
+        return b;
+    }
+
+    static int _bitLength(Big const& b) {
+        int n = 32 * (b.size() - 1);
+        for (std::uint32_t top = b.back(); top; top >>= 1) ++n;
+        return n;
+    }
+
+    static bool _bit(Big const& b, int i) {
+        return (b[i / 32] >> (i % 32)) & 1;
+    }
+
+    static DiyFp _pow10(int k) {
+        if (k >= 0) {
+            Big const p = _bigPow10(k);
+            int const len = _bitLength(p);
+            std::uint64_t f = 0;
+            for (int i = len - 1; i >= 0 && i >= len - 64; --i) {
+                f = (f << 1) | _bit(p, i);
+            }
+            if (len <= 64) {
+                return DiyFp(f << (64 - len), len - 64);
+            }
+            if (_bit(p, len - 65) && ++f == 0) {
+                return DiyFp(1ULL << 63, len - 63);
+            }
+            return DiyFp(f, len - 64);
+        }
+        // 10^k = 2^-n * (2^n / 10^-k), with n such that the quotient has
+        // 65 bits; the last one rounds the 64 bit significand.
+        Big const d = _bigPow10(-k);
+        int const n = _bitLength(d) + 64;
+        Big r(d.size() + 1, 0);
+        std::uint64_t qLo = 0;
+        for (int i = n; i >= 0; --i) {
+            std::uint32_t carry = (i == n) ? 1 : 0;
+            for (auto& limb : r) {
+                std::uint32_t const next = limb >> 31;
+                limb = (limb << 1) | carry;
+                carry = next;
+            }
+            bool ge = true;
+            for (int j = r.size() - 1; j >= 0; --j) {
+                std::uint32_t const dj = (j < static_cast<int>(d.size())) ? d[j] : 0;
+                if (r[j] != dj) {
+                    ge = r[j] > dj;
+                    break;
+                }
+            }
+            if (ge) {
+                std::int64_t borrow = 0;
+                for (unsigned j = 0; j < r.size(); ++j) {
+                    std::int64_t v = static_cast<std::int64_t>(r[j])
+                        - (j < d.size() ? d[j] : 0) - borrow;
+                    borrow = v < 0;
+                    r[j] = static_cast<std::uint32_t>(v + (borrow << 32));
+                }
+                if (i < 64) qLo |= 1ULL << i;
+            }
+        }
+        // The quotient is in (2^64, 2^65), so bit 64 is set.
+        std::uint64_t f = (qLo >> 1) | (1ULL << 63);
+        if (qLo & 1) ++f;
+        return DiyFp(f, 1 - n);
+    }
+
+    DiyFp _powers[count];
+};
+
+CachedPowers const cachedPowers;
+
+/// Get c = 10^-K such that the product with a number of binary exponent e
+/// has an exponent in [-60, -32].
+DiyFp getCachedPower(int e, int& K) {
+    double const dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0) ++k;
+    int const index = (k >> 3) + 1;
+    K = -(CachedPowers::minExp10 + index * 8);
+    return cachedPowers.get(index);
+}
+
+std::uint64_t const pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+void grisuRound(char* buffer, int len, std::uint64_t delta, std::uint64_t rest,
+                std::uint64_t tenKappa, std::uint64_t wpW) {
+    while (rest < wpW && delta - rest >= tenKappa &&
+           (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW)) {
+        --buffer[len - 1];
+        rest += tenKappa;
+    }
+}
+
+int countDecimalDigits(std::uint32_t n) {
+    int digits = 1;
+    while (digits < 10 && n >= pow10[digits]) ++digits;
+    return digits;
+}
+
+void digitGen(DiyFp const& W, DiyFp const& Mp, std::uint64_t delta,
+              char* buffer, int& len, int& K) {
+    DiyFp const one(1ULL << -Mp.e, Mp.e);
+    DiyFp const wpW = Mp - W;
+    std::uint32_t p1 = static_cast<std::uint32_t>(Mp.f >> -one.e);
+    std::uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = countDecimalDigits(p1);
+    len = 0;
+    while (kappa > 0) {
+        std::uint32_t const div = static_cast<std::uint32_t>(pow10[kappa - 1]);
+        std::uint32_t const d = p1 / div;
+        p1 %= div;
+        if (d || len) buffer[len++] = static_cast<char>('0' + d);
+        --kappa;
+        std::uint64_t const tmp = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            K += kappa;
+            grisuRound(buffer, len, delta, tmp, pow10[kappa] << -one.e, wpW.f);
+            return;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char const d = static_cast<char>(p2 >> -one.e);
+        if (d || len) buffer[len++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            K += kappa;
+            int const index = -kappa;
+            grisuRound(buffer, len, delta, p2, one.f, wpW.f * (index < 20 ? pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+/// Generate the digits of a positive value; value = digits * 10^K.
+void grisu2(double value, char* buffer, int& len, int& K) {
+    DiyFp const v(value);
+    DiyFp wMinus, wPlus;
+    v.normalizedBoundaries(wMinus, wPlus);
+    DiyFp const c = getCachedPower(wPlus.e, K);
+    DiyFp const W = v.normalize() * c;
+    DiyFp Wp = wPlus * c;
+    DiyFp Wm = wMinus * c;
+    ++Wm.f;
+    --Wp.f;
+    digitGen(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+char* writeExponent(int K, char* dest) {
+    if (K < 0) {
+        *dest++ = '-';
+        K = -K;
+    }
+    if (K >= 100) {
+        *dest++ = static_cast<char>('0' + K / 100);
+        K %= 100;
+        *dest++ = static_cast<char>('0' + K / 10);
+    } else if (K >= 10) {
+        *dest++ = static_cast<char>('0' + K / 10);
+    }
+    *dest++ = static_cast<char>('0' + K % 10);
+    return dest;
+}
+
+/// Lay out len digits with decimal exponent k, like %g would.
+char* prettify(char* buffer, int len, int k, char* dest) {
+    int const kk = len + k; // 10^(kk-1) <= v < 10^kk
+    if (k >= 0 && kk <= 17) {
+        // 1234e3 -> 1234000
+        std::memcpy(dest, buffer, len);
+        std::memset(dest + len, '0', k);
+        return dest + kk;
+    }
+    if (kk > 0 && kk <= 17) {
+        // 1234e-2 -> 12.34
+        std::memcpy(dest, buffer, kk);
+        dest[kk] = '.';
+        std::memcpy(dest + kk + 1, buffer + kk, len - kk);
+        return dest + len + 1;
+    }
+    if (kk > -5 && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        int const offset = 2 - kk;
+        dest[0] = '0';
+        dest[1] = '.';
+        std::memset(dest + 2, '0', offset - 2);
+        std::memcpy(dest + offset, buffer, len);
+        return dest + len + offset;
+    }
+    // 1234e30 -> 1.234e33
+    *dest++ = buffer[0];
+    if (len > 1) {
+        *dest++ = '.';
+        std::memcpy(dest, buffer + 1, len - 1);
+        dest += len - 1;
+    }
+    *dest++ = 'e';
+    return writeExponent(kk - 1, dest);
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::size_t doubleToString(double value, char* dest) {
+    if (!std::isfinite(value)) {
+        return std::snprintf(dest, maxDoubleStringSize, "%g", value);
+    }
+    char* p = dest;
+    if (std::signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        *p++ = '0';
+        return p - dest;
+    }
+    char digits[20];
+    int len = 0;
+    int K = 0;
+    grisu2(value, digits, len, K);
+    return prettify(digits, len, K, p) - dest;
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,61 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/LruCache.h"
+
+// System headers
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.util.LruCache");
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::uint64_t const LruCacheBase::REPORT_INTERVAL;
+
+
+void LruCacheBase::_counted(std::size_t size) const {
+    std::uint64_t const lookups = _stats.hits + _stats.misses;
+    if (lookups % REPORT_INTERVAL != 0) {
+        return;
+    }
+    std::ostringstream os;
+    os << _name << " lookups=" << lookups << " hits=" << _stats.hits
+       << " hitRate=" << 100.0 * _stats.hits / lookups << "% misses=" << _stats.misses
+       << " size=" << size;
+    if (_reporter) {
+        _reporter(os);
+    }
+    LOGS(_log, LOG_LVL_INFO, os.str());
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,167 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_LRUCACHE_H
+#define LSST_QSERV_UTIL_LRUCACHE_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// LruCacheBase counts the lookups of an LruCache and reports them.
+class LruCacheBase {
+public:
+    struct Stats {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+        std::uint64_t size{0}; ///< Entries in the cache
+    };
+
+    /// Writes fields of the owner of a cache to its reports.
+    using Reporter = std::function<void(std::ostream&)>;
+
+    /// Lookups between two reports of the statistics.
+    static std::uint64_t const REPORT_INTERVAL = 1000;
+
+    std::size_t getMaxSize() const { return _maxSize; }
+
+    /// Set the fields added to the reports.
+    void setReporter(Reporter const& reporter) { _reporter = reporter; }
+
+protected:
+    LruCacheBase(std::string const& name, std::size_t maxSize)
+        : _name(name), _maxSize(maxSize) {}
+
+    /// Log the statistics at INFO every REPORT_INTERVAL lookups.
+    void _counted(std::size_t size) const;
+
+    Stats _stats;
+
+private:
+    std::string const _name;
+    std::size_t const _maxSize;
+    Reporter _reporter;
+};
+
+
+/// LruCache maps keys to values, keeping at most maxSize of them and
+/// dropping the least recently used first. Lookups are counted by the
+/// caller, with addHit() and addMiss(), as only it knows whether a value
+/// found is usable.
+///
+/// Not thread-safe, callers lock around it.
+template <class Key, class Value>
+class LruCache : public LruCacheBase {
+public:
+    /// @param name - prefix of the reports.
+    /// @param maxSize - entries kept, none if 0.
+    LruCache(std::string const& name, std::size_t maxSize)
+        : LruCacheBase(name, maxSize) {}
+    LruCache(LruCache const&) = delete;
+    LruCache& operator=(LruCache const&) = delete;
+
+    /// @return the value of key, made the most recently used, or nullptr.
+    ///         It stays valid until the entry is dropped.
+    Value* find(Key const& key) {
+        auto iter = _map.find(key);
+        if (iter == _map.end()) {
+            return nullptr;
+        }
+        _lru.splice(_lru.begin(), _lru, iter->second.second);
+        return &iter->second.first;
+    }
+
+    /// Insert or replace the value of key, dropping the least recently used
+    /// entries beyond getMaxSize().
+    void insert(Key const& key, Value const& value) {
+        if (getMaxSize() == 0) {
+            return;
+        }
+        erase(key);
+        _lru.push_front(key);
+        _map.emplace(key, std::make_pair(value, _lru.begin()));
+        while (_map.size() > getMaxSize()) {
+            _erase(_map.find(_lru.back()));
+        }
+    }
+
+    /// @return true if key had an entry.
+    bool erase(Key const& key) {
+        auto iter = _map.find(key);
+        if (iter == _map.end()) {
+            return false;
+        }
+        _erase(iter);
+        return true;
+    }
+
+    /// Drop the entries for which pred(key, value) is true.
+    /// @return the number of entries dropped.
+    template <class Pred>
+    std::size_t eraseIf(Pred pred) {
+        std::size_t count = 0;
+        for (auto iter = _map.begin(); iter != _map.end();) {
+            auto next = std::next(iter);
+            if (pred(iter->first, iter->second.first)) {
+                _erase(iter);
+                ++count;
+            }
+            iter = next;
+        }
+        return count;
+    }
+
+    std::size_t size() const { return _map.size(); }
+
+    void addHit() { ++_stats.hits; _counted(_map.size()); }
+    void addMiss() { ++_stats.misses; _counted(_map.size()); }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.size = _map.size();
+        return stats;
+    }
+
+private:
+    using Map = std::map<Key, std::pair<Value, typename std::list<Key>::iterator>>;
+
+    void _erase(typename Map::iterator iter) {
+        _lru.erase(iter->second.second);
+        _map.erase(iter);
+    }
+
+    Map _map;
+    std::list<Key> _lru; ///< Keys, most recently used first
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_LRUCACHE_H
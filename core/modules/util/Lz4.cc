@@ -0,0 +1,220 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/Lz4.h"
+
+// System headers
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Format constants: a match is at least 4 bytes, the last 5 bytes are
+// always literals and the last match starts at least 12 bytes before the end.
+std::size_t const minMatch = 4;
+std::size_t const lastLiterals = 5;
+std::size_t const mfLimit = 12;
+std::size_t const maxOffset = 65535;
+int const hashLog = 14;
+
+inline std::uint32_t read32(unsigned char const* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t read64(unsigned char const* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t hash(std::uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - hashLog);
+}
+
+/// @return the number of equal bytes at a and b, stopping at limit.
+inline std::size_t matchLength(unsigned char const* a, unsigned char const* b,
+                               unsigned char const* limit) {
+    unsigned char const* const start = a;
+    while (a + 8 <= limit) {
+        std::uint64_t const diff = read64(a) ^ read64(b);
+        if (diff) {
+            return a - start + (__builtin_ctzll(diff) >> 3);
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return a - start;
+}
+
+/// Write the extra bytes of a length whose 4 bit token field is saturated.
+inline unsigned char* writeLength(std::size_t len, unsigned char* op) {
+    for (; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<unsigned char>(len);
+    return op;
+}
+
+inline unsigned char* writeLiterals(unsigned char const* lit, std::size_t litLen,
+                                    unsigned char* token, unsigned char* op) {
+    if (litLen >= 15) {
+        *token = 15 << 4;
+        op = writeLength(litLen - 15, op);
+    } else {
+        *token = static_cast<unsigned char>(litLen << 4);
+    }
+    if (litLen > 0) { // lit may be null for an empty input
+        std::memcpy(op, lit, litLen);
+    }
+    return op + litLen;
+}
+
+/// Read the extra bytes of a saturated length.
+/// @return false if the input ends first
+inline bool readLength(unsigned char const*& ip, unsigned char const* iend, std::size_t& len) {
+    unsigned char b;
+    do {
+        if (ip == iend) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::size_t Lz4::compress(char const* src, std::size_t srcSize, char* dest) {
+    unsigned char const* const base = reinterpret_cast<unsigned char const*>(src);
+    unsigned char const* const iend = base + srcSize;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dest);
+    unsigned char const* anchor = base;
+    if (srcSize > mfLimit) {
+        unsigned char const* const matchLimit = iend - lastLiterals;
+        unsigned char const* const ilimit = iend - mfLimit;
+        std::vector<std::uint32_t> table(1 << hashLog, 0);
+        unsigned char const* ip = base;
+        unsigned searches = 0;
+        while (ip < ilimit) {
+            std::uint32_t const seq = read32(ip);
+            std::uint32_t& slot = table[hash(seq)];
+            unsigned char const* ref = base + slot;
+            slot = static_cast<std::uint32_t>(ip - base);
+            if (ref >= ip || static_cast<std::size_t>(ip - ref) > maxOffset || read32(ref) != seq) {
+                // Skip faster through incompressible data.
+                ip += 1 + (searches++ >> 6);
+                continue;
+            }
+            searches = 0;
+            // Extend the match backwards over pending literals.
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            std::size_t const len = minMatch + matchLength(ip + minMatch, ref + minMatch, matchLimit);
+            unsigned char* const token = op++;
+            op = writeLiterals(anchor, ip - anchor, token, op);
+            std::size_t const offset = ip - ref;
+            *op++ = static_cast<unsigned char>(offset);
+            *op++ = static_cast<unsigned char>(offset >> 8);
+            std::size_t const matchCode = len - minMatch;
+            if (matchCode >= 15) {
+                *token |= 15;
+                op = writeLength(matchCode - 15, op);
+            } else {
+                *token |= static_cast<unsigned char>(matchCode);
+            }
+            ip += len;
+            anchor = ip;
+        }
+    }
+    unsigned char* const token = op++;
+    op = writeLiterals(anchor, iend - anchor, token, op);
+    return op - reinterpret_cast<unsigned char*>(dest);
+}
+
+bool Lz4::decompress(char const* src, std::size_t srcSize, char* dest, std::size_t destSize) {
+    unsigned char const* ip = reinterpret_cast<unsigned char const*>(src);
+    unsigned char const* const iend = ip + srcSize;
+    unsigned char* const obase = reinterpret_cast<unsigned char*>(dest);
+    unsigned char* op = obase;
+    unsigned char* const oend = op + destSize;
+    while (ip < iend) {
+        unsigned const token = *ip++;
+        std::size_t litLen = token >> 4;
+        if (litLen == 15 && !readLength(ip, iend, litLen)) return false;
+        if (litLen > static_cast<std::size_t>(iend - ip)
+            || litLen > static_cast<std::size_t>(oend - op)) {
+            return false;
+        }
+        if (litLen <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            std::memcpy(op, ip, 16); // A fixed size copy is much cheaper.
+        } else {
+            std::memcpy(op, ip, litLen);
+        }
+        ip += litLen;
+        op += litLen;
+        if (ip == iend) break; // The last sequence has only literals.
+        if (iend - ip < 2) return false;
+        std::size_t const offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - obase)) return false;
+        std::size_t len = token & 15;
+        if (len == 15 && !readLength(ip, iend, len)) return false;
+        len += minMatch;
+        if (len > static_cast<std::size_t>(oend - op)) return false;
+        unsigned char const* match = op - offset;
+        unsigned char* const copyEnd = op + len;
+        if (offset >= 8 && oend - copyEnd >= 8) {
+            // Copy 8 bytes at a time, overrunning copyEnd by up to 7 bytes.
+            do {
+                std::memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < copyEnd);
+            op = copyEnd;
+        } else if (offset >= len) {
+            std::memcpy(op, match, len);
+            op += len;
+        } else {
+            // Overlapping copy repeats the last offset bytes.
+            for (std::size_t i = 0; i < len; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op == oend;
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,56 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_LZ4_H
+#define LSST_QSERV_UTIL_LZ4_H
+
+// System headers
+#include <cstddef>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// Lz4 compresses and decompresses single blocks in the LZ4 block format
+/// (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), so that
+/// either end may be swapped for the reference liblz4. The compressor is a
+/// greedy single-hash-table matcher, trading some ratio for speed.
+class Lz4 {
+public:
+    /// @return the largest compressed size of srcSize input bytes
+    static std::size_t compressBound(std::size_t srcSize) {
+        return srcSize + srcSize / 255 + 16;
+    }
+
+    /// Compress src into dest, which must hold compressBound(srcSize) bytes.
+    /// @return the compressed size
+    static std::size_t compress(char const* src, std::size_t srcSize, char* dest);
+
+    /// Decompress a block, which must expand to exactly destSize bytes.
+    /// Corrupt input is detected, never read or written out of bounds.
+    /// @return false if src is not a valid block of destSize bytes
+    static bool decompress(char const* src, std::size_t srcSize, char* dest, std::size_t destSize);
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_LZ4_H
@@ -0,0 +1,117 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/MappedFile.h"
+
+// System headers
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::size_t const MappedFile::MAGIC_SIZE;
+
+
+MappedFile::Ptr MappedFile::map(std::string const& path, std::string const& owner) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(errnoText(owner + ": cannot open", path));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error(errnoText(owner + ": cannot stat", path));
+    }
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->_size = st.st_size;
+    if (file->_size > 0) {
+        void* addr = ::mmap(nullptr, file->_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error(errnoText(owner + ": cannot map", path));
+        }
+        file->_data = static_cast<char const*>(addr);
+    }
+    ::close(fd);
+    return file;
+}
+
+
+void MappedFile::save(std::string const& path, std::vector<Part> const& parts,
+                      std::string const& owner) {
+    std::string const tmpPath = path + ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error(errnoText(owner + ": cannot create", tmpPath));
+        }
+        for (auto const& part : parts) {
+            out.write(static_cast<char const*>(part.data), part.bytes);
+        }
+        out.close();
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error(errnoText(owner + ": cannot write", tmpPath));
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error(errnoText(owner + ": cannot rename to", path));
+    }
+}
+
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        ::munmap(const_cast<char*>(_data), _size);
+    }
+}
+
+
+bool MappedFile::hasHeader(char const magic[MAGIC_SIZE], std::uint64_t headerBytes) const {
+    return _size >= headerBytes && _size >= MAGIC_SIZE && std::memcmp(_data, magic, MAGIC_SIZE) == 0;
+}
+
+
+void MappedFile::willNeed() const {
+    if (_data != nullptr) {
+        ::madvise(const_cast<char*>(_data), _size, MADV_WILLNEED);
+    }
+}
+
+
+std::string errnoText(std::string const& what, std::string const& path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+}}} // namespace lsst::qserv::util
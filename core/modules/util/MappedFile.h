@@ -0,0 +1,88 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_MAPPEDFILE_H
+#define LSST_QSERV_UTIL_MAPPEDFILE_H
+
+// System headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// MappedFile is a file mapped read-only into memory. It serves files of
+/// arrays that are used where they lie instead of being parsed, written by
+/// save(). Such files start with a header whose first MAGIC_SIZE bytes name
+/// their format.
+class MappedFile {
+public:
+    using Ptr = std::shared_ptr<MappedFile const>;
+
+    static std::size_t const MAGIC_SIZE = 8;
+
+    /// A piece of a file written by save().
+    struct Part {
+        void const* data;
+        std::uint64_t bytes;
+    };
+
+    /// Map file path. It must not be modified while mapped.
+    /// @param owner - prefix of error messages, e.g. the class reading path.
+    /// @throws std::runtime_error if path cannot be mapped.
+    static Ptr map(std::string const& path, std::string const& owner);
+
+    /// Write parts one after another to path, through a temporary file
+    /// renamed to path, so that readers never see a partial file.
+    /// @throws std::runtime_error on failure.
+    static void save(std::string const& path, std::vector<Part> const& parts,
+                     std::string const& owner);
+
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    char const* data() const { return _data; }
+    std::uint64_t size() const { return _size; }
+
+    /// @return true if the file holds at least headerBytes, starting with magic.
+    bool hasHeader(char const magic[MAGIC_SIZE], std::uint64_t headerBytes) const;
+
+    /// Ask for the whole file to be read in now rather than on first use.
+    void willNeed() const;
+
+private:
+    MappedFile() = default;
+
+    char const* _data = nullptr; ///< nullptr for an empty file
+    std::uint64_t _size = 0;
+};
+
+/// @return "<what> <path>: " followed by the text of errno.
+std::string errnoText(std::string const& what, std::string const& path);
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_MAPPEDFILE_H
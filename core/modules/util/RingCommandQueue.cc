@@ -0,0 +1,176 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/RingCommandQueue.h"
+
+// System headers
+#include <thread>
+
+namespace {
+
+/// Attempts to find a command before parking in getCmd().
+int const SPIN_TRIES = 16;
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+RingCommandQueue::RingCommandQueue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    _mask = size - 1;
+    _cells.reset(new Cell[size]);
+    for (std::size_t j=0; j < size; ++j) {
+        _cells[j].seq.store(j, std::memory_order_relaxed);
+    }
+}
+
+
+void RingCommandQueue::queCmd(Command::Ptr const& cmd) {
+    // Once commands have spilled, later ones follow them so that the ring
+    // cannot overtake them.
+    if (_spilled.load() > 0 || !_push(cmd)) {
+        std::lock_guard<std::mutex> lock(_mx);
+        _qu.push_back(cmd);
+        ++_spilled;
+        if (_waiters.load() > 0) {
+            _cv.notify_one();
+        }
+        return;
+    }
+    // Pairs with the fence in getCmd(): either the parking thread sees the
+    // command, or this one sees the parking thread.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiters.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(_mx);
+        _cv.notify_one();
+    }
+}
+
+
+Command::Ptr RingCommandQueue::getCmd(bool wait) {
+    Command::Ptr cmd;
+    if (_popAny(cmd) || !wait) {
+        return cmd;
+    }
+    for (int j=0; j < SPIN_TRIES; ++j) {
+        std::this_thread::yield();
+        if (_popAny(cmd)) {
+            return cmd;
+        }
+    }
+    std::unique_lock<std::mutex> lock(_mx);
+    ++_waiters;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!_pop(cmd) && !_popSpilled(cmd)) {
+        _cv.wait(lock);
+    }
+    --_waiters;
+    return cmd;
+}
+
+
+void RingCommandQueue::notify(bool all) {
+    std::lock_guard<std::mutex> lock(_mx);
+    CommandQueue::notify(all);
+}
+
+
+/// Put cmd in the ring.
+/// @return false if the ring is full.
+bool RingCommandQueue::_push(Command::Ptr const& cmd) {
+    std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &_cells[pos & _mask];
+        std::size_t seq = cell->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->cmd = cmd;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+
+/// Take the oldest command from the ring.
+/// @return false if the ring is empty.
+bool RingCommandQueue::_pop(Command::Ptr& cmd) {
+    std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &_cells[pos & _mask];
+        std::size_t seq = cell->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0) {
+            if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cmd = std::move(cell->cmd);
+    cell->seq.store(pos + _mask + 1, std::memory_order_release);
+    return true;
+}
+
+
+bool RingCommandQueue::_popSpilled(Command::Ptr& cmd) {
+    if (_qu.empty()) {
+        return false;
+    }
+    cmd = std::move(_qu.front());
+    _qu.pop_front();
+    --_spilled;
+    return true;
+}
+
+
+bool RingCommandQueue::_popAny(Command::Ptr& cmd) {
+    if (_pop(cmd)) {
+        return true;
+    }
+    if (_spilled.load() > 0) {
+        std::lock_guard<std::mutex> lock(_mx);
+        return _pop(cmd) || _popSpilled(cmd);
+    }
+    return false;
+}
+
+}}} // namespace lsst::qserv::util
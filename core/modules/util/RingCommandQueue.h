@@ -0,0 +1,89 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_UTIL_RINGCOMMANDQUEUE_H_
+#define LSST_QSERV_UTIL_RINGCOMMANDQUEUE_H_
+
+// System headers
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Qserv headers
+#include "util/EventThread.h"
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// A CommandQueue for ThreadPools whose commands are too short for every
+/// thread to take the queue mutex, e.g.
+///     ThreadPool::newThreadPool(n, std::make_shared<RingCommandQueue>());
+///
+/// Commands go through a bounded lock-free ring (a Vyukov MPMC queue), so
+/// queCmd() and getCmd() do not lock while there are commands to hand out.
+/// Threads that find it empty park on the condition variable of
+/// CommandQueue, and queCmd() only takes the mutex to wake them when some
+/// are parked (an eventcount). When the ring is full, commands spill into
+/// the deque of CommandQueue until the ring has drained, so queCmd() never
+/// blocks. Order is FIFO, except between commands queued at the same time
+/// as the ring fills up.
+class RingCommandQueue : public CommandQueue {
+public:
+    using Ptr = std::shared_ptr<RingCommandQueue>;
+
+    /// @param capacity - size of the ring, rounded up to a power of 2.
+    explicit RingCommandQueue(std::size_t capacity=1024);
+
+    void queCmd(Command::Ptr const& cmd) override;
+    Command::Ptr getCmd(bool wait=true) override;
+    void notify(bool all=true) override;
+
+    std::size_t getCapacity() const { return _mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        Command::Ptr cmd;
+    };
+
+    bool _push(Command::Ptr const& cmd);
+    bool _pop(Command::Ptr& cmd);
+    bool _popSpilled(Command::Ptr& cmd); ///< Call with _mx locked.
+    bool _popAny(Command::Ptr& cmd);
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+    // Producers, consumers and parking each get their own cache line.
+    char _pad0[64];
+    std::atomic<std::size_t> _enqueuePos{0};
+    char _pad1[64];
+    std::atomic<std::size_t> _dequeuePos{0};
+    char _pad2[64];
+    std::atomic<int> _waiters{0};  ///< Threads parked, or about to park, in getCmd()
+    std::atomic<int> _spilled{0};  ///< Commands in _qu
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif /* LSST_QSERV_UTIL_RINGCOMMANDQUEUE_H_ */
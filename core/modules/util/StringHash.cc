@@ -26,6 +26,7 @@
 #include "util/StringHash.h"
 
 // System headers
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -38,6 +39,11 @@
 #include <openssl/sha.h>
 #endif
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define QSERV_CRC32C_X86 1
+#include <nmmintrin.h>
+#endif
+
 namespace {
 
 #ifdef __APPLE__
@@ -84,6 +90,142 @@ inline std::string wrapHashHex(void const* buffer, int bufferSize) {
     return s.str();
 }
 
+////////////////////////////////////////////////////////////////////////
+// CRC32C (Castagnoli)
+////////////////////////////////////////////////////////////////////////
+
+struct Crc32cTable {
+    Crc32cTable() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1; // reflected polynomial
+            }
+            t[i] = c;
+        }
+    }
+    std::uint32_t t[256];
+};
+
+std::uint32_t crc32cScalar(std::uint32_t crc, unsigned char const* p, std::size_t len) {
+    static Crc32cTable const table;
+    while (len--) {
+        crc = table.t[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef QSERV_CRC32C_X86
+__attribute__((target("sse4.2")))
+std::uint32_t crc32cHw(std::uint32_t crc, unsigned char const* p, std::size_t len) {
+    std::uint64_t c = crc;
+    while (len >= 8) {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+        p += 8;
+        len -= 8;
+    }
+    std::uint32_t c32 = static_cast<std::uint32_t>(c);
+    while (len--) {
+        c32 = _mm_crc32_u8(c32, *p++);
+    }
+    return c32;
+}
+
+/// Static initializers may run before the one setting up the CPU model
+/// that __builtin_cpu_supports() reads, hence __builtin_cpu_init().
+bool detectCrc32cHw() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+bool const hasCrc32cHw = detectCrc32cHw();
+#endif
+
+////////////////////////////////////////////////////////////////////////
+// xxHash64, after the reference implementation by Yann Collet
+////////////////////////////////////////////////////////////////////////
+
+std::uint64_t const xxPrime1 = 11400714785074694791ULL;
+std::uint64_t const xxPrime2 = 14029467366897019727ULL;
+std::uint64_t const xxPrime3 =  1609587929392839161ULL;
+std::uint64_t const xxPrime4 =  9650029242287828579ULL;
+std::uint64_t const xxPrime5 =  2870177450012600261ULL;
+
+inline std::uint64_t rotl64(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t read64(unsigned char const* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v)); // little-endian hosts only
+    return v;
+}
+
+inline std::uint32_t read32(unsigned char const* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t xxRound(std::uint64_t acc, std::uint64_t input) {
+    acc += input * xxPrime2;
+    acc = rotl64(acc, 31);
+    return acc * xxPrime1;
+}
+
+inline std::uint64_t xxMergeRound(std::uint64_t acc, std::uint64_t val) {
+    acc ^= xxRound(0, val);
+    return acc * xxPrime1 + xxPrime4;
+}
+
+std::uint64_t xxHash64(unsigned char const* p, std::size_t len, std::uint64_t seed) {
+    unsigned char const* const end = p + len;
+    std::uint64_t h;
+    if (len >= 32) {
+        unsigned char const* const limit = end - 32;
+        std::uint64_t v1 = seed + xxPrime1 + xxPrime2;
+        std::uint64_t v2 = seed + xxPrime2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - xxPrime1;
+        do {
+            v1 = xxRound(v1, read64(p));
+            v2 = xxRound(v2, read64(p + 8));
+            v3 = xxRound(v3, read64(p + 16));
+            v4 = xxRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxMergeRound(h, v1);
+        h = xxMergeRound(h, v2);
+        h = xxMergeRound(h, v3);
+        h = xxMergeRound(h, v4);
+    } else {
+        h = seed + xxPrime5;
+    }
+    h += len;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxRound(0, read64(p));
+        h = rotl64(h, 27) * xxPrime1 + xxPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * xxPrime1;
+        h = rotl64(h, 23) * xxPrime2 + xxPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * xxPrime5;
+        h = rotl64(h, 11) * xxPrime1;
+    }
+    h ^= h >> 33;
+    h *= xxPrime2;
+    h ^= h >> 29;
+    h *= xxPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
 } // anonymous namespace
 
 namespace lsst {
@@ -125,4 +267,20 @@ std::string StringHash::getSha256(char const* buffer, int bufferSize) {
     return wrapHash<SHA256, SHA256_DIGEST_LENGTH>(buffer, bufferSize);
 }
 
+/// @return the CRC32C (Castagnoli) checksum of the input buffer
+std::uint32_t StringHash::getCrc32c(char const* buffer, std::size_t bufferSize) {
+    unsigned char const* p = reinterpret_cast<unsigned char const*>(buffer);
+#ifdef QSERV_CRC32C_X86
+    if (hasCrc32cHw) {
+        return ~crc32cHw(~0U, p, bufferSize);
+    }
+#endif
+    return ~crc32cScalar(~0U, p, bufferSize);
+}
+
+/// @return the xxHash64 hash, with seed 0, of the input buffer
+std::uint64_t StringHash::getXxHash64(char const* buffer, std::size_t bufferSize) {
+    return xxHash64(reinterpret_cast<unsigned char const*>(buffer), bufferSize, 0);
+}
+
 }}} // namespace lsst::qserv::util
@@ -25,6 +25,8 @@
 #define LSST_QSERV_UTIL_STRINGHASH_H
 
 // System headers
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace lsst {
@@ -40,6 +42,11 @@ public:
     static std::string getMd5(char const* buffer, int bufferSize);
     static std::string getSha1(char const* buffer, int bufferSize);
     static std::string getSha256(char const* buffer, int bufferSize);
+
+    /// Fast non-cryptographic checksums, for detecting corruption only.
+    /// getCrc32c uses the SSE4.2 crc32 instruction when the CPU has it.
+    static std::uint32_t getCrc32c(char const* buffer, std::size_t bufferSize);
+    static std::uint64_t getXxHash64(char const* buffer, std::size_t bufferSize);
 };
 
 }}} // namespace lsst::qserv::util
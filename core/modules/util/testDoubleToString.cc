@@ -0,0 +1,92 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test DoubleToString.h
+ *
+ */
+
+// System headers
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+// Qserv headers
+#include "util/DoubleToString.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE DoubleToString
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+std::string format(double value) {
+    char buf[util::maxDoubleStringSize];
+    return std::string(buf, util::doubleToString(value, buf));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Layout) {
+    BOOST_CHECK_EQUAL(format(0.0), "0");
+    BOOST_CHECK_EQUAL(format(-0.0), "-0");
+    BOOST_CHECK_EQUAL(format(1.0), "1");
+    BOOST_CHECK_EQUAL(format(1500.0), "1500");
+    BOOST_CHECK_EQUAL(format(0.1), "0.1");
+    BOOST_CHECK_EQUAL(format(-12.34), "-12.34");
+    BOOST_CHECK_EQUAL(format(0.001234), "0.001234");
+    BOOST_CHECK_EQUAL(format(1e21), "1e21");
+    BOOST_CHECK_EQUAL(format(5e-324), "5e-324");
+    BOOST_CHECK_EQUAL(format(1.7976931348623157e308), "1.7976931348623157e308");
+}
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    char buf[util::maxDoubleStringSize + 1];
+    for (int i = 0; i < 1000000; ++i) {
+        double value = dist(gen);
+        if (i % 2) {
+            // Arbitrary bit patterns cover subnormals and extreme exponents.
+            std::uint64_t bits = gen();
+            std::memcpy(&value, &bits, sizeof(value));
+            if (!std::isfinite(value)) continue;
+        }
+        std::size_t const size = util::doubleToString(value, buf);
+        BOOST_REQUIRE(size <= util::maxDoubleStringSize);
+        buf[size] = '\0';
+        double const back = std::strtod(buf, nullptr);
+        BOOST_REQUIRE_MESSAGE(std::memcmp(&back, &value, sizeof(value)) == 0, buf);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,9 +28,13 @@
  */
 
 // System headers
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 // Third-party headers
 
@@ -40,6 +44,7 @@
 // Qserv headers
 #include "util/EventThread.h"
 #include "util/InstanceCount.h"
+#include "util/RingCommandQueue.h"
 
 // Boost unit test header
 #define BOOST_TEST_MODULE common
@@ -236,6 +241,103 @@ BOOST_AUTO_TEST_CASE(EventThreadTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(RingCommandQueueTest) {
+    LOGS_DEBUG("RingCommandQueue test");
+    auto ringQueue = std::make_shared<RingCommandQueue>(5);
+    BOOST_CHECK(ringQueue->getCapacity() == 8);
+    BOOST_CHECK(ringQueue->getCmd(false) == nullptr);
+
+    // Commands come out in order, including those spilled from a full ring.
+    std::vector<int> order;
+    for (int j=0; j<20; ++j) {
+        ringQueue->queCmd(std::make_shared<Command>([&order, j](CmdData*){ order.push_back(j); }));
+    }
+    for (int j=0; j<20; ++j) {
+        auto cmd = ringQueue->getCmd(false);
+        BOOST_REQUIRE(cmd != nullptr);
+        cmd->runAction(nullptr);
+    }
+    BOOST_CHECK(ringQueue->getCmd(false) == nullptr);
+    for (int j=0; j<20; ++j) {
+        BOOST_CHECK(order[j] == j);
+    }
+
+    // A pool on a small ring, fed while it runs.
+    std::atomic<int> total{0};
+    int expected = 0;
+    auto pool = ThreadPool::newThreadPool(8, ringQueue);
+    for (int j=1; j<20000; ++j) {
+        ringQueue->queCmd(std::make_shared<Command>([&total, j](CmdData*){ total += j; }));
+        expected += j;
+    }
+    pool->endAll(); // Queued after everything else, so all of it runs first.
+    pool->waitForResize(0);
+    BOOST_CHECK(total == expected);
+}
+
+
+/// Time enqueueing and running cmdsPerThread trivial commands from each of
+/// 'threads' producers, on a pool of 'threads' threads fed by queue, and
+/// check that every command ran exactly once.
+/// @return commands per second
+double queueThroughput(CommandQueue::Ptr const& queue, int threads, int cmdsPerThread) {
+    std::atomic<int> done{0};
+    int const total = threads * cmdsPerThread;
+    std::vector<std::atomic<int>> runs(total);
+    for (auto& r : runs) r = 0;
+    // Commands are made up front, so that only the queue is timed.
+    std::vector<Command::Ptr> cmds;
+    for (int j=0; j<total; ++j) {
+        cmds.push_back(std::make_shared<Command>([&done, &runs, j](CmdData*){
+            ++runs[j];
+            ++done;
+        }));
+    }
+    auto pool = ThreadPool::newThreadPool(threads, queue);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int t=0; t<threads; ++t) {
+        producers.emplace_back([&queue, &cmds, t, cmdsPerThread]() {
+            for (int j=t*cmdsPerThread; j<(t+1)*cmdsPerThread; ++j) {
+                queue->queCmd(cmds[j]);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    while (done < total) {
+        std::this_thread::yield();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pool->endAll();
+    pool->waitForResize(0);
+    BOOST_CHECK_EQUAL(done, total);
+    int wrong = 0;
+    for (auto const& r : runs) {
+        if (r != 1) ++wrong;
+    }
+    BOOST_CHECK_EQUAL(wrong, 0);
+    return total / secs;
+}
+
+
+/// Benchmark of enqueue/dequeue throughput, mutex and deque against ring.
+/// Disabled by default as it is slow and starts up to 128 threads, run it
+/// with --run_test=Suite/CommandQueueThroughput.
+BOOST_AUTO_TEST_CASE(CommandQueueThroughput, *boost::unit_test::disabled()) {
+    int const cmds = 200000;
+    for (int threads : {1, 8, 32, 64}) {
+        double mutexRate = queueThroughput(std::make_shared<CommandQueue>(), threads,
+                                           cmds/threads);
+        double ringRate = queueThroughput(std::make_shared<RingCommandQueue>(), threads,
+                                          cmds/threads);
+        LOGS_INFO("threads=" << threads << " CommandQueue cmds/s=" << mutexRate
+                  << " RingCommandQueue cmds/s=" << ringRate);
+    }
+}
+
+
 BOOST_AUTO_TEST_CASE(InstanceCountTest) {
 
     struct CA {
@@ -0,0 +1,106 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <sstream>
+#include <string>
+
+// Qserv headers
+#include "util/LruCache.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE LruCache_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::util::LruCache;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Eviction) {
+    LruCache<std::string, int> cache("test", 2);
+    cache.insert("a", 1);
+    cache.insert("b", 2);
+    BOOST_REQUIRE(cache.find("a") != nullptr);
+    BOOST_CHECK_EQUAL(*cache.find("a"), 1);
+    // "b" is now the least recently used.
+    cache.insert("c", 3);
+    BOOST_CHECK_EQUAL(cache.size(), 2u);
+    BOOST_CHECK(cache.find("b") == nullptr);
+    BOOST_CHECK(cache.find("a") != nullptr);
+    BOOST_CHECK(cache.find("c") != nullptr);
+
+    // Replacing a value keeps one entry.
+    cache.insert("c", 4);
+    BOOST_CHECK_EQUAL(cache.size(), 2u);
+    BOOST_CHECK_EQUAL(*cache.find("c"), 4);
+    *cache.find("c") = 5;
+    BOOST_CHECK_EQUAL(*cache.find("c"), 5);
+
+    LruCache<int, int> none("none", 0);
+    none.insert(1, 1);
+    BOOST_CHECK_EQUAL(none.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Erase) {
+    LruCache<int, int> cache("test", 10);
+    for (int j = 0; j < 6; ++j) {
+        cache.insert(j, j * j);
+    }
+    BOOST_CHECK(cache.erase(0));
+    BOOST_CHECK(!cache.erase(0));
+    BOOST_CHECK_EQUAL(cache.eraseIf([](int key, int) { return key % 2 == 1; }), 3u);
+    BOOST_CHECK_EQUAL(cache.size(), 2u);
+    BOOST_CHECK(cache.find(2) != nullptr);
+    BOOST_CHECK(cache.find(4) != nullptr);
+    // The order of use survives erasing.
+    cache.find(2);
+    for (int j = 10; j < 19; ++j) {
+        cache.insert(j, j);
+    }
+    BOOST_CHECK(cache.find(4) == nullptr);
+    BOOST_CHECK(cache.find(2) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Stats) {
+    using Cache = LruCache<int, int>;
+    Cache cache("test", 10);
+    int reports = 0;
+    cache.setReporter([&reports](std::ostream& os) { ++reports; os << " extra=1"; });
+    cache.insert(1, 1);
+    for (unsigned j = 0; j < Cache::REPORT_INTERVAL; ++j) {
+        if (cache.find(j % 2) != nullptr) {
+            cache.addHit();
+        } else {
+            cache.addMiss();
+        }
+    }
+    auto stats = cache.getStats();
+    BOOST_CHECK_EQUAL(stats.hits, Cache::REPORT_INTERVAL / 2);
+    BOOST_CHECK_EQUAL(stats.misses, Cache::REPORT_INTERVAL / 2);
+    BOOST_CHECK_EQUAL(stats.size, 1u);
+    BOOST_CHECK_EQUAL(reports, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test Lz4.h
+ *
+ */
+
+// System headers
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "util/Lz4.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE Lz4
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+std::string compress(std::string const& src) {
+    std::string dest(util::Lz4::compressBound(src.size()), '\0');
+    dest.resize(util::Lz4::compress(src.data(), src.size(), &dest[0]));
+    return dest;
+}
+
+bool decompress(std::string const& src, std::size_t size, std::string& dest) {
+    dest.assign(size, '\0');
+    return util::Lz4::decompress(src.data(), src.size(), &dest[0], size);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+    std::mt19937 gen(7);
+    std::string text;
+    while (text.size() < 1000000) {
+        text += std::to_string(gen() % 100000) + "\t" + std::to_string(gen() % 7) + "\tNULL\n";
+    }
+    std::string random;
+    for (int i = 0; i < 100000; ++i) {
+        random += static_cast<char>(gen());
+    }
+    std::vector<std::string> inputs{"", "a", "abcabcabc", std::string(13, 'a'),
+                                    std::string(100000, 'x'), text, random};
+    for (auto const& src : inputs) {
+        std::string const compressed = compress(src);
+        BOOST_CHECK(compressed.size() <= util::Lz4::compressBound(src.size()));
+        std::string back;
+        BOOST_REQUIRE(decompress(compressed, src.size(), back));
+        BOOST_CHECK(back == src);
+    }
+    // An empty input may come without a buffer.
+    std::string empty(util::Lz4::compressBound(0), '\0');
+    BOOST_CHECK_EQUAL(util::Lz4::compress(nullptr, 0, &empty[0]), 1u);
+    BOOST_CHECK(compress(text).size() < text.size() * 3 / 4);
+    BOOST_CHECK(compress(std::string(100000, 'x')).size() < 1000);
+}
+
+BOOST_AUTO_TEST_CASE(KnownBlock) {
+    // Made by the reference implementation: 3 literals, a 21 byte match at
+    // offset 3, then 9 final literals.
+    std::string const block("\x3f" "abc" "\x03\x00" "\x02" "\x90" ", the end", 17);
+    std::string back;
+    BOOST_REQUIRE(decompress(block, 33, back));
+    BOOST_CHECK_EQUAL(back, "abcabcabcabcabcabcabcabc, the end");
+}
+
+BOOST_AUTO_TEST_CASE(Corrupt) {
+    std::string src;
+    for (int i = 0; i < 1000; ++i) {
+        src += "row " + std::to_string(i % 10) + " value\n";
+    }
+    std::string const compressed = compress(src);
+    std::string back;
+    // Wrong size, truncated input, bad offset.
+    BOOST_CHECK(!decompress(compressed, src.size() - 1, back));
+    BOOST_CHECK(!decompress(compressed, src.size() + 1, back));
+    BOOST_CHECK(!decompress(compressed.substr(0, compressed.size() / 2), src.size(), back));
+    BOOST_CHECK(!decompress(std::string("\x10" "a" "\x05\x00", 4), 5, back));
+    BOOST_CHECK(!decompress(std::string("\x10" "a" "\x00\x00", 4), 5, back));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
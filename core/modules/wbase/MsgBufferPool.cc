@@ -0,0 +1,93 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wbase/MsgBufferPool.h"
+
+// System headers
+#include <utility>
+
+namespace {
+// Enough to cover the messages of the tasks in flight on a worker, each
+// buffer being around ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT.
+std::size_t const defaultMaxBuffers = 64;
+// Status and small result messages are not worth a pooled buffer.
+std::size_t const defaultMinSize = 64*1024;
+// A few times ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT. Buffers grown by
+// the rare larger messages are freed rather than pinned in the pool.
+std::size_t const defaultMaxCapacity = 8*1000*1000;
+}
+
+namespace lsst {
+namespace qserv {
+namespace wbase {
+
+std::string MsgBufferPool::acquire(std::size_t size) {
+    if (size < _minSize) {
+        return std::string();
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_free.empty()) {
+        return std::string();
+    }
+    // Best fit: the smallest buffer big enough, else the largest one.
+    std::size_t best = 0;
+    for (std::size_t j = 1; j < _free.size(); ++j) {
+        std::size_t const cap = _free[j].capacity();
+        std::size_t const bestCap = _free[best].capacity();
+        bool const fits = cap >= size;
+        bool const bestFits = bestCap >= size;
+        if ((fits && (!bestFits || cap < bestCap)) || (!fits && !bestFits && cap > bestCap)) {
+            best = j;
+        }
+    }
+    std::swap(_free[best], _free.back());
+    std::string buf(std::move(_free.back()));
+    _free.pop_back();
+    return buf;
+}
+
+void MsgBufferPool::release(std::string&& buf) {
+    std::size_t const cap = buf.capacity();
+    if (cap < _minSize || cap > _maxCapacity) {
+        std::string().swap(buf); // Free it now.
+        return;
+    }
+    buf.clear(); // Keeps capacity.
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_free.size() < _maxBuffers) {
+        _free.push_back(std::move(buf));
+    }
+}
+
+std::size_t MsgBufferPool::size() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _free.size();
+}
+
+MsgBufferPool& MsgBufferPool::getPool() {
+    static MsgBufferPool pool(defaultMaxBuffers, defaultMinSize, defaultMaxCapacity);
+    return pool;
+}
+
+}}} // namespace lsst::qserv::wbase
@@ -0,0 +1,83 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_WBASE_MSGBUFFERPOOL_H
+#define LSST_QSERV_WBASE_MSGBUFFERPOOL_H
+
+// System headers
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace wbase {
+
+/// MsgBufferPool keeps the string buffers that result messages are
+/// serialized into once XrdSsi is done sending them, so that the next
+/// message reuses their capacity instead of allocating ~2MB again.
+/// Buffers travel by move from the serializer, through the SendChannel, to
+/// XrdSsi and back, without their bytes being copied.
+///
+/// Only buffers for large messages are pooled: small messages get a buffer
+/// of their own, so that they do not hold on to megabytes of capacity
+/// while queued. Buffers that grew past maxCapacity are freed on release.
+class MsgBufferPool {
+public:
+    /// @param maxBuffers number of buffers kept for reuse
+    /// @param minSize messages smaller than this do not use the pool
+    /// @param maxCapacity buffers with more capacity than this are not kept
+    MsgBufferPool(std::size_t maxBuffers, std::size_t minSize, std::size_t maxCapacity)
+        : _maxBuffers(maxBuffers), _minSize(minSize), _maxCapacity(maxCapacity) {}
+    MsgBufferPool(MsgBufferPool const&) = delete;
+    MsgBufferPool& operator=(MsgBufferPool const&) = delete;
+
+    /// @param size expected size of the message
+    /// @return an empty buffer. For messages of at least minSize bytes,
+    ///         this is the recycled buffer with the smallest capacity
+    ///         holding size bytes, or the largest one if none does.
+    std::string acquire(std::size_t size);
+
+    /// Give a buffer back once its contents are no longer needed. Buffers
+    /// beyond the pool's capacity, or with a capacity outside
+    /// [minSize, maxCapacity], are freed.
+    void release(std::string&& buf);
+
+    /// @return the number of buffers waiting to be reused.
+    std::size_t size() const;
+
+    /// @return the pool shared by everything in this worker.
+    static MsgBufferPool& getPool();
+
+private:
+    std::size_t const _maxBuffers;
+    std::size_t const _minSize;
+    std::size_t const _maxCapacity;
+    std::vector<std::string> _free;
+    mutable std::mutex _mtx;
+};
+
+}}} // namespace lsst::qserv::wbase
+
+#endif // LSST_QSERV_WBASE_MSGBUFFERPOOL_H
@@ -39,6 +39,8 @@ namespace wbase {
 /// debugging code without an XrdSsi channel.
 class NopChannel : public SendChannel {
 public:
+    using SendChannel::sendStream;
+
     virtual bool send(char const* buf, int bufLen) {
         std::cout << "NopChannel send(" << (void*) buf
                   << ", " << bufLen << ");\n";
@@ -72,6 +74,8 @@ SendChannel::Ptr SendChannel::newNopChannel() {
 /// remembers what it has received.
 class StringChannel : public SendChannel {
 public:
+    using SendChannel::sendStream;
+
     StringChannel(std::string& dest) : _dest(dest) {}
 
     virtual bool send(char const* buf, int bufLen) {
@@ -60,6 +60,18 @@ public:
         throw Bug("Streaming is unimplemented, should not see this");
     }
 
+    /// Send a bucket of bytes, handing over ownership of buf. Channels that
+    /// can hold on to buf until it is sent override this to avoid copying;
+    /// the default copies through the char const* overload.
+    /// @param last true if no more sendStream calls will be invoked.
+    virtual bool sendStream(std::string&& buf, bool last) {
+        return sendStream(buf.data(), buf.size(), last);
+    }
+
+    /// Stop accepting data. Wakes up a sendStream call that is waiting for
+    /// the receiver to catch up; later sendStream calls return false.
+    virtual void cancel() {}
+
     /// Set a function to be called when a resources from a deferred send*
     /// operation may be released. This allows a sendFile() caller to be
     /// notified when the file descriptor may be closed and perhaps reclaimed.
@@ -152,6 +152,10 @@ void Task::cancel() {
     if (qr != nullptr) {
         qr->cancel();
     }
+    // Release a QueryRunner blocked on a full result stream.
+    if (sendChannel != nullptr) {
+        sendChannel->cancel();
+    }
 
     auto sched = _taskScheduler.lock();
     if (sched != nullptr) {
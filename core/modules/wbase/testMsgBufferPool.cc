@@ -0,0 +1,106 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+  /**
+  * @brief Test the choice of recycled result buffers.
+  */
+
+// System headers
+#include <string>
+
+// Qserv headers
+#include "wbase/MsgBufferPool.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE MsgBufferPool
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wbase::MsgBufferPool;
+
+namespace {
+
+std::size_t const KB = 1024;
+
+/// Release a buffer of at least cap bytes of capacity.
+/// @return its actual capacity
+std::size_t give(MsgBufferPool& pool, std::size_t cap) {
+    std::string buf;
+    buf.reserve(cap);
+    std::size_t const actual = buf.capacity();
+    pool.release(std::move(buf));
+    return actual;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(BestFit) {
+    MsgBufferPool pool(10, 64*KB, 8*KB*KB);
+    std::size_t const small = give(pool, 100*KB);
+    std::size_t const medium = give(pool, 500*KB);
+    std::size_t const large = give(pool, 2*KB*KB);
+    BOOST_CHECK_EQUAL(pool.size(), 3u);
+
+    // The smallest buffer that holds the message, whatever the order.
+    std::string buf = pool.acquire(300*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), medium);
+    BOOST_CHECK(buf.empty());
+    pool.release(std::move(buf));
+    buf = pool.acquire(100*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), small);
+    pool.release(std::move(buf));
+    buf = pool.acquire(1*KB*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), large);
+    pool.release(std::move(buf));
+
+    // The largest buffer when none holds it.
+    buf = pool.acquire(4*KB*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), large);
+    BOOST_CHECK_EQUAL(pool.size(), 2u);
+    buf = pool.acquire(4*KB*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), medium);
+    buf = pool.acquire(4*KB*KB);
+    BOOST_CHECK_EQUAL(buf.capacity(), small);
+    BOOST_CHECK_EQUAL(pool.size(), 0u);
+    BOOST_CHECK_EQUAL(pool.acquire(100*KB).capacity(), std::string().capacity());
+}
+
+BOOST_AUTO_TEST_CASE(Limits) {
+    MsgBufferPool pool(2, 64*KB, 8*KB*KB);
+    give(pool, 100*KB);
+    // Small messages do not take a pooled buffer.
+    BOOST_CHECK_EQUAL(pool.acquire(1*KB).capacity(), std::string().capacity());
+    BOOST_CHECK_EQUAL(pool.size(), 1u);
+
+    // Buffers outside [minSize, maxCapacity], or beyond maxBuffers, are freed.
+    give(pool, 1*KB);
+    give(pool, 9*KB*KB);
+    BOOST_CHECK_EQUAL(pool.size(), 1u);
+    give(pool, 200*KB);
+    give(pool, 300*KB);
+    BOOST_CHECK_EQUAL(pool.size(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
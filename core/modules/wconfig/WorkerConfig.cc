@@ -52,7 +52,12 @@ WorkerConfig::WorkerConfig(const util::ConfigStore& configStore)
       _memManClass(configStore.get("memman.class", "MemManReal")),
       _memManSizeMb(configStore.getInt("memman.memory", 1000)),
       _memManLocation(configStore.getRequired("memman.location")),
+      _memManPrefetchChunks(configStore.getInt("memman.prefetch_chunks", 0)),
+      _memManHugePages(configStore.getInt("memman.huge_pages", 0) != 0),
+      _memManNuma(configStore.get("memman.numa", "none")),
       _threadPoolSize(configStore.getInt("scheduler.thread_pool_size", wsched::BlendScheduler::getMinPoolSize())),
+      _stealDepth(configStore.getInt("scheduler.steal_depth", 0)),
+      _scanFusionMax(configStore.getInt("scheduler.scan_fusion_max", 0)),
       _maxGroupSize(configStore.getInt("scheduler.group_size", 1)),
       _requiredTasksCompleted(configStore.getInt("scheduler.required_tasks_completed", 25)),
       _prioritySlow(configStore.getInt("scheduler.priority_slow", 2)),
@@ -71,15 +76,23 @@ WorkerConfig::WorkerConfig(const util::ConfigStore& configStore)
       _scanMaxMinutesMed(configStore.getInt("scheduler.scanmaxminutes_med", 60*8)),
       _scanMaxMinutesSlow(configStore.getInt("scheduler.scanmaxminutes_slow", 60*12)),
       _scanMaxMinutesSnail(configStore.getInt("scheduler.scanmaxminutes_snail", 60*24)),
-      _maxTasksBootedPerUserQuery(configStore.getInt("scheduler.maxtasksbootedperuserquery", 5)) {
+      _maxTasksBootedPerUserQuery(configStore.getInt("scheduler.maxtasksbootedperuserquery", 5)),
+      _resultStreamQueueMb(configStore.getInt("results.stream_queue_mb", 64)),
+      _resultWorkerQueueMb(configStore.getInt("results.worker_queue_mb", 2000)),
+      _resultCompression(configStore.get("results.compression", "LZ4")) {
 }
 
 std::ostream& operator<<(std::ostream &out, WorkerConfig const& workerConfig) {
     out << "MemManClass=" << workerConfig._memManClass;
     if (workerConfig._memManClass == "MemManReal") {
         out << "MemManSizeMb=" << workerConfig._memManSizeMb;
+        out << " MemManPrefetchChunks=" << workerConfig._memManPrefetchChunks;
+        out << " MemManHugePages=" << workerConfig._memManHugePages;
+        out << " MemManNuma=" << workerConfig._memManNuma;
     }
     out << " poolSize=" << workerConfig._threadPoolSize << ", maxGroupSize=" << workerConfig._maxGroupSize;
+    out << " stealDepth=" << workerConfig._stealDepth;
+    out << " scanFusionMax=" << workerConfig._scanFusionMax;
     out << " requiredTasksCompleted=" << workerConfig._requiredTasksCompleted;
 
     out << " priority fast=" << workerConfig._priorityFast
@@ -89,6 +102,10 @@ std::ostream& operator<<(std::ostream &out, WorkerConfig const& workerConfig) {
     out << " Reserved threads fast=" << workerConfig._maxReserveFast
          << " med=" << workerConfig._maxReserveMed << " slow=" << workerConfig._maxReserveSlow;
 
+    out << " Result queue MB stream=" << workerConfig._resultStreamQueueMb
+        << " worker=" << workerConfig._resultWorkerQueueMb;
+    out << " Result compression=" << workerConfig._resultCompression;
+
     return out;
 }
 
@@ -70,6 +70,24 @@ public:
         return _threadPoolSize;
     }
 
+    /* Get the number of Tasks a pool thread takes from the scheduler at once,
+     * 0 to run the plain thread pool instead of the work stealing one.
+     *
+     * @return Tasks taken from the scheduler per visit
+     */
+    unsigned int getStealDepth() const {
+        return _stealDepth;
+    }
+
+    /* Get the most Tasks that may share one scan of a chunk table,
+     * fused scans are off below 2.
+     *
+     * @return maximum Tasks in a fused scan
+     */
+    unsigned int getScanFusionMax() const {
+        return _scanFusionMax;
+    }
+
     /* Get required number of completed tasks for table in a chunk for the average to be valid.
      *
      * @return required tasks completed before average time is valid.
@@ -185,6 +203,32 @@ public:
         return _memManSizeMb;
     }
 
+    /* Get number of chunks after the active one whose tables the scan
+     * schedulers read ahead, 0 to read only on demand.
+     *
+     * @return number of chunks to prefetch
+     */
+    unsigned int getMemManPrefetchChunks() const {
+        return _memManPrefetchChunks;
+    }
+
+    /* Get whether the Memory Manager advises huge pages for mapped tables
+     *
+     * @return true to use huge pages
+     */
+    bool getMemManHugePages() const {
+        return _memManHugePages;
+    }
+
+    /* Get the NUMA placement of memory locked by the Memory Manager,
+     * "none" or "interleave"
+     *
+     * @return name of the NUMA placement
+     */
+    std::string const& getMemManNuma() const {
+        return _memManNuma;
+    }
+
     /* Get MySQL configuration for worker MySQL instance
      *
      * @return a structure containing MySQL parameters
@@ -257,6 +301,33 @@ public:
          return _maxActiveChunksSnail;
      }
 
+    /* Get the maximum amount of result data queued for a single czar
+     * request before the producing query blocks, 0 meaning unlimited
+     *
+     * @return per-stream result queue budget, in MB
+     */
+    uint64_t getResultStreamQueueMb() const {
+        return _resultStreamQueueMb;
+    }
+
+    /* Get the maximum amount of result data queued across all czar
+     * requests before producing queries block, 0 meaning unlimited
+     *
+     * @return per-worker result queue budget, in MB
+     */
+    uint64_t getResultWorkerQueueMb() const {
+        return _resultWorkerQueueMb;
+    }
+
+    /* Get the codec compressing results for czars that leave the choice
+     * to the worker: NONE, LZ4 or ZLIB
+     *
+     * @return result compression codec name
+     */
+    std::string const& getResultCompression() const {
+        return _resultCompression;
+    }
+
 
     /** Overload output operator for current class
      *
@@ -275,8 +346,13 @@ private:
     std::string const _memManClass;
     uint64_t const _memManSizeMb;
     std::string const _memManLocation;
+    unsigned int const _memManPrefetchChunks;
+    bool const _memManHugePages;
+    std::string const _memManNuma;
 
     unsigned int const _threadPoolSize;
+    unsigned int const _stealDepth;
+    unsigned int const _scanFusionMax;
     unsigned int const _maxGroupSize;
     unsigned int const _requiredTasksCompleted;
 
@@ -300,6 +376,10 @@ private:
     unsigned int const _scanMaxMinutesSlow;
     unsigned int const _scanMaxMinutesSnail;
     unsigned int const _maxTasksBootedPerUserQuery;
+
+    uint64_t const _resultStreamQueueMb;
+    uint64_t const _resultWorkerQueueMb;
+    std::string const _resultCompression;
 };
 
 }}} // namespace qserv::core::wconfig
@@ -41,6 +41,7 @@
 #include "proto/worker.pb.h"
 #include "wbase/Base.h"
 #include "wbase/SendChannel.h"
+#include "wcontrol/WorkStealingQueue.h"
 #include "wdb/ChunkResource.h"
 #include "wdb/QueryRunner.h"
 
@@ -53,8 +54,8 @@ namespace qserv {
 namespace wcontrol {
 
 Foreman::Foreman(Scheduler::Ptr const& s, uint poolSize, mysql::MySqlConfig const& mySqlConfig,
-    wpublish::QueriesAndChunks::Ptr const& queries)
-    : _scheduler{s}, _mySqlConfig(mySqlConfig), _queries{queries} {
+    wpublish::QueriesAndChunks::Ptr const& queries, uint stealDepth)
+    : _scheduler{s}, _queue{s}, _mySqlConfig(mySqlConfig), _queries{queries} {
     // Make the chunk resource mgr
     // Creating backend makes a connection to the database for making temporary tables.
     // It will delete temporary tables that it can identify as being created by a worker.
@@ -64,8 +65,11 @@ Foreman::Foreman(Scheduler::Ptr const& s, uint poolSize, mysql::MySqlConfig cons
     _chunkResourceMgr = wdb::ChunkResourceMgr::newMgr(_backend);
     assert(s); // Cannot operate without scheduler.
 
-    LOGS(_log, LOG_LVL_DEBUG, "poolSize=" << poolSize);
-    _pool = util::ThreadPool::newThreadPool(poolSize, _scheduler);
+    if (stealDepth > 0) {
+        _queue = std::make_shared<WorkStealingQueue>(_scheduler, stealDepth);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "poolSize=" << poolSize << " stealDepth=" << stealDepth);
+    _pool = util::ThreadPool::newThreadPool(poolSize, _queue);
 }
 
 Foreman::~Foreman() {
@@ -95,7 +99,7 @@ void Foreman::processTask(std::shared_ptr<wbase::Task> const& task) {
 
     task->setFunc(func);
     _queries->addTask(task);
-    _scheduler->queCmd(task);
+    _queue->queCmd(task);
 }
 
 }}} // namespace
@@ -69,8 +69,11 @@ public:
 /// The schedulers may limit the number of threads they will use from the thread pool.
 class Foreman : public wbase::MsgProcessor {
 public:
+    /// @param stealDepth - if not 0, the pool threads take this many Tasks from
+    ///                     the scheduler at once and steal from each other,
+    ///                     see WorkStealingQueue.
     Foreman(Scheduler::Ptr const& s, uint poolSize, mysql::MySqlConfig const& mySqlConfig,
-            wpublish::QueriesAndChunks::Ptr const& queries);
+            wpublish::QueriesAndChunks::Ptr const& queries, uint stealDepth=0);
     virtual ~Foreman();
     // This class should not be copied.
     Foreman(Foreman const&) = delete;
@@ -83,6 +86,7 @@ private:
     std::shared_ptr<wdb::ChunkResourceMgr> _chunkResourceMgr;
     util::ThreadPool::Ptr _pool;
     Scheduler::Ptr _scheduler;
+    util::CommandQueue::Ptr _queue; ///< Feeds _pool, _scheduler or a WorkStealingQueue in front of it
     mysql::MySqlConfig const _mySqlConfig;
     wpublish::QueriesAndChunks::Ptr _queries;
 
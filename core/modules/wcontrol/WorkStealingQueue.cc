@@ -0,0 +1,268 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wcontrol/WorkStealingQueue.h"
+
+// System headers
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "wbase/Task.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wcontrol.WorkStealingQueue");
+
+/// Longest a parked thread waits before looking for work again. This catches
+/// Tasks the scheduler makes ready on its own, e.g. when a query is moved to
+/// the snail scan.
+std::chrono::milliseconds const PARK_TIMEOUT(100);
+
+std::atomic<int> nextId{0};
+
+/// @return the Task in cmd, or nullptr if it is some other Command.
+lsst::qserv::wbase::Task* asTask(lsst::qserv::util::Command::Ptr const& cmd) {
+    return dynamic_cast<lsst::qserv::wbase::Task*>(cmd.get());
+}
+
+/// @return the chunk of the Task in cmd, or -1 if it is not a Task.
+int chunkOf(lsst::qserv::util::Command::Ptr const& cmd) {
+    auto task = asTask(cmd);
+    return task == nullptr ? -1 : task->getChunkId();
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+WorkStealingQueue::WorkStealingQueue(util::CommandQueue::Ptr const& scheduler, unsigned int depth)
+    : _scheduler{scheduler}, _depth{std::max(depth, 1u)}, _id{nextId++} {
+    LOGS(_log, LOG_LVL_DEBUG, "WorkStealingQueue depth=" << _depth);
+}
+
+
+void WorkStealingQueue::queCmd(util::Command::Ptr const& cmd) {
+    _scheduler->queCmd(cmd);
+    _wake(false);
+}
+
+
+util::Command::Ptr WorkStealingQueue::getCmd(bool wait) {
+    auto slot = _getSlot();
+    while (true) {
+        std::uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(_mx);
+            generation = _generation;
+        }
+        util::Command::Ptr cmd = _popLocal(*slot);
+        if (cmd != nullptr) {
+            return _handOut(*slot, cmd, _localCount);
+        }
+        cmd = _fetch(*slot);
+        if (cmd != nullptr) {
+            return cmd;
+        }
+        cmd = _steal(slot);
+        if (cmd != nullptr) {
+            return _handOut(*slot, cmd, _stolenCount);
+        }
+        if (!wait) {
+            return nullptr;
+        }
+        // Anything queued or finished since generation was read changes it,
+        // so it cannot be missed.
+        std::unique_lock<std::mutex> lock(_mx);
+        ++_parked;
+        _cv.wait_for(lock, PARK_TIMEOUT, [this, generation]() { return _generation != generation; });
+        --_parked;
+    }
+}
+
+
+void WorkStealingQueue::notify(bool all) {
+    _scheduler->notify(all);
+    _wake(all);
+}
+
+
+void WorkStealingQueue::commandStart(util::Command::Ptr const& cmd) {
+    if (asTask(cmd) != nullptr) {
+        _getSlot()->lastChunk = chunkOf(cmd);
+    }
+    _scheduler->commandStart(cmd);
+}
+
+
+void WorkStealingQueue::commandFinish(util::Command::Ptr const& cmd) {
+    _scheduler->commandFinish(cmd);
+    // The finishing thread looks for work anyway, but a thread that left the
+    // pool will not, and may still hold Tasks in its deque.
+    _wake(false);
+}
+
+
+/// @return the slot of the calling thread, making it on the first call.
+WorkStealingQueue::Slot::Ptr WorkStealingQueue::_getSlot() {
+    struct ThreadSlots {
+        std::map<int, Slot::Ptr> slots;
+        ~ThreadSlots() {
+            for (auto& elem : slots) {
+                elem.second->owned = false;
+            }
+        }
+    };
+    static thread_local ThreadSlots threadSlots;
+    auto& slot = threadSlots.slots[_id];
+    if (slot == nullptr) {
+        slot = std::make_shared<Slot>();
+        std::lock_guard<std::mutex> lock(_slotsMx);
+        _slots.push_back(slot);
+    }
+    return slot;
+}
+
+
+util::Command::Ptr WorkStealingQueue::_popLocal(Slot& slot) {
+    std::lock_guard<std::mutex> lock(slot.mx);
+    if (slot.cmds.empty()) {
+        return nullptr;
+    }
+    auto cmd = std::move(slot.cmds.front());
+    slot.cmds.pop_front();
+    return cmd;
+}
+
+
+/// Take up to _depth commands from the scheduler, return the one to run now
+/// and keep the rest in slot.
+util::Command::Ptr WorkStealingQueue::_fetch(Slot& slot) {
+    auto cmd = _scheduler->getCmd(false);
+    if (cmd == nullptr) {
+        return nullptr;
+    }
+    if (asTask(cmd) != nullptr) {
+        std::vector<util::Command::Ptr> extra;
+        for (unsigned int j=1; j < _depth; ++j) {
+            auto next = _scheduler->getCmd(false);
+            if (next == nullptr) {
+                break;
+            }
+            extra.push_back(next);
+            // Other commands may stop the thread, so nothing goes after them.
+            if (asTask(next) == nullptr) {
+                break;
+            }
+        }
+        if (slot.lastChunk >= 0 && chunkOf(cmd) != slot.lastChunk) {
+            for (auto& next : extra) {
+                if (chunkOf(next) == slot.lastChunk) {
+                    std::swap(cmd, next);
+                    break;
+                }
+            }
+        }
+        if (!extra.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(slot.mx);
+                slot.cmds.insert(slot.cmds.end(), extra.begin(), extra.end());
+            }
+            _wake(false); // An idle thread may steal them.
+        }
+    }
+    return _handOut(slot, cmd, _schedulerCount);
+}
+
+
+/// Take a command from the back of another thread's deque, preferring Tasks
+/// on the chunk thief ran last.
+util::Command::Ptr WorkStealingQueue::_steal(Slot::Ptr const& thief) {
+    std::vector<Slot::Ptr> victims;
+    {
+        std::lock_guard<std::mutex> lock(_slotsMx);
+        // Forget the slots of threads that have exited, once they are empty.
+        auto end = std::remove_if(_slots.begin(), _slots.end(), [](Slot::Ptr const& slot) {
+            if (slot->owned) {
+                return false;
+            }
+            std::lock_guard<std::mutex> slotLock(slot->mx);
+            return slot->cmds.empty();
+        });
+        _slots.erase(end, _slots.end());
+        victims = _slots;
+    }
+    for (int pass=0; pass < 2; ++pass) {
+        bool const sameChunkOnly = pass == 0;
+        if (sameChunkOnly && thief->lastChunk < 0) {
+            continue;
+        }
+        for (auto const& victim : victims) {
+            if (victim == thief) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(victim->mx);
+            if (victim->cmds.empty()
+                || (sameChunkOnly && chunkOf(victim->cmds.back()) != thief->lastChunk)) {
+                continue;
+            }
+            auto cmd = std::move(victim->cmds.back());
+            victim->cmds.pop_back();
+            return cmd;
+        }
+    }
+    return nullptr;
+}
+
+
+util::Command::Ptr WorkStealingQueue::_handOut(Slot& slot, util::Command::Ptr const& cmd,
+                                               std::atomic<std::uint64_t>& counter) {
+    ++counter;
+    if (slot.lastChunk >= 0 && chunkOf(cmd) == slot.lastChunk) {
+        ++_sameChunkCount;
+    }
+    return cmd;
+}
+
+
+/// Tell parked threads there may be something to do.
+void WorkStealingQueue::_wake(bool all) {
+    std::lock_guard<std::mutex> lock(_mx);
+    ++_generation;
+    if (_parked > 0) {
+        if (all) {
+            _cv.notify_all();
+        } else {
+            _cv.notify_one();
+        }
+    }
+}
+
+}}} // namespace lsst::qserv::wcontrol
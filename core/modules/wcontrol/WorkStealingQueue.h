@@ -0,0 +1,113 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_WCONTROL_WORKSTEALINGQUEUE_H
+#define LSST_QSERV_WCONTROL_WORKSTEALINGQUEUE_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Qserv headers
+#include "util/EventThread.h"
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+/// WorkStealingQueue sits between a ThreadPool and its scheduler, e.g.
+///     ThreadPool::newThreadPool(n, std::make_shared<WorkStealingQueue>(blendSched, 2));
+///
+/// The scheduler still decides which Tasks run and accounts for them, but a
+/// thread that visits it takes up to depth Tasks at once. It runs the one on
+/// the chunk it ran last, if there is one, and keeps the rest in a deque of
+/// its own, which it works through before visiting the scheduler again.
+/// Threads with nothing to do steal from the back of the other deques,
+/// preferring Tasks on their own last chunk. Idle threads park on this
+/// queue, not on the scheduler, so queCmd(), commandFinish() and notify()
+/// must go through this object.
+///
+/// Tasks held in a deque count as in flight for the scheduler, so a large
+/// depth makes its thread limits coarser.
+class WorkStealingQueue : public util::CommandQueue {
+public:
+    using Ptr = std::shared_ptr<WorkStealingQueue>;
+
+    /// @param depth - Tasks taken from the scheduler per visit, at least 1.
+    WorkStealingQueue(util::CommandQueue::Ptr const& scheduler, unsigned int depth);
+    WorkStealingQueue(WorkStealingQueue const&) = delete;
+    WorkStealingQueue& operator=(WorkStealingQueue const&) = delete;
+
+    void queCmd(util::Command::Ptr const& cmd) override;
+    util::Command::Ptr getCmd(bool wait=true) override;
+    void notify(bool all=true) override;
+    void commandStart(util::Command::Ptr const& cmd) override;
+    void commandFinish(util::Command::Ptr const& cmd) override;
+
+    unsigned int getDepth() const { return _depth; }
+    std::uint64_t getSchedulerCount() const { return _schedulerCount; } ///< Commands from the scheduler
+    std::uint64_t getLocalCount() const { return _localCount; }  ///< Commands from the thread's deque
+    std::uint64_t getStolenCount() const { return _stolenCount; } ///< Commands from other deques
+    std::uint64_t getSameChunkCount() const { return _sameChunkCount; } ///< Tasks on the thread's last chunk
+
+private:
+    /// The deque of one thread.
+    struct Slot {
+        using Ptr = std::shared_ptr<Slot>;
+        std::mutex mx;
+        std::deque<util::Command::Ptr> cmds;
+        int lastChunk{-1};          ///< Only used by the owning thread
+        std::atomic<bool> owned{true}; ///< false once the thread has exited
+    };
+
+    Slot::Ptr _getSlot();
+    util::Command::Ptr _popLocal(Slot& slot);
+    util::Command::Ptr _fetch(Slot& slot);
+    util::Command::Ptr _steal(Slot::Ptr const& thief);
+    util::Command::Ptr _handOut(Slot& slot, util::Command::Ptr const& cmd,
+                                std::atomic<std::uint64_t>& counter);
+    void _wake(bool all);
+
+    util::CommandQueue::Ptr _scheduler;
+    unsigned int const _depth;
+    int const _id; ///< Tells apart queues in the slots of a thread
+
+    std::mutex _slotsMx; ///< Protects _slots
+    std::vector<Slot::Ptr> _slots;
+
+    std::uint64_t _generation{0}; ///< Changes when there may be new work, protected by _mx
+    int _parked{0};               ///< Threads waiting on _cv, protected by _mx
+
+    std::atomic<std::uint64_t> _schedulerCount{0};
+    std::atomic<std::uint64_t> _localCount{0};
+    std::atomic<std::uint64_t> _stolenCount{0};
+    std::atomic<std::uint64_t> _sameChunkCount{0};
+};
+
+}}} // namespace lsst::qserv::wcontrol
+
+#endif // LSST_QSERV_WCONTROL_WORKSTEALINGQUEUE_H
@@ -53,15 +53,17 @@
 #include "mysql/MySqlConfig.h"
 #include "mysql/MySqlConnection.h"
 #include "mysql/SchemaFactory.h"
+#include "proto/MsgPool.h"
 #include "proto/ProtoHeaderWrap.h"
+#include "proto/ResultCompression.h"
 #include "proto/worker.pb.h"
 #include "sql/Schema.h"
 #include "sql/SqlErrorObject.h"
 #include "util/common.h"
 #include "util/MultiError.h"
-#include "util/StringHash.h"
 #include "util/threadSafe.h"
 #include "wbase/Base.h"
+#include "wbase/MsgBufferPool.h"
 #include "wbase/SendChannel.h"
 #include "wdb/ChunkResource.h"
 
@@ -73,6 +75,8 @@ namespace lsst {
 namespace qserv {
 namespace wdb {
 
+std::atomic<proto::ProtoHeader::CompressionType> QueryRunner::_defaultCompression{proto::ProtoHeader::NONE};
+
 QueryRunner::Ptr QueryRunner::newQueryRunner(wbase::Task::Ptr const& task,
                                              ChunkResourceMgr::Ptr const& chunkResourceMgr,
                                              mysql::MySqlConfig const& mySqlConfig) {
@@ -132,6 +136,7 @@ bool QueryRunner::runQuery() {
         wbase::TaskQueryRunner *_tqr;
     };
     Release release(_task, this);
+    _threadId = std::this_thread::get_id();
 
     if (_task->getCancelled()) {
         LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " runQuery, task was cancelled before it started.");
@@ -179,16 +184,40 @@ MYSQL_RES* QueryRunner::_primeResult(std::string const& query) {
 
 void QueryRunner::_initMsgs() {
     _protoHeader = std::make_shared<proto::ProtoHeader>();
+    // Protocol 3 only goes to czars that asked for it.
+    if (_task->msg->has_maxprotocol() && _task->msg->maxprotocol() >= 3) {
+        _resultProtocol = 3;
+    }
+    // Czars predating compression cannot uncompress.
+    if (_task->msg->compressionok()) {
+        _compression = _task->msg->has_resultcompression() ?
+            _task->msg->resultcompression() : _defaultCompression.load();
+    }
     _initMsg();
 }
 
 void QueryRunner::_initMsg() {
-    _result = std::make_shared<proto::Result>();
+    // Refill the previous message in place, reusing its RowBundles and strings.
+    if (_result) {
+        _result->Clear();
+    } else {
+        _result = proto::MsgPool<proto::Result>::getPool().acquire();
+    }
     _result->mutable_rowschema();
     _result->set_continues(0);
     if (_task->msg->has_session()) {
         _result->set_session(_task->msg->session());
     }
+    _initColumnar();
+}
+
+/// Start filling the columnar rows of _result, once the schema is known.
+void QueryRunner::_initColumnar() {
+    _columnarBuilder.reset();
+    if (_resultProtocol >= 3 && !_columnEncodings.empty()) {
+        _columnarBuilder.reset(new proto::ColumnarRowsBuilder(*_result->mutable_columnar(),
+                                                              _columnEncodings));
+    }
 }
 
 void QueryRunner::_fillSchema(MYSQL_RES* result) {
@@ -208,18 +237,51 @@ void QueryRunner::_fillSchema(MYSQL_RES* result) {
         }
         cs->set_sqltype(i->colType.sqlType);
         cs->set_mysqltype(i->colType.mysqlType);
+        _columnEncodings.push_back(_columnEncoding(i->colType.mysqlType));
     }
+    _initColumnar();
 }
 
-/// Fill one row in the Result msg from one row in MYSQL_RES*
-/// If the message has gotten larger than the desired message size,
-/// it will be transmitted with a flag set indicating the result
-/// continues in later messages.
+/// @return how a column of mysqlType is shipped in protocol 3. FLOAT and
+/// DECIMAL stay TEXT: MySQL rounds FLOAT text, and a parsed DECIMAL may not
+/// format back to the same digits.
+proto::ResultColumn::Encoding QueryRunner::_columnEncoding(int mysqlType) {
+    switch (mysqlType) {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_LONGLONG:
+        return proto::ResultColumn::INT64;
+    case MYSQL_TYPE_DOUBLE:
+        return proto::ResultColumn::DOUBLE;
+    default:
+        return proto::ResultColumn::TEXT;
+    }
+}
+
+/// Fill rows in the Result msg from the rows in MYSQL_RES*
 bool QueryRunner::_fillRows(MYSQL_RES* result, int numFields, uint& rowCount, size_t& tSize) {
     MYSQL_ROW row;
 
     while ((row = mysql_fetch_row(result))) {
         auto lengths = mysql_fetch_lengths(result);
+        if (!_addRow(row, lengths, numFields, rowCount, tSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Fill one row in the Result msg from one row of a MySQL result.
+/// If the message has gotten larger than the desired message size,
+/// it will be transmitted with a flag set indicating the result
+/// continues in later messages.
+bool QueryRunner::_addRow(MYSQL_ROW row, unsigned long* lengths, int numFields,
+                          uint& rowCount, size_t& tSize) {
+    if (_columnarBuilder) {
+        tSize += _columnarBuilder->addRow(row, lengths);
+    } else {
         proto::RowBundle* rawRow =_result->add_row();
         for(int i=0; i < numFields; ++i) {
             if (row[i]) {
@@ -231,44 +293,123 @@ bool QueryRunner::_fillRows(MYSQL_RES* result, int numFields, uint& rowCount, si
             }
         }
         tSize += rawRow->ByteSize();
-        ++rowCount;
+    }
+    ++rowCount;
 
-        // Each element needs to be mysql-sanitized
-        if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT) {
-            if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT) {
-                LOGS_ERROR("Message single row too large to send using protobuffer");
-                return false;
-            }
-            LOGS(_log, LOG_LVL_DEBUG, "Large message size=" << tSize
-                 << ", splitting message rowCount=" << rowCount);
-            _transmit(false, rowCount, tSize);
-            rowCount = 0;
-            tSize = 0;
-            _initMsg();
-            // This task is going to have multiple results to return to the czar and
-            // the speed this task can be completed will be limited by the czar's ability to
-            // read in results, which could be very very slow. The upshot of this is the
-            // scheduler for this worker should stop waiting for this task. leavePool()
-            // will tell the scheduler this task is finished and create a new thread in the pool
-            // to replace this one.
-            auto pet = _task->getAndNullPoolEventThread();
-            if (pet != nullptr) {
-                pet->leavePool();
-            } else {
-                LOGS(_log, LOG_LVL_DEBUG, "Large result PoolEventThread was null. Probably already moved.");
-            }
+    // Each element needs to be mysql-sanitized
+    if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT) {
+        if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT) {
+            LOGS_ERROR("Message single row too large to send using protobuffer");
+            return false;
         }
+        LOGS(_log, LOG_LVL_DEBUG, "Large message size=" << tSize
+             << ", splitting message rowCount=" << rowCount);
+        // This task is going to have multiple results to return to the czar and
+        // the speed this task can be completed will be limited by the czar's ability to
+        // read in results, which could be very very slow. The upshot of this is the
+        // scheduler for this worker should stop waiting for this task. leavePool()
+        // will tell the scheduler this task is finished and create a new thread in the pool
+        // to replace this one. It must be called from that thread, so the rows of a
+        // fused scan added from the thread of another Task leave it to runPending().
+        // It comes before sending, which may wait for the czar (see ChannelStream).
+        if (std::this_thread::get_id() == _threadId) {
+            _leavePool();
+        } else {
+            _leavePoolPending = true;
+            _hasPending = true;
+        }
+        _transmit(false, rowCount, tSize);
+        rowCount = 0;
+        tSize = 0;
+        _initMsg();
     }
     return true;
 }
 
+/// Have the thread running this Task leave the pool.
+void QueryRunner::_leavePool() {
+    auto pet = _task->getAndNullPoolEventThread();
+    if (pet != nullptr) {
+        pet->leavePool(_task);
+    } else {
+        LOGS(_log, LOG_LVL_DEBUG, "Large result PoolEventThread was null. Probably already moved.");
+    }
+}
+
+/// Add a row selected for this Task by a fused scan.
+void QueryRunner::addFusedRow(char** row, unsigned long* lengths) {
+    bool woke = false;
+    {
+        std::lock_guard<std::mutex> lock(_fusedMtx);
+        if (_cancelled || _fusedErred || _fusedDetached) {
+            return;
+        }
+        bool const hadPending = _hasPending;
+        if (!_addRow(row, lengths, _numFields, _rowCount, _tSize)) {
+            _fusedErred = true;
+        }
+        woke = !hadPending && _hasPending;
+    }
+    if (woke) {
+        ScanFusion::getDefault().wake();
+    }
+}
+
+/// Send the messages and leave the pool as the rows added by the leader of
+/// a fused scan require, from the thread of this Task waiting for the scan.
+void QueryRunner::runPending() {
+    std::deque<std::pair<std::string, bool>> pending;
+    bool leave = false;
+    {
+        std::lock_guard<std::mutex> lock(_fusedMtx);
+        pending.swap(_pending);
+        std::swap(leave, _leavePoolPending);
+        _hasPending = false;
+    }
+    // Leave first, as sending may wait for the czar.
+    if (leave) {
+        _leavePool();
+    }
+    for (auto& msg : pending) {
+        if (_cancelled) {
+            break;
+        }
+        if (!_sendStream(std::move(msg.first), msg.second)) {
+            LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit fused scan message!");
+        }
+    }
+}
+
+/// Stop taking rows from the leader of a fused scan, and do the work it left.
+void QueryRunner::_leaveFusedScan() {
+    {
+        std::lock_guard<std::mutex> lock(_fusedMtx);
+        _fusedDetached = true;
+    }
+    runPending();
+}
+
+/// Send msg through the channel of the Task. The leader of a fused scan
+/// queues it instead, as the czar of this Task may be slow to take it.
+bool QueryRunner::_sendStream(std::string&& msg, bool last) {
+    if (std::this_thread::get_id() != _threadId) {
+        // _fusedMtx is held by addFusedRow().
+        _pending.emplace_back(std::move(msg), last);
+        _hasPending = true;
+        return true;
+    }
+    return _task->sendChannel->sendStream(std::move(msg), last);
+}
+
 /// Transmit result data with its header.
 /// If 'last' is true, this is the last message in the result set
 /// and flags are set accordingly.
 void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
     LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _transmit last=" << last
          << " rowCount=" << rowCount << " tSize=" << tSize);
-    std::string resultString;
+    // Serialize into a recycled buffer, which is then moved all the way to
+    // XrdSsi and returned to the pool once sent.
+    std::string resultString = wbase::MsgBufferPool::getPool().acquire(tSize);
     _result->set_queryid(_task->getQueryId());
     _result->set_jobid(_task->getJobId());
     _result->set_continues(!last);
@@ -282,16 +423,26 @@ void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
         LOGS(_log, LOG_LVL_ERROR, msg);
     }
     _result->SerializeToString(&resultString);
+    _protoHeader->clear_compression();
+    _protoHeader->clear_rawsize();
+    if (_compression != proto::ProtoHeader::NONE) {
+        std::string compressed = wbase::MsgBufferPool::getPool().acquire(resultString.size());
+        if (proto::ResultCompression::compress(*_protoHeader, _compression, resultString, compressed)) {
+            resultString.swap(compressed);
+        }
+        wbase::MsgBufferPool::getPool().release(std::move(compressed));
+    }
     _transmitHeader(resultString);
     LOGS(_log, LOG_LVL_DEBUG, "_transmit last=" << last << " " << _task->getIdStr()
          << " resultString=" << util::prettyCharList(resultString, 5));
     if (!_cancelled) {
-        bool sent = _task->sendChannel->sendStream(resultString.data(), resultString.size(), last);
+        bool sent = _sendStream(std::move(resultString), last);
         if (!sent) {
             LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit message!");
         }
     } else {
         LOGS(_log, LOG_LVL_DEBUG, "_transmit cancelled");
+        wbase::MsgBufferPool::getPool().release(std::move(resultString));
     }
     _largeResult = true; // Transmits after the first are considered large results.
 }
@@ -300,9 +451,12 @@ void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
 void QueryRunner::_transmitHeader(std::string& msg) {
     LOGS(_log, LOG_LVL_DEBUG, "_transmitHeader");
     // Set header
-    _protoHeader->set_protocol(2); // protocol 2: row-by-row message
+    _protoHeader->set_protocol(_resultProtocol); // 2: row-by-row, 3: columnar message
     _protoHeader->set_size(msg.size());
-    _protoHeader->set_md5(util::StringHash::getMd5(msg.data(), msg.size()));
+    // The czar asks for the checksum it wants, czars predating that get MD5.
+    proto::ProtoHeader::ChecksumType checksumType = _task->msg->has_checksumtype() ?
+        _task->msg->checksumtype() : proto::ProtoHeader::MD5;
+    proto::ProtoHeaderWrap::setChecksum(*_protoHeader, checksumType, msg.data(), msg.size());
     _protoHeader->set_wname(getHostname());
     std::string protoHeaderString;
     _protoHeader->SerializeToString(&protoHeaderString);
@@ -312,7 +466,7 @@ void QueryRunner::_transmitHeader(std::string& msg) {
     assert(protoHeaderString.size() < 255);
     auto msgBuf = proto::ProtoHeaderWrap::wrap(protoHeaderString);
     if (!_cancelled) {
-        bool sent = _task->sendChannel->sendStream(msgBuf.data(), msgBuf.size(), false);
+        bool sent = _sendStream(std::move(msgBuf), false);
         if (!sent) {
             LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit header!");
         }
@@ -364,6 +518,9 @@ bool QueryRunner::_dispatchChannel() {
     if (m.fragment_size() < 1) {
         throw Bug("QueryRunner: No fragments to execute in TaskMsg");
     }
+    if (_isFusible()) {
+        return _dispatchFused();
+    }
     ChunkResourceRequest req(_chunkResourceMgr, m);
 
     uint rowCount = 0;
@@ -402,21 +559,142 @@ bool QueryRunner::_dispatchChannel() {
         util::Error worker_err(e.errNo(), e.errMsg());
         _multiError.push_back(worker_err);
     }
+    _rowCount = rowCount;
+    _tSize = tSize;
+    _finishChannel(erred);
+    return !erred;
+}
+
+/// Send the last message of the result.
+void QueryRunner::_finishChannel(bool& erred) {
     if (!_cancelled) {
         // Send results.
-        _transmit(true, rowCount, tSize);
+        _transmit(true, _rowCount, _tSize);
     } else {
         erred = true;
         // Send poison error.
         _multiError.push_back(util::Error(-1, "Poisoned."));
         // Do we need to do any cleanup?
     }
+}
+
+/// @return true if the Task is a single query that can share its scan.
+bool QueryRunner::_isFusible() {
+    proto::TaskMsg const& m = *_task->msg;
+    if (!ScanFusion::getDefault().isEnabled() || m.scantable_size() == 0 || m.fragment_size() != 1) {
+        return false;
+    }
+    proto::TaskMsg_Fragment const& fragment(m.fragment(0));
+    return !fragment.has_subchunks() && fragment.query_size() == 1
+        && _scanQuery.parse(fragment.query(0));
+}
+
+/// Run the query of the Task, sharing the scan of its table with the Tasks
+/// on the same chunk table that come while it is being scanned.
+bool QueryRunner::_dispatchFused() {
+    proto::TaskMsg& m = *_task->msg;
+    ChunkResourceRequest req(_chunkResourceMgr, m);
+    auto& fusion = ScanFusion::getDefault();
+    bool erred = false;
+    try {
+        ChunkResource cr(req.getResourceFragment(0));
+        // Every Task needs the schema of its own result, which reading no
+        // rows gives cheaply.
+        MYSQL_RES* res = _primeResult(_scanQuery.makeSchemaQuery());
+        if (!res) {
+            erred = true;
+        } else {
+            _fillSchema(res);
+            _numFields = mysql_num_fields(res);
+            _mysqlConn->freeResult();
+
+            std::string const key = _task->user + ":" + m.db() + ":" + std::to_string(m.chunkid())
+                + ":" + _scanQuery.getFrom();
+            auto batch = fusion.join(key, shared_from_this());
+            if (batch->members.front().get() != this) {
+                // Another Task has scanned for this one, unless this one was
+                // cancelled first.
+                _leaveFusedScan();
+                if (!batch->done) {
+                    erred = true;
+                } else if (!batch->error.empty()) {
+                    _multiError.push_back(util::Error(-1, batch->error));
+                    erred = true;
+                }
+            } else {
+                try {
+                    if (batch->members.size() == 1) {
+                        res = _primeResult(m.fragment(0).query(0));
+                        erred = res == nullptr || !_fillRows(res, _numFields, _rowCount, _tSize);
+                        if (res) {
+                            _mysqlConn->freeResult();
+                        }
+                    } else {
+                        _leadingFusedScan = true;
+                        erred = !_scanFor(batch->members);
+                        _leadingFusedScan = false;
+                    }
+                } catch(...) {
+                    fusion.finish(key, batch, "Fused scan failed");
+                    throw;
+                }
+                fusion.finish(key, batch, erred ? "Fused scan failed: " + _multiError.toOneLineString()
+                                                : std::string());
+            }
+        }
+    } catch(sql::SqlErrorObject const& e) {
+        util::Error worker_err(e.errNo(), e.errMsg());
+        _multiError.push_back(worker_err);
+    }
+    erred = erred || _fusedErred;
+    _finishChannel(erred);
     return !erred;
 }
 
+/// Scan the table once for all of members, giving each the rows it selects.
+bool QueryRunner::_scanFor(std::vector<ScanFusion::Member::Ptr> const& members) {
+    std::vector<ScanQuery const*> queries;
+    unsigned int numFields = 0;
+    for (auto const& member : members) {
+        queries.push_back(&member->getScanQuery());
+        numFields += 1 + member->getFieldCount();
+    }
+    MYSQL_RES* res = _primeResult(ScanQuery::makeFusedQuery(queries));
+    if (!res) {
+        return false;
+    }
+    if (mysql_num_fields(res) != numFields) {
+        _mysqlConn->freeResult();
+        _multiError.push_back(util::Error(-1, "Fused scan returned unexpected columns"));
+        return false;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " fused scan for " << members.size() << " tasks");
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(res))) {
+        auto lengths = mysql_fetch_lengths(res);
+        int offset = 0;
+        for (auto const& member : members) {
+            // The flag column of member, then its columns.
+            if (row[offset] != nullptr && row[offset][0] == '1') {
+                member->addFusedRow(row + offset + 1, lengths + offset + 1);
+            }
+            offset += 1 + member->getFieldCount();
+        }
+    }
+    _mysqlConn->freeResult();
+    return true;
+}
+
 void QueryRunner::cancel() {
     LOGS(_log, LOG_LVL_WARN, "Trying QueryRunner::cancel() call, experimental");
     _cancelled.store(true);
+    // Stop waiting for a fused scan led by another Task.
+    ScanFusion::getDefault().wake();
+    if (_leadingFusedScan) {
+        // Other Tasks still need the scan, rows just stop being kept for this one.
+        LOGS(_log, LOG_LVL_WARN, "QueryRunner::cancel() leaving fused scan running");
+        return;
+    }
     if (!_mysqlConn.get()) {
         LOGS(_log, LOG_LVL_WARN, "QueryRunner::cancel() no MysqlConn");
         return;
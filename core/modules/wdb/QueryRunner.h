@@ -35,21 +35,22 @@
 
 // System headers
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
 #include "mysql/MySqlConnection.h"
+#include "proto/ColumnarRows.h"
 #include "util/MultiError.h"
 #include "wbase/Task.h"
 #include "wdb/ChunkResource.h"
-
-namespace lsst {
-namespace qserv {
-namespace proto {
-class ProtoHeader;
-class Result;
-}}}
+#include "wdb/ScanFusion.h"
 
 namespace lsst {
 namespace qserv {
@@ -57,7 +58,8 @@ namespace wdb {
 
 /// On the worker, run a query related to a Task, writing the results to a table or supplied SendChannel.
 ///
-class QueryRunner : public wbase::TaskQueryRunner, public std::enable_shared_from_this<QueryRunner> {
+class QueryRunner : public wbase::TaskQueryRunner, public ScanFusion::Member,
+                    public std::enable_shared_from_this<QueryRunner> {
 public:
     using Ptr = std::shared_ptr<QueryRunner>;
     static QueryRunner::Ptr newQueryRunner(wbase::Task::Ptr const& task,
@@ -71,6 +73,19 @@ public:
     bool runQuery() override;
     void cancel() override; ///< Cancel the action (in-progress)
 
+    ScanQuery const& getScanQuery() const override { return _scanQuery; }
+    int getFieldCount() const override { return _numFields; }
+    void addFusedRow(char** row, unsigned long* lengths) override;
+    bool isCancelled() const override { return _cancelled; }
+    bool hasPending() const override { return _hasPending; }
+    void runPending() override;
+
+    /// Set the codec compressing results for czars that accept compression
+    /// but leave the choice to the worker.
+    static void setDefaultCompression(proto::ProtoHeader::CompressionType compression) {
+        _defaultCompression = compression;
+    }
+
 protected:
     QueryRunner(wbase::Task::Ptr const& task,
                 ChunkResourceMgr::Ptr const& chunkResourceMgr,
@@ -79,14 +94,24 @@ private:
     bool _initConnection();
     void _setDb();
     bool _dispatchChannel(); ///< Dispatch with output sent through a SendChannel
+    bool _isFusible();
+    bool _dispatchFused();
+    bool _scanFor(std::vector<ScanFusion::Member::Ptr> const& members);
+    void _leaveFusedScan();
+    void _finishChannel(bool& erred);
     MYSQL_RES* _primeResult(std::string const& query); ///< Obtain a result handle for a query.
 
     bool _fillRows(MYSQL_RES* result, int numFields, uint& rowCount, size_t& tsize);
+    bool _addRow(MYSQL_ROW row, unsigned long* lengths, int numFields, uint& rowCount, size_t& tSize);
     void _fillSchema(MYSQL_RES* result);
     void _initMsgs();
     void _initMsg();
+    void _initColumnar();
+    static proto::ResultColumn::Encoding _columnEncoding(int mysqlType);
     void _transmit(bool last, uint rowCount, size_t size);
     void _transmitHeader(std::string& msg);
+    bool _sendStream(std::string&& msg, bool last);
+    void _leavePool();
 
     ///< Actual task
     wbase::Task::Ptr _task;
@@ -95,14 +120,36 @@ private:
     ChunkResourceMgr::Ptr _chunkResourceMgr;
     std::string _dbName;
     std::atomic<bool> _cancelled{false};
+    std::thread::id _threadId; ///< Of the thread running the Task
     mysql::MySqlConfig const _mySqlConfig;
     std::unique_ptr<mysql::MySqlConnection> _mysqlConn;
 
     util::MultiError _multiError; // Error log
 
     std::shared_ptr<proto::ProtoHeader> _protoHeader;
-    std::shared_ptr<proto::Result> _result;
+    std::shared_ptr<proto::Result> _result; ///< From proto::MsgPool, refilled per message
     bool _largeResult{false}; //< True for all transmits after the first transmit.
+
+    int _resultProtocol{2}; ///< 2: rows in RowBundles, 3: in ColumnarRows
+    std::vector<proto::ResultColumn::Encoding> _columnEncodings; ///< Protocol 3 only
+    std::unique_ptr<proto::ColumnarRowsBuilder> _columnarBuilder; ///< Fills _result, protocol 3
+
+    ScanQuery _scanQuery;    ///< Set if the Task may share its scan
+    int _numFields{-1};
+    uint _rowCount{0};       ///< Rows in _result, for rows added by addFusedRow()
+    size_t _tSize{0};        ///< Size of those rows
+    bool _fusedErred{false};
+    std::atomic<bool> _leadingFusedScan{false}; ///< cancel() must not stop the scan of others
+
+    // Work left by the leader of a fused scan for the thread of this Task.
+    std::mutex _fusedMtx; ///< Held while rows are added by the leader
+    std::deque<std::pair<std::string, bool>> _pending; ///< Messages to send, with their last flag
+    bool _leavePoolPending{false}; ///< The thread should leave the pool
+    bool _fusedDetached{false};    ///< No rows are taken from the leader anymore
+    std::atomic<bool> _hasPending{false};
+
+    proto::ProtoHeader::CompressionType _compression{proto::ProtoHeader::NONE};
+    static std::atomic<proto::ProtoHeader::CompressionType> _defaultCompression;
 };
 
 }}} // namespace
@@ -27,6 +27,7 @@
 
 // System headers
 #include <iostream>
+#include <vector>
 
 // Third-party headers
 
@@ -42,6 +43,18 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.ChunkResource");
 
+using lsst::qserv::wdb::ScTable;
+
+/// @return the chunk table of sc, as db.table_chunkId
+std::string chunkTableName(ScTable const& sc) {
+    return sc.db + "." + sc.table + "_" + std::to_string(sc.chunkId);
+}
+
+/// @return the key of subchunk sc, as db.table_chunkId:subChunkId
+std::string subChunkKey(ScTable const& sc) {
+    return chunkTableName(sc) + ":" + std::to_string(sc.subChunkId);
+}
+
 } // anonymous namespace
 
 
@@ -61,6 +74,9 @@ bool SQLBackend::load(ScTableVector const& v, sql::SqlErrorObject& err) {
     memLockRequireOwnership();
     for(ScTableVector::const_iterator i=v.begin(), e=v.end();
             i != e; ++i) {
+        if (i->chunkId != DUMMY_CHUNK && _isIndexed(*i) && _bind(*i)) {
+            continue;
+        }
         std::string const* createScript = nullptr;
         if (i->chunkId == DUMMY_CHUNK) {
             createScript = &CREATE_DUMMY_SUBCHUNK_SCRIPT;
@@ -96,7 +112,14 @@ void SQLBackend::_discard(ScTableVector::const_iterator begin,
               ScTableVector::const_iterator end) {
     memLockRequireOwnership();
     for(ScTableVector::const_iterator i=begin, e=end; i != e; ++i) {
-        std::string discard = (boost::format(lsst::qserv::wbase::CLEANUP_SUBCHUNK_SCRIPT)
+        std::string const* discardScript = &lsst::qserv::wbase::CLEANUP_SUBCHUNK_SCRIPT;
+        {
+            std::lock_guard<std::mutex> lock(_bindMtx);
+            if (_bound.erase(subChunkKey(*i)) > 0) {
+                discardScript = &lsst::qserv::wbase::UNBIND_SUBCHUNK_SCRIPT;
+            }
+        }
+        std::string discard = (boost::format(*discardScript)
         % i->db % i->table  % i->chunkId % i->subChunkId).str();
         sql::SqlErrorObject err;
         if (!_sqlConn.runQuery(discard, err)) {
@@ -105,6 +128,75 @@ void SQLBackend::_discard(ScTableVector::const_iterator begin,
     }
 }
 
+std::chrono::seconds const SQLBackend::INDEXED_CHECK_INTERVAL(300);
+
+bool SQLBackend::_isIndexed(ScTable const& sc) {
+    std::string const chunkTable = chunkTableName(sc);
+    auto const now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_bindMtx);
+        auto iter = _indexed.find(chunkTable);
+        if (iter != _indexed.end() && now - iter->second.checked < INDEXED_CHECK_INTERVAL) {
+            return iter->second.indexed;
+        }
+    }
+    // Both tables must have an index starting with the subchunk column.
+    std::string const chunkId = std::to_string(sc.chunkId);
+    bool indexed = false;
+    bool overlapIndexed = false;
+    sql::SqlErrorObject err;
+    if (!_hasSubChunkIndex(sc.db, sc.table + "_" + chunkId, indexed, err)
+        || (indexed && !_hasSubChunkIndex(sc.db, sc.table + "FullOverlap_" + chunkId,
+                                          overlapIndexed, err))) {
+        // Not remembered, the next subchunk tries again.
+        LOGS(_log, LOG_LVL_WARN, "isIndexed query failed, copying subchunks of " << chunkTable
+             << " err=" << err.printErrMsg());
+        return false;
+    }
+    indexed = indexed && overlapIndexed;
+    LOGS(_log, LOG_LVL_DEBUG, "isIndexed " << chunkTable << " " << indexed);
+    std::lock_guard<std::mutex> lock(_bindMtx);
+    _indexed[chunkTable] = Indexed{indexed, now};
+    return indexed;
+}
+
+bool SQLBackend::_hasSubChunkIndex(std::string const& db, std::string const& table, bool& indexed,
+                                   sql::SqlErrorObject& err) {
+    std::string const sql = "SHOW INDEX FROM `" + db + "`.`" + table + "`"
+        " WHERE Column_name = '" + SUB_CHUNK_COLUMN + "' AND Seq_in_index = 1";
+    sql::SqlResults results;
+    std::vector<std::string> keys;
+    if (!_sqlConn.runQuery(sql, results, err) || !results.extractFirstColumn(keys, err)) {
+        return false;
+    }
+    indexed = !keys.empty();
+    return true;
+}
+
+bool SQLBackend::_bind(ScTable const& sc) {
+    using namespace lsst::qserv::wbase;
+    std::string bind = (boost::format(BIND_SUBCHUNK_SCRIPT)
+        % sc.db % sc.table % SUB_CHUNK_COLUMN % sc.chunkId % sc.subChunkId).str();
+    sql::SqlErrorObject err;
+    if (_sqlConn.runQuery(bind, err)) {
+        std::lock_guard<std::mutex> lock(_bindMtx);
+        _bound.insert(subChunkKey(sc));
+        return true;
+    }
+    LOGS(_log, LOG_LVL_WARN, "bind failed for " << sc << ", copying it and checking "
+         << chunkTableName(sc) << " again. err=" << err.printErrMsg());
+    // Drop any view made before the failure, the copy must not find it in its place.
+    std::string unbind = (boost::format(UNBIND_SUBCHUNK_SCRIPT)
+        % sc.db % sc.table % sc.chunkId % sc.subChunkId).str();
+    sql::SqlErrorObject unbindErr;
+    if (!_sqlConn.runQuery(unbind, unbindErr)) {
+        LOGS(_log, LOG_LVL_WARN, "unbind failed for " << sc << " err=" << unbindErr.printErrMsg());
+    }
+    std::lock_guard<std::mutex> lock(_bindMtx);
+    _indexed.erase(chunkTableName(sc));
+    return false;
+}
+
 /// Run the 'query'. If it fails, terminate the program.
 void SQLBackend::_execLockSql(std::string const& query) {
     LOGS(_log, LOG_LVL_DEBUG, "execLockSql " << query);
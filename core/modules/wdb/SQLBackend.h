@@ -27,6 +27,9 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <sys/types.h>
@@ -71,6 +74,11 @@ typedef std::vector<ScTable> ScTableVector;
 /// in the SQLBackend constructor call to SQLBackend::_memLockAcquire(). The reason it is so important
 /// is that the in-memory tables have their schema written to disk but no data, so they are
 /// just a bunch of empty tables when the program starts up.
+///
+/// Subchunks of chunk tables that are indexed on the subchunk column (as the data loader
+/// makes them) are not copied: they are bound to views selecting the subchunk from the
+/// chunk tables, which queries read through the index. Other chunk tables, and those
+/// whose views cannot be made, fall back to the in-memory copies.
 class SQLBackend {
 public:
     using Ptr=std::shared_ptr<SQLBackend>;
@@ -115,8 +123,35 @@ protected:
     /// Exit the program immediately to reduce minimize possible problems.
     void _exitDueToConflict(const std::string& msg);
 
+    /// @return true if the chunk table of sc, and its full overlap table, are indexed on
+    ///         the subchunk column. The answer is kept for a chunk table until a bind on
+    ///         it fails, and at most INDEXED_CHECK_INTERVAL, since its tables may be
+    ///         reloaded or reindexed meanwhile.
+    bool _isIndexed(ScTable const& sc);
+
+    /// Find whether db.table has an index starting with the subchunk column.
+    /// @return false if the query failed.
+    bool _hasSubChunkIndex(std::string const& db, std::string const& table, bool& indexed,
+                           sql::SqlErrorObject& err);
+
+    /// Bind the subchunk sc to views of its chunk tables.
+    /// @return false if the views could not be made. The chunk table is then checked
+    ///         again by _isIndexed() for its next subchunk.
+    bool _bind(ScTable const& sc);
+
+    static std::chrono::seconds const INDEXED_CHECK_INTERVAL;
+
     sql::SqlConnection _sqlConn;
 
+    struct Indexed {
+        bool indexed;
+        std::chrono::steady_clock::time_point checked;
+    };
+
+    std::mutex _bindMtx; ///< Protects _indexed and _bound
+    std::map<std::string, Indexed> _indexed; ///< By chunk table, db.table_chunkId
+    std::set<std::string> _bound; ///< Subchunks bound to views, db.table_chunkId:subChunkId
+
     // Memory lock table members.
     std::atomic<bool> _lockConflict{false};
     std::atomic<bool> _lockAquired{false};
@@ -0,0 +1,310 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/ScanFusion.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.ScanFusion");
+
+/// A word of a query outside of quotes.
+struct Word {
+    std::string upper;  ///< The word in upper case
+    std::size_t pos;
+    std::size_t end;
+    int depth;          ///< Parentheses around the word
+    bool call;          ///< Followed by '('
+};
+
+std::string trim(std::string const& str) {
+    auto begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    auto end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+/// Find the words of query, and its commas outside of parentheses.
+/// @return false for comments, several statements, or unbalanced quotes or
+///         parentheses.
+bool scanQuery(std::string const& query, std::vector<Word>& words, std::vector<std::size_t>& commas) {
+    std::size_t const size = query.size();
+    int depth = 0;
+    std::size_t j = 0;
+    while (j < size) {
+        char const c = query[j];
+        if (c == '\'' || c == '"' || c == '`') {
+            std::size_t k = j + 1;
+            while (k < size && query[k] != c) {
+                k += (query[k] == '\\' && c != '`') ? 2 : 1;
+            }
+            if (k >= size) {
+                return false;
+            }
+            j = k + 1;
+        } else if ((c == '-' && j + 1 < size && query[j+1] == '-') || c == '#'
+                   || (c == '/' && j + 1 < size && query[j+1] == '*') || c == ';') {
+            return false;
+        } else if (c == '(') {
+            ++depth;
+            ++j;
+        } else if (c == ')') {
+            if (--depth < 0) {
+                return false;
+            }
+            ++j;
+        } else if (c == ',') {
+            if (depth == 0) {
+                commas.push_back(j);
+            }
+            ++j;
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            // Skip numbers, so that the exponent of 1e5 is not a word.
+            while (j < size && (std::isalnum(static_cast<unsigned char>(query[j])) || query[j] == '.')) {
+                ++j;
+            }
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            Word word;
+            word.pos = j;
+            while (j < size && (std::isalnum(static_cast<unsigned char>(query[j]))
+                                || query[j] == '_' || query[j] == '$')) {
+                word.upper += std::toupper(static_cast<unsigned char>(query[j]));
+                ++j;
+            }
+            word.end = j;
+            word.depth = depth;
+            std::size_t k = query.find_first_not_of(" \t\r\n", j);
+            word.call = k != std::string::npos && query[k] == '(';
+            words.push_back(word);
+        } else {
+            ++j;
+        }
+    }
+    return depth == 0;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+bool ScanQuery::parse(std::string const& query) {
+    // Words that make a query more than a filter over one table.
+    static std::set<std::string> const rejected{
+        "ALL", "DISTINCT", "DISTINCTROW", "FOR", "GROUP", "HAVING", "HIGH_PRIORITY", "INTO",
+        "JOIN", "LIMIT", "LOCK", "ORDER", "PROCEDURE", "SQL_BIG_RESULT", "SQL_BUFFER_RESULT",
+        "SQL_CACHE", "SQL_CALC_FOUND_ROWS", "SQL_NO_CACHE", "SQL_SMALL_RESULT", "STRAIGHT_JOIN",
+        "UNION", "WINDOW"};
+    static std::set<std::string> const aggregates{
+        "AVG", "BIT_AND", "BIT_OR", "BIT_XOR", "COUNT", "GROUP_CONCAT", "MAX", "MIN", "STD",
+        "STDDEV", "STDDEV_POP", "STDDEV_SAMP", "SUM", "VAR_POP", "VAR_SAMP", "VARIANCE"};
+
+    std::string sql = trim(query);
+    if (!sql.empty() && sql.back() == ';') {
+        sql = trim(sql.substr(0, sql.size() - 1));
+    }
+    std::vector<Word> words;
+    std::vector<std::size_t> commas;
+    if (!scanQuery(sql, words, commas) || words.empty()
+        || words[0].upper != "SELECT" || words[0].pos != 0) {
+        return false;
+    }
+    Word const* from = nullptr;
+    Word const* where = nullptr;
+    for (std::size_t j=1; j < words.size(); ++j) {
+        Word const& word = words[j];
+        if ((word.call && aggregates.count(word.upper) > 0) || word.upper == "SELECT") {
+            return false;
+        }
+        if (word.depth > 0) {
+            continue;
+        }
+        if (rejected.count(word.upper) > 0) {
+            return false;
+        }
+        if (word.upper == "FROM") {
+            if (from != nullptr) {
+                return false;
+            }
+            from = &word;
+        } else if (word.upper == "WHERE") {
+            if (from == nullptr || where != nullptr) {
+                return false;
+            }
+            where = &word;
+        }
+    }
+    if (from == nullptr) {
+        return false;
+    }
+    std::size_t const fromEnd = where == nullptr ? sql.size() : where->pos;
+    std::size_t itemStart = words[0].end;
+    for (auto comma : commas) {
+        if (comma > from->pos) {
+            return false; // More than one table
+        }
+        if (trim(sql.substr(itemStart, comma - itemStart)) == "*") {
+            return false; // Only allowed first, not in a fused query
+        }
+        itemStart = comma + 1;
+    }
+    if (trim(sql.substr(itemStart, from->pos - itemStart)) == "*") {
+        return false;
+    }
+    std::string selectList = trim(sql.substr(words[0].end, from->pos - words[0].end));
+    std::string fromTable = trim(sql.substr(from->end, fromEnd - from->end));
+    std::string whereExpr = where == nullptr ? std::string() : trim(sql.substr(where->end));
+    if (selectList.empty() || selectList == "*" || fromTable.empty()
+        || fromTable.find('(') != std::string::npos || (where != nullptr && whereExpr.empty())) {
+        return false;
+    }
+    _selectList = selectList;
+    _from = fromTable;
+    _where = whereExpr;
+    return true;
+}
+
+
+std::string ScanQuery::makeSchemaQuery() const {
+    std::string sql = "SELECT " + _selectList + " FROM " + _from;
+    if (!_where.empty()) {
+        sql += " WHERE " + _where;
+    }
+    return sql + " LIMIT 0";
+}
+
+
+std::string ScanQuery::makeFusedQuery(std::vector<ScanQuery const*> const& queries) {
+    std::ostringstream sql;
+    sql << "SELECT ";
+    bool scanAll = false;
+    for (std::size_t j=0; j < queries.size(); ++j) {
+        ScanQuery const& query = *queries[j];
+        if (j > 0) {
+            sql << ", ";
+        }
+        if (query._where.empty()) {
+            sql << "1";
+            scanAll = true;
+        } else {
+            sql << "(" << query._where << ") IS TRUE";
+        }
+        sql << " AS QS_FUSED_" << j << ", " << query._selectList;
+    }
+    if (!queries.empty()) {
+        sql << " FROM " << queries[0]->_from;
+    }
+    if (!scanAll) {
+        for (std::size_t j=0; j < queries.size(); ++j) {
+            sql << (j == 0 ? " WHERE (" : " OR (") << queries[j]->_where << ")";
+        }
+    }
+    return sql.str();
+}
+
+
+ScanFusion::Batch::Ptr ScanFusion::join(std::string const& key, Member::Ptr const& member) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    Lane& lane = _lanes[key];
+    if (lane.next != nullptr) {
+        auto batch = lane.next;
+        if (batch->members.size() < _maxTasks) {
+            batch->members.push_back(member);
+            while (!batch->done && !member->isCancelled()) {
+                if (member->hasPending()) {
+                    lock.unlock();
+                    member->runPending();
+                    lock.lock();
+                } else {
+                    _cv.wait(lock);
+                }
+            }
+            return batch;
+        }
+        // The next scan is full, so scan alone now.
+        batch = std::make_shared<Batch>();
+        batch->members.push_back(member);
+        batch->inLane = false;
+        return batch;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->members.push_back(member);
+    if (lane.running) {
+        // Lead the next scan, once the running one is done.
+        lane.next = batch;
+        _cv.wait(lock, [&lane]() { return !lane.running; });
+        lane.next.reset();
+        if (batch->members.size() > 1) {
+            ++_fusedScans;
+            _fusedTasks += batch->members.size();
+        }
+        LOGS(_log, LOG_LVL_DEBUG, key << " scan for " << batch->members.size() << " tasks");
+    }
+    lane.running = true;
+    return batch;
+}
+
+
+void ScanFusion::finish(std::string const& key, Batch::Ptr const& batch, std::string const& error) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    batch->error = error;
+    batch->done = true;
+    if (batch->inLane) {
+        auto iter = _lanes.find(key);
+        if (iter != _lanes.end()) {
+            iter->second.running = false;
+            if (iter->second.next == nullptr) {
+                _lanes.erase(iter);
+            }
+        }
+    }
+    _cv.notify_all();
+}
+
+
+void ScanFusion::wake() {
+    // Taking the lock orders this after the check of a member about to wait.
+    std::lock_guard<std::mutex> lock(_mtx);
+    _cv.notify_all();
+}
+
+
+ScanFusion& ScanFusion::getDefault() {
+    // Never destroyed, as Tasks may still be scanning during exit.
+    static ScanFusion* fusion = new ScanFusion();
+    return *fusion;
+}
+
+}}} // namespace lsst::qserv::wdb
@@ -0,0 +1,157 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_SCANFUSION_H
+#define LSST_QSERV_WDB_SCANFUSION_H
+
+// System headers
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// A fragment query simple enough to share its table scan with others:
+///     SELECT <list> FROM <table> [WHERE <predicate>]
+/// over a single table, without aggregates, DISTINCT, GROUP BY, ORDER BY,
+/// LIMIT or subqueries.
+class ScanQuery {
+public:
+    /// @return false if query is not simple enough, leaving this unchanged.
+    bool parse(std::string const& query);
+
+    std::string const& getSelectList() const { return _selectList; }
+    std::string const& getFrom() const { return _from; }
+    std::string const& getWhere() const { return _where; } ///< Empty if there is none
+
+    /// @return the query returning no rows, for the schema of its result.
+    std::string makeSchemaQuery() const;
+
+    /// @return one query scanning the table once for all of queries, which
+    /// must have the same FROM. The columns of each query come in turn, each
+    /// time after a column that is 1 in the rows that query selects.
+    static std::string makeFusedQuery(std::vector<ScanQuery const*> const& queries);
+
+private:
+    std::string _selectList;
+    std::string _from;
+    std::string _where;
+};
+
+
+/// ScanFusion lets Tasks reading the same chunk table at the same time share
+/// one scan of it.
+///
+/// Scans of a table, identified by a key, run one at a time. A Task that
+/// comes while one is running waits for it to finish with the others that
+/// come meanwhile, up to maxTasks of them. The first of those then runs a
+/// fused query for all of them, and hands each row to the Tasks that select
+/// it. The Tasks waiting would otherwise each have read the table.
+///
+/// The leader must not wait on behalf of the others, so work that may block,
+/// such as sending results, is left to the thread of each member: members
+/// wait in join() for the scan to be done, for work of their own, or to be
+/// cancelled. The scan still waits for the czar of the leader.
+class ScanFusion {
+public:
+    /// A Task taking part in a scan. Rows are added from the thread leading the scan.
+    class Member {
+    public:
+        using Ptr = std::shared_ptr<Member>;
+        virtual ~Member() {}
+        virtual ScanQuery const& getScanQuery() const = 0;
+        virtual int getFieldCount() const = 0; ///< Columns of the query's result
+        virtual void addFusedRow(char** row, unsigned long* lengths) = 0;
+
+        /// @return true once the Task is cancelled, to stop waiting in join().
+        virtual bool isCancelled() const { return false; }
+
+        /// @return true if the rows added left work to do from the thread of
+        ///         the Task, which join() then does with runPending().
+        virtual bool hasPending() const { return false; }
+        virtual void runPending() {}
+    };
+
+    /// The Tasks sharing one scan. members[0] leads it. Members are kept
+    /// alive until the leader is done with them, as a cancelled member stops
+    /// waiting before the scan is over.
+    struct Batch {
+        using Ptr = std::shared_ptr<Batch>;
+        std::vector<Member::Ptr> members;
+        std::atomic<bool> done{false};
+        bool inLane{true};  ///< false if run outside of the scans of its key
+        std::string error;  ///< Set by the leader if the scan failed, before done
+    };
+
+    ScanFusion() = default;
+    ScanFusion(ScanFusion const&) = delete;
+    ScanFusion& operator=(ScanFusion const&) = delete;
+
+    /// Take part in the next scan of key, waiting as described above.
+    /// @return the batch of the caller. If the caller is its first member, it
+    ///         must run the scan now and then call finish(). Otherwise the
+    ///         scan is done, unless the caller was cancelled first.
+    Batch::Ptr join(std::string const& key, Member::Ptr const& member);
+
+    /// Report the scan of batch as done, waking its other members.
+    void finish(std::string const& key, Batch::Ptr const& batch, std::string const& error);
+
+    /// Wake the members waiting for a scan, to check isCancelled() and
+    /// hasPending() again. Must not be called with a lock a Member takes in
+    /// those held.
+    void wake();
+
+    /// @param maxTasks - Tasks sharing one scan, fusion is off below 2.
+    void setMaxTasks(unsigned int maxTasks) { _maxTasks = maxTasks; }
+    unsigned int getMaxTasks() const { return _maxTasks; }
+    bool isEnabled() const { return _maxTasks > 1; }
+
+    std::uint64_t getFusedScanCount() const { return _fusedScans; } ///< Scans shared by 2 or more
+    std::uint64_t getFusedTaskCount() const { return _fusedTasks; } ///< Tasks in those scans
+
+    /// @return the ScanFusion of the worker.
+    static ScanFusion& getDefault();
+
+private:
+    struct Lane {
+        bool running{false};
+        Batch::Ptr next; ///< Gathering while the running scan goes on
+    };
+
+    std::atomic<unsigned int> _maxTasks{0};
+    std::map<std::string, Lane> _lanes;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::atomic<std::uint64_t> _fusedScans{0};
+    std::atomic<std::uint64_t> _fusedTasks{0};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_SCANFUSION_H
@@ -0,0 +1,255 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+  /**
+  * @brief Test fused scans of chunk tables.
+  */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "wdb/ScanFusion.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ScanFusion
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wdb::ScanFusion;
+using lsst::qserv::wdb::ScanQuery;
+
+namespace {
+
+struct FakeMember : public ScanFusion::Member {
+    ScanQuery const& getScanQuery() const override { return query; }
+    int getFieldCount() const override { return 1; }
+    void addFusedRow(char**, unsigned long*) override { ++rows; }
+    bool isCancelled() const override { return cancelled; }
+    bool hasPending() const override { return pending; }
+    void runPending() override {
+        pending = false;
+        pendingThread = std::this_thread::get_id();
+    }
+    ScanQuery query;
+    int rows{0};
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> pending{false};
+    std::thread::id pendingThread;
+};
+
+using MemberPtr = std::shared_ptr<FakeMember>;
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(ParseSimple) {
+    ScanQuery q;
+    BOOST_CHECK(q.parse("SELECT o.ra,o.decl AS d FROM LSST.Object_3240 AS QST_1_ WHERE o.x > 3 "
+                        "AND o.name = 'a, b' "));
+    BOOST_CHECK_EQUAL(q.getSelectList(), "o.ra,o.decl AS d");
+    BOOST_CHECK_EQUAL(q.getFrom(), "LSST.Object_3240 AS QST_1_");
+    BOOST_CHECK_EQUAL(q.getWhere(), "o.x > 3 AND o.name = 'a, b'");
+    BOOST_CHECK_EQUAL(q.makeSchemaQuery(), "SELECT o.ra,o.decl AS d FROM LSST.Object_3240 AS QST_1_ "
+                      "WHERE o.x > 3 AND o.name = 'a, b' LIMIT 0");
+
+    BOOST_CHECK(q.parse("select scisql_fluxToAbMag(zFlux), 1e5 from LSST.Object_1;"));
+    BOOST_CHECK_EQUAL(q.getWhere(), "");
+}
+
+BOOST_AUTO_TEST_CASE(ParseRejected) {
+    ScanQuery q;
+    std::vector<std::string> queries{
+        "SELECT COUNT(*) FROM LSST.Object_1",
+        "SELECT DISTINCT ra FROM LSST.Object_1",
+        "SELECT ra FROM LSST.Object_1 ORDER BY ra",
+        "SELECT ra FROM LSST.Object_1 WHERE x > 1 LIMIT 5",
+        "SELECT ra, SUM(x) FROM LSST.Object_1 GROUP BY ra",
+        "SELECT o.ra FROM LSST.Object_1 o, LSST.Source_1 s WHERE o.id = s.id",
+        "SELECT o.ra FROM LSST.Object_1 o JOIN LSST.Source_1 s USING (id)",
+        "SELECT ra FROM LSST.Object_1 WHERE id IN (SELECT id FROM LSST.Source_1)",
+        "SELECT * FROM LSST.Object_1",
+        "SELECT ra, * FROM LSST.Object_1",
+        "SELECT ra FROM LSST.Object_1; DROP TABLE x",
+        "SELECT ra FROM LSST.Object_1 -- comment",
+        "SELECT ra FROM LSST.Object_1 WHERE name = 'open",
+        "SHOW TABLES"};
+    for (auto const& query : queries) {
+        BOOST_CHECK_MESSAGE(!q.parse(query), query);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FusedQuery) {
+    ScanQuery a;
+    ScanQuery b;
+    BOOST_REQUIRE(a.parse("SELECT ra FROM LSST.Object_1 AS QST_1_ WHERE x > 1"));
+    BOOST_REQUIRE(b.parse("SELECT decl, y FROM LSST.Object_1 AS QST_1_ WHERE y < 2"));
+    BOOST_CHECK_EQUAL(ScanQuery::makeFusedQuery({&a, &b}),
+                      "SELECT (x > 1) IS TRUE AS QS_FUSED_0, ra, (y < 2) IS TRUE AS QS_FUSED_1, decl, y "
+                      "FROM LSST.Object_1 AS QST_1_ WHERE (x > 1) OR (y < 2)");
+
+    // A query without WHERE needs every row.
+    ScanQuery c;
+    BOOST_REQUIRE(c.parse("SELECT ra FROM LSST.Object_1 AS QST_1_"));
+    BOOST_CHECK_EQUAL(ScanQuery::makeFusedQuery({&a, &c}),
+                      "SELECT (x > 1) IS TRUE AS QS_FUSED_0, ra, 1 AS QS_FUSED_1, ra "
+                      "FROM LSST.Object_1 AS QST_1_");
+}
+
+BOOST_AUTO_TEST_CASE(Convoy) {
+    // While one Task scans, the others pile into the next scan, which the
+    // first of them leads for all.
+    ScanFusion fusion;
+    fusion.setMaxTasks(8);
+    BOOST_CHECK(fusion.isEnabled());
+    std::string const key = "LSST:1:Object_1";
+
+    auto first = std::make_shared<FakeMember>();
+    auto firstBatch = fusion.join(key, first);
+    BOOST_CHECK(firstBatch->members.size() == 1);
+
+    int const waiting = 5;
+    std::vector<MemberPtr> members;
+    for (int j=0; j < waiting; ++j) {
+        members.push_back(std::make_shared<FakeMember>());
+    }
+    std::vector<ScanFusion::Batch::Ptr> batches(waiting);
+    std::atomic<int> scans{0};
+    std::vector<std::thread> threads;
+    for (int j=0; j < waiting; ++j) {
+        threads.emplace_back([&, j]() {
+            auto batch = fusion.join(key, members[j]);
+            if (batch->members.front() == members[j]) {
+                ++scans;
+                for (auto const& member : batch->members) {
+                    member->addFusedRow(nullptr, nullptr);
+                }
+                fusion.finish(key, batch, "");
+            }
+            batches[j] = batch;
+        });
+        // Let each thread join in turn.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    fusion.finish(key, firstBatch, "");
+    for (auto& thrd : threads) {
+        thrd.join();
+    }
+    BOOST_CHECK(scans == 1);
+    for (int j=0; j < waiting; ++j) {
+        BOOST_CHECK(members[j]->rows == 1);
+        BOOST_CHECK(batches[j]->members.size() == waiting);
+        BOOST_CHECK(batches[j]->done);
+    }
+    BOOST_CHECK(fusion.getFusedScanCount() == 1);
+    BOOST_CHECK(fusion.getFusedTaskCount() == waiting);
+
+    // With the scans done, the next Task scans at once.
+    auto lastBatch = fusion.join(key, std::make_shared<FakeMember>());
+    BOOST_CHECK(lastBatch->members.size() == 1);
+    fusion.finish(key, lastBatch, "");
+}
+
+BOOST_AUTO_TEST_CASE(ConvoyFull) {
+    // Tasks beyond maxTasks scan alone rather than wait.
+    ScanFusion fusion;
+    fusion.setMaxTasks(2);
+    std::string const key = "LSST:2:Object_2";
+    auto runningBatch = fusion.join(key, std::make_shared<FakeMember>());
+
+    ScanFusion::Batch::Ptr batchA;
+    ScanFusion::Batch::Ptr batchB;
+    std::thread leader([&]() {
+        batchA = fusion.join(key, std::make_shared<FakeMember>());
+        fusion.finish(key, batchA, "");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::thread follower([&]() { batchB = fusion.join(key, std::make_shared<FakeMember>()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto extraBatch = fusion.join(key, std::make_shared<FakeMember>());
+    BOOST_CHECK(extraBatch->members.size() == 1);
+    BOOST_CHECK(!extraBatch->inLane);
+    fusion.finish(key, extraBatch, "");
+
+    fusion.finish(key, runningBatch, "");
+    leader.join();
+    follower.join();
+    BOOST_CHECK(batchA == batchB);
+    BOOST_CHECK(batchA->members.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(MemberThread) {
+    // Work the leader leaves for a member is done by the member's thread,
+    // and a cancelled member stops waiting before the scan is done.
+    ScanFusion fusion;
+    fusion.setMaxTasks(4);
+    std::string const key = "LSST:3:Object_3";
+    auto runningBatch = fusion.join(key, std::make_shared<FakeMember>());
+
+    auto leader = std::make_shared<FakeMember>();
+    auto member = std::make_shared<FakeMember>();
+    auto cancelled = std::make_shared<FakeMember>();
+    ScanFusion::Batch::Ptr leaderBatch;
+    std::thread leaderThread([&]() { leaderBatch = fusion.join(key, leader); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ScanFusion::Batch::Ptr memberBatch;
+    std::thread::id memberId;
+    std::thread memberThread([&]() {
+        memberId = std::this_thread::get_id();
+        memberBatch = fusion.join(key, member);
+    });
+    ScanFusion::Batch::Ptr cancelledBatch;
+    std::thread cancelledThread([&]() { cancelledBatch = fusion.join(key, cancelled); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    fusion.finish(key, runningBatch, "");
+    leaderThread.join();
+    BOOST_REQUIRE(leaderBatch->members.size() == 3);
+
+    cancelled->cancelled = true;
+    fusion.wake();
+    cancelledThread.join();
+    BOOST_CHECK(cancelledBatch == leaderBatch);
+    BOOST_CHECK(!cancelledBatch->done);
+
+    member->pending = true;
+    fusion.wake();
+    for (int j=0; j < 100 && member->pending; ++j) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    BOOST_CHECK(!member->pending);
+    BOOST_CHECK(!leaderBatch->done);
+
+    fusion.finish(key, leaderBatch, "");
+    memberThread.join();
+    BOOST_CHECK(member->pendingThread == memberId);
+    BOOST_CHECK(memberBatch->done);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -331,7 +331,7 @@ class WmgrClient(object):
         return self._getKey(result, 'name')
 
 
-    def createTable(self, dbName, tableName, schema=None, chunkColumns=False):
+    def createTable(self, dbName, tableName, schema=None, chunkColumns=False, subChunkIndex=False):
         """
         Create new table.
 
@@ -339,12 +339,15 @@ class WmgrClient(object):
         if schema is None then table schema will be loaded from CSS. If chunkColumns
         is True then delete colums "_chunkId", "_subChunkId" from table (if they
         exist) and add columns "chunkId", "subChunkId" (if they don't exist).
+        If subChunkIndex is True then add an index on "subChunkId" column, which
+        chunk tables created from this table will have too.
 
         @raise ClientException: in case of problems
         """
 
         _log.debug('create table: %s.%s', dbName, tableName)
-        data = dict(table=tableName, chunkColumns=str(int(chunkColumns)))
+        data = dict(table=tableName, chunkColumns=str(int(chunkColumns)),
+                    subChunkIndex=str(int(subChunkIndex)))
         if schema:
             data['schema'] = schema
         else:
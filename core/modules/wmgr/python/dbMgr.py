@@ -268,6 +268,13 @@ def createTable(dbName):
                     '0', '1', 'yes', 'no', 'false', 'true'. If set to true then
                     delete columns "_chunkId", "_subChunkId" from table (if they
                     exist) and add columns "chunkId", "subChunkId" (if they don't exist)
+    subChunkIndex:  boolean flag, false by default, accepted values:
+                    '0', '1', 'yes', 'no', 'false', 'true'. If set to true then
+                    add an index on "subChunkId" column (if there is none). Chunk
+                    tables copy it, workers then bind subchunks through the index
+                    instead of copying their rows into memory tables. Loading
+                    data into a chunk table with the index orders its rows by
+                    subChunkId
 
     If `schemaSource` is 'request' then request must include `schema` parameter
     which is an SQL DDL statement starting with 'CREATE TABLE TableName ...'.
@@ -290,6 +297,7 @@ def createTable(dbName):
     schemaSource = request.form.get('schemaSource', 'request').strip().lower()
     schema = request.form.get('schema', '').strip()
     chunkColumns = _getArgFlag(request.form, 'chunkColumns', False)
+    subChunkIndex = _getArgFlag(request.form, 'subChunkIndex', False)
 
     if tblName:
         _validateTableName(tblName)
@@ -374,6 +382,24 @@ def createTable(dbName):
             _log.error('Failed to alter database table: %s', exc)
             raise ExceptionResponse(500, "DbError", "Failed to alter database table", str(exc))
 
+    if subChunkIndex:
+        # Index subChunkId column unless some index already starts with it
+
+        try:
+            table = '`{0}`.`{1}`'.format(dbName, tblName)
+
+            q = "SHOW INDEX FROM %s WHERE Column_name = 'subChunkId' AND Seq_in_index = 1" % table
+            result = dbConn.execute(q)
+            if not result.fetchall():
+                _log.info('Adding subChunkId index to table %s', table)
+
+                q = 'ALTER TABLE %s ADD INDEX subChunkId (subChunkId)' % table
+                _log.debug('query: %s', q)
+                dbConn.execute(q)
+        except Exception as exc:
+            _log.error('Failed to index database table: %s', exc)
+            raise ExceptionResponse(500, "DbError", "Failed to index database table", str(exc))
+
     # return representation for new database, 201 code is for CREATED
     response = json.jsonify(result=_tblDict(dbName, tblName))
     response.status_code = 201
@@ -832,9 +858,33 @@ def loadData(dbName, tblName, chunkId=None):
                 results = dbConn.execute(sql, options)
                 count = results.rowcount
 
+    if chunkId is not None:
+        _clusterSubChunks(dbConn, dbName, tblName)
+
     return json.jsonify(result=dict(status="OK", count=count))
 
 
+def _clusterSubChunks(dbConn, dbName, tblName):
+    """
+    Store the rows of a chunk or overlap table in subChunkId order if it has an
+    index starting with subChunkId (see `subChunkIndex` in createTable), so that
+    the rows of each subchunk read through the index are next to each other.
+    The table is rewritten, so this is done after every load of it.
+    """
+    table = '`{0}`.`{1}`'.format(dbName, tblName)
+    try:
+        q = "SHOW INDEX FROM %s WHERE Column_name = 'subChunkId' AND Seq_in_index = 1" % table
+        if not dbConn.execute(q).fetchall():
+            return
+        _log.info('Ordering rows of table %s by subChunkId', table)
+        q = 'ALTER TABLE %s ORDER BY subChunkId' % table
+        _log.debug('query: %s', q)
+        dbConn.execute(q)
+    except Exception as exc:
+        _log.error('Failed to order database table: %s', exc)
+        raise ExceptionResponse(500, "DbError", "Failed to order database table", str(exc))
+
+
 @dbService.route('/<dbName>/tables/<tblName>/index', methods=['GET'])
 @dbService.route('/<dbName>/tables/<tblName>/chunks/<int:chunkId>/index', methods=['GET'])
 def getIndex(dbName, tblName, chunkId=None):
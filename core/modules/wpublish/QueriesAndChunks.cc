@@ -23,6 +23,10 @@
 
 // Class header
 #include "wpublish/QueriesAndChunks.h"
+
+// System headers
+#include <sstream>
+
 // LSST headers
 #include "lsst/log/Log.h"
 
@@ -61,7 +65,10 @@ QueriesAndChunks::QueriesAndChunks(std::chrono::seconds deadAfter,
     auto rExamine = [this](){
         while (_loopExamine) {
             std::this_thread::sleep_for(_examineAfter);
-            if (_loopExamine) examineAll();
+            if (_loopExamine) {
+                examineAll();
+                logStatus();
+            }
         }
     };
     std::thread te(rExamine);
@@ -305,6 +312,28 @@ void QueriesAndChunks::examineAll() {
 }
 
 
+void QueriesAndChunks::addStatusReporter(StatusReporter const& reporter) {
+    std::lock_guard<std::mutex> lock(_statusMtx);
+    _statusReporters.push_back(reporter);
+}
+
+
+void QueriesAndChunks::logStatus() {
+    std::ostringstream os;
+    {
+        std::lock_guard<std::mutex> lock(_statusMtx);
+        if (_statusReporters.empty()) {
+            return;
+        }
+        for (auto const& reporter : _statusReporters) {
+            os << " ";
+            reporter(os);
+        }
+    }
+    LOGS(_log, LOG_LVL_INFO, "Worker status:" << os.str());
+}
+
+
 /// @return a map that contains time totals for all chunks for tasks running on specific
 /// tables. The map is sorted by table name and contains sub-maps ordered by chunk id.
 /// The sub-maps contain information about how long tasks take to complete on that table
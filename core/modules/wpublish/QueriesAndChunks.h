@@ -25,6 +25,8 @@
 #define LSST_QSERV_WPUBLISH_QUERIESANDCHUNKS_H
 
 // System headers
+#include <functional>
+#include <ostream>
 
 // Qserv headers
 #include "wbase/Task.h"
@@ -167,6 +169,15 @@ public:
 
     void examineAll();
 
+    /// Writes the state of some part of the worker to a status line.
+    using StatusReporter = std::function<void(std::ostream&)>;
+
+    /// Add a reporter to the status line logged after each examineAll() pass.
+    void addStatusReporter(StatusReporter const& reporter);
+
+    /// Log the worker status line built by the status reporters.
+    void logStatus();
+
     // Figure out each chunkTable's percentage of time.
     // Store average time for a task to run on this table for this chunk.
     struct ChunkTimePercent {
@@ -216,6 +227,9 @@ private:
     std::atomic<bool> _loopExamine{true};
     std::chrono::seconds _examineAfter{std::chrono::minutes(5)};
 
+    std::mutex _statusMtx; ///< Protects _statusReporters.
+    std::vector<StatusReporter> _statusReporters;
+
     /// Maximum number of tasks that can be booted until entire UserQuery is put on snailScan.
     int _maxTasksBooted{5};
 
@@ -62,6 +62,10 @@ public:
     /// @return true if the next Task will come from a different active chunk.
     virtual bool nextTaskDifferentChunkId() = 0;
 
+    /// Set how many chunks after the active one have their tables read ahead, 0 for none.
+    /// Collections that do not read ahead ignore this.
+    virtual void setPrefetchDepth(unsigned int depth) {}
+
     /// Remove task from this collection.
     /// @return a pointer to the removed task or nullptr if the task was not found.
     virtual wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) = 0;
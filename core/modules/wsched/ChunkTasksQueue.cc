@@ -35,6 +35,17 @@
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.wsched.ChunkTasksQueue");
+
+/// @return how ChunkTasks::ready() prepares tbl for a Task, which is also how
+///         ChunkTasks::startPrefetch() reads it ahead.
+lsst::qserv::memman::TableInfo lockInfo(lsst::qserv::proto::ScanTableInfo const& tbl,
+                                        bool useFlexibleLock) {
+    using LockType = lsst::qserv::memman::TableInfo::LockType;
+    LockType lckOptTbl = LockType::REQUIRED;
+    if (useFlexibleLock) lckOptTbl = LockType::FLEXIBLE;
+    LockType lckOptIdx = LockType::NOLOCK;
+    return lsst::qserv::memman::TableInfo(tbl.db + "/" + tbl.table, lckOptTbl, lckOptIdx, tbl.scanRating);
+}
 }
 
 namespace lsst {
@@ -56,18 +67,33 @@ void ChunkTasksQueue::queueTask(wbase::Task::Ptr const& task) {
         return iter;
     };
 
-    std::lock_guard<std::mutex> lg(_mapMx);
-    int chunkId = task->getChunkId();
-    auto iter = insertChunkTask(chunkId);
-    ++_taskCount;
-    iter->second->queTask(task);
+    std::vector<Prefetch> prefetches;
+    {
+        std::lock_guard<std::mutex> lg(_mapMx);
+        int chunkId = task->getChunkId();
+        auto iter = insertChunkTask(chunkId);
+        ++_taskCount;
+        iter->second->queTask(task);
+        _memMan->addDemand(chunkId, 1);
+        // The chunk may be one of the next to run.
+        _planPrefetch();
+        prefetches.swap(_toPrefetch);
+    }
+    _prefetch(prefetches);
 }
 
 
 /// @return true if this object is ready to provide a Task from its queue.
 bool ChunkTasksQueue::ready(bool useFlexibleLock) {
-    std::lock_guard<std::mutex> lock(_mapMx);
-    return _ready(useFlexibleLock);
+    bool rdy;
+    std::vector<Prefetch> prefetches;
+    {
+        std::lock_guard<std::mutex> lock(_mapMx);
+        rdy = _ready(useFlexibleLock);
+        prefetches.swap(_toPrefetch);
+    }
+    _prefetch(prefetches);
+    return rdy;
 }
 
 
@@ -81,6 +107,7 @@ bool ChunkTasksQueue::ready(bool useFlexibleLock) {
 /// run the next Task on the current chunk.
 /// The _activeChunk advances when all of its Tasks have completed.
 bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
+    _useFlexibleLock = useFlexibleLock;
     if (_readyChunk != nullptr) {
         return true;
     }
@@ -92,6 +119,8 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
     if (_activeChunk == _chunkMap.end()) {
         _activeChunk = _chunkMap.begin();
         _activeChunk->second->setActive(); // Flag tasks on active so new Tasks added wont be run.
+        ++_prefetchGen;
+        _planPrefetch();
     }
 
     // Check the active chunk for valid Tasks
@@ -125,6 +154,8 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
         }
         newActive->second->movePendingToActive();
         newActive->second->setActive();
+        ++_prefetchGen;
+        _planPrefetch();
     }
 
     // Advance through chunks until READY or NO_RESOURCES found, or until entire list scanned.
@@ -159,18 +190,78 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
 }
 
 
-wbase::Task::Ptr ChunkTasksQueue::getTask(bool useFlexibleLock) {
+/// Precondition: _mapMx must be locked
+/// Plan reading ahead the tables of the _prefetchDepth chunks after the _activeChunk, in the
+/// order they will become active, so that their first Tasks do not wait on the disk. This
+/// stops at the first chunk MemMan had no free memory for, as the chunks after it are needed
+/// later. The plan is carried out by _prefetch() once _mapMx is released.
+void ChunkTasksQueue::_planPrefetch() {
+    if (_prefetchDepth == 0 || _activeChunk == _chunkMap.end()) {
+        return;
+    }
+    auto iter = _activeChunk;
+    for (unsigned int j=0; j < _prefetchDepth; ++j) {
+        ++iter;
+        if (iter == _chunkMap.end()) {
+            iter = _chunkMap.begin();
+        }
+        if (iter == _activeChunk) {
+            return;
+        }
+        auto const& chunk = iter->second;
+        if (chunk->prefetchStarved(_prefetchGen)) {
+            return;
+        }
+        auto tables = chunk->startPrefetch(_prefetchGen, _useFlexibleLock);
+        if (!tables.empty()) {
+            _toPrefetch.push_back(Prefetch{chunk, std::move(tables), _prefetchGen});
+        }
+    }
+}
+
+
+/// Precondition: _mapMx must not be locked, as MemMan::prefetch() makes system calls.
+/// Read ahead the tables planned by _planPrefetch(), stopping at the first chunk MemMan has
+/// no memory for.
+void ChunkTasksQueue::_prefetch(std::vector<Prefetch> const& prefetches) {
+    if (prefetches.empty()) {
+        return;
+    }
+    std::vector<int> results(prefetches.size(), -1);
+    for (unsigned int j=0; j < prefetches.size(); ++j) {
+        auto const& pf = prefetches[j];
+        results[j] = _memMan->prefetch(pf.tables, pf.chunk->getChunkId());
+        if (results[j] == ENOMEM) {
+            break;
+        }
+    }
     std::lock_guard<std::mutex> lock(_mapMx);
-    // Attempt to set _readyChunk.
-    _ready(useFlexibleLock);
-    // If a Task was ready, _readyChunk will not be nullptr.
-    if (_readyChunk != nullptr) {
-        wbase::Task::Ptr task = _readyChunk->getTask(useFlexibleLock);
-        _readyChunk = nullptr;
-        --_taskCount;
-        return task;
+    for (unsigned int j=0; j < prefetches.size(); ++j) {
+        prefetches[j].chunk->endPrefetch(results[j], prefetches[j].gen);
     }
-    return nullptr;
+}
+
+
+wbase::Task::Ptr ChunkTasksQueue::getTask(bool useFlexibleLock) {
+    wbase::Task::Ptr task;
+    std::vector<Prefetch> prefetches;
+    {
+        std::lock_guard<std::mutex> lock(_mapMx);
+        // Attempt to set _readyChunk.
+        _ready(useFlexibleLock);
+        // If a Task was ready, _readyChunk will not be nullptr.
+        if (_readyChunk != nullptr) {
+            task = _readyChunk->getTask(useFlexibleLock);
+            _readyChunk = nullptr;
+            --_taskCount;
+            if (task != nullptr) {
+                _memMan->addDemand(task->getChunkId(), -1);
+            }
+        }
+        prefetches.swap(_toPrefetch);
+    }
+    _prefetch(prefetches);
+    return task;
 }
 
 
@@ -224,6 +315,7 @@ wbase::Task::Ptr ChunkTasksQueue::removeTask(wbase::Task::Ptr const& task) {
     auto ret = ct->removeTask(task);
     if (ret != nullptr) {
         --_taskCount; // Need to do this as getTask() wont be called for task.
+        _memMan->addDemand(chunkId, -1);
     }
     return ret;
 }
@@ -319,6 +411,7 @@ void ChunkTasks::setActive(bool active) {
         LOGS(_log, LOG_LVL_DEBUG, "ChunkTasks " << _chunkId << " active changed to " << active);
         if (_active && !active) {
             movePendingToActive();
+            _prefetched = false; // Read ahead again when next in line.
         }
     }
     _active = active;
@@ -377,9 +470,6 @@ ChunkTasks::ReadyState ChunkTasks::ready(bool useFlexibleLock) {
     // will not examine any further chunks upon seeing those results.
     auto task = _activeTasks.top();
     if (!task->hasMemHandle()) {
-        memman::TableInfo::LockType lckOptTbl = memman::TableInfo::LockType::REQUIRED;
-        if (useFlexibleLock) lckOptTbl = memman::TableInfo::LockType::FLEXIBLE;
-        memman::TableInfo::LockType lckOptIdx = memman::TableInfo::LockType::NOLOCK;
         auto scanInfo = task->getScanInfo();
         auto chunkId = task->getChunkId();
         if (chunkId != _chunkId) {
@@ -389,8 +479,7 @@ ChunkTasks::ReadyState ChunkTasks::ready(bool useFlexibleLock) {
         }
         std::vector<memman::TableInfo> tblVect;
         for (auto const& tbl : scanInfo.infoTables) {
-            memman::TableInfo ti(tbl.db + "/" + tbl.table, lckOptTbl, lckOptIdx);
-            tblVect.push_back(ti);
+            tblVect.push_back(lockInfo(tbl, useFlexibleLock));
         }
         // If tblVect is empty, we should get the empty handle
         memman::MemMan::Handle handle = _memMan->prepare(tblVect, chunkId);
@@ -424,6 +513,49 @@ ChunkTasks::ReadyState ChunkTasks::ready(bool useFlexibleLock) {
 }
 
 
+/// Start reading ahead the tables used by the Tasks of this chunk, if not done already.
+/// The tables are described as ready() will prepare them.
+/// ChunkTasks relies on its owner for thread safety.
+std::vector<memman::TableInfo> ChunkTasks::startPrefetch(unsigned int gen, bool useFlexibleLock) {
+    std::vector<memman::TableInfo> tblVect;
+    if (_prefetched || _prefetching || prefetchStarved(gen)) {
+        return tblVect;
+    }
+    std::set<std::string> tables;
+    auto addTables = [&tables, &tblVect, useFlexibleLock](std::vector<wbase::Task::Ptr> const& tasks) {
+        for (auto const& task : tasks) {
+            for (auto const& tbl : task->getScanInfo().infoTables) {
+                if (tables.insert(tbl.db + "/" + tbl.table).second) {
+                    tblVect.push_back(lockInfo(tbl, useFlexibleLock));
+                }
+            }
+        }
+    };
+    addTables(_activeTasks._tasks);
+    addTables(_pendingTasks);
+    // With no tables, there is nothing to read yet, but scans may still be queued.
+    _prefetching = !tblVect.empty();
+    return tblVect;
+}
+
+
+/// ChunkTasks relies on its owner for thread safety.
+void ChunkTasks::endPrefetch(int rc, unsigned int gen) {
+    _prefetching = false;
+    if (rc == 0) {
+        _prefetched = true;
+        LOGS(_log, LOG_LVL_DEBUG, "ChunkTasks " << _chunkId << " prefetched");
+    } else if (rc == ENOMEM) {
+        _prefetchStarved = true;
+        _prefetchStarvedGen = gen;
+    } else if (rc != -1) {
+        // The Tasks will find out about missing tables when they run.
+        LOGS(_log, LOG_LVL_WARN, "ChunkTasks " << _chunkId << " prefetch failed errno=" << rc);
+        _prefetched = true;
+    }
+}
+
+
 /// @return old value of _resourceStarved.
 bool ChunkTasks::setResourceStarved(bool starved){
     auto val = _resourceStarved;
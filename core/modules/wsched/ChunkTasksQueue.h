@@ -25,9 +25,11 @@
 
 // System headers
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 // Qserv headers
 #include "memman/MemMan.h"
@@ -66,6 +68,17 @@ public:
     bool readyToAdvance(); ///< @return true if active Tasks for this chunk are done.
     void setActive(bool active=true); ///< Flag current requests so new requests will be pending.
     bool setResourceStarved(bool starved); ///< hook for tracking starvation.
+    /// @return the tables of the queued Tasks to read ahead, with the lock types ready()
+    ///         prepares them with, or none if they were read already, are being read,
+    ///         or MemMan had no memory for them in prefetch generation gen.
+    std::vector<memman::TableInfo> startPrefetch(unsigned int gen, bool useFlexibleLock);
+    /// Record the outcome of reading ahead the tables returned by startPrefetch(gen).
+    /// @param rc errno from MemMan::prefetch, ENOMEM when out of memory, -1 if not tried.
+    void endPrefetch(int rc, unsigned int gen);
+    /// @return true if MemMan had no memory to read ahead this chunk in generation gen.
+    bool prefetchStarved(unsigned int gen) const {
+        return _prefetchStarved && _prefetchStarvedGen == gen;
+    }
     std::size_t size() const { return _activeTasks.size() + _pendingTasks.size(); }
     int getChunkId() { return _chunkId; }
 
@@ -100,6 +113,10 @@ private:
     int _chunkId;                    ///< Chunk Id for all Tasks in this instance.
     bool _active{false};            ///< True when this is the active chunk.
     bool _resourceStarved{false};   ///< True when advancement is prevented by lack of memory.
+    bool _prefetched{false};        ///< True when the tables have been read ahead.
+    bool _prefetching{false};       ///< True while the tables are being read ahead.
+    bool _prefetchStarved{false};   ///< True when MemMan had no memory to read ahead.
+    unsigned int _prefetchStarvedGen{0}; ///< Prefetch generation of _prefetchStarved.
     wbase::Task::Ptr              _readyTask{nullptr}; ///< Task that is ready to run with memory reserved.
     SlowTableHeap                 _activeTasks;        ///< All Tasks must be put on this before they can run.
     std::vector<wbase::Task::Ptr> _pendingTasks;       ///< Task that should not be run until later.
@@ -147,12 +164,22 @@ public:
     bool setResourceStarved(bool starved) override;
     bool nextTaskDifferentChunkId() override;
     int getActiveChunkId(); ///< return the active chunk id, or -1 if there isn't one.
+    void setPrefetchDepth(unsigned int depth) override { _prefetchDepth = depth; }
 
     wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) override;
 
 private:
+    /// Tables of a chunk to read ahead once _mapMx is released.
+    struct Prefetch {
+        ChunkTasks::Ptr chunk;
+        std::vector<memman::TableInfo> tables;
+        unsigned int gen;
+    };
+
     bool _ready(bool useFlexibleLock);
     bool _empty() const { return _chunkMap.empty(); }
+    void _planPrefetch();
+    void _prefetch(std::vector<Prefetch> const& prefetches);
 
     mutable std::mutex _mapMx; ///< Protects _chunkMap, _activeChunk, and _readyChunk.
     ChunkMap _chunkMap; ///< map by chunk Id.
@@ -162,6 +189,12 @@ private:
     memman::MemMan::Ptr _memMan;
     std::atomic<int> _taskCount{0}; ///< Count of all tasks currently in _chunkMap.
     bool _resourceStarved{false};
+    std::atomic<unsigned int> _prefetchDepth{0}; ///< Chunks after the active one to read ahead.
+    std::vector<Prefetch> _toPrefetch; ///< Planned read aheads, protected by _mapMx.
+    /// Bumped when the active chunk changes, which frees memory. A chunk MemMan had no memory
+    /// for is not read ahead again until then. Protected by _mapMx.
+    unsigned int _prefetchGen{0};
+    bool _useFlexibleLock{false}; ///< As last passed to _ready(), for _planPrefetch().
     SchedulerBase* _scheduler; ///< Pointer to scheduler that owns this. This can be nullptr.
 };
 
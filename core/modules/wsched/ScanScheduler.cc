@@ -261,7 +261,16 @@ void ScanScheduler::logMemManStats() {
          << " FlxF=" << s.numFlexFiles
          << " FlxLck=" << s.numFlexLock
          << " lckCalls=" << s.numLocks
-         << " errs=" << s.numErrors);
+         << " errs=" << s.numErrors
+         << " pref=" << s.numPrefetch
+         << " prefHits=" << s.numPrefHits
+         << " prefSkips=" << s.numPrefSkips
+         << " bRetained=" << s.bytesRetained
+         << " retHits=" << s.numRetHits
+         << " retMiss=" << s.numRetMiss
+         << " evicted=" << s.numEvicted
+         << " hugeAdvised=" << s.numHugeAdvised << "/" << s.numHugeErrors
+         << " intlv=" << s.numInterleave << "/" << s.numPlaceErrors);
 }
 
 }}} // namespace lsst::qserv::wsched
@@ -81,6 +81,9 @@ public:
 
     void logMemManStats();
 
+    /// Read ahead the tables of this many chunks after the active one, 0 for none.
+    void setPrefetchDepth(unsigned int depth) { _taskQueue->setPrefetchDepth(depth); }
+
     double getMaxTimeMinutes() const { return _maxTimeMinutes; }
     wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) override;
 
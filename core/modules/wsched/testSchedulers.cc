@@ -28,6 +28,12 @@
   */
 
 
+// System headers
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
 // LSST headers
 #include "lsst/log/Log.h"
 
@@ -37,6 +43,7 @@
 #include "proto/worker.pb.h"
 #include "util/EventThread.h"
 #include "wbase/Task.h"
+#include "wcontrol/WorkStealingQueue.h"
 #include "wpublish/QueriesAndChunks.h"
 #include "wsched/ChunkDisk.h"
 #include "wsched/ChunkTasksQueue.h"
@@ -65,6 +72,35 @@ double const oneHr = 60.0;
 Task::Ptr makeTask(std::shared_ptr<TaskMsg> tm) {
     return std::make_shared<Task>(tm, std::shared_ptr<SendChannel>());
 }
+/// MemManNone that records prefetched chunks, and is out of memory for one chunk.
+/// It also keeps the count of Tasks queued by chunk, and the last tables
+/// prefetched and prepared.
+class PrefetchMemMan : public lsst::qserv::memman::MemManNone {
+public:
+    using TableInfo = lsst::qserv::memman::TableInfo;
+    PrefetchMemMan() : MemManNone(1, true) {}
+    int prefetch(std::vector<TableInfo> const& tables, int chunk) override {
+        if (chunk == noMemChunk) {
+            ++noMemCalls;
+            return ENOMEM;
+        }
+        chunks.push_back(chunk);
+        prefetched = tables;
+        return 0;
+    }
+    Handle prepare(std::vector<TableInfo> const& tables, int chunk) override {
+        prepared = tables;
+        return MemManNone::prepare(tables, chunk);
+    }
+    void addDemand(int chunk, int tasks) override { demand[chunk] += tasks; }
+    std::vector<int> chunks;
+    std::vector<TableInfo> prefetched;
+    std::vector<TableInfo> prepared;
+    int noMemChunk{-1};
+    int noMemCalls{0};
+    std::map<int, int> demand;
+};
+
 struct SchedulerFixture {
     typedef std::shared_ptr<TaskMsg> TaskMsgPtr;
 
@@ -410,6 +446,95 @@ BOOST_AUTO_TEST_CASE(ScanScheduleTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(ChunkTasksQueuePrefetch) {
+    auto memMan = std::make_shared<PrefetchMemMan>();
+    wsched::ChunkTasksQueue ctl{nullptr, memMan};
+    ctl.setPrefetchDepth(2);
+    lsst::qserv::QueryId qIdInc = 1;
+
+    // Nothing is read ahead until there is an active chunk.
+    for (int chunkId : {10, 20, 30, 40}) {
+        ctl.queueTask(makeTask(newTaskMsgScan(chunkId, 0, qIdInc++, 0)));
+    }
+    BOOST_CHECK(memMan->chunks.empty());
+
+    // Running out of memory stops the lookahead.
+    memMan->noMemChunk = 30;
+    BOOST_CHECK(ctl.ready(false) == true);
+    BOOST_CHECK(ctl.getActiveChunkId() == 10);
+    BOOST_CHECK((memMan->chunks == std::vector<int>{20}));
+    BOOST_CHECK(memMan->noMemCalls == 1);
+
+    // The chunk out of memory is not tried again until the active chunk changes.
+    ctl.queueTask(makeTask(newTaskMsgScan(40, 0, qIdInc++, 0)));
+    BOOST_CHECK(memMan->noMemCalls == 1);
+
+    // A new chunk right after the active one is read ahead, the others only once.
+    ctl.queueTask(makeTask(newTaskMsgScan(15, 0, qIdInc++, 0)));
+    BOOST_CHECK((memMan->chunks == std::vector<int>{20, 15}));
+
+    // The lookahead moves on with the active chunk.
+    memMan->noMemChunk = -1;
+    auto tsk10 = ctl.getTask(false);
+    BOOST_CHECK(tsk10->getChunkId() == 10);
+    ctl.taskComplete(tsk10);
+    BOOST_CHECK(ctl.ready(false) == true);
+    BOOST_CHECK(ctl.getActiveChunkId() == 15);
+    BOOST_CHECK((memMan->chunks == std::vector<int>{20, 15, 30}));
+}
+
+
+BOOST_AUTO_TEST_CASE(ChunkTasksQueuePrefetchLockType) {
+    // Tables are read ahead as ready() prepares them, flexible or not.
+    for (bool useFlexibleLock : {false, true}) {
+        auto memMan = std::make_shared<PrefetchMemMan>();
+        wsched::ChunkTasksQueue ctl{nullptr, memMan};
+        ctl.setPrefetchDepth(1);
+        lsst::qserv::QueryId qIdInc = 1;
+        for (int chunkId : {10, 20}) {
+            ctl.queueTask(makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0)));
+        }
+        BOOST_CHECK(ctl.ready(useFlexibleLock) == true);
+        BOOST_REQUIRE((memMan->chunks == std::vector<int>{20}));
+        BOOST_REQUIRE(memMan->prepared.size() == 1);
+        BOOST_REQUIRE(memMan->prefetched.size() == 1);
+        auto const& prepared = memMan->prepared[0];
+        auto const& prefetched = memMan->prefetched[0];
+        BOOST_CHECK(prepared.theData == (useFlexibleLock ? PrefetchMemMan::TableInfo::LockType::FLEXIBLE
+                                                         : PrefetchMemMan::TableInfo::LockType::REQUIRED));
+        BOOST_CHECK(prefetched.tableName == prepared.tableName);
+        BOOST_CHECK(prefetched.theData == prepared.theData);
+        BOOST_CHECK(prefetched.theIndex == prepared.theIndex);
+        BOOST_CHECK(prefetched.scanRating == prepared.scanRating);
+        BOOST_CHECK(prefetched.scanRating == 3);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ChunkTasksQueueDemand) {
+    auto memMan = std::make_shared<PrefetchMemMan>();
+    wsched::ChunkTasksQueue ctl{nullptr, memMan};
+    lsst::qserv::QueryId qIdInc = 1;
+
+    // MemMan knows how many Tasks are queued for each chunk.
+    Task::Ptr a7 = makeTask(newTaskMsgScan(7, 0, qIdInc++, 0));
+    Task::Ptr b7 = makeTask(newTaskMsgScan(7, 0, qIdInc++, 0));
+    Task::Ptr a9 = makeTask(newTaskMsgScan(9, 0, qIdInc++, 0));
+    ctl.queueTask(a7);
+    ctl.queueTask(b7);
+    ctl.queueTask(a9);
+    BOOST_CHECK(memMan->demand[7] == 2);
+    BOOST_CHECK(memMan->demand[9] == 1);
+
+    // Tasks leave the count when they run or are removed.
+    auto tsk = ctl.getTask(false);
+    BOOST_CHECK(tsk->getChunkId() == 7);
+    BOOST_CHECK(memMan->demand[7] == 1);
+    BOOST_CHECK(ctl.removeTask(a9) != nullptr);
+    BOOST_CHECK(memMan->demand[9] == 0);
+}
+
+
 struct SchedFixture {
     SchedFixture() {
         setupQueriesBlend();
@@ -1099,4 +1224,101 @@ BOOST_AUTO_TEST_CASE(ChunkTasksQueueTest) {
     BOOST_CHECK(ctl.getActiveChunkId() == -1);
 }
 
+
+BOOST_AUTO_TEST_CASE(WorkStealingQueueTest) {
+    SchedFixture f;
+    auto queue = std::make_shared<lsst::qserv::wcontrol::WorkStealingQueue>(f.blend, 3);
+    auto queScan = [this, &f, &queue](int chunkId) {
+        queue->queCmd(makeTask(newTaskMsgScan(chunkId, lsst::qserv::proto::ScanInfo::Rating::MEDIUM,
+                                              f.qIdInc++, 0)));
+    };
+    for (int j=0; j<3; ++j) {
+        queScan(30 + j/2);
+    }
+
+    // One visit to the scheduler takes 3 Tasks, and all of them are in flight.
+    auto cmd = queue->getCmd(false);
+    BOOST_CHECK(cmd != nullptr);
+    queue->commandStart(cmd);
+    BOOST_CHECK(queue->getSchedulerCount() == 1);
+    BOOST_CHECK(f.blend->getInFlight() == 3);
+
+    // Another thread steals one of the Tasks held by this one.
+    lsst::qserv::util::Command::Ptr stolen;
+    std::thread thief([&queue, &stolen]() { stolen = queue->getCmd(false); });
+    thief.join();
+    BOOST_CHECK(stolen != nullptr);
+    BOOST_CHECK(queue->getStolenCount() == 1);
+
+    // This thread finds the other one in its own deque before going back to
+    // the scheduler for a new Task.
+    queScan(32);
+    auto local = queue->getCmd(false);
+    BOOST_CHECK(local != nullptr);
+    BOOST_CHECK(queue->getLocalCount() == 1);
+    auto last = queue->getCmd(false);
+    BOOST_CHECK(last != nullptr);
+    BOOST_CHECK(queue->getSchedulerCount() == 2);
+    BOOST_CHECK(queue->getCmd(false) == nullptr);
+
+    for (auto const& done : {cmd, stolen, local, last}) {
+        queue->commandFinish(done);
+    }
+    BOOST_CHECK(f.blend->getInFlight() == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(WorkStealingLoadTest) {
+    // Run the same synthetic load through the plain pool and the work
+    // stealing one. Each Task reads a table belonging to its chunk.
+    int const chunkCount = 16;
+    int const tasksPerChunk = 200;
+    std::vector<std::vector<int>> tables(chunkCount, std::vector<int>(32*1024, 1));
+
+    auto runLoad = [&](SchedFixture& f, lsst::qserv::util::CommandQueue::Ptr const& queue) {
+        auto pool = lsst::qserv::util::ThreadPool::newThreadPool(f.maxThreads, queue);
+        std::atomic<int> done{0};
+        std::atomic<long> total{0};
+        auto start = std::chrono::steady_clock::now();
+        for (int j=0; j < tasksPerChunk; ++j) {
+            for (int chunk=0; chunk < chunkCount; ++chunk) {
+                auto task = makeTask(newTaskMsgScan(chunk, lsst::qserv::proto::ScanInfo::Rating::FAST,
+                                                    f.qIdInc++, 0));
+                auto const& table = tables[chunk];
+                task->setFunc([&table, &done, &total](lsst::qserv::util::CmdData*) {
+                    long sum = 0;
+                    for (int val : table) sum += val;
+                    total += sum;
+                    ++done;
+                });
+                queue->queCmd(task);
+            }
+        }
+        auto deadline = start + std::chrono::seconds(60);
+        while (done < chunkCount*tasksPerChunk && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        pool->endAll();
+        pool->waitForResize(0);
+        BOOST_CHECK(done == chunkCount*tasksPerChunk);
+        BOOST_CHECK(total == long(done)*32*1024);
+        BOOST_CHECK(f.blend->getInFlight() == 0);
+        return elapsed.count();
+    };
+
+    SchedFixture plain;
+    double plainSecs = runLoad(plain, plain.blend);
+
+    SchedFixture stealing;
+    auto queue = std::make_shared<lsst::qserv::wcontrol::WorkStealingQueue>(stealing.blend, 2);
+    double stealingSecs = runLoad(stealing, queue);
+
+    auto handedOut = queue->getSchedulerCount() + queue->getLocalCount() + queue->getStolenCount();
+    BOOST_CHECK(handedOut >= std::uint64_t(chunkCount*tasksPerChunk));
+    LOGS(_log, LOG_LVL_INFO, "WorkStealingLoadTest plain=" << plainSecs << "s stealing=" << stealingSecs
+         << "s scheduler=" << queue->getSchedulerCount() << " local=" << queue->getLocalCount()
+         << " stolen=" << queue->getStolenCount() << " sameChunk=" << queue->getSameChunkCount());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -34,6 +34,7 @@
 #include "global/Bug.h"
 #include "global/debugUtil.h"
 #include "util/common.h"
+#include "wbase/MsgBufferPool.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.xrdsvc.ChannelStream");
@@ -44,34 +45,44 @@ namespace lsst {
 namespace qserv {
 namespace xrdsvc {
 
-/// SimpleBuffer is a really simple buffer for transferring data packets to
-/// XrdSsi
-class SimpleBuffer : public XrdSsiStream::Buffer, boost::noncopyable {
+/// StreamBuffer transfers a data packet to XrdSsi. It takes over the
+/// packet's string and points data at its bytes, so nothing is copied.
+class StreamBuffer : public XrdSsiStream::Buffer, boost::noncopyable {
 public:
-    SimpleBuffer(std::string const& input) {
-        data = new char[input.size()];
-        memcpy(data, input.data(), input.size());
+    StreamBuffer(std::string&& input) : _input(std::move(input)) {
+        data = &_input[0];
         next = 0;
     }
 
     //!> Call to recycle the buffer when finished
     virtual void Recycle() {
-        delete this; // Self-destruct. FIXME: Not sure this is right.
+        // Hand the string's storage back for the next message.
+        wbase::MsgBufferPool::getPool().release(std::move(_input));
+        delete this;
     }
 
     // Inherited from XrdSsiStream:
     // char  *data; //!> -> Buffer containing the data
     // Buffer *next; //!> For chaining by buffer receiver
 
-    virtual ~SimpleBuffer() {
-        delete[] data;
-    }
+    virtual ~StreamBuffer() {}
+
+private:
+    std::string _input;
 };
 
 ////////////////////////////////////////////////////////////////////////
 // ChannelStream implementation
 ////////////////////////////////////////////////////////////////////////
 
+std::uint64_t ChannelStream::_streamLimit = 0;
+std::uint64_t ChannelStream::_workerLimit = 0;
+std::uint64_t ChannelStream::_workerQueuedBytes = 0;
+std::uint64_t ChannelStream::_workerBlockedCount = 0;
+std::uint64_t ChannelStream::_workerBlockedStreams = 0;
+std::mutex ChannelStream::_budgetMutex;
+std::condition_variable ChannelStream::_budgetCv;
+
 /// Constructor
 ChannelStream::ChannelStream()
     : XrdSsiStream(isActive),
@@ -84,47 +95,160 @@ ChannelStream::~ChannelStream() {
         LOGS(_log, LOG_LVL_DEBUG, "Stream (" << (void *) this << ") deleted");
     } catch (...) {} // Destructors have nowhere to throw exceptions
 #endif
+    // Give back the budget of anything XrdSsi never picked up.
+    cancel();
 }
 
 /// Push in a data packet
-void
+bool
 ChannelStream::append(char const* buf, int bufLen, bool last) {
+    std::string msg = wbase::MsgBufferPool::getPool().acquire(bufLen);
+    msg.assign(buf, bufLen);
+    return append(std::move(msg), last);
+}
+
+/// Push in a data packet, taking ownership of msg
+bool
+ChannelStream::append(std::string&& msg, bool last) {
     if (_closed) {
         throw Bug("ChannelStream::append: Stream closed, append(...,last=true) already received");
     }
-    LOGS(_log, LOG_LVL_DEBUG, "last=" << last << " " << util::prettyCharBuf(buf, bufLen, 10));
+    LOGS(_log, LOG_LVL_DEBUG, "last=" << last << " " << util::prettyCharBuf(msg.data(), msg.size(), 10));
+    {
+        // Wait for budget. This is where a slow czar throttles the producer.
+        std::unique_lock<std::mutex> lock(_budgetMutex);
+        if (!_cancelled && _overBudget()) {
+            ++_workerBlockedCount;
+            // Only the first stream to block is worth noting, the worker
+            // status line reports the rest.
+            auto lvl = (_workerBlockedStreams++ == 0) ? LOG_LVL_INFO : LOG_LVL_DEBUG;
+            LOGS(_log, lvl, "append waiting for budget, stream queued=" << _queuedBytes
+                 << " worker queued=" << _workerQueuedBytes);
+            _budgetCv.wait(lock, [this]() { return _cancelled || !_overBudget(); });
+            --_workerBlockedStreams;
+        }
+        if (_cancelled) {
+            wbase::MsgBufferPool::getPool().release(std::move(msg));
+            return false;
+        }
+        // Once counted, the bytes are given back by GetBuff() or cancel().
+        _queuedBytes += msg.size();
+        _workerQueuedBytes += msg.size();
+    }
     {
         std::unique_lock<std::mutex> lock(_mutex);
         LOGS(_log, LOG_LVL_DEBUG, "Trying to append message (flowing)");
-
-        _msgs.push_back(std::string(buf, bufLen));
+        if (_cancelled) {
+            wbase::MsgBufferPool::getPool().release(std::move(msg));
+            return false;
+        }
+        _msgs.push_back(std::move(msg));
         _closed = last; // if last is true, then we are closed.
         _hasDataCondition.notify_one();
     }
+    return true;
 }
 
 /// Pull out a data packet as a Buffer object (called by XrdSsi code)
 XrdSsiStream::Buffer*
 ChannelStream::GetBuff(XrdSsiErrInfo &eInfo, int &dlen, bool &last) {
-    std::unique_lock<std::mutex> lock(_mutex);
-    while(_msgs.empty() && !_closed) { // No msgs, but we aren't done
-        // wait.
-        LOGS(_log, LOG_LVL_DEBUG, "Waiting, no data ready");
-        _hasDataCondition.wait(lock);
+    StreamBuffer* sb = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(_msgs.empty() && !_closed && !_cancelled) { // No msgs, but we aren't done
+            // wait.
+            LOGS(_log, LOG_LVL_DEBUG, "Waiting, no data ready");
+            _hasDataCondition.wait(lock);
+        }
+        if (_msgs.empty()) { // We are closed or cancelled and no more
+            // msgs are available.
+            LOGS(_log, LOG_LVL_DEBUG, "Not waiting, but closed");
+            dlen = 0;
+            eInfo.Set("Not an active stream", EOPNOTSUPP);
+            return 0;
+        }
+        dlen = _msgs.front().size();
+        sb = new StreamBuffer(std::move(_msgs.front()));
+        _msgs.pop_front();
+        last = _closed && _msgs.empty();
     }
-    if (_msgs.empty() && _closed) { // We are closed and no more
-        // msgs are available.
-        LOGS(_log, LOG_LVL_DEBUG, "Not waiting, but closed");
-        dlen = 0;
-        eInfo.Set("Not an active stream", EOPNOTSUPP);
-        return 0;
+    {
+        std::lock_guard<std::mutex> lock(_budgetMutex);
+        if (!_cancelled) { // cancel() has already given back everything.
+            _queuedBytes -= dlen;
+            _workerQueuedBytes -= dlen;
+        }
     }
-    SimpleBuffer* sb = new SimpleBuffer(_msgs.front());
-    dlen = _msgs.front().size();
-    _msgs.pop_front();
-    last = _closed && _msgs.empty();
+    _budgetCv.notify_all();
     LOGS(_log, LOG_LVL_DEBUG, "returning buffer (" << dlen << ", " << (last ? "(last)" : "(more)") << ")");
     return sb;
 }
 
+void
+ChannelStream::cancel() {
+    if (_cancelled.exchange(true)) {
+        return;
+    }
+    std::deque<std::string> dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        dropped.swap(_msgs);
+        _hasDataCondition.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_budgetMutex);
+        _workerQueuedBytes -= _queuedBytes;
+        _queuedBytes = 0;
+    }
+    _budgetCv.notify_all();
+    for (auto& msg : dropped) {
+        wbase::MsgBufferPool::getPool().release(std::move(msg));
+    }
+}
+
+std::uint64_t
+ChannelStream::getQueuedBytes() const {
+    std::lock_guard<std::mutex> lock(_budgetMutex);
+    return _queuedBytes;
+}
+
+void
+ChannelStream::setLimits(std::uint64_t streamLimit, std::uint64_t workerLimit) {
+    {
+        std::lock_guard<std::mutex> lock(_budgetMutex);
+        _streamLimit = streamLimit;
+        _workerLimit = workerLimit;
+    }
+    _budgetCv.notify_all();
+}
+
+std::uint64_t
+ChannelStream::getWorkerQueuedBytes() {
+    std::lock_guard<std::mutex> lock(_budgetMutex);
+    return _workerQueuedBytes;
+}
+
+std::uint64_t
+ChannelStream::getWorkerBlockedCount() {
+    std::lock_guard<std::mutex> lock(_budgetMutex);
+    return _workerBlockedCount;
+}
+
+std::uint64_t
+ChannelStream::getWorkerBlockedStreams() {
+    std::lock_guard<std::mutex> lock(_budgetMutex);
+    return _workerBlockedStreams;
+}
+
+/// @return true if this stream may not queue another message yet.
+/// Must be called with _budgetMutex held.
+bool
+ChannelStream::_overBudget() const {
+    if (_queuedBytes == 0) {
+        return false; // Always let one message through.
+    }
+    return (_streamLimit > 0 && _queuedBytes >= _streamLimit)
+        || (_workerLimit > 0 && _workerQueuedBytes >= _workerLimit);
+}
+
 }}} // lsst::qserv::xrdsvc
@@ -24,7 +24,9 @@
 #define LSST_QSERV_XRDSVC_CHANNELSTREAM_H
 
 // System headers
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <mutex>
 #include <string>
@@ -38,25 +40,75 @@ namespace qserv {
 namespace xrdsvc {
 /// ChannelStream is an implementation of an XrdSsiStream that accepts
 /// SendChannel streamed data.
+///
+/// Bytes queued but not yet handed to XrdSsi are bounded per stream and
+/// across all streams of the worker (see setLimits()). append() blocks the
+/// producer while either budget is exceeded, until XrdSsi drains the queue
+/// or the stream is cancelled. A stream with an empty queue may always
+/// append one message, so every stream makes progress.
+///
+/// A blocked producer holds its thread. QueryRunner leaves the Foreman pool
+/// before sending the messages of a Task that has more than one, but a
+/// Task sending a single message does so from a pool thread: its body,
+/// appended after its header, may wait there for the worker budget. Each
+/// such wait costs the pool a thread until XrdSsi drains some stream.
 class ChannelStream : public XrdSsiStream {
 public:
     ChannelStream();
     virtual ~ChannelStream();
 
     /// Push in a data packet
-    void append(char const* buf, int bufLen, bool last);
+    /// @return false if the stream was cancelled and the packet dropped
+    bool append(char const* buf, int bufLen, bool last);
+
+    /// Push in a data packet, taking ownership of msg without copying it.
+    /// @return false if the stream was cancelled and the packet dropped
+    bool append(std::string&& msg, bool last);
 
     /// Pull out a data packet as a Buffer object (called by XrdSsi code)
     virtual Buffer *GetBuff(XrdSsiErrInfo &eInfo, int &dlen, bool &last);
 
+    /// Drop queued data and wake up any blocked append() call. Later
+    /// append() calls are ignored.
+    void cancel();
+
     bool closed() const { return _closed; }
 
+    /// @return the number of bytes queued in this stream
+    std::uint64_t getQueuedBytes() const;
+
+    /// Set the queued byte budgets, 0 meaning unlimited.
+    /// @param streamLimit budget for a single stream
+    /// @param workerLimit budget for all streams of this worker
+    static void setLimits(std::uint64_t streamLimit, std::uint64_t workerLimit);
+
+    /// @return the number of bytes queued in all streams of this worker
+    static std::uint64_t getWorkerQueuedBytes();
+
+    /// @return how many append() calls have had to wait for budget
+    static std::uint64_t getWorkerBlockedCount();
+
+    /// @return the number of streams of this worker waiting for budget now
+    static std::uint64_t getWorkerBlockedStreams();
+
 private:
+    bool _overBudget() const;
+
     bool _closed; ///< Closed to new append() calls?
-    // Can keep a deque of (buf, bufsize) to reduce copying, if needed.
-    std::deque<std::string> _msgs; ///< Message queue
+    std::atomic<bool> _cancelled{false}; ///< Cancelled by XrdSsi?
+    std::deque<std::string> _msgs; ///< Message queue, handed to XrdSsi by move
     std::mutex _mutex; ///< _msgs protection
     std::condition_variable _hasDataCondition; ///< _msgs condition
+
+    std::uint64_t _queuedBytes{0}; ///< Protected by _budgetMutex
+
+    static std::uint64_t _streamLimit;
+    static std::uint64_t _workerLimit;
+    static std::uint64_t _workerQueuedBytes;
+    static std::uint64_t _workerBlockedCount;
+    static std::uint64_t _workerBlockedStreams;
+    static std::mutex _budgetMutex; ///< Protects queued byte counts and limits
+    static std::condition_variable _budgetCv; ///< Signalled when bytes are dequeued
 };
 
 }}} // namespace lsst::qserv::xrdsvc
@@ -25,7 +25,9 @@
 #include "xrdsvc/SsiService.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <iostream>
 #include <string>
 #include <stdlib.h>
@@ -42,16 +44,20 @@
 #include "memman/MemMan.h"
 #include "memman/MemManNone.h"
 #include "mysql/MySqlConnection.h"
+#include "proto/worker.pb.h"
 #include "sql/SqlConnection.h"
 #include "wbase/Base.h"
 #include "wconfig/WorkerConfig.h"
 #include "wconfig/WorkerConfigError.h"
 #include "wcontrol/Foreman.h"
+#include "wdb/QueryRunner.h"
+#include "wdb/ScanFusion.h"
 #include "wpublish/ChunkInventory.h"
 #include "wsched/BlendScheduler.h"
 #include "wsched/FifoScheduler.h"
 #include "wsched/GroupScheduler.h"
 #include "wsched/ScanScheduler.h"
+#include "xrdsvc/ChannelStream.h"
 #include "xrdsvc/SsiSession.h"
 #include "xrdsvc/XrdName.h"
 
@@ -91,7 +97,18 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
         uint64_t memManSize = workerConfig.getMemManSizeMb()*1000000;
         LOGS(_log, LOG_LVL_DEBUG, "Using MemManReal with memManSizeMb=" << workerConfig.getMemManSizeMb() 
             << " location=" <<  workerConfig.getMemManLocation());
-        memMan = std::shared_ptr<memman::MemMan>(memman::MemMan::create(memManSize, workerConfig.getMemManLocation()));
+        memman::MemMan::MapOptions mapOpts;
+        mapOpts.hugePages = workerConfig.getMemManHugePages();
+        if (workerConfig.getMemManNuma() == "interleave") {
+            mapOpts.interleave = true;
+        } else if (workerConfig.getMemManNuma() != "none") {
+            LOGS(_log, LOG_LVL_ERROR, "Unrecognized memman NUMA placement " << workerConfig.getMemManNuma());
+            throw wconfig::WorkerConfigError("Unrecognized memman NUMA placement.");
+        }
+        LOGS(_log, LOG_LVL_INFO, "MemManReal hugePages=" << mapOpts.hugePages
+             << " interleave=" << mapOpts.interleave);
+        memMan = std::shared_ptr<memman::MemMan>(memman::MemMan::create(memManSize, workerConfig.getMemManLocation(),
+                                                                        mapOpts));
     } else if (cfgMemMan == "MemManNone"){
         memMan = std::make_shared<memman::MemManNone>(1, false);
     } else {
@@ -136,6 +153,13 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
         "SchedSnail", maxThread, workerConfig.getMaxReserveSnail(), workerConfig.getPrioritySnail(),
         workerConfig.getMaxActiveChunksSnail(), memMan, slow+1, slowest, snailScanMaxMinutes);
 
+    unsigned int prefetchChunks = workerConfig.getMemManPrefetchChunks();
+    for (auto const& sched : scanSchedulers) {
+        sched->setPrefetchDepth(prefetchChunks);
+    }
+    snail->setPrefetchDepth(prefetchChunks);
+    LOGS(_log, LOG_LVL_INFO, "Prefetching tables of " << prefetchChunks << " chunks ahead");
+
     wpublish::QueriesAndChunks::Ptr queries =
         std::make_shared<wpublish::QueriesAndChunks>(std::chrono::minutes(5), std::chrono::minutes(5),
                 maxTasksBootedPerUserQuery);
@@ -146,8 +170,32 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
     unsigned int requiredTasksCompleted = workerConfig.getRequiredTasksCompleted();
     queries->setRequiredTasksCompleted(requiredTasksCompleted);
 
+    // Bound the result data queued for slow czars.
+    uint64_t const mb = 1024*1024;
+    ChannelStream::setLimits(workerConfig.getResultStreamQueueMb()*mb,
+                             workerConfig.getResultWorkerQueueMb()*mb);
+    LOGS(_log, LOG_LVL_INFO, "Result queue budget MB stream=" << workerConfig.getResultStreamQueueMb()
+         << " worker=" << workerConfig.getResultWorkerQueueMb());
+    queries->addStatusReporter([](std::ostream& os) {
+        os << "resultQueuedBytes=" << ChannelStream::getWorkerQueuedBytes()
+           << " resultBlockedStreams=" << ChannelStream::getWorkerBlockedStreams()
+           << " resultBlockedTotal=" << ChannelStream::getWorkerBlockedCount();
+    });
+
+    std::string compressionName = workerConfig.getResultCompression();
+    std::transform(compressionName.begin(), compressionName.end(), compressionName.begin(), ::toupper);
+    proto::ProtoHeader::CompressionType compression;
+    if (!proto::ProtoHeader::CompressionType_Parse(compressionName, &compression)) {
+        throw wconfig::WorkerConfigError("Unrecognized result compression "
+                                         + workerConfig.getResultCompression());
+    }
+    wdb::QueryRunner::setDefaultCompression(compression);
+
+    wdb::ScanFusion::getDefault().setMaxTasks(workerConfig.getScanFusionMax());
+    LOGS(_log, LOG_LVL_INFO, "Fused scans of up to " << workerConfig.getScanFusionMax() << " tasks");
+
     _foreman = std::make_shared<wcontrol::Foreman>(
-            blendSched, poolSize, workerConfig.getMySqlConfig(), queries);
+            blendSched, poolSize, workerConfig.getMySqlConfig(), queries, workerConfig.getStealDepth());
 }
 
 SsiService::~SsiService() {
@@ -84,23 +84,52 @@ SsiSession::ReplyChannel::sendFile(int fd, Size fSize) {
 
 bool
 SsiSession::ReplyChannel::sendStream(char const* buf, int bufLen, bool last) {
-    // Initialize streaming object if not initialized.
     LOGS(_log, LOG_LVL_DEBUG, "sendStream, checking stream " << (void *) _stream
          << " len=" << bufLen << " last=" << last);
-    if (!_stream) {
-        _initStream();
-    } else if (_stream->closed()) {
+    ChannelStream* stream = _getStream();
+    if (!stream) {
         return false;
     }
-    _stream->append(buf, bufLen, last);
-    return true;
+    // May block until the czar has drained enough of the stream.
+    return stream->append(buf, bufLen, last);
+}
+
+bool
+SsiSession::ReplyChannel::sendStream(std::string&& buf, bool last) {
+    LOGS(_log, LOG_LVL_DEBUG, "sendStream, checking stream " << (void *) _stream
+         << " len=" << buf.size() << " last=" << last);
+    ChannelStream* stream = _getStream();
+    if (!stream) {
+        return false;
+    }
+    // May block until the czar has drained enough of the stream.
+    return stream->append(std::move(buf), last);
 }
 
 void
-SsiSession::ReplyChannel::_initStream() {
-    //_stream.reset(new Stream);
-    _stream = new ChannelStream();
-    _ssiSession.SetResponse(_stream);
+SsiSession::ReplyChannel::cancel() {
+    std::lock_guard<std::mutex> lock(_streamMutex);
+    _cancelled = true;
+    if (_stream) {
+        _stream->cancel();
+    }
+}
+
+/// @return the stream, initializing it if needed, or nullptr if the
+/// channel is cancelled or the stream is already closed.
+ChannelStream*
+SsiSession::ReplyChannel::_getStream() {
+    std::lock_guard<std::mutex> lock(_streamMutex);
+    if (_cancelled) {
+        return nullptr;
+    }
+    if (!_stream) {
+        _stream = new ChannelStream();
+        _ssiSession.SetResponse(_stream);
+    } else if (_stream->closed()) {
+        return nullptr;
+    }
+    return _stream;
 }
 
 }}} // lsst::qserv::xrdsvc
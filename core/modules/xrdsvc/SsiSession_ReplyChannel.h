@@ -23,6 +23,9 @@
 #ifndef LSST_QSERV_XRDSVC_SSISESSION_REPLYCHANNEL_H
 #define LSST_QSERV_XRDSVC_SSISESSION_REPLYCHANNEL_H
 
+// System headers
+#include <mutex>
+
 // Third-party headers
 #include "XrdSsi/XrdSsiResponder.hh"
 
@@ -51,12 +54,16 @@ public:
     virtual bool sendError(std::string const& msg, int code);
     virtual bool sendFile(int fd, Size fSize);
     virtual bool sendStream(char const* buf, int bufLen, bool last);
+    virtual bool sendStream(std::string&& buf, bool last);
+    virtual void cancel();
 
 private:
-    void _initStream();
+    ChannelStream* _getStream();
 
     SsiSession& _ssiSession;
     ChannelStream* _stream;
+    bool _cancelled{false};
+    std::mutex _streamMutex; ///< Protects _stream and _cancelled
 };
 
 }}} // namespace lsst::qserv::xrdsvc
@@ -0,0 +1,156 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2016 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+  /**
+  * @brief Test the queued byte budgets of ChannelStream.
+  */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Third-party headers
+#include "XrdSsi/XrdSsiErrInfo.hh"
+
+// Qserv headers
+#include "xrdsvc/ChannelStream.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ChannelStream
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::xrdsvc::ChannelStream;
+
+namespace {
+
+/// Take the next message of a stream, as XrdSsi does.
+/// @return its size
+int take(ChannelStream& stream) {
+    XrdSsiErrInfo eInfo;
+    int dlen = 0;
+    bool last = false;
+    XrdSsiStream::Buffer* buf = stream.GetBuff(eInfo, dlen, last);
+    if (buf != nullptr) {
+        buf->Recycle();
+    }
+    return dlen;
+}
+
+/// Wait up to a few seconds for n streams to be blocked.
+bool waitBlocked(std::uint64_t n) {
+    for (int j = 0; j < 500 && ChannelStream::getWorkerBlockedStreams() != n; ++j) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return ChannelStream::getWorkerBlockedStreams() == n;
+}
+
+/// Reset the budgets after each test.
+struct Fixture {
+    ~Fixture() { ChannelStream::setLimits(0, 0); }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(StreamLimit) {
+    ChannelStream::setLimits(100, 0);
+    ChannelStream stream;
+    // One message always goes through, even over the budget.
+    BOOST_CHECK(stream.append(std::string(150, 'a'), false));
+    BOOST_CHECK_EQUAL(stream.getQueuedBytes(), 150u);
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 150u);
+
+    std::uint64_t const blockedBefore = ChannelStream::getWorkerBlockedCount();
+    std::atomic<bool> appended{false};
+    std::thread producer([&stream, &appended]() {
+        appended = stream.append(std::string(10, 'b'), true);
+    });
+    BOOST_CHECK(waitBlocked(1));
+    BOOST_CHECK(!appended);
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerBlockedCount(), blockedBefore + 1);
+
+    // Draining the stream lets the producer go on.
+    BOOST_CHECK_EQUAL(take(stream), 150);
+    producer.join();
+    BOOST_CHECK(appended);
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerBlockedStreams(), 0u);
+    BOOST_CHECK_EQUAL(stream.getQueuedBytes(), 10u);
+    BOOST_CHECK_EQUAL(take(stream), 10);
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(WorkerLimit) {
+    ChannelStream::setLimits(0, 100);
+    ChannelStream busy;
+    ChannelStream other;
+    BOOST_CHECK(busy.append(std::string(80, 'a'), false));
+    BOOST_CHECK(busy.append(std::string(30, 'a'), false));
+    // An empty stream appends over the worker budget, but only once.
+    BOOST_CHECK(other.append(std::string(20, 'b'), false));
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 130u);
+
+    std::atomic<bool> appended{false};
+    std::thread producer([&other, &appended]() {
+        appended = other.append(std::string(20, 'b'), true);
+    });
+    BOOST_CHECK(waitBlocked(1));
+    // Draining another stream frees worker budget.
+    BOOST_CHECK_EQUAL(take(busy), 80);
+    producer.join();
+    BOOST_CHECK(appended);
+    BOOST_CHECK_EQUAL(other.getQueuedBytes(), 40u);
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 70u);
+}
+
+BOOST_AUTO_TEST_CASE(CancelWakes) {
+    ChannelStream::setLimits(100, 0);
+    {
+        ChannelStream stream;
+        BOOST_CHECK(stream.append(std::string(150, 'a'), false));
+        std::atomic<bool> appended{true};
+        std::thread producer([&stream, &appended]() {
+            appended = stream.append(std::string(10, 'b'), true);
+        });
+        BOOST_CHECK(waitBlocked(1));
+        // The waiting message is dropped and the budget given back.
+        stream.cancel();
+        producer.join();
+        BOOST_CHECK(!appended);
+        BOOST_CHECK_EQUAL(stream.getQueuedBytes(), 0u);
+        BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 0u);
+        BOOST_CHECK(!stream.append(std::string(10, 'c'), true));
+        BOOST_CHECK_EQUAL(take(stream), 0);
+    }
+    // A stream destroyed with queued bytes gives them back.
+    {
+        ChannelStream stream;
+        BOOST_CHECK(stream.append(std::string(50, 'a'), false));
+    }
+    BOOST_CHECK_EQUAL(ChannelStream::getWorkerQueuedBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()